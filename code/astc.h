@@ -5,15 +5,6 @@
 #include <cstddef>
 #include <array>
 #include <assert.h>
-#include <atomic>
-#include <functional>
-
-#include <webgpu/webgpu.h>
-#include <webgpu/webgpu_cpp.h>
-
-#if defined(EMSCRIPTEN)
-#include <emscripten.h>
-#endif
 
 const unsigned int BLOCK_MAX_TEXELS = 144;
 
@@ -75,10 +66,44 @@ const unsigned int BLOCK_MAX_KMEANS_TEXELS = 64;
 
 const float ERROR_CALC_DEFAULT = 1e30f;
 
+//scale from 8 bit unorm channels to the encoder channel range (0 to 65536), shared with the shaders decoding packed texels
+const float UNORM8_TO_CHANNEL = static_cast<float>(65536.0 / 255.0);
+
 static constexpr uint16_t BLOCK_BAD_PARTITIONING = 0xFFFFu;
 
 const float TUNE_DB_LIMIT_BASE = 200.0f;
 
+//the 2D block sizes of the ASTC format
+const unsigned int ASTC_BLOCK_SIZE_COUNT_2D = 14;
+const uint8_t ASTC_BLOCK_SIZES_2D[ASTC_BLOCK_SIZE_COUNT_2D][2] = {
+	{4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6},
+	{10, 5}, {10, 6}, {8, 8}, {10, 8}, {10, 10}, {12, 10}, {12, 12}
+};
+
+//texel capacities of the block size specialised pipelines (TEXEL_CAPACITY override of the shaders), every block size uses the smallest one that fits
+const unsigned int TEXEL_CAPACITY_CLASS_COUNT = 4;
+const unsigned int TEXEL_CAPACITY_CLASSES[TEXEL_CAPACITY_CLASS_COUNT] = { 16, 36, 64, BLOCK_MAX_TEXELS };
+
+//number of batches that can be in flight at once (host prepares one batch while the GPU computes another and the host consumes a third)
+const unsigned int BATCHES_IN_FLIGHT = 3;
+
+//upper bound for the combined size of all per batch buffers, the batch size is reduced to fit into it
+const uint64_t BATCH_MEMORY_BUDGET = 1024ull * 1024 * 1024;
+
+//storage buffers bound by the largest passes (pass16 and pass17), the device has to be created with at least this limit
+const uint32_t REQUIRED_STORAGE_BUFFERS_PER_STAGE = 9;
+
+//stride between the per partition count copies of the uniform variables (minUniformBufferOffsetAlignment)
+const unsigned int UNIFORM_SLOT_STRIDE = 256;
+
+//byte offsets of the indirect dispatch arguments written by the compaction pass (pass008)
+const uint64_t INDIRECT_ARGS_BLOCKS = 0 * 3 * sizeof(uint32_t);
+const uint64_t INDIRECT_ARGS_PARTITIONED_BLOCKS = 1 * 3 * sizeof(uint32_t);
+const uint64_t INDIRECT_ARGS_DECIMATION_MODES = 2 * 3 * sizeof(uint32_t);
+const uint64_t INDIRECT_ARGS_BLOCK_MODES = 3 * 3 * sizeof(uint32_t);
+const uint64_t INDIRECT_ARGS_CANDIDATES = 4 * 3 * sizeof(uint32_t);
+const uint64_t INDIRECT_ARGS_SIZE = 5 * 3 * sizeof(uint32_t);
+
 enum quant_method
 {
 	QUANT_2 = 0,
@@ -296,6 +321,27 @@ struct alignas(16) uniform_variables {
 
 	uint32_t partitioning_count_selected[BLOCK_MAX_PARTITIONS];
 	uint32_t partitioning_count_all[BLOCK_MAX_PARTITIONS];
+
+	float tune_error_limit; //blocks with a lower error are not searched with more partitions
+	uint32_t batch_block_count;
+
+	uint32_t _padding1;
+	uint32_t _padding2;
+};
+
+/**
+ * @brief uniforms of the block extraction pass (pass000), written once per batch
+ */
+struct alignas(16) extraction_variables {
+	uint32_t image_width;
+	uint32_t image_height;
+	uint32_t blocks_x;
+	uint32_t first_block; //first block of the batch, counted from the start of its first block row
+
+	uint32_t first_row; //first image row of the uploaded rows (the first row of the first block row)
+	uint32_t xdim;
+	uint32_t ydim;
+	uint32_t block_count;
 };
 
 struct partition_info {
@@ -516,6 +562,25 @@ struct alignas(16) InputBlock {
 	uint32_t padding;
 };
 
+//GPU layout of InputBlock: texels are stored as packed RGBA8 and decoded in the shaders, the partitioning
+//of a block is looked up in the partition info table through its PartitionedBlock reference
+struct alignas(16) InputBlock_GPU {
+	uint32_t pixels[BLOCK_MAX_TEXELS];
+	uint32_t partition_pixel_counts[BLOCK_MAX_PARTITIONS];
+
+	uint32_t partitioning_idx;
+	uint32_t grayscale;
+	uint32_t constant_alpha;
+	uint32_t padding;
+};
+
+//partitionedBlocksBuffer structs
+//input block partitioned with one of the partitionings (written by pass007, not used with 1 partition)
+struct PartitionedBlock {
+	uint32_t source_block;          //index of the input block in the batch
+	uint32_t partition_table_idx;   //index into partitionInfoBuffer
+};
+
 //pass1_output_idealEndpointsAndWeights structs
 //per partitoin data of IdealEndpointsAndWeights
 struct alignas(16) IdealEndpointsAndWeights_p {
@@ -654,6 +719,21 @@ struct alignas(16) SymbolicBlock {
 	uint32_t quantized_weights[BLOCK_MAX_WEIGHTS];
 };
 
+/**
+ * @brief Lookup tables of the physical block packing, widened to 32 bits for use in the symbolic to physical shader
+ */
+struct ise_tables_GPU {
+	uint32_t quant_levels[21];
+	uint32_t btq_counts[21]; //bits | trits << 8 | quints << 16
+	uint32_t ise_sizes[21]; //scale | divisor << 8
+
+	uint32_t integer_of_trits[243]; //indexed [i4][i3][i2][i1][i0]
+	uint32_t integer_of_quints[125]; //indexed [i2][i1][i0]
+
+	uint32_t weight_scramble_maps[12][32]; //unquantized weight -> scrambled weight, for weight quant modes QUANT_2 to QUANT_32
+	uint32_t color_scrambled_pquant[17][256]; //unquantized color -> scrambled color, for color quant modes QUANT_6 to QUANT_256
+};
+
 
 //End of block data struct definitions
 //-----------------------------------------------------------------------------------------------------------------------------------
@@ -686,6 +766,58 @@ std::vector<InputBlock> SplitImageIntoBlocks(
 	int blockHeight
 );
 
+/**
+ * @brief Split a range of blocks of the image (in row-major block order) into caller provided storage
+ *
+ * @param      firstBlock   Index of the first block to extract.
+ * @param      blockCount   Number of blocks to extract.
+ * @param[out] blocksOut    Destination for @c blockCount blocks.
+ */
+void SplitImageIntoBlocks(
+	const uint8_t* imageData,
+	int width,
+	int height,
+	int blockWidth,
+	int blockHeight,
+	uint64_t firstBlock,
+	uint32_t blockCount,
+	InputBlock* blocksOut
+);
+
+/**
+ * @brief Pick the initial k-means cluster centers of a block (weighted random, with fixed cutoffs).
+ */
+void kmeans_init(
+	const InputBlock& blk,
+	unsigned int texel_count,
+	unsigned int partition_count,
+	const float channel_weights[4],
+	std::vector<std::array<float, 4>>& cluster_centers
+);
+
+/**
+ * @brief Assign every texel to its closest cluster center, no partition is left empty.
+ */
+void kmeans_assign(
+	const InputBlock& blk,
+	unsigned int texel_count,
+	unsigned int partition_count,
+	const float channel_weights[4],
+	const std::vector<std::array<float, 4>>& cluster_centers,
+	uint8_t partition_of_texel[BLOCK_MAX_TEXELS]
+);
+
+/**
+ * @brief Move the cluster centers to the mean of their assigned texels.
+ */
+void kmeans_update(
+	const InputBlock& blk,
+	unsigned int texel_count,
+	unsigned int partition_count,
+	std::vector<std::array<float, 4>>& cluster_centers,
+	const uint8_t partition_of_texel[BLOCK_MAX_TEXELS]
+);
+
 unsigned int find_best_partition_candidates(
 	const block_descriptor& block_descriptor,
 	const InputBlock& blk,
@@ -721,264 +853,7 @@ void symbolic_to_physical(
 	uint8_t physical_compressed_block[16]
 );
 
-class ASTCEncoder {
-public:
-	ASTCEncoder(const wgpu::Device& device);
-
-	~ASTCEncoder();
-
-	void init();
-	void secondaryInit(uint32_t textureWidth, uint32_t textureHeight, uint8_t blockXDim, uint8_t blockYDim);
-
-	void encode(uint8_t* imageData, uint8_t* dataOut, size_t dataLen);
-
-	uint32_t numBlocks;
-	uint32_t blocksX;
-	uint32_t blocksY;
-
-	const uint32_t batchSize = 920;
-
-	float tune_error_limit;
-
-#if defined(EMSCRIPTEN)
-	std::atomic<int> m_pending_pipelines;
-	void initAsync(std::function<void()> on_initialized);
-#endif
-
-	bool is_initialized = false;
-
-private:
-
-	void initMetadata();
-	void initTrialModes();
-	void initBindGroupLayouts();
-	void initBuffers();
-	void initPipelines();
-	void initBindGroups();
-	void releasePerImageResources();
-
-	void printBufferSizes();
-
-#if defined(EMSCRIPTEN)
-	struct PipelineBuildInfo {
-		wgpu::ShaderModule* shaderModule;
-		std::string shaderPath;
-		std::string shaderLabel;
-		wgpu::ComputePipeline* targetPipeline;
-		wgpu::BindGroupLayout* bindGroupLayout;
-	};
-
-	std::vector<PipelineBuildInfo> m_pipeline_build_queue;
-	int m_current_pipeline_index = 0;
-
-	void createNextPipeline(std::function<void()> on_all_pipelines_created);
-	void initPipelinesAsync(std::function<void()> on_all_pipelines_created);
-
-	struct PipelineCreationContext {
-		ASTCEncoder* encoderInstance;
-		wgpu::ComputePipeline* targetPipeline;
-		std::function<void()> onAllPipelinesCreated;
-	};
-
-	static void OnPipelineCreated(WGPUCreatePipelineAsyncStatus status, WGPUComputePipeline pipeline, char const* message, void* userdata);
-#endif
-
-	wgpu::Device device;
-	wgpu::Queue queue;
-
-	block_descriptor block_descriptor; //contains metadata used in compression
-
-	std::vector<float> sin_table; //precomputed sine values
-	std::vector<float> cos_table; //precomputed cosine values
-
-	uint32_t textureWidth;
-	uint32_t textureHeight;
-	uint8_t blockXDim;
-	uint8_t blockYDim;
-
-	std::vector<uint32_t> valid_decimation_modes; //Decimation modes that we actually consider for encoding
-	std::vector<PackedBlockModeLookup> valid_block_modes; //Block modes that we actually consider for encoding
-
-	//Shader modules 
-	wgpu::ShaderModule pass001_initKmeansShader;
-	wgpu::ShaderModule pass002_assignKmeansShader;
-	wgpu::ShaderModule pass003_updateKmeansShader;
-	wgpu::ShaderModule pass004_partitionMismatchShader;
-	wgpu::ShaderModule pass005_partitionOrderingShader;
-	wgpu::ShaderModule pass006_evaluatePartitionShader;
-	wgpu::ShaderModule pass007_preparePartitionedBlocksShader;
-
-	wgpu::ShaderModule pass1_idealEndpointsShader;
-	wgpu::ShaderModule pass2_decimatedWeightsShader;
-	wgpu::ShaderModule pass3_angularOffsetsShader;
-	wgpu::ShaderModule pass4_lowestAndHighestWeightShader;
-	wgpu::ShaderModule pass5_valuesForQuantLevelsShader;
-	wgpu::ShaderModule pass6_remapLowAndHighValuesShader;
-	wgpu::ShaderModule pass7_weightsAndErrorForBMShader;
-	wgpu::ShaderModule pass8_encodingChoiceErrorsShader;
-	wgpu::ShaderModule pass9_computeColorErrorShader;
-	wgpu::ShaderModule pass10_colorEndpointCombinationsShader_2part;
-	wgpu::ShaderModule pass10_colorEndpointCombinationsShader_3part;
-	wgpu::ShaderModule pass10_colorEndpointCombinationsShader_4part;
-	wgpu::ShaderModule pass11_bestEndpointCombinationsForModeShader_1part;
-	wgpu::ShaderModule pass11_bestEndpointCombinationsForModeShader_2part;
-	wgpu::ShaderModule pass11_bestEndpointCombinationsForModeShader_3part;
-	wgpu::ShaderModule pass11_bestEndpointCombinationsForModeShader_4part;
-	wgpu::ShaderModule pass12_findTopNCandidatesShader;
-	wgpu::ShaderModule pass13_recomputeIdealEndpointsShader;
-	wgpu::ShaderModule pass14_packColorEndpointsShader;
-	wgpu::ShaderModule pass15_unpackColorEndpointsShader;
-	wgpu::ShaderModule pass16_realignWeightsShader;
-	wgpu::ShaderModule pass17_computeFinalErrorShader;
-	wgpu::ShaderModule pass18_pickBestCandidateShader;
-
-	//Compute Pipelines
-	wgpu::ComputePipeline pass001_pipeline;
-	wgpu::ComputePipeline pass002_pipeline;
-	wgpu::ComputePipeline pass003_pipeline;
-	wgpu::ComputePipeline pass004_pipeline;
-	wgpu::ComputePipeline pass005_pipeline;
-	wgpu::ComputePipeline pass006_pipeline;
-	wgpu::ComputePipeline pass007_pipeline;
-
-	wgpu::ComputePipeline pass1_pipeline;
-	wgpu::ComputePipeline pass2_pipeline;
-	wgpu::ComputePipeline pass3_pipeline;
-	wgpu::ComputePipeline pass4_pipeline;
-	wgpu::ComputePipeline pass5_pipeline;
-	wgpu::ComputePipeline pass6_pipeline;
-	wgpu::ComputePipeline pass7_pipeline;
-	wgpu::ComputePipeline pass8_pipeline;
-	wgpu::ComputePipeline pass9_pipeline;
-	wgpu::ComputePipeline pass10_pipeline_2part;
-	wgpu::ComputePipeline pass10_pipeline_3part;
-	wgpu::ComputePipeline pass10_pipeline_4part;
-	wgpu::ComputePipeline pass11_pipeline_1part;
-	wgpu::ComputePipeline pass11_pipeline_2part;
-	wgpu::ComputePipeline pass11_pipeline_3part;
-	wgpu::ComputePipeline pass11_pipeline_4part;
-	wgpu::ComputePipeline pass12_pipeline;
-	wgpu::ComputePipeline pass13_pipeline;
-	wgpu::ComputePipeline pass14_pipeline;
-	wgpu::ComputePipeline pass15_pipeline;
-	wgpu::ComputePipeline pass16_pipeline;
-	wgpu::ComputePipeline pass17_pipeline;
-	wgpu::ComputePipeline pass18_pipeline;
-
-	//Bind Group Layouts
-	wgpu::BindGroupLayout pass001_bindGroupLayout;
-	wgpu::BindGroupLayout pass002_bindGroupLayout;
-	wgpu::BindGroupLayout pass003_bindGroupLayout;
-	wgpu::BindGroupLayout pass004_bindGroupLayout;
-	wgpu::BindGroupLayout pass005_bindGroupLayout;
-	wgpu::BindGroupLayout pass006_bindGroupLayout;
-	wgpu::BindGroupLayout pass007_bindGroupLayout;
-
-	wgpu::BindGroupLayout pass1_bindGroupLayout;
-	wgpu::BindGroupLayout pass2_bindGroupLayout;
-	wgpu::BindGroupLayout pass3_bindGroupLayout;
-	wgpu::BindGroupLayout pass4_bindGroupLayout;
-	wgpu::BindGroupLayout pass5_bindGroupLayout;
-	wgpu::BindGroupLayout pass6_bindGroupLayout;
-	wgpu::BindGroupLayout pass7_bindGroupLayout;
-	wgpu::BindGroupLayout pass8_bindGroupLayout;
-	wgpu::BindGroupLayout pass9_bindGroupLayout;
-	wgpu::BindGroupLayout pass10_bindGroupLayout;
-	wgpu::BindGroupLayout pass11_bindGroupLayout_1part;
-	wgpu::BindGroupLayout pass11_bindGroupLayout_234part;
-	wgpu::BindGroupLayout pass12_bindGroupLayout;
-	wgpu::BindGroupLayout pass13_bindGroupLayout;
-	wgpu::BindGroupLayout pass14_bindGroupLayout;
-	wgpu::BindGroupLayout pass15_bindGroupLayout;
-	wgpu::BindGroupLayout pass16_bindGroupLayout;
-	wgpu::BindGroupLayout pass17_bindGroupLayout;
-	wgpu::BindGroupLayout pass18_bindGroupLayout;
-
-	//Buffers
-	wgpu::Buffer uniformsBuffer;
-
-	//Buffers for partitioning info (constant after setup)
-	wgpu::Buffer kmeansTexelsBuffer;
-	wgpu::Buffer coverageBitmaps2Buffer;
-	wgpu::Buffer coverageBitmaps3Buffer;
-	wgpu::Buffer coverageBitmaps4Buffer;
-	wgpu::Buffer partitionInfoBuffer;
-
-	//Buffers for block mode info (constant after setup)
-	wgpu::Buffer blockModesBuffer;
-	wgpu::Buffer blockModeIndexBuffer;
-	wgpu::Buffer decimationModesBuffer;
-	wgpu::Buffer decimationInfoBuffer;
-	wgpu::Buffer texelToWeightMapBuffer;
-	wgpu::Buffer weightToTexelMapBuffer;
-
-	wgpu::Buffer validDecimationModesBuffer;
-	wgpu::Buffer validBlockModesBuffer;
-
-	//Buffers for storing sin and cos function values
-	wgpu::Buffer sinBuffer;
-	wgpu::Buffer cosBuffer;
-
-	//Block data buffers (they contain the data for individual blocks)
-	wgpu::Buffer inputBlocksBuffer;
-
-	wgpu::Buffer pass001_output_clusterCenters;
-	wgpu::Buffer pass002_output_texelAssignments;
-	wgpu::Buffer pass004_output_mismatchCounts;
-	wgpu::Buffer pass005_output_partitionOrdering;
-	wgpu::Buffer pass006_output_partitioningErrors;
-
-	wgpu::Buffer partitionedBlocksBuffer;
-
-	wgpu::Buffer pass1_output_idealEndpointsAndWeights;
-	wgpu::Buffer pass2_output_decimatedWeights;
-	wgpu::Buffer pass3_output_angular_offsets;
-	wgpu::Buffer pass4_output_lowestAndHighestWeight;
-	wgpu::Buffer pass5_output_lowValues;
-	wgpu::Buffer pass5_output_highValues;
-	wgpu::Buffer pass6_output_finalValueRanges;
-	wgpu::Buffer pass7_output_quantizationResults;
-	wgpu::Buffer pass8_output_encodingChoiceErrors;
-	wgpu::Buffer pass9_output_colorFormatErrors;
-	wgpu::Buffer pass9_output_colorFormats;
-	wgpu::Buffer pass10_output_colorEndpointCombinations;
-	wgpu::Buffer pass11_output_bestEndpointCombinationsForMode;
-	wgpu::Buffer pass12_output_finalCandidates;
-	wgpu::Buffer pass12_output_topCandidates;
-	wgpu::Buffer pass13_output_rgbsVectors;
-	wgpu::Buffer pass15_output_unpackedEndpoints;
-	wgpu::Buffer pass18_output_symbolicBlocks;
-
-	wgpu::Buffer outputReadbackBuffer;
-
-	wgpu::Buffer pass1111ReadbackBuffer;
-
-	//Bind Groups
-	wgpu::BindGroup pass001_bindGroup;
-	wgpu::BindGroup pass002_bindGroup;
-	wgpu::BindGroup pass003_bindGroup;
-	wgpu::BindGroup pass004_bindGroup;
-	wgpu::BindGroup pass005_bindGroup;
-	wgpu::BindGroup pass006_bindGroup;
-	wgpu::BindGroup pass007_bindGroup;
-
-	wgpu::BindGroup pass1_bindGroup;
-	wgpu::BindGroup pass2_bindGroup;
-	wgpu::BindGroup pass3_bindGroup;
-	wgpu::BindGroup pass4_bindGroup;
-	wgpu::BindGroup pass5_bindGroup;
-	wgpu::BindGroup pass6_bindGroup;
-	wgpu::BindGroup pass7_bindGroup;
-	wgpu::BindGroup pass8_bindGroup;
-	wgpu::BindGroup pass9_bindGroup;
-	wgpu::BindGroup pass10_bindGroup;
-	wgpu::BindGroup pass11_bindGroup_1part;
-	wgpu::BindGroup pass11_bindGroup_234part;
-	wgpu::BindGroup pass12_bindGroup;
-	wgpu::BindGroup pass13_bindGroup;
-	wgpu::BindGroup pass14_bindGroup;
-	wgpu::BindGroup pass15_bindGroup;
-	wgpu::BindGroup pass16_bindGroup;
-	wgpu::BindGroup pass17_bindGroup;
-	wgpu::BindGroup pass18_bindGroup;
-};
\ No newline at end of file
+/**
+ * @brief Fill the lookup tables used by symbolic_to_physical in the layout expected by the GPU packing pass
+ */
+void init_ise_tables_GPU(ise_tables_GPU& tables);
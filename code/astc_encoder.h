@@ -0,0 +1,433 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+
+#include <webgpu/webgpu.h>
+#include <webgpu/webgpu_cpp.h>
+
+#if defined(EMSCRIPTEN)
+#include <emscripten.h>
+#endif
+
+#include "astc.h"
+#include "webgpu_utils.h"
+#include "thread_pool.h"
+#include "gpu_profiler.h"
+
+class ASTCEncoder {
+public:
+	ASTCEncoder(const wgpu::Device& device);
+
+	~ASTCEncoder();
+
+	void init();
+	void secondaryInit(uint32_t textureWidth, uint32_t textureHeight, uint8_t blockXDim, uint8_t blockYDim);
+
+	//fills rowCount tightly packed RGBA8 image rows, starting at firstRow, into the staging memory
+	using RowSource = std::function<void(uint32_t firstRow, uint32_t rowCount, uint8_t* rows)>;
+
+	//receives the finished 16 byte blocks of a batch, firstBlock is the row-major index of the first one
+	using BlockSink = std::function<void(uint64_t firstBlock, uint32_t blockCount, const uint8_t* blocks)>;
+
+	//rowPitch is the distance between the image rows in bytes, 0 for tightly packed RGBA8 rows
+	void encode(const uint8_t* imageData, uint8_t* dataOut, size_t dataLen, size_t rowPitch = 0);
+
+	//same, with the blocks handed to the sink batch by batch instead of collected in one array
+	void encode(const uint8_t* imageData, size_t rowPitch, const BlockSink& blockSink);
+
+	/**
+	 * @brief Encode an image that is never held in memory as a whole.
+	 *
+	 * Rows are requested batch by batch in image order (a block row shared by two batches is requested twice) and
+	 * the blocks are handed to the sink as soon as their batch is finished, in block order. Host memory stays bounded
+	 * by the batch size, whatever the size of the image.
+	 */
+	void encodeStreaming(const RowSource& rowSource, const BlockSink& blockSink);
+
+	/**
+	 * @brief Totals over all images encoded by the encoder.
+	 */
+	struct Statistics {
+		uint64_t imagesEncoded = 0;
+		uint64_t blocksEncoded = 0;
+		uint64_t batchesSubmitted = 0;
+		double encodeSeconds = 0.0; //wall time of encode, including the wait for the GPU
+		double lastEncodeSeconds = 0.0;
+
+		//host time of the stages, setup is secondaryInit, the others are parts of encodeSeconds
+		double setupSeconds = 0.0;
+		double readRowsSeconds = 0.0;  //waiting for a staging buffer and reading the image rows into it
+		double submitSeconds = 0.0;    //recording and submitting the passes of the batches
+		double waitSeconds = 0.0;      //waiting for the results of the GPU
+		double writeSeconds = 0.0;     //handing the finished blocks to the sink
+	};
+
+	Statistics statistics;
+
+	GpuProfiler gpuProfiler; //per pass GPU times, only collected with ASTC_GPU_PROFILE on a device with timestamp queries
+
+	uint64_t numBlocks;
+	uint32_t blocksX;
+	uint32_t blocksY;
+
+	uint32_t batchSize = 920; //derived from the device limits in secondaryInit
+
+#if defined(EMSCRIPTEN)
+	void initAsync(std::function<void()> on_initialized);
+#endif
+
+	bool is_initialized = false;
+
+private:
+
+	/**
+	 * @brief Block size dependent state of the encoder.
+	 *
+	 * Holds the metadata of one block size and the constant buffers it is uploaded to. A session is built the
+	 * first time an image uses its block size and is kept for the lifetime of the encoder, so later images
+	 * with the same block size only update the per image state.
+	 */
+	struct BlockSizeSession {
+		uint8_t blockXDim;
+		uint8_t blockYDim;
+
+		block_descriptor block_descriptor; //contains metadata used in compression
+
+		std::vector<uint32_t> valid_decimation_modes; //Decimation modes that we actually consider for encoding
+		std::vector<PackedBlockModeLookup> valid_block_modes; //Block modes that we actually consider for encoding
+
+		float tune_error_limit; //scaled by the texel count and channel weights, compared against the block errors
+
+		//Buffers for partitioning info
+		wgpu::Buffer kmeansTexelsBuffer;
+		wgpu::Buffer coverageBitmaps2Buffer;
+		wgpu::Buffer coverageBitmaps3Buffer;
+		wgpu::Buffer coverageBitmaps4Buffer;
+		wgpu::Buffer partitionInfoBuffer;
+
+		//Buffers for block mode info
+		wgpu::Buffer blockModesBuffer;
+		wgpu::Buffer blockModeIndexBuffer;
+		wgpu::Buffer decimationModesBuffer;
+		wgpu::Buffer decimationInfoBuffer;
+		wgpu::Buffer texelToWeightMapBuffer;
+		wgpu::Buffer weightToTexelMapBuffer;
+
+		wgpu::Buffer validDecimationModesBuffer;
+		wgpu::Buffer validBlockModesBuffer;
+	};
+
+	BlockSizeSession& getSession(uint8_t blockXDim, uint8_t blockYDim);
+
+	void initMetadata(BlockSizeSession& session);
+	void initTrialModes(BlockSizeSession& session);
+	void initSessionBuffers(BlockSizeSession& session);
+	void initBindGroupLayouts();
+	void initSharedBuffers();
+	bool initBuffers();
+	void initPipelines();
+	void initBindGroups();
+	void releaseResources();
+
+	bool growBuffer(wgpu::Buffer& buffer, const wgpu::BufferDescriptor& descriptor);
+
+	void printBufferSizes();
+
+	uint32_t computeBatchSize();
+	uint64_t maxBatchImageRows(uint32_t batch_size);
+
+	/**
+	 * @brief Staging resources of one batch in the encode pipeline.
+	 *
+	 * The raw RGBA8 image rows covering the batch are written straight into the mapped staging buffer (the
+	 * blocks are extracted from them on the GPU), the finished physical block of
+	 * every block (packed on the GPU from the best symbolic block of all partition counts) is copied into the readback buffer. Slots are reused round-robin, so up to BATCHES_IN_FLIGHT
+	 * batches can be queued on the GPU while the host prepares and consumes the others.
+	 */
+	struct BatchSlot {
+		wgpu::Buffer inputStagingBuffer;
+		wgpu::Buffer readbackBuffer;
+
+		BufferMapState inputMap;
+		BufferMapState readbackMap;
+
+		GpuProfiler::BatchQueries queries; //pass timestamps of the batch, unused unless profiling
+
+		uint64_t batchStart = 0;
+		uint32_t batchSize = 0;
+		uint32_t firstColumn = 0; //block column of the first block, in the first block row of the batch
+		uint32_t firstRow = 0;
+		uint64_t rowBytes = 0;
+		bool inFlight = false;
+	};
+
+	void writeUniformSlots(uint32_t batch_block_count);
+	void submitBatch(BatchSlot& slot);
+	void retireBatch(BatchSlot& slot, const BlockSink& blockSink);
+	void waitForBatchSlots();
+
+	enum class PipelineSpecialization {
+		None,
+		TexelCapacity,                  //TEXEL_CAPACITY sizes the per texel workgroup arrays
+		TexelCapacityAndWorkgroupSize,  //one invocation per texel, WORKGROUP_SIZE follows TEXEL_CAPACITY
+	};
+
+	/**
+	 * @brief Shader and compute pipeline of one pass.
+	 *
+	 * All pipelines are created asynchronously and compile concurrently. Pipelines that are only used by batches with
+	 * more partitions are waited for by the first batch that records them, so encoding can start once the
+	 * pipelines of 1 partition are ready. Specialised pipelines are recreated with the texel capacity of the block size,
+	 * which shrinks their workgroup memory for small blocks.
+	 */
+	struct PipelineBuildInfo {
+		wgpu::ShaderModule* shaderModule;
+#if defined(EMSCRIPTEN)
+		std::string shaderPath;
+#else
+		const unsigned char* shaderData;
+		size_t shaderDataLen;
+#endif
+		std::string shaderLabel;
+		wgpu::ComputePipeline* targetPipeline;
+		wgpu::BindGroupLayout* bindGroupLayout;
+		uint32_t partitionCount; //lowest partition count that uses the pipeline
+		PipelineSpecialization specialization = PipelineSpecialization::None;
+	};
+
+	std::vector<PipelineBuildInfo> m_pipeline_build_queue;
+	std::atomic<int> m_pending_pipelines[BLOCK_MAX_PARTITIONS + 1] = {}; //pipelines still being created, by partition count
+	std::atomic<bool> m_pipeline_creation_failed = false;
+
+	uint32_t m_texel_capacity = BLOCK_MAX_TEXELS; //texel capacity the specialised pipelines were created for
+	std::map<uint32_t, std::vector<wgpu::ComputePipeline>> m_texel_capacity_variants; //specialised pipelines of the capacities used before, indexed like the build queue
+
+	void initPipelineBuildQueue();
+	void createPipelineAsync(const PipelineBuildInfo& info);
+	void selectTexelCapacity(uint32_t texelCount);
+	bool pipelinesReady(uint32_t partitionCount);
+	void waitForPipelines(uint32_t partitionCount);
+
+#if defined(EMSCRIPTEN)
+	std::function<void()> m_on_first_pipelines_created;
+
+	void initPipelinesAsync(std::function<void()> on_first_pipelines_created);
+#endif
+
+	struct PipelineCreationContext {
+		ASTCEncoder* encoderInstance;
+		wgpu::ComputePipeline* targetPipeline;
+		uint32_t partitionCount;
+		std::string shaderLabel;
+	};
+
+	static void OnPipelineCreated(WGPUCreatePipelineAsyncStatus status, WGPUComputePipeline pipeline, char const* message, void* userdata);
+
+	wgpu::Device device;
+	wgpu::Queue queue;
+
+	std::map<uint16_t, std::unique_ptr<BlockSizeSession>> sessions; //keyed by (blockXDim << 8) | blockYDim
+	BlockSizeSession* session = nullptr; //session of the current image
+	BlockSizeSession* boundSession = nullptr; //session the bind groups were created with
+
+	ThreadPool threadPool; //workers for the host side stages (block extraction)
+
+	std::vector<float> sin_table; //precomputed sine values
+	std::vector<float> cos_table; //precomputed cosine values
+
+	uint32_t textureWidth;
+	uint32_t textureHeight;
+	uint8_t blockXDim;
+	uint8_t blockYDim;
+
+	//Shader modules 
+	wgpu::ShaderModule pass000_extractBlocksShader;
+	wgpu::ShaderModule pass001_initKmeansShader;
+	wgpu::ShaderModule pass002_assignKmeansShader;
+	wgpu::ShaderModule pass003_updateKmeansShader;
+	wgpu::ShaderModule pass004_partitionMismatchShader;
+	wgpu::ShaderModule pass005_partitionOrderingShader;
+	wgpu::ShaderModule pass006_evaluatePartitionShader;
+	wgpu::ShaderModule pass007_preparePartitionedBlocksShader;
+	wgpu::ShaderModule pass008_compactActiveBlocksShader;
+
+	wgpu::ShaderModule pass1_idealEndpointsShader[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ShaderModule pass2_decimatedWeightsShader;
+	wgpu::ShaderModule pass3_angularOffsetsShader;
+	wgpu::ShaderModule pass4_lowestAndHighestWeightShader;
+	wgpu::ShaderModule pass5_valuesForQuantLevelsShader;
+	wgpu::ShaderModule pass6_remapLowAndHighValuesShader;
+	wgpu::ShaderModule pass7_weightsAndErrorForBMShader;
+	wgpu::ShaderModule pass8_encodingChoiceErrorsShader[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ShaderModule pass9_computeColorErrorShader[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ShaderModule pass10_colorEndpointCombinationsShader_2part;
+	wgpu::ShaderModule pass10_colorEndpointCombinationsShader_3part;
+	wgpu::ShaderModule pass10_colorEndpointCombinationsShader_4part;
+	wgpu::ShaderModule pass11_bestEndpointCombinationsForModeShader_1part;
+	wgpu::ShaderModule pass11_bestEndpointCombinationsForModeShader_2part;
+	wgpu::ShaderModule pass11_bestEndpointCombinationsForModeShader_3part;
+	wgpu::ShaderModule pass11_bestEndpointCombinationsForModeShader_4part;
+	wgpu::ShaderModule pass12_findTopNCandidatesShader;
+	wgpu::ShaderModule pass13_recomputeIdealEndpointsShader[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ShaderModule pass14_packColorEndpointsShader[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ShaderModule pass15_unpackColorEndpointsShader[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ShaderModule pass16_realignWeightsShader[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ShaderModule pass17_computeFinalErrorShader[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ShaderModule pass18_pickBestCandidateShader;
+	wgpu::ShaderModule pass19_symbolicToPhysicalShader;
+
+	//Compute Pipelines
+	wgpu::ComputePipeline pass000_pipeline;
+	wgpu::ComputePipeline pass001_pipeline;
+	wgpu::ComputePipeline pass002_pipeline;
+	wgpu::ComputePipeline pass003_pipeline;
+	wgpu::ComputePipeline pass004_pipeline;
+	wgpu::ComputePipeline pass005_pipeline;
+	wgpu::ComputePipeline pass006_pipeline;
+	wgpu::ComputePipeline pass007_pipeline;
+	wgpu::ComputePipeline pass008_pipeline;
+
+	wgpu::ComputePipeline pass1_pipeline[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ComputePipeline pass2_pipeline;
+	wgpu::ComputePipeline pass3_pipeline;
+	wgpu::ComputePipeline pass4_pipeline;
+	wgpu::ComputePipeline pass5_pipeline;
+	wgpu::ComputePipeline pass6_pipeline;
+	wgpu::ComputePipeline pass7_pipeline;
+	wgpu::ComputePipeline pass8_pipeline[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ComputePipeline pass9_pipeline[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ComputePipeline pass10_pipeline_2part;
+	wgpu::ComputePipeline pass10_pipeline_3part;
+	wgpu::ComputePipeline pass10_pipeline_4part;
+	wgpu::ComputePipeline pass11_pipeline_1part;
+	wgpu::ComputePipeline pass11_pipeline_2part;
+	wgpu::ComputePipeline pass11_pipeline_3part;
+	wgpu::ComputePipeline pass11_pipeline_4part;
+	wgpu::ComputePipeline pass12_pipeline;
+	wgpu::ComputePipeline pass13_pipeline[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ComputePipeline pass14_pipeline[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ComputePipeline pass15_pipeline[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ComputePipeline pass16_pipeline[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ComputePipeline pass17_pipeline[BLOCK_MAX_PARTITIONS]; //variants by partition count
+	wgpu::ComputePipeline pass18_pipeline;
+	wgpu::ComputePipeline pass19_pipeline;
+
+	//Bind Group Layouts
+	wgpu::BindGroupLayout pass000_bindGroupLayout;
+	wgpu::BindGroupLayout pass001_bindGroupLayout;
+	wgpu::BindGroupLayout pass002_bindGroupLayout;
+	wgpu::BindGroupLayout pass003_bindGroupLayout;
+	wgpu::BindGroupLayout pass004_bindGroupLayout;
+	wgpu::BindGroupLayout pass005_bindGroupLayout;
+	wgpu::BindGroupLayout pass006_bindGroupLayout;
+	wgpu::BindGroupLayout pass007_bindGroupLayout;
+	wgpu::BindGroupLayout pass008_bindGroupLayout;
+
+	wgpu::BindGroupLayout pass1_bindGroupLayout;
+	wgpu::BindGroupLayout pass2_bindGroupLayout;
+	wgpu::BindGroupLayout pass3_bindGroupLayout;
+	wgpu::BindGroupLayout pass4_bindGroupLayout;
+	wgpu::BindGroupLayout pass5_bindGroupLayout;
+	wgpu::BindGroupLayout pass6_bindGroupLayout;
+	wgpu::BindGroupLayout pass7_bindGroupLayout;
+	wgpu::BindGroupLayout pass8_bindGroupLayout;
+	wgpu::BindGroupLayout pass9_bindGroupLayout;
+	wgpu::BindGroupLayout pass10_bindGroupLayout;
+	wgpu::BindGroupLayout pass11_bindGroupLayout_1part;
+	wgpu::BindGroupLayout pass11_bindGroupLayout_234part;
+	wgpu::BindGroupLayout pass12_bindGroupLayout;
+	wgpu::BindGroupLayout pass13_bindGroupLayout;
+	wgpu::BindGroupLayout pass14_bindGroupLayout;
+	wgpu::BindGroupLayout pass15_bindGroupLayout;
+	wgpu::BindGroupLayout pass16_bindGroupLayout;
+	wgpu::BindGroupLayout pass17_bindGroupLayout;
+	wgpu::BindGroupLayout pass18_bindGroupLayout;
+	wgpu::BindGroupLayout pass19_bindGroupLayout;
+
+	//Buffers (the block size dependent constant buffers are held by the sessions)
+	wgpu::Buffer uniformsBuffer;
+
+	wgpu::Buffer iseTablesBuffer;
+
+	//Buffers for storing sin and cos function values
+	wgpu::Buffer sinBuffer;
+	wgpu::Buffer cosBuffer;
+
+	//Raw image rows of the current batch and the uniforms of the extraction pass
+	wgpu::Buffer extractionUniformsBuffer;
+	wgpu::Buffer imageRowsBuffer;
+
+	//Block data buffers (they contain the data for individual blocks)
+	wgpu::Buffer inputBlocksBuffer;
+
+	//Output of pass008: blocks still searched with the current partition count, and the indirect dispatch sizes for them
+	wgpu::Buffer activeBlocksBuffer;
+	wgpu::Buffer indirectArgsBuffer;
+
+	wgpu::Buffer pass001_output_clusterCenters;
+	wgpu::Buffer pass002_output_texelAssignments;
+	wgpu::Buffer pass004_output_mismatchCounts;
+	wgpu::Buffer pass005_output_partitionOrdering;
+	wgpu::Buffer pass006_output_partitioningErrors;
+
+	wgpu::Buffer partitionedBlocksBuffer;
+
+	wgpu::Buffer pass1_output_idealEndpointsAndWeights;
+	wgpu::Buffer pass2_output_decimatedWeights;
+	wgpu::Buffer pass3_output_angular_offsets;
+	wgpu::Buffer pass4_output_lowestAndHighestWeight;
+	wgpu::Buffer pass5_output_lowValues;
+	wgpu::Buffer pass5_output_highValues;
+	wgpu::Buffer pass6_output_finalValueRanges;
+	wgpu::Buffer pass7_output_quantizationResults;
+	wgpu::Buffer pass8_output_encodingChoiceErrors;
+	wgpu::Buffer pass9_output_colorFormatErrors;
+	wgpu::Buffer pass9_output_colorFormats;
+	wgpu::Buffer pass10_output_colorEndpointCombinations;
+	wgpu::Buffer pass11_output_bestEndpointCombinationsForMode;
+	wgpu::Buffer pass12_output_finalCandidates;
+	wgpu::Buffer pass12_output_topCandidates;
+	wgpu::Buffer pass13_output_rgbsVectors;
+	wgpu::Buffer pass15_output_unpackedEndpoints;
+	wgpu::Buffer pass18_output_symbolicBlocks;
+	wgpu::Buffer pass19_output_physicalBlocks;
+
+	std::array<BatchSlot, BATCHES_IN_FLIGHT> batchSlots;
+
+	//Bind Groups
+	wgpu::BindGroup pass000_bindGroup;
+	wgpu::BindGroup pass001_bindGroup;
+	wgpu::BindGroup pass002_bindGroup;
+	wgpu::BindGroup pass003_bindGroup;
+	wgpu::BindGroup pass004_bindGroup;
+	wgpu::BindGroup pass005_bindGroup;
+	wgpu::BindGroup pass006_bindGroup;
+	wgpu::BindGroup pass007_bindGroup;
+	wgpu::BindGroup pass008_bindGroup;
+
+	wgpu::BindGroup pass1_bindGroup;
+	wgpu::BindGroup pass2_bindGroup;
+	wgpu::BindGroup pass3_bindGroup;
+	wgpu::BindGroup pass4_bindGroup;
+	wgpu::BindGroup pass5_bindGroup;
+	wgpu::BindGroup pass6_bindGroup;
+	wgpu::BindGroup pass7_bindGroup;
+	wgpu::BindGroup pass8_bindGroup;
+	wgpu::BindGroup pass9_bindGroup;
+	wgpu::BindGroup pass10_bindGroup;
+	wgpu::BindGroup pass11_bindGroup_1part;
+	wgpu::BindGroup pass11_bindGroup_234part;
+	wgpu::BindGroup pass12_bindGroup;
+	wgpu::BindGroup pass13_bindGroup;
+	wgpu::BindGroup pass14_bindGroup;
+	wgpu::BindGroup pass15_bindGroup;
+	wgpu::BindGroup pass16_bindGroup;
+	wgpu::BindGroup pass17_bindGroup;
+	wgpu::BindGroup pass18_bindGroup;
+	wgpu::BindGroup pass19_bindGroup;
+};
\ No newline at end of file
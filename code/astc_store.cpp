@@ -1,6 +1,18 @@
 #include "astc_store.h"
+#include "trace.h"
+#include <algorithm>
 #include <stdexcept>
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif !defined(EMSCRIPTEN)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 
 struct astc_header
 {
@@ -13,16 +25,15 @@ struct astc_header
 	uint8_t dim_z[3];			// block count is inferred
 };
 
+static_assert(sizeof(astc_header) == ASTC_HEADER_SIZE, "astc_header has to match the file format");
+
 static const uint32_t ASTC_MAGIC_ID = 0x5CA1AB13;
 
-int store_image(
+static astc_header make_header(
 	unsigned int block_x,
 	unsigned int block_y,
 	unsigned int dim_x,
-	unsigned int dim_y,
-	uint8_t* data, 
-	size_t data_len,
-	const std::string& filename
+	unsigned int dim_y
 ) {
 	unsigned int block_z = 1;
 	unsigned int dim_z = 1;
@@ -49,16 +60,220 @@ int store_image(
 	hdr.dim_z[1] = (dim_z >> 8) & 0xFF;
 	hdr.dim_z[2] = (dim_z >> 16) & 0xFF;
 
-	std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
-	if (!file)
-	{
-		throw std::runtime_error("File open failed: " + filename);
-		return 1;
+	return hdr;
+}
+
+static uint64_t blocks_size(unsigned int block_x, unsigned int block_y, unsigned int dim_x, unsigned int dim_y) {
+	uint64_t blocksX = ((uint64_t)dim_x + block_x - 1) / block_x;
+	uint64_t blocksY = ((uint64_t)dim_y + block_y - 1) / block_y;
+	return blocksX * blocksY * 16;
+}
+
+/**
+ * @brief Output written with buffered writes, used where the file can not be mapped.
+ */
+class StreamAstcOutput : public AstcOutput {
+public:
+	StreamAstcOutput(const astc_header& hdr, const std::string& filename) : filename(filename) {
+		file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file) {
+			throw std::runtime_error("File open failed: " + filename);
+		}
+		file.write(reinterpret_cast<const char*>(&hdr), sizeof(astc_header));
+	}
+
+	~StreamAstcOutput() override {
+		if (!finished) {
+			file.close();
+			std::remove(filename.c_str());
+		}
+	}
+
+	void writeBlocks(uint64_t firstBlock, uint32_t blockCount, const uint8_t* blocks) override {
+		//blocks arrive in order, the seek only matters if a caller writes them out of order
+		std::streamoff offset = static_cast<std::streamoff>(ASTC_HEADER_SIZE + firstBlock * 16);
+		if (file.tellp() != offset) {
+			file.seekp(offset);
+		}
+		file.write(reinterpret_cast<const char*>(blocks), (std::streamsize)blockCount * 16);
+		if (!file) {
+			throw std::runtime_error("File write failed: " + filename);
+		}
+	}
+
+	void finish() override {
+		TRACE_SPAN("finish output");
+		file.close();
+		if (!file) {
+			throw std::runtime_error("File write failed: " + filename);
+		}
+		finished = true;
+	}
+
+private:
+	std::string filename;
+	std::ofstream file;
+	bool finished = false;
+};
+
+#if !defined(EMSCRIPTEN)
+/**
+ * @brief Output preallocated to its final size and mapped into memory, blocks are copied into the mapping.
+ */
+class MappedAstcOutput : public AstcOutput {
+public:
+	//returns null if the file could not be created and mapped
+	static std::unique_ptr<MappedAstcOutput> open(const astc_header& hdr, uint64_t fileSize, const std::string& filename) {
+		std::unique_ptr<MappedAstcOutput> output(new MappedAstcOutput(filename));
+
+		if (fileSize > SIZE_MAX) {
+			return nullptr;
+		}
+		output->size = static_cast<size_t>(fileSize);
+
+#if defined(_WIN32)
+		output->file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (output->file == INVALID_HANDLE_VALUE) {
+			return nullptr;
+		}
+
+		//creating the mapping extends the file to its size, with its clusters allocated (fails when the disk is full)
+		output->mapping = CreateFileMappingA(output->file, nullptr, PAGE_READWRITE, (DWORD)(fileSize >> 32), (DWORD)(fileSize & 0xFFFFFFFF), nullptr);
+		if (output->mapping == nullptr) {
+			return nullptr;
+		}
+
+		output->data = static_cast<uint8_t*>(MapViewOfFile(output->mapping, FILE_MAP_WRITE, 0, 0, output->size));
+		if (output->data == nullptr) {
+			return nullptr;
+		}
+#else
+		output->fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (output->fd < 0) {
+			return nullptr;
+		}
+
+		//the blocks of the file are allocated up front: a sparse file would fail in the middle of a memcpy (SIGBUS) once
+		//the disk is full, here the caller falls back to the streamed output instead
+#if defined(__APPLE__)
+		fstore_t store = { F_ALLOCATEALL, F_PEOFPOSMODE, 0, static_cast<off_t>(fileSize), 0 };
+		if (fcntl(output->fd, F_PREALLOCATE, &store) == -1 || ftruncate(output->fd, static_cast<off_t>(fileSize)) != 0) {
+			return nullptr;
+		}
+#else
+		if (posix_fallocate(output->fd, 0, static_cast<off_t>(fileSize)) != 0) {
+			return nullptr;
+		}
+#endif
+
+		void* mapped = mmap(nullptr, output->size, PROT_READ | PROT_WRITE, MAP_SHARED, output->fd, 0);
+		if (mapped == MAP_FAILED) {
+			return nullptr;
+		}
+		output->data = static_cast<uint8_t*>(mapped);
+#endif
+
+		memcpy(output->data, &hdr, sizeof(astc_header));
+		return output;
+	}
+
+	~MappedAstcOutput() override {
+		unmap();
+		if (!finished) {
+			std::remove(filename.c_str());
+		}
 	}
 
-	file.write(reinterpret_cast<char*>(&hdr), sizeof(astc_header));
-	file.write(reinterpret_cast<char*>(data), data_len);
-	return 0;
+	void writeBlocks(uint64_t firstBlock, uint32_t blockCount, const uint8_t* blocks) override {
+		if (ASTC_HEADER_SIZE + (firstBlock + blockCount) * 16 > size) {
+			throw std::runtime_error("Blocks written past the end of " + filename);
+		}
+		memcpy(data + ASTC_HEADER_SIZE + firstBlock * 16, blocks, (size_t)blockCount * 16);
+	}
+
+	void finish() override {
+		TRACE_SPAN("finish output");
+		//unmapping does not report a failed write back of the pages, so they are flushed to the file first
+		bool flushed = flush();
+		if (!unmap() || !flushed) {
+			throw std::runtime_error("File write failed: " + filename);
+		}
+		finished = true;
+	}
+
+private:
+	explicit MappedAstcOutput(const std::string& filename) : filename(filename) {}
+
+	bool flush() {
+		if (data == nullptr) {
+			return false;
+		}
+#if defined(_WIN32)
+		return FlushViewOfFile(data, 0) != 0 && FlushFileBuffers(file) != 0;
+#else
+		return msync(data, size, MS_SYNC) == 0;
+#endif
+	}
+
+	bool unmap() {
+		bool success = true;
+#if defined(_WIN32)
+		if (data != nullptr) {
+			success &= UnmapViewOfFile(data) != 0;
+		}
+		if (mapping != nullptr) {
+			CloseHandle(mapping);
+		}
+		if (file != INVALID_HANDLE_VALUE) {
+			success &= CloseHandle(file) != 0;
+		}
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (data != nullptr) {
+			success &= munmap(data, size) == 0;
+		}
+		if (fd >= 0) {
+			success &= close(fd) == 0;
+		}
+		fd = -1;
+#endif
+		data = nullptr;
+		return success;
+	}
+
+	std::string filename;
+	uint8_t* data = nullptr;
+	size_t size = 0;
+	bool finished = false;
+
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+};
+#endif
+
+std::unique_ptr<AstcOutput> open_astc_output(
+	unsigned int block_x,
+	unsigned int block_y,
+	unsigned int dim_x,
+	unsigned int dim_y,
+	const std::string& filename
+) {
+	TRACE_SPAN("open_astc_output");
+	astc_header hdr = make_header(block_x, block_y, dim_x, dim_y);
+
+#if !defined(EMSCRIPTEN)
+	std::unique_ptr<MappedAstcOutput> mapped = MappedAstcOutput::open(hdr, ASTC_HEADER_SIZE + blocks_size(block_x, block_y, dim_x, dim_y), filename);
+	if (mapped) {
+		return mapped;
+	}
+#endif
+
+	return std::make_unique<StreamAstcOutput>(hdr, filename);
 }
 
 #if defined(EMSCRIPTEN)
@@ -67,39 +282,14 @@ AstcFile create_astc_file_in_memory(
 	unsigned int block_y,
 	unsigned int dim_x,
 	unsigned int dim_y,
-	uint8_t* data,
 	size_t data_len
 ) {
-	const size_t headerSize = 16;
-	const size_t finalFileSize = headerSize + data_len;
+	const size_t finalFileSize = ASTC_HEADER_SIZE + data_len;
 	auto finalFileBuffer = std::make_unique<uint8_t[]>(finalFileSize);
-	uint8_t* ptr = finalFileBuffer.get();
-
-	*ptr++ = ASTC_MAGIC_ID & 0xFF;
-	*ptr++ = (ASTC_MAGIC_ID >> 8) & 0xFF;
-	*ptr++ = (ASTC_MAGIC_ID >> 16) & 0xFF;
-	*ptr++ = (ASTC_MAGIC_ID >> 24) & 0xFF;
-
-	*ptr++ = static_cast<uint8_t>(block_x);
-	*ptr++ = static_cast<uint8_t>(block_y);
-	*ptr++ = 1; // block_z
-
-	*ptr++ = dim_x & 0xFF;
-	*ptr++ = (dim_x >> 8) & 0xFF;
-	*ptr++ = (dim_x >> 16) & 0xFF;
-
-	*ptr++ = dim_y & 0xFF;
-	*ptr++ = (dim_y >> 8) & 0xFF;
-	*ptr++ = (dim_y >> 16) & 0xFF;
-
-	uint32_t dim_z = 1;
-	*ptr++ = dim_z & 0xFF;
-	*ptr++ = (dim_z >> 8) & 0xFF;
-	*ptr++ = (dim_z >> 16) & 0xFF;
 
-	// Copy the raw compressed data after the correctly formatted header.
-	memcpy(ptr, data, data_len);
+	astc_header hdr = make_header(block_x, block_y, dim_x, dim_y);
+	memcpy(finalFileBuffer.get(), &hdr, sizeof(astc_header));
 
 	return AstcFile{ std::move(finalFileBuffer), finalFileSize };
 }
-#endif
\ No newline at end of file
+#endif
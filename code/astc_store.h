@@ -1,17 +1,44 @@
+#pragma once
+
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <cstring>
 #include <memory>
+#include <string>
+
+static const size_t ASTC_HEADER_SIZE = 16;
+
+/**
+ * @brief Destination of the blocks of one .astc file.
+ *
+ * The header is written when the output is opened, the blocks follow batch by batch as the encoder finishes them,
+ * so the file is written while the image is still being encoded. An output that is destroyed without finish
+ * (a failed encode) removes its file again.
+ */
+class AstcOutput {
+public:
+	virtual ~AstcOutput() = default;
+
+	//firstBlock is the row-major index of the first of the blockCount 16 byte blocks
+	virtual void writeBlocks(uint64_t firstBlock, uint32_t blockCount, const uint8_t* blocks) = 0;
 
-int store_image(
+	//completes the file once all blocks are written, throws if it could not be written
+	virtual void finish() = 0;
+};
+
+/**
+ * @brief Open an .astc file for the blocks of an image.
+ *
+ * The file is preallocated and memory mapped, so the blocks are copied straight to their place in the file. Where
+ * the file can not be mapped the blocks are written to it with buffered writes instead.
+ */
+std::unique_ptr<AstcOutput> open_astc_output(
 	unsigned int block_x,
 	unsigned int block_y,
 	unsigned int dim_x,
 	unsigned int dim_y,
-	uint8_t* data,
-	size_t data_len,
 	const std::string& filename
 );
 
@@ -19,14 +46,19 @@ int store_image(
 struct AstcFile {
 	std::unique_ptr<uint8_t[]> data;
 	size_t size;
+
+	//the encoder writes the blocks straight behind the header
+	uint8_t* blocks() { return data.get() + ASTC_HEADER_SIZE; }
 };
 
+/**
+ * @brief Allocate a whole .astc file in memory, with the header written and room for data_len bytes of blocks.
+ */
 AstcFile create_astc_file_in_memory(
 	unsigned int block_x,
 	unsigned int block_y,
 	unsigned int dim_x,
 	unsigned int dim_y,
-	uint8_t* data,
 	size_t data_len
 );
-#endif
\ No newline at end of file
+#endif
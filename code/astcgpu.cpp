@@ -0,0 +1,379 @@
+#if !defined(EMSCRIPTEN)
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <webgpu/webgpu.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include "astcgpu.h"
+#include "astc_encoder.h"
+#include "pipeline_cache.h"
+#include "trace.h"
+#include "webgpu_utils.h"
+
+struct astcgpu_context {
+	std::unique_ptr<PipelineCache> pipelineCache; //only for auto created devices, has to outlive the device
+
+	wgpu::Instance instance;
+	wgpu::Adapter adapter;
+	wgpu::Device device;
+
+	std::unique_ptr<ASTCEncoder> encoder;
+
+	std::string lastError;
+};
+
+//message of the last failed astcgpu_context_create of the thread, there is no context to keep it in
+static thread_local std::string lastCreateError;
+
+//a software adapter (SwiftShader in Dawn) gives comparable timings on machines without a GPU, e.g. CI
+static bool fallbackAdapterRequested() {
+	const char* value = std::getenv("ASTC_FALLBACK_ADAPTER");
+	return value != nullptr && value[0] != '\0' && strcmp(value, "0") != 0;
+}
+
+//creates the device of the high performance adapter, same as the command line tool always did. Returns
+//ASTCGPU_ERROR_NO_ADAPTER without an instance or adapter, the other failures throw
+static astcgpu_status createDevice(astcgpu_context& context) {
+
+	wgpu::InstanceDescriptor desc = {};
+	context.instance = wgpu::CreateInstance(&desc);
+	if (!context.instance) {
+		lastCreateError = "Could not initialize WebGPU";
+		return ASTCGPU_ERROR_NO_ADAPTER;
+	}
+
+	wgpu::RequestAdapterOptions adapterOpts = {};
+	adapterOpts.powerPreference = wgpu::PowerPreference::HighPerformance;
+	adapterOpts.forceFallbackAdapter = fallbackAdapterRequested();
+	context.adapter = requestAdapterSync(context.instance, &adapterOpts);
+	if (!context.adapter) {
+		lastCreateError = "Could not get adapter";
+		return ASTCGPU_ERROR_NO_ADAPTER;
+	}
+
+	wgpu::AdapterInfo properties = {};
+	context.adapter.GetInfo(&properties);
+
+	ASTC_LOG(LogLevel::Info, "--- Adapter Info ---");
+	ASTC_LOG(LogLevel::Info, "Vendor: " << (properties.vendor ? properties.vendor : "N/A"));
+	ASTC_LOG(LogLevel::Info, "Architecture: " << (properties.architecture ? properties.architecture : "N/A"));
+	ASTC_LOG(LogLevel::Info, "Device: " << (properties.device ? properties.device : "N/A"));
+	ASTC_LOG(LogLevel::Info, "Description: " << (properties.description ? properties.description : "N/A"));
+	ASTC_LOG(LogLevel::Info, "--------------------");
+
+	wgpu::RequiredLimits requiredLimits = getRequiredLimits(context.adapter);
+
+	wgpu::DeviceDescriptor deviceDesc = {};
+	deviceDesc.label = "ASTC encoder device";
+	deviceDesc.requiredFeatureCount = 0;
+	deviceDesc.requiredLimits = &requiredLimits;
+	deviceDesc.defaultQueue.label = "The default queue";
+
+	deviceDesc.deviceLostCallback = [](WGPUDeviceLostReason reason, char const* message, void* /* pUserData */) {
+		ASTC_LOG(LogLevel::Error, "Device lost: reason " << reason << (message ? std::string(" (") + message + ")" : std::string()));
+		};
+
+	//compiled shaders and pipelines are kept on disk when ASTC_PIPELINE_CACHE_DIR is set
+	context.pipelineCache = std::make_unique<PipelineCache>();
+	context.pipelineCache->attach(deviceDesc);
+
+	//timestamp queries for the per pass GPU times, with ASTC_GPU_PROFILE
+	GpuProfiler::attach(deviceDesc, context.adapter);
+
+	context.device = requestDeviceSync(context.adapter, &deviceDesc);
+	if (!context.device) {
+		throw std::runtime_error("Could not get device");
+	}
+
+	auto onDeviceError = [](WGPUErrorType type, char const* message, void* /* pUserData */) {
+		ASTC_LOG(LogLevel::Error, "Uncaptured device error: type " << type << (message ? std::string(" (") + message + ")" : std::string()));
+		};
+	context.device.SetUncapturedErrorCallback(onDeviceError, nullptr /* pUserData */);
+	return ASTCGPU_SUCCESS;
+}
+
+//block sink calling a write_blocks callback of the C API, a failed write aborts the encode
+static ASTCEncoder::BlockSink callbackBlockSink(astcgpu_write_blocks_fn write_blocks, void* userdata) {
+	return [write_blocks, userdata](uint64_t firstBlock, uint32_t blockCount, const uint8_t* blocks) {
+		if (write_blocks(userdata, firstBlock, blockCount, blocks) != 0) {
+			throw std::runtime_error("Writing blocks " + std::to_string(firstBlock) + " to " + std::to_string(firstBlock + blockCount) + " failed");
+		}
+	};
+}
+
+astcgpu_status astcgpu_context_create(WGPUDevice device, astcgpu_context** context) {
+
+	lastCreateError.clear();
+
+	if (context == nullptr) {
+		lastCreateError = "No context pointer";
+		return ASTCGPU_ERROR_INVALID_ARGUMENT;
+	}
+	*context = nullptr;
+
+	std::unique_ptr<astcgpu_context> result = std::make_unique<astcgpu_context>();
+
+	try {
+		if (device != nullptr) {
+			result->device = wgpu::Device(device); //adds a reference, the caller keeps its own
+		}
+		else {
+			//no adapter is a property of the machine rather than a failure of the encoder, callers can tell them apart
+			astcgpu_status status = createDevice(*result);
+			if (status != ASTCGPU_SUCCESS) {
+				return status;
+			}
+		}
+
+		result->encoder = std::make_unique<ASTCEncoder>(result->device);
+		result->encoder->init();
+	}
+	catch (const std::exception& e) {
+		lastCreateError = e.what();
+		return ASTCGPU_ERROR_DEVICE;
+	}
+
+	*context = result.release();
+	return ASTCGPU_SUCCESS;
+}
+
+void astcgpu_context_destroy(astcgpu_context* context) {
+
+	if (context == nullptr) {
+		return;
+	}
+
+	//the encoder waits for the pipelines still being created, so the stats cover every partition count and
+	//texel capacity variant the context created
+	context->encoder.reset();
+	if (context->pipelineCache) {
+		context->pipelineCache->printStats("context");
+	}
+
+	delete context;
+}
+
+uint64_t astcgpu_compressed_size(uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y) {
+
+	if (block_x == 0 || block_y == 0) {
+		return 0;
+	}
+
+	uint64_t blocksX = ((uint64_t)width + block_x - 1) / block_x;
+	uint64_t blocksY = ((uint64_t)height + block_y - 1) / block_y;
+	return blocksX * blocksY * 16;
+}
+
+int astcgpu_is_valid_block_size(uint32_t block_x, uint32_t block_y) {
+
+	for (unsigned int i = 0; i < ASTC_BLOCK_SIZE_COUNT_2D; i++) {
+		if (ASTC_BLOCK_SIZES_2D[i][0] == block_x && ASTC_BLOCK_SIZES_2D[i][1] == block_y) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+astcgpu_status astcgpu_encode(
+	astcgpu_context* context,
+	const uint8_t* pixels,
+	uint32_t width,
+	uint32_t height,
+	size_t row_stride,
+	uint32_t block_x,
+	uint32_t block_y,
+	uint8_t* output,
+	size_t output_size
+) {
+	if (context == nullptr) {
+		return ASTCGPU_ERROR_INVALID_ARGUMENT;
+	}
+
+	if (pixels == nullptr || output == nullptr || width == 0 || height == 0 || (row_stride != 0 && row_stride < (size_t)width * 4)) {
+		context->lastError = "Invalid image";
+		return ASTCGPU_ERROR_INVALID_ARGUMENT;
+	}
+
+	if (!astcgpu_is_valid_block_size(block_x, block_y)) {
+		context->lastError = "Unsupported block size " + std::to_string(block_x) + "x" + std::to_string(block_y);
+		return ASTCGPU_ERROR_UNSUPPORTED_BLOCK_SIZE;
+	}
+
+	uint64_t compressedSize = astcgpu_compressed_size(width, height, block_x, block_y);
+	if (output_size < compressedSize) {
+		context->lastError = "Output buffer of " + std::to_string(output_size) + " bytes, " + std::to_string(compressedSize) + " bytes needed";
+		return ASTCGPU_ERROR_OUTPUT_TOO_SMALL;
+	}
+
+	try {
+		context->encoder->secondaryInit(width, height, static_cast<uint8_t>(block_x), static_cast<uint8_t>(block_y));
+		context->encoder->encode(pixels, output, output_size, row_stride);
+	}
+	catch (const std::exception& e) {
+		context->lastError = e.what();
+		return ASTCGPU_ERROR_ENCODE;
+	}
+
+	context->lastError.clear();
+	return ASTCGPU_SUCCESS;
+}
+
+astcgpu_status astcgpu_encode_to_callback(
+	astcgpu_context* context,
+	const uint8_t* pixels,
+	uint32_t width,
+	uint32_t height,
+	size_t row_stride,
+	uint32_t block_x,
+	uint32_t block_y,
+	astcgpu_write_blocks_fn write_blocks,
+	void* userdata
+) {
+	if (context == nullptr) {
+		return ASTCGPU_ERROR_INVALID_ARGUMENT;
+	}
+
+	if (pixels == nullptr || write_blocks == nullptr || width == 0 || height == 0 || (row_stride != 0 && row_stride < (size_t)width * 4)) {
+		context->lastError = "Invalid image";
+		return ASTCGPU_ERROR_INVALID_ARGUMENT;
+	}
+
+	if (!astcgpu_is_valid_block_size(block_x, block_y)) {
+		context->lastError = "Unsupported block size " + std::to_string(block_x) + "x" + std::to_string(block_y);
+		return ASTCGPU_ERROR_UNSUPPORTED_BLOCK_SIZE;
+	}
+
+	try {
+		context->encoder->secondaryInit(width, height, static_cast<uint8_t>(block_x), static_cast<uint8_t>(block_y));
+		context->encoder->encode(pixels, row_stride, callbackBlockSink(write_blocks, userdata));
+	}
+	catch (const std::exception& e) {
+		context->lastError = e.what();
+		return ASTCGPU_ERROR_ENCODE;
+	}
+
+	context->lastError.clear();
+	return ASTCGPU_SUCCESS;
+}
+
+astcgpu_status astcgpu_encode_streaming(
+	astcgpu_context* context,
+	uint32_t width,
+	uint32_t height,
+	uint32_t block_x,
+	uint32_t block_y,
+	astcgpu_read_rows_fn read_rows,
+	astcgpu_write_blocks_fn write_blocks,
+	void* userdata
+) {
+	if (context == nullptr) {
+		return ASTCGPU_ERROR_INVALID_ARGUMENT;
+	}
+
+	if (read_rows == nullptr || write_blocks == nullptr || width == 0 || height == 0) {
+		context->lastError = "Invalid image";
+		return ASTCGPU_ERROR_INVALID_ARGUMENT;
+	}
+
+	if (!astcgpu_is_valid_block_size(block_x, block_y)) {
+		context->lastError = "Unsupported block size " + std::to_string(block_x) + "x" + std::to_string(block_y);
+		return ASTCGPU_ERROR_UNSUPPORTED_BLOCK_SIZE;
+	}
+
+	ASTCEncoder::RowSource rowSource = [&](uint32_t firstRow, uint32_t rowCount, uint8_t* rows) {
+		if (read_rows(userdata, firstRow, rowCount, rows) != 0) {
+			throw std::runtime_error("Reading image rows " + std::to_string(firstRow) + " to " + std::to_string(firstRow + rowCount) + " failed");
+		}
+	};
+
+	try {
+		context->encoder->secondaryInit(width, height, static_cast<uint8_t>(block_x), static_cast<uint8_t>(block_y));
+		context->encoder->encodeStreaming(rowSource, callbackBlockSink(write_blocks, userdata));
+	}
+	catch (const std::exception& e) {
+		context->lastError = e.what();
+		return ASTCGPU_ERROR_ENCODE;
+	}
+
+	context->lastError.clear();
+	return ASTCGPU_SUCCESS;
+}
+
+astcgpu_status astcgpu_get_statistics(const astcgpu_context* context, astcgpu_statistics* statistics) {
+
+	if (context == nullptr || statistics == nullptr) {
+		return ASTCGPU_ERROR_INVALID_ARGUMENT;
+	}
+
+	const ASTCEncoder::Statistics& encoderStatistics = context->encoder->statistics;
+
+	statistics->images_encoded = encoderStatistics.imagesEncoded;
+	statistics->blocks_encoded = encoderStatistics.blocksEncoded;
+	statistics->batches_submitted = encoderStatistics.batchesSubmitted;
+	statistics->encode_seconds = encoderStatistics.encodeSeconds;
+	statistics->last_encode_seconds = encoderStatistics.lastEncodeSeconds;
+	statistics->batch_size = encoderStatistics.imagesEncoded > 0 ? context->encoder->batchSize : 0;
+	statistics->setup_seconds = encoderStatistics.setupSeconds;
+	statistics->read_rows_seconds = encoderStatistics.readRowsSeconds;
+	statistics->submit_seconds = encoderStatistics.submitSeconds;
+	statistics->wait_seconds = encoderStatistics.waitSeconds;
+	statistics->write_seconds = encoderStatistics.writeSeconds;
+
+	return ASTCGPU_SUCCESS;
+}
+
+void astcgpu_reset_statistics(astcgpu_context* context) {
+	if (context != nullptr) {
+		context->encoder->statistics = {};
+		context->encoder->gpuProfiler.reset();
+	}
+}
+
+void astcgpu_print_gpu_profile(const astcgpu_context* context) {
+	if (context != nullptr) {
+		context->encoder->gpuProfiler.printReport();
+	}
+}
+
+astcgpu_status astcgpu_get_required_limits(WGPUAdapter adapter, WGPURequiredLimits* limits) {
+
+	if (adapter == nullptr || limits == nullptr) {
+		return ASTCGPU_ERROR_INVALID_ARGUMENT;
+	}
+
+	wgpu::RequiredLimits requiredLimits = getRequiredLimits(wgpu::Adapter(adapter));
+	if (requiredLimits.limits.maxStorageBuffersPerShaderStage < REQUIRED_STORAGE_BUFFERS_PER_STAGE) {
+		return ASTCGPU_ERROR_DEVICE;
+	}
+
+	//the C++ structs are layout compatible with the C ones
+	*limits = *reinterpret_cast<const WGPURequiredLimits*>(&requiredLimits);
+	limits->nextInChain = nullptr;
+	return ASTCGPU_SUCCESS;
+}
+
+const char* astcgpu_get_last_error(const astcgpu_context* context) {
+	return context != nullptr ? context->lastError.c_str() : lastCreateError.c_str();
+}
+
+const char* astcgpu_status_string(astcgpu_status status) {
+	switch (status) {
+	case ASTCGPU_SUCCESS: return "success";
+	case ASTCGPU_ERROR_INVALID_ARGUMENT: return "invalid argument";
+	case ASTCGPU_ERROR_UNSUPPORTED_BLOCK_SIZE: return "unsupported block size";
+	case ASTCGPU_ERROR_OUTPUT_TOO_SMALL: return "output buffer too small";
+	case ASTCGPU_ERROR_DEVICE: return "device or pipeline creation failed";
+	case ASTCGPU_ERROR_ENCODE: return "encoding failed";
+	case ASTCGPU_ERROR_NO_ADAPTER: return "no adapter";
+	}
+	return "unknown status";
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "averages_and_directions.h"
+#include <cmath>
 
 float dot_product(float vec1[4], float vec2[4]) {
 	return vec1[0] * vec2[0] + vec1[1] * vec2[1] + vec1[2] * vec2[2] + vec1[3] * vec2[3];
@@ -2,6 +2,7 @@
 #include "averages_and_directions.h"
 
 #include <iostream>
+#include <limits>
 
 // Calculates the weighted squared difference between two colors
 static float dot_product_squared_difference(
@@ -150,7 +151,7 @@ void kmeans_assign(
 	} while (problem_case_found);
 }
 
-static void kmeans_update(
+void kmeans_update(
 	const InputBlock& blk,
 	unsigned int texel_count,
 	unsigned int partition_count,
@@ -1,149 +1,39 @@
+#include <chrono>
 #include <iostream>
+#include <cstring>
+#include <memory>
+#include <optional>
 
-#include "astc.h"
+#include "astc_encoder.h"
 #include "webgpu_utils.h"
+#include "metadata_cache.h"
+#include "trace.h"
 
 
-std::vector<InputBlock> SplitImageIntoBlocks(
-    uint8_t* imageData,
-    int width,
-    int height,
-    int blockWidth,
-    int blockHeight
-) {
+//adds the time until the end of its scope to a statistics field
+class StageTimer {
+public:
+    explicit StageTimer(double& seconds) : seconds(seconds), start(std::chrono::steady_clock::now()) {}
 
-    std::vector<InputBlock> blocks;
-
-    int blocksX = (width + blockWidth - 1) / blockWidth;
-    int blocksY = (height + blockHeight - 1) / blockHeight;
-
-    for (int by = 0; by < blocksY; ++by) {
-        for (int bx = 0; bx < blocksX; ++bx) {
-            InputBlock block = {};
-
-            float alpha_min = 1e38f;
-            float alpha_max = 0;
-
-            bool grayscale = true;
-
-            int pixelIndex = 0;
-            for (int dy = 0; dy < blockHeight; ++dy) {
-
-                int y = by * blockHeight + dy;
-                int clamped_y = std::min(y, height - 1);
-
-                for (int dx = 0; dx < blockWidth; ++dx) {
-
-                    int x = bx * blockWidth + dx;
-                    int clamped_x = std::min(x, width - 1);
-
-                    int idx = (clamped_y * width + clamped_x) * 4;
-
-
-                    for (int c = 0; c < 4; c++) {
-                        float channel_value = (imageData[idx + c] / 255.0f) * 65536.0f;
-
-                        block.pixels[pixelIndex][c] = channel_value;
-						
-                        if (c == 3) {
-							alpha_max = std::max(alpha_max, channel_value);
-							alpha_min = std::min(alpha_min, channel_value);
-                        }
-                    }
-
-                    grayscale = grayscale && (block.pixels[pixelIndex][0] == block.pixels[pixelIndex][1] && block.pixels[pixelIndex][0] == block.pixels[pixelIndex][2]);
-
-					block.texel_partitions[pixelIndex] = 0;
-
-                    ++pixelIndex;
-                }
-            }
-
-            if (grayscale) {
-                block.grayscale = 1;
-            }
-            else {
-                block.grayscale = 0;
-            }
-
-            if (alpha_max == alpha_min) {
-				block.constant_alpha = 1;
-            }
-            else {
-				block.constant_alpha = 0;
-            }
-
-			block.partition_pixel_counts[0] = blockWidth * blockHeight;
-            block.partition_pixel_counts[1] = 0;
-			block.partition_pixel_counts[2] = 0;
-			block.partition_pixel_counts[3] = 0;
-
-            blocks.push_back(block);
-        }
+    ~StageTimer() {
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
     }
 
-    return blocks;
-}
-
-//generate best partitionings for provided input blocks
-static int generateBlockPartitionings(
-    const block_descriptor& block_descriptor,
-    const std::vector<InputBlock>& unpartitionedBlocks,
-    int partition_count,
-    int partition_search_limint,
-    int requested_candidates,
-    std::vector<InputBlock>& partitionedBlocks,
-    std::vector<int>& blockOffsets
-) {
-    int imageBlocksNum = unpartitionedBlocks.size();
-    int texel_count = block_descriptor.uniform_variables.texel_count;
-
-    partitionedBlocks.clear();
-    blockOffsets.clear();
-
-    blockOffsets.resize(imageBlocksNum);
-    int nextOffset = 0;
-
-    for (int i = 0; i < imageBlocksNum; i++) {
-        unsigned int partition_indices[TUNE_MAX_PARTITIONING_CANDIDATES];
-        int candidatecount = find_best_partition_candidates(block_descriptor, unpartitionedBlocks[i], partition_count, partition_search_limint, partition_indices, requested_candidates);
-
-        blockOffsets[i] = nextOffset;
-        nextOffset += candidatecount;
-
-        for (int j = 0; j < candidatecount; j++) {
-
-            partitionedBlocks.emplace_back(unpartitionedBlocks[i]);
-            InputBlock& partitionedBlock = partitionedBlocks.back();
-
-            auto& pi = block_descriptor.get_partition_info(partition_count, partition_indices[j]);
-
-            for (int tex = 0; tex < texel_count; tex++) {
-				partitionedBlock.texel_partitions[tex] = pi.partition_of_texel[tex];
-            }
+private:
+    double& seconds;
+    std::chrono::steady_clock::time_point start;
+};
 
-            partitionedBlock.partitioning_idx = pi.partition_index;
-
-            for (int p = 0; p < partition_count; p++) {
-                partitionedBlock.partition_pixel_counts[p] = pi.partition_texel_count[p];
-            }
-        }
-
-    }
-
-    return nextOffset;
+void ASTCEncoder::initMetadata(BlockSizeSession& blockSession) {
+    //built once per block size and process, or loaded from the disk cache when ASTC_METADATA_CACHE_DIR is set
+    MetadataCache::shared().load(blockSession.blockXDim, blockSession.blockYDim, blockSession.block_descriptor);
 }
 
-void ASTCEncoder::initMetadata() {
-    construct_metadata_structures(blockXDim, blockYDim, block_descriptor);
-
-    init_partition_tables(block_descriptor, false, 4);
-    init_partition_tables_GPU(block_descriptor);
-
-    construct_angular_tables(sin_table, cos_table);
-}
+void ASTCEncoder::initTrialModes(BlockSizeSession& blockSession) {
+    block_descriptor& block_descriptor = blockSession.block_descriptor;
+    std::vector<uint32_t>& valid_decimation_modes = blockSession.valid_decimation_modes;
+    std::vector<PackedBlockModeLookup>& valid_block_modes = blockSession.valid_block_modes;
 
-void ASTCEncoder::initTrialModes() {
     valid_decimation_modes.clear();
     valid_block_modes.clear();
 
@@ -206,14 +96,22 @@ ASTCEncoder::ASTCEncoder(const wgpu::Device& device):
         throw std::runtime_error("Invalid WebGPU Device");
     }
 
+    wgpu::SupportedLimits supportedLimits = {};
+    device.GetLimits(&supportedLimits);
+    if (supportedLimits.limits.maxStorageBuffersPerShaderStage < REQUIRED_STORAGE_BUFFERS_PER_STAGE) {
+        throw std::runtime_error("WebGPU Device supports too few storage buffers per shader stage");
+    }
+
     //init to some default values
     this->textureWidth = 0;
     this->textureHeight = 0;
     this->blocksX = (textureWidth + 4 - 1) / 4;
     this->blocksY = (textureHeight + 4 - 1) / 4;
-    this->numBlocks = blocksX * blocksY;
+    this->numBlocks = (uint64_t)blocksX * blocksY;
     this->blockXDim = 4;
     this->blockYDim = 4;
+
+    gpuProfiler.init(device);
 }
 
 void ASTCEncoder::init() {
@@ -221,15 +119,15 @@ void ASTCEncoder::init() {
         return;
     }
 
-    std::cout << "Initializing ASTCEncoder for the first time..." << std::endl;
+    ASTC_LOG(LogLevel::Debug, "Initializing ASTCEncoder for the first time...");
 
-    std::cout << "Initializing bind group layouts..." << std::endl;
+    ASTC_LOG(LogLevel::Debug, "Initializing bind group layouts...");
     initBindGroupLayouts();
-    std::cout << "Initializing pipelines..." << std::endl;
+    ASTC_LOG(LogLevel::Debug, "Initializing pipelines...");
     initPipelines();
 
     is_initialized = true;
-    std::cout << "ASTCEncoder initialization complete." << std::endl;
+    ASTC_LOG(LogLevel::Debug, "ASTCEncoder initialization complete.");
 }
 
 #if defined(EMSCRIPTEN)
@@ -241,16 +139,16 @@ void ASTCEncoder::initAsync(std::function<void()> on_initialized) {
         return;
     }
 
-    std::cout << "Initializing ASTCEncoder for the first time..." << std::endl;
+    ASTC_LOG(LogLevel::Debug, "Initializing ASTCEncoder for the first time...");
 
-    std::cout << "Initializing bind group layouts..." << std::endl;
+    ASTC_LOG(LogLevel::Debug, "Initializing bind group layouts...");
     initBindGroupLayouts();
 
-    std::cout << "Initializing pipelines (Async)..." << std::endl;
+    ASTC_LOG(LogLevel::Debug, "Initializing pipelines (Async)...");
     auto on_init_shared = std::make_shared<std::function<void()>>(on_initialized);
     initPipelinesAsync([this, on_init_shared]() {
         this->is_initialized = true;
-        std::cout << "ASTCEncoder initialization complete." << std::endl;
+        ASTC_LOG(LogLevel::Debug, "ASTCEncoder initialization complete.");
 
         if (*on_init_shared) {
             (*on_init_shared)();
@@ -260,280 +158,456 @@ void ASTCEncoder::initAsync(std::function<void()> on_initialized) {
 }
 #endif
 
+ASTCEncoder::BlockSizeSession& ASTCEncoder::getSession(uint8_t blockXDim, uint8_t blockYDim) {
+
+    uint16_t key = static_cast<uint16_t>((blockXDim << 8) | blockYDim);
+
+    auto it = sessions.find(key);
+    if (it != sessions.end()) {
+        return *it->second;
+    }
+
+    TRACE_SPAN("secondaryInit: block size session");
+    ASTC_LOG(LogLevel::Debug, "Precomputing compression data for " << (int)blockXDim << "x" << (int)blockYDim << " blocks...");
+
+    std::unique_ptr<BlockSizeSession> blockSession = std::make_unique<BlockSizeSession>();
+    blockSession->blockXDim = blockXDim;
+    blockSession->blockYDim = blockYDim;
+
+    initMetadata(*blockSession);
+    initTrialModes(*blockSession);
+
+    //error limit of the block size, blocks with a lower error are not searched with further partition counts
+    const uniform_variables& uniforms = blockSession->block_descriptor.uniform_variables;
+
+    float texels = static_cast<float>(blockXDim * blockYDim);
+    float ltexels = logf(texels) / logf(10.0f);
+    float db_limit = 80 - 19 * ltexels;
+
+    float weights_sum = uniforms.channel_weights[0] + uniforms.channel_weights[1] + uniforms.channel_weights[2] + uniforms.channel_weights[3];
+
+    blockSession->tune_error_limit = pow(0.1f, db_limit * 0.1f) * 65535.0f * 65535.0f * uniforms.texel_count * weights_sum;
+    ASTC_LOG(LogLevel::Debug, "error limit: " << blockSession->tune_error_limit);
+
+    ASTC_LOG(LogLevel::Debug, "Writing precomputed data to buffers...");
+    initSessionBuffers(*blockSession);
+
+    BlockSizeSession& result = *blockSession;
+    sessions[key] = std::move(blockSession);
+    return result;
+}
+
 void ASTCEncoder::secondaryInit(uint32_t textureWidth, uint32_t textureHeight, uint8_t blockXDim, uint8_t blockYDim) {
+    TRACE_SPAN("secondaryInit");
+    StageTimer setupTimer(statistics.setupSeconds);
 
-    //if there are any old resources release them before initializing them again
-    releasePerImageResources();
+    //buffers that don't depend on the block size or the image are created with the first image
+    if (!uniformsBuffer) {
+        TRACE_SPAN("secondaryInit: shared buffers");
+        initSharedBuffers();
+    }
 
     this->textureWidth = textureWidth;
     this->textureHeight = textureHeight;
     this->blocksX = (textureWidth + blockXDim - 1) / blockXDim;
     this->blocksY = (textureHeight + blockYDim - 1) / blockYDim;
-    this->numBlocks = blocksX * blocksY;
+    this->numBlocks = (uint64_t)blocksX * blocksY;
     this->blockXDim = blockXDim;
     this->blockYDim = blockYDim;
 
-	float texels = static_cast<float>(blockXDim * blockYDim);
-    float ltexels = logf(texels) / logf(10.0f);
+    //metadata and constant buffers are built once per block size
+    session = &getSession(blockXDim, blockYDim);
 
-	this->tune_error_limit = 80 - 19 * ltexels;
-    std::cout << "error limit: " << this->tune_error_limit << std::endl;
+    //passes with per texel workgroup arrays are specialised for the texel count of the block size
+    {
+        TRACE_SPAN("secondaryInit: select texel capacity");
+        selectTexelCapacity(blockXDim * blockYDim);
+    }
 
-    this->tune_error_limit = pow(0.1f, this->tune_error_limit * 0.1f) * 65535.0f * 65535.0f;
-    std::cout << "error limit: " << this->tune_error_limit << std::endl;
+    batchSize = computeBatchSize();
 
+    //per batch buffers only grow, the bind groups are recreated when they or the session changed
+    ASTC_LOG(LogLevel::Debug, "Initializing storage buffers...");
+    bool buffersChanged;
+    {
+        TRACE_SPAN("secondaryInit: storage buffers");
+        buffersChanged = initBuffers();
+    }
 
-    std::cout << "Precomputing compression data..." << std::endl;
-    initMetadata();
-    initTrialModes();
+    if (buffersChanged || session != boundSession) {
+        TRACE_SPAN("secondaryInit: bind groups");
+        ASTC_LOG(LogLevel::Debug, "Initializing bind groups...");
+        initBindGroups();
+        boundSession = session;
 
-    std::cout << "Initializing storage buffers..." << std::endl;
-    initBuffers();
-    std::cout << "Initializing bind groups..." << std::endl;
-    initBindGroups();
+        printBufferSizes();
+    }
+}
 
-    printBufferSizes();
+void ASTCEncoder::encode(const uint8_t* imageData, uint8_t* dataOut, size_t dataLen, size_t rowPitch) {
 
-    //write the precomputed metadata to the buffers
-    //write to block mode and decimation mode buffers
-    std::cout << "Writing precomputed data to buffers..." << std::endl;
-    queue.WriteBuffer(blockModesBuffer, 0, block_descriptor.block_modes, block_descriptor.uniform_variables.block_mode_count * sizeof(block_mode));
-    queue.WriteBuffer(blockModeIndexBuffer, 0, block_descriptor.block_mode_index, block_descriptor.uniform_variables.block_mode_count * sizeof(uint32_t));
-    queue.WriteBuffer(decimationModesBuffer, 0, block_descriptor.decimation_modes, block_descriptor.uniform_variables.decimation_mode_count * sizeof(decimation_mode));
-    queue.WriteBuffer(decimationInfoBuffer, 0, block_descriptor.decimation_info_metadata, block_descriptor.uniform_variables.decimation_mode_count * sizeof(decimation_info));
-    queue.WriteBuffer(texelToWeightMapBuffer, 0, block_descriptor.decimation_info_packed.texel_to_weight_map_data.data(), block_descriptor.decimation_info_packed.texel_to_weight_map_data.size() * sizeof(TexelToWeightMap));
-    queue.WriteBuffer(weightToTexelMapBuffer, 0, block_descriptor.decimation_info_packed.weight_to_texel_map_data.data(), block_descriptor.decimation_info_packed.weight_to_texel_map_data.size() * sizeof(WeightToTexelMap));
+    if (dataLen < numBlocks * 16) {
+        throw std::runtime_error("Output buffer is too small for the compressed image");
+    }
 
-    queue.WriteBuffer(validDecimationModesBuffer, 0, valid_decimation_modes.data(), valid_decimation_modes.size() * sizeof(uint32_t));
-    queue.WriteBuffer(validBlockModesBuffer, 0, valid_block_modes.data(), valid_block_modes.size() * sizeof(PackedBlockModeLookup));
+    encode(imageData, rowPitch, [&](uint64_t firstBlock, uint32_t blockCount, const uint8_t* blocks) {
+        memcpy(dataOut + firstBlock * 16, blocks, (size_t)blockCount * 16);
+    });
+}
 
-    //write to sin and cos table buffers
-    queue.WriteBuffer(sinBuffer, 0, sin_table.data(), SINCOS_STEPS * ANGULAR_STEPS * sizeof(float));
-    queue.WriteBuffer(cosBuffer, 0, cos_table.data(), SINCOS_STEPS * ANGULAR_STEPS * sizeof(float));
+void ASTCEncoder::encode(const uint8_t* imageData, size_t rowPitch, const BlockSink& blockSink) {
 
-    //write to partitioning buffers
-    queue.WriteBuffer(kmeansTexelsBuffer, 0, block_descriptor.kmeans_texels, BLOCK_MAX_KMEANS_TEXELS * sizeof(uint32_t));
-    queue.WriteBuffer(coverageBitmaps2Buffer, 0, block_descriptor.coverage_bitmaps_2, BLOCK_MAX_PARTITIONINGS * 2 * sizeof(uint64_t));
-    queue.WriteBuffer(coverageBitmaps3Buffer, 0, block_descriptor.coverage_bitmaps_3, BLOCK_MAX_PARTITIONINGS * 3 * sizeof(uint64_t));
-    queue.WriteBuffer(coverageBitmaps4Buffer, 0, block_descriptor.coverage_bitmaps_4, BLOCK_MAX_PARTITIONINGS * 4 * sizeof(uint64_t));
+    uint64_t row_size = (uint64_t)textureWidth * 4;
+    uint64_t row_pitch = rowPitch != 0 ? rowPitch : row_size;
 
-    queue.WriteBuffer(partitionInfoBuffer, 0, block_descriptor.partitionings_GPU, ((3 * BLOCK_MAX_PARTITIONINGS) + 1) * sizeof(partition_info_GPU));
+    // Row ranges are copied in parallel, each worker writes its own part of the staging buffer.
+    // The staged rows are always tightly packed, padded source rows are copied one by one
+    RowSource rowSource = [&](uint32_t firstRow, uint32_t rowCount, uint8_t* stagedRows) {
+        threadPool.parallelFor(rowCount, 64, [&](uint32_t begin, uint32_t end) {
+            if (row_pitch == row_size) {
+                memcpy(stagedRows + begin * row_size, imageData + (firstRow + begin) * row_size, (end - begin) * row_size);
+                return;
+            }
+            for (uint32_t row = begin; row < end; row++) {
+                memcpy(stagedRows + row * row_size, imageData + (firstRow + row) * row_pitch, row_size);
+            }
+        });
+    };
+
+    encodeStreaming(rowSource, blockSink);
 }
 
-void ASTCEncoder::encode(uint8_t* imageData, uint8_t* dataOut, size_t dataLen) {
+void ASTCEncoder::encodeStreaming(const RowSource& rowSource, const BlockSink& blockSink) {
 
-    float weights_sum = block_descriptor.uniform_variables.channel_weights[0] +
-        block_descriptor.uniform_variables.channel_weights[1] +
-        block_descriptor.uniform_variables.channel_weights[2] +
-        block_descriptor.uniform_variables.channel_weights[3];
+    TRACE_SPAN("encode");
+    ASTC_LOG(LogLevel::Debug, "Total blocks to compress: " << numBlocks);
 
-    this->tune_error_limit = this->tune_error_limit * block_descriptor.uniform_variables.texel_count * weights_sum;
-    std::cout << "error limit: " << this->tune_error_limit << std::endl;
+    auto encodeStart = std::chrono::steady_clock::now();
 
-    std::cout << "Total blocks to compress: " << numBlocks << std::endl;
+    try {
+        // Batches are pipelined over the slot ring: while the GPU computes one batch, the host
+        // prepares the next one and consumes the results of the batch submitted before it
+        uint32_t batchIndex = 0;
+        for (uint64_t batch_start = 0; batch_start < numBlocks; batch_start += batchSize, batchIndex++) {
+            uint64_t batch_end = std::min<uint64_t>(batch_start + batchSize, numBlocks);
+            uint32_t current_batch_size = static_cast<uint32_t>(batch_end - batch_start);
 
-    //get image blocks
-    std::cout << "Preparing image blocks..." << std::endl;
-    std::vector<InputBlock> original_blocks = SplitImageIntoBlocks(imageData, textureWidth, textureHeight, blockXDim, blockYDim);
+            BatchSlot& slot = batchSlots[batchIndex % BATCHES_IN_FLIGHT];
 
-    // This vector will store the best encoding found for each block across all partition counts
-    std::vector<SymbolicBlock> best_symbolic_blocks(numBlocks);
-    for (auto& block : best_symbolic_blocks) {
-        block.errorval = ERROR_CALC_DEFAULT;
-    }
+            // The slot is still holding an older batch, consume its results first
+            if (slot.inFlight) {
+                retireBatch(slot, blockSink);
+            }
 
-    for (uint32_t batch_start = 0; batch_start < numBlocks; batch_start += batchSize) {
-        uint32_t batch_end = std::min(batch_start + batchSize, numBlocks);
-        uint32_t current_batch_size = batch_end - batch_start;
+            ASTC_LOG(LogLevel::Debug, "Processing batch starting at block " << batch_start << " (" << current_batch_size << " blocks)...");
 
-        std::cout << "Processing batch starting at block " << batch_start << " (" << current_batch_size << " blocks)..." << std::endl;
+            // Get the image rows covered by the batch, written straight into the mapped staging buffer.
+            // The blocks themselves are extracted from them on the GPU (pass000)
+            {
+                TRACE_SPAN("wait for staging buffer");
+                StageTimer readRowsTimer(statistics.readRowsSeconds);
+                if (!waitForBufferMap(device, slot.inputMap)) {
+                    throw std::runtime_error("Failed to map input staging buffer");
+                }
+            }
 
-        auto batch_blocks_begin = original_blocks.begin() + batch_start;
-        auto batch_blocks_end = original_blocks.begin() + batch_end;
-        std::vector<InputBlock> batch_original_blocks(batch_blocks_begin, batch_blocks_end);
+            uint64_t first_block_row = batch_start / blocksX;
+            uint32_t first_row = static_cast<uint32_t>(first_block_row * blockYDim);
+            uint32_t end_row = static_cast<uint32_t>(std::min<uint64_t>(((batch_end - 1) / blocksX + 1) * blockYDim, textureHeight));
+            uint64_t row_size = (uint64_t)textureWidth * 4;
 
+            uint8_t* stagedRows = static_cast<uint8_t*>(slot.inputStagingBuffer.GetMappedRange(0, (end_row - first_row) * row_size));
+            {
+                TRACE_SPAN("read image rows");
+                StageTimer readRowsTimer(statistics.readRowsSeconds);
+                rowSource(first_row, end_row - first_row, stagedRows);
+            }
+            slot.inputStagingBuffer.Unmap();
 
-        queue.WriteBuffer(inputBlocksBuffer, 0, batch_original_blocks.data(), current_batch_size * sizeof(InputBlock));
+            slot.batchStart = batch_start;
+            slot.batchSize = current_batch_size;
+            slot.firstColumn = static_cast<uint32_t>(batch_start - first_block_row * blocksX);
+            slot.firstRow = first_row;
+            slot.rowBytes = (end_row - first_row) * row_size;
 
-        // Iterate through all supported partition counts
-        for (unsigned int p_count = 1; p_count <= 4; ++p_count) {
-            std::cout << "Compressing with " << p_count << " partition(s)..." << std::endl;
+            {
+                StageTimer submitTimer(statistics.submitSeconds);
+                submitBatch(slot);
+            }
+            statistics.batchesSubmitted++;
 
-            // Prepare block data for the current partition count
-            /*
-            std::vector<InputBlock> current_blocks;
-            std::vector<int> block_offsets;
-            int current_partitioned_blocks_num;
-            block_descriptor.uniform_variables.partition_count = p_count;
+            // Both mappings resolve once the GPU has finished with this batch
+            mapBufferAsync(slot.readbackBuffer, wgpu::MapMode::Read, slot.readbackBuffer.GetSize(), &slot.readbackMap);
+            mapBufferAsync(slot.inputStagingBuffer, wgpu::MapMode::Write, slot.inputStagingBuffer.GetSize(), &slot.inputMap);
+            gpuProfiler.mapBatch(slot.queries);
+            slot.inFlight = true;
+        }
 
-            if (p_count == 1) {
-                current_blocks = batch_original_blocks;
-                current_partitioned_blocks_num = batch_original_blocks.size();
-                block_offsets.resize(current_batch_size);
-                for (uint32_t i = 0; i < current_batch_size; ++i) block_offsets[i] = i;
-            }
-            else {
-                unsigned int search_limit = 100;
-                unsigned int candidates = TUNE_MAX_PARTITIONING_CANDIDATES;
-                std::cout << "Partitioning..." << std::endl;
-                current_partitioned_blocks_num = generateBlockPartitionings(
-                    block_descriptor, batch_original_blocks, p_count, search_limit, candidates,
-                    current_blocks, block_offsets);
-                std::cout << "done" << std::endl;
+        // Consume the batches that are still in flight, in submission order
+        for (uint32_t i = 0; i < BATCHES_IN_FLIGHT; i++) {
+            BatchSlot& slot = batchSlots[(batchIndex + i) % BATCHES_IN_FLIGHT];
+            if (slot.inFlight) {
+                retireBatch(slot, blockSink);
             }
+        }
+    }
+    catch (...) {
+        // The batches still on the GPU belong to the aborted image, their results are dropped
+        waitForBatchSlots();
+        throw;
+    }
 
-            if (current_partitioned_blocks_num == 0) {
-                std::cout << "No valid partitionings found for " << p_count << " partitions. Skipping." << std::endl;
-                continue;
-            }
-            */
+    std::chrono::duration<double> encodeTime = std::chrono::steady_clock::now() - encodeStart;
+    statistics.imagesEncoded++;
+    statistics.blocksEncoded += numBlocks;
+    statistics.encodeSeconds += encodeTime.count();
+    statistics.lastEncodeSeconds = encodeTime.count();
 
-            if (p_count == 1) {
-                queue.WriteBuffer(partitionedBlocksBuffer, 0, batch_original_blocks.data(), current_batch_size * sizeof(InputBlock));
+    ASTC_LOG(LogLevel::Debug, "Encoding complete.");
+}
 
-				block_descriptor.uniform_variables.requested_partitionings = 1;
-				block_descriptor.uniform_variables.tune_partitoning_candidate_limit = 1;
-            }
-            else {
-                block_descriptor.uniform_variables.requested_partitionings = TUNE_MAX_PARTITIONING_CANDIDATES;
-                block_descriptor.uniform_variables.tune_partitoning_candidate_limit = TUNE_MAX_PARTITIONING_CANDIDATE_LIMIT;
-            }
+void ASTCEncoder::writeUniformSlots(uint32_t batch_block_count) {
 
-            block_descriptor.uniform_variables.partition_count = p_count;
-            block_descriptor.uniform_variables.tune_candidate_limit = TUNE_MAX_TRIAL_CANDIDATES;
-            block_descriptor.uniform_variables.quant_limit = QUANT_32;
+    // Every partition count gets its own copy of the uniforms, selected with a dynamic offset when binding
+    std::vector<uint8_t> uniformSlots(BLOCK_MAX_PARTITIONS * UNIFORM_SLOT_STRIDE, 0);
 
-            queue.WriteBuffer(uniformsBuffer, 0, &block_descriptor.uniform_variables, sizeof(uniform_variables));
+    block_descriptor& block_descriptor = session->block_descriptor;
 
-            int decimation_modes_num = valid_decimation_modes.size();
-            int block_modes_num = valid_block_modes.size();
-            int numCandidates = block_descriptor.uniform_variables.tune_candidate_limit;
-            int current_partitioned_blocks_num = current_batch_size * block_descriptor.uniform_variables.requested_partitionings;
+    for (unsigned int p_count = 1; p_count <= 4; ++p_count) {
+        if (p_count == 1) {
+            block_descriptor.uniform_variables.requested_partitionings = 1;
+            block_descriptor.uniform_variables.tune_partitoning_candidate_limit = 1;
+        }
+        else {
+            block_descriptor.uniform_variables.requested_partitionings = TUNE_MAX_PARTITIONING_CANDIDATES;
+            block_descriptor.uniform_variables.tune_partitoning_candidate_limit = TUNE_MAX_PARTITIONING_CANDIDATE_LIMIT;
+        }
 
-            // Run the full compute pipeline
-            wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
+        block_descriptor.uniform_variables.partition_count = p_count;
+        block_descriptor.uniform_variables.tune_candidate_limit = TUNE_MAX_TRIAL_CANDIDATES;
+        block_descriptor.uniform_variables.quant_limit = QUANT_32;
+        block_descriptor.uniform_variables.tune_error_limit = session->tune_error_limit;
+        block_descriptor.uniform_variables.batch_block_count = batch_block_count;
 
-			//Pratitioning Passes (only for p_count > 1)
-            if (p_count > 1) {
-                { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass001_pipeline); pass.SetBindGroup(0, pass001_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_batch_size, 1, 1); pass.End(); }
+        memcpy(uniformSlots.data() + (p_count - 1) * UNIFORM_SLOT_STRIDE, &block_descriptor.uniform_variables, sizeof(uniform_variables));
+    }
 
-                for (int i = 0; i < 4; i++) {
-                    { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass002_pipeline); pass.SetBindGroup(0, pass002_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_batch_size, 1, 1); pass.End(); }
-                    { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass003_pipeline); pass.SetBindGroup(0, pass003_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_batch_size, 1, 1); pass.End(); }
-                }
+    queue.WriteBuffer(uniformsBuffer, 0, uniformSlots.data(), uniformSlots.size());
+}
 
-                { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass004_pipeline); pass.SetBindGroup(0, pass004_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_batch_size, 1, 1); pass.End(); }
-                { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass005_pipeline); pass.SetBindGroup(0, pass005_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_batch_size, 1, 1); pass.End(); }
-                { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass006_pipeline); pass.SetBindGroup(0, pass006_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_batch_size, 1, 1); pass.End(); }
-                { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass007_pipeline); pass.SetBindGroup(0, pass007_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_batch_size, 1, 1); pass.End(); }
-            }
+void ASTCEncoder::submitBatch(BatchSlot& slot) {
 
+    uint32_t current_batch_size = slot.batchSize;
 
-            // Passes 1-9
-            { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass1_pipeline); pass.SetBindGroup(0, pass1_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, 1, 1); pass.End(); }
-            { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass2_pipeline); pass.SetBindGroup(0, pass2_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, decimation_modes_num, 1); pass.End(); }
-            { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass3_pipeline); pass.SetBindGroup(0, pass3_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, decimation_modes_num, 1); pass.End(); }
-            { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass4_pipeline); pass.SetBindGroup(0, pass4_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, decimation_modes_num, 1); pass.End(); }
-            { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass5_pipeline); pass.SetBindGroup(0, pass5_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, decimation_modes_num, 1); pass.End(); }
-            { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass6_pipeline); pass.SetBindGroup(0, pass6_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, block_modes_num, 1); pass.End(); }
-            { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass7_pipeline); pass.SetBindGroup(0, pass7_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, block_modes_num, 1); pass.End(); }
-            { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass8_pipeline); pass.SetBindGroup(0, pass8_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, 1, 1); pass.End(); }
-            { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass9_pipeline); pass.SetBindGroup(0, pass9_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, 1, 1); pass.End(); }
-
-            // Pass 10 (Color Endpoint Combinations) is different for partition counts
-            if (p_count > 1) {
-                wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
-                switch (p_count) {
-                case 2: pass.SetPipeline(pass10_pipeline_2part); break;
-                case 3: pass.SetPipeline(pass10_pipeline_3part); break;
-                case 4: pass.SetPipeline(pass10_pipeline_4part); break;
-                }
-                pass.SetBindGroup(0, pass10_bindGroup, 0, nullptr);
-                pass.DispatchWorkgroups(current_partitioned_blocks_num, 1, 1);
-                pass.End();
+    TRACE_SPAN("submitBatch");
+
+    // Queue ordered, so batches that are already submitted keep the values they were recorded with
+    {
+        TRACE_SPAN("WriteBuffer: uniforms");
+        writeUniformSlots(current_batch_size);
+    }
+
+    // All partition counts of the batch are recorded into a single command buffer (split only while pipelines are still compiling)
+    gpuProfiler.beginBatch(slot.queries);
+    wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
+
+    extraction_variables extraction = {};
+    extraction.image_width = textureWidth;
+    extraction.image_height = textureHeight;
+    extraction.blocks_x = blocksX;
+    extraction.first_block = slot.firstColumn;
+    extraction.first_row = slot.firstRow;
+    extraction.xdim = blockXDim;
+    extraction.ydim = blockYDim;
+    extraction.block_count = current_batch_size;
+    {
+        TRACE_SPAN("WriteBuffer: extraction uniforms");
+        queue.WriteBuffer(extractionUniformsBuffer, 0, &extraction, sizeof(extraction_variables));
+    }
+
+    std::optional<TraceSpan> recording;
+    recording.emplace("record commands");
+
+    // Pass 000 (gathers the input blocks of the batch from the uploaded image rows)
+    encoder.CopyBufferToBuffer(slot.inputStagingBuffer, 0, imageRowsBuffer, 0, slot.rowBytes);
+    { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass000", 0); pass.SetPipeline(pass000_pipeline); pass.SetBindGroup(0, pass000_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_batch_size, 1, 1); pass.End(); }
+
+    // Iterate through all supported partition counts
+    for (unsigned int p_count = 1; p_count <= 4; ++p_count) {
+        ASTC_LOG(LogLevel::Debug, "Compressing with " << p_count << " partition(s)...");
+
+        // Pipelines of higher partition counts can still be compiling right after init, the work recorded so far
+        // is submitted first so the GPU starts on it while they finish
+        if (!pipelinesReady(p_count)) {
+            recording.reset();
+            wgpu::CommandBuffer commands = encoder.Finish();
+            {
+                TRACE_SPAN("Submit");
+                queue.Submit(1, &commands);
             }
 
-            // Pass 11 (Best Combination for Mode) Is different for partition counts
             {
-                wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
-                switch (p_count) {
-                case 1: pass.SetPipeline(pass11_pipeline_1part); pass.SetBindGroup(0, pass11_bindGroup_1part, 0, nullptr); break;
-                case 2: pass.SetPipeline(pass11_pipeline_2part); pass.SetBindGroup(0, pass11_bindGroup_234part, 0, nullptr); break;
-                case 3: pass.SetPipeline(pass11_pipeline_3part); pass.SetBindGroup(0, pass11_bindGroup_234part, 0, nullptr); break;
-                case 4: pass.SetPipeline(pass11_pipeline_4part); pass.SetBindGroup(0, pass11_bindGroup_234part, 0, nullptr); break;
-                }
-                pass.DispatchWorkgroups(current_partitioned_blocks_num, block_modes_num, 1);
-                pass.End();
+                TRACE_SPAN("wait for pipelines");
+                waitForPipelines(p_count);
             }
+            encoder = device.CreateCommandEncoder();
+            recording.emplace("record commands");
+        }
 
-            // Pass 12 (Find Top N Candidates)
-            { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass12_pipeline); pass.SetBindGroup(0, pass12_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, 1, 1); pass.End(); }
+        uint32_t uniformOffset = (p_count - 1) * UNIFORM_SLOT_STRIDE;
 
-            // Passes 13-17 (Refinement Loop)
-            for (int a = 0; a < 6; a++) {
-                { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass13_pipeline); pass.SetBindGroup(0, pass13_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, numCandidates, 1); pass.End(); }
-                { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass14_pipeline); pass.SetBindGroup(0, pass14_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, numCandidates, 1); pass.End(); }
-                { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass15_pipeline); pass.SetBindGroup(0, pass15_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, numCandidates, 1); pass.End(); }
+        // Compaction: only blocks whose best encoding so far is not under the error limit are searched further,
+        // all following passes are dispatched indirectly with the sizes written here
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass008", p_count); pass.SetPipeline(pass008_pipeline); pass.SetBindGroup(0, pass008_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroups(1, 1, 1); pass.End(); }
 
-                if (a == 0) {
-                    { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass17_pipeline); pass.SetBindGroup(0, pass17_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, numCandidates, 1); pass.End(); }
-                }
+		//Pratitioning Passes (only for p_count > 1)
+        if (p_count > 1) {
+            { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass001", p_count); pass.SetPipeline(pass001_pipeline); pass.SetBindGroup(0, pass001_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_BLOCKS); pass.End(); }
 
-                { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass16_pipeline); pass.SetBindGroup(0, pass16_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, numCandidates, 1); pass.End(); }
-                { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass17_pipeline); pass.SetBindGroup(0, pass17_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, numCandidates, 1); pass.End(); }
+            for (int i = 0; i < 4; i++) {
+                { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass002", p_count); pass.SetPipeline(pass002_pipeline); pass.SetBindGroup(0, pass002_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_BLOCKS); pass.End(); }
+                { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass003", p_count); pass.SetPipeline(pass003_pipeline); pass.SetBindGroup(0, pass003_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_BLOCKS); pass.End(); }
             }
 
-            // Pass 18
-            { wgpu::ComputePassEncoder pass = encoder.BeginComputePass(); pass.SetPipeline(pass18_pipeline); pass.SetBindGroup(0, pass18_bindGroup, 0, nullptr); pass.DispatchWorkgroups(current_partitioned_blocks_num, 1, 1); pass.End(); }
-
-
-            // Read data from the final output buffer
-            encoder.CopyBufferToBuffer(pass18_output_symbolicBlocks, 0, outputReadbackBuffer, 0, current_partitioned_blocks_num * sizeof(SymbolicBlock));
-            wgpu::CommandBuffer commands = encoder.Finish();
-            queue.Submit(1, &commands);
+            { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass004", p_count); pass.SetPipeline(pass004_pipeline); pass.SetBindGroup(0, pass004_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_BLOCKS); pass.End(); }
+            { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass005", p_count); pass.SetPipeline(pass005_pipeline); pass.SetBindGroup(0, pass005_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_BLOCKS); pass.End(); }
+            { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass006", p_count); pass.SetPipeline(pass006_pipeline); pass.SetBindGroup(0, pass006_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_BLOCKS); pass.End(); }
+            { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass007", p_count); pass.SetPipeline(pass007_pipeline); pass.SetBindGroup(0, pass007_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_BLOCKS); pass.End(); }
+        }
 
-            std::vector<SymbolicBlock> current_results(current_partitioned_blocks_num);
-            mapOutputBufferSync<SymbolicBlock>(device, outputReadbackBuffer, current_partitioned_blocks_num, current_results);
 
+        // Passes 1-9
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass1", p_count); pass.SetPipeline(pass1_pipeline[p_count - 1]); pass.SetBindGroup(0, pass1_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_PARTITIONED_BLOCKS); pass.End(); }
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass2", p_count); pass.SetPipeline(pass2_pipeline); pass.SetBindGroup(0, pass2_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_DECIMATION_MODES); pass.End(); }
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass3", p_count); pass.SetPipeline(pass3_pipeline); pass.SetBindGroup(0, pass3_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_DECIMATION_MODES); pass.End(); }
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass4", p_count); pass.SetPipeline(pass4_pipeline); pass.SetBindGroup(0, pass4_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_DECIMATION_MODES); pass.End(); }
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass5", p_count); pass.SetPipeline(pass5_pipeline); pass.SetBindGroup(0, pass5_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_DECIMATION_MODES); pass.End(); }
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass6", p_count); pass.SetPipeline(pass6_pipeline); pass.SetBindGroup(0, pass6_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_BLOCK_MODES); pass.End(); }
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass7", p_count); pass.SetPipeline(pass7_pipeline); pass.SetBindGroup(0, pass7_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_BLOCK_MODES); pass.End(); }
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass8", p_count); pass.SetPipeline(pass8_pipeline[p_count - 1]); pass.SetBindGroup(0, pass8_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_PARTITIONED_BLOCKS); pass.End(); }
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass9", p_count); pass.SetPipeline(pass9_pipeline[p_count - 1]); pass.SetBindGroup(0, pass9_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_PARTITIONED_BLOCKS); pass.End(); }
+
+        // Pass 10 (Color Endpoint Combinations) is different for partition counts
+        if (p_count > 1) {
+            wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass10", p_count);
+            switch (p_count) {
+            case 2: pass.SetPipeline(pass10_pipeline_2part); break;
+            case 3: pass.SetPipeline(pass10_pipeline_3part); break;
+            case 4: pass.SetPipeline(pass10_pipeline_4part); break;
+            }
+            pass.SetBindGroup(0, pass10_bindGroup, 1, &uniformOffset);
+            pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_PARTITIONED_BLOCKS);
+            pass.End();
+        }
 
-            //Choose the best partitioning candidate for each block & compare to the current best
-            for (uint32_t i = 0; i < current_batch_size; ++i) {
-                int start_offset = i * block_descriptor.uniform_variables.requested_partitionings;
-                int end_offset = (i + 1) * block_descriptor.uniform_variables.requested_partitionings;
+        // Pass 11 (Best Combination for Mode) Is different for partition counts
+        {
+            wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass11", p_count);
+            switch (p_count) {
+            case 1: pass.SetPipeline(pass11_pipeline_1part); pass.SetBindGroup(0, pass11_bindGroup_1part, 1, &uniformOffset); break;
+            case 2: pass.SetPipeline(pass11_pipeline_2part); pass.SetBindGroup(0, pass11_bindGroup_234part, 1, &uniformOffset); break;
+            case 3: pass.SetPipeline(pass11_pipeline_3part); pass.SetBindGroup(0, pass11_bindGroup_234part, 1, &uniformOffset); break;
+            case 4: pass.SetPipeline(pass11_pipeline_4part); pass.SetBindGroup(0, pass11_bindGroup_234part, 1, &uniformOffset); break;
+            }
+            pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_BLOCK_MODES);
+            pass.End();
+        }
 
-                if (start_offset >= end_offset)
-                    continue; // No candidates for this block
+        // Pass 12 (Find Top N Candidates)
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass12", p_count); pass.SetPipeline(pass12_pipeline); pass.SetBindGroup(0, pass12_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_PARTITIONED_BLOCKS); pass.End(); }
 
-                const SymbolicBlock* best_candidate_for_block = &current_results[start_offset];
-                for (int j = start_offset + 1; j < end_offset; ++j) {
-                    if (current_results[j].errorval < best_candidate_for_block->errorval) {
-                        best_candidate_for_block = &current_results[j];
-                    }
-                }
+        // Passes 13-17 (Refinement Loop)
+        for (int a = 0; a < 6; a++) {
+            { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass13", p_count); pass.SetPipeline(pass13_pipeline[p_count - 1]); pass.SetBindGroup(0, pass13_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_CANDIDATES); pass.End(); }
+            { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass14", p_count); pass.SetPipeline(pass14_pipeline[p_count - 1]); pass.SetBindGroup(0, pass14_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_CANDIDATES); pass.End(); }
+            { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass15", p_count); pass.SetPipeline(pass15_pipeline[p_count - 1]); pass.SetBindGroup(0, pass15_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_CANDIDATES); pass.End(); }
 
-                // Compare its error with the best overall encoding found so far
-                uint32_t global_block_index = batch_start + i;
-                if (best_candidate_for_block->errorval < best_symbolic_blocks[global_block_index].errorval) {
-                    best_symbolic_blocks[global_block_index] = *best_candidate_for_block;
-                }
+            if (a == 0) {
+                { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass17", p_count); pass.SetPipeline(pass17_pipeline[p_count - 1]); pass.SetBindGroup(0, pass17_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_CANDIDATES); pass.End(); }
             }
+
+            { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass16", p_count); pass.SetPipeline(pass16_pipeline[p_count - 1]); pass.SetBindGroup(0, pass16_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_CANDIDATES); pass.End(); }
+            { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass17", p_count); pass.SetPipeline(pass17_pipeline[p_count - 1]); pass.SetBindGroup(0, pass17_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_CANDIDATES); pass.End(); }
         }
 
+        // Pass 18 (keeps the best candidate of each block across partition counts)
+        { wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass18", p_count); pass.SetPipeline(pass18_pipeline); pass.SetBindGroup(0, pass18_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroupsIndirect(indirectArgsBuffer, INDIRECT_ARGS_BLOCKS); pass.End(); }
+    }
+
+    // Pass 19 (packs the best symbolic block of each block into its final 16 byte physical block)
+    {
+        uint32_t uniformOffset = 0;
+        uint32_t workgroupCount = (current_batch_size + 63) / 64;
+        wgpu::ComputePassEncoder pass = gpuProfiler.beginPass(encoder, slot.queries, "pass19", 0); pass.SetPipeline(pass19_pipeline); pass.SetBindGroup(0, pass19_bindGroup, 1, &uniformOffset); pass.DispatchWorkgroups(workgroupCount, 1, 1); pass.End();
     }
 
-    // Final physical encoding of the best symbolic blocks found
-    std::cout << "Performing final physical encoding..." << std::endl;
-    for (uint32_t i = 0; i < numBlocks; i++) {
-        int offset = i * 16;
-        uint8_t* outputBlock = dataOut + offset;
-        symbolic_to_physical(block_descriptor, best_symbolic_blocks[i], outputBlock);
+    // A single readback per batch, only the finished blocks
+    encoder.CopyBufferToBuffer(pass19_output_physicalBlocks, 0, slot.readbackBuffer, 0, current_batch_size * 16);
+    gpuProfiler.resolveBatch(encoder, slot.queries);
+    wgpu::CommandBuffer commands = encoder.Finish();
+    recording.reset();
+
+    TRACE_SPAN("Submit");
+    queue.Submit(1, &commands);
+}
+
+void ASTCEncoder::retireBatch(BatchSlot& slot, const BlockSink& blockSink) {
+
+    {
+        TRACE_SPAN("wait for readback");
+        StageTimer waitTimer(statistics.waitSeconds);
+        if (!waitForBufferMap(device, slot.readbackMap)) {
+            slot.inFlight = false;
+            throw std::runtime_error("Failed to map output readback buffer");
+        }
     }
 
-    std::cout << "Encoding complete." << std::endl;
-    
-    
+    // The blocks were already selected and packed on the GPU, they go straight to the sink
+    const uint8_t* results = static_cast<const uint8_t*>(slot.readbackBuffer.GetConstMappedRange(0, slot.batchSize * 16));
+    try {
+        TRACE_SPAN("write blocks");
+        StageTimer writeTimer(statistics.writeSeconds);
+        blockSink(slot.batchStart, slot.batchSize, results);
+    }
+    catch (...) {
+        slot.readbackBuffer.Unmap();
+        slot.inFlight = false;
+        throw;
+    }
+
+    slot.readbackBuffer.Unmap();
+    slot.inFlight = false;
+
+    gpuProfiler.collectBatch(slot.queries);
+}
+
+void ASTCEncoder::waitForBatchSlots() {
+    for (BatchSlot& slot : batchSlots) {
+        if (slot.inputStagingBuffer) {
+            waitForBufferMap(device, slot.inputMap);
+        }
+        if (slot.readbackBuffer) {
+            //results of a batch that was never retired (aborted encode) are dropped
+            if (waitForBufferMap(device, slot.readbackMap) && slot.inFlight) {
+                slot.readbackBuffer.Unmap();
+            }
+        }
+        gpuProfiler.dropBatch(slot.queries);
+        slot.inFlight = false;
+    }
 }
 
 ASTCEncoder::~ASTCEncoder() {
+    //pipelines still being created write into this encoder from their callbacks, let them finish first
+    //(not through waitForPipelines, which throws when one of them failed)
+    while (!pipelinesReady(BLOCK_MAX_PARTITIONS)) {
+#if defined(__EMSCRIPTEN__)
+        emscripten_sleep(1);
+#else
+        device.Tick();
+#endif
+    }
+
     // Release all WebGPU resources
+    releaseResources();
 }
\ No newline at end of file
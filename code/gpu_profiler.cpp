@@ -0,0 +1,264 @@
+#include "gpu_profiler.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "astc.h"
+#include "trace.h"
+
+bool GpuProfiler::requested() {
+	const char* value = std::getenv("ASTC_GPU_PROFILE");
+	return value != nullptr && value[0] != '\0' && strcmp(value, "0") != 0;
+}
+
+void GpuProfiler::attach(wgpu::DeviceDescriptor& deviceDescriptor, const wgpu::Adapter& adapter) {
+
+	static const wgpu::FeatureName timestampFeature = wgpu::FeatureName::TimestampQuery;
+
+	if (!requested()) {
+		return;
+	}
+
+	if (!adapter.HasFeature(timestampFeature)) {
+		ASTC_LOG(LogLevel::Warning, "GPU profiling requested, but the adapter does not support timestamp queries");
+		return;
+	}
+
+	deviceDescriptor.requiredFeatureCount = 1;
+	deviceDescriptor.requiredFeatures = &timestampFeature;
+}
+
+void GpuProfiler::init(const wgpu::Device& device) {
+	this->device = device;
+	enabled = requested() && device.HasFeature(wgpu::FeatureName::TimestampQuery);
+
+	if (enabled) {
+		ASTC_LOG(LogLevel::Info, "GPU profiling enabled");
+	}
+}
+
+void GpuProfiler::beginBatch(BatchQueries& queries) {
+
+	if (!enabled) {
+		return;
+	}
+
+	if (!queries.querySet) {
+		uint64_t resolveSize = (uint64_t)MAX_PASSES_PER_BATCH * 2 * sizeof(uint64_t);
+
+		wgpu::QuerySetDescriptor querySetDesc = {};
+		querySetDesc.label = "Pass timestamps";
+		querySetDesc.type = wgpu::QueryType::Timestamp;
+		querySetDesc.count = MAX_PASSES_PER_BATCH * 2;
+		queries.querySet = device.CreateQuerySet(&querySetDesc);
+
+		wgpu::BufferDescriptor resolveDesc = {};
+		resolveDesc.label = "Pass timestamps resolve buffer";
+		resolveDesc.size = resolveSize;
+		resolveDesc.usage = wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc;
+		queries.resolveBuffer = device.CreateBuffer(&resolveDesc);
+
+		wgpu::BufferDescriptor readbackDesc = {};
+		readbackDesc.label = "Pass timestamps readback buffer";
+		readbackDesc.size = resolveSize;
+		readbackDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+		queries.readbackBuffer = device.CreateBuffer(&readbackDesc);
+	}
+
+	queries.passes.clear();
+}
+
+wgpu::ComputePassEncoder GpuProfiler::beginPass(const wgpu::CommandEncoder& encoder, BatchQueries& queries, const char* pass, uint32_t partitionCount) {
+
+	if (!enabled) {
+		return encoder.BeginComputePass();
+	}
+
+	if (queries.passes.size() >= MAX_PASSES_PER_BATCH) {
+		droppedPasses++;
+		return encoder.BeginComputePass();
+	}
+
+	uint32_t query = static_cast<uint32_t>(queries.passes.size()) * 2;
+	queries.passes.push_back(passIndex(pass, partitionCount));
+
+	wgpu::ComputePassTimestampWrites timestampWrites = {};
+	timestampWrites.querySet = queries.querySet;
+	timestampWrites.beginningOfPassWriteIndex = query;
+	timestampWrites.endOfPassWriteIndex = query + 1;
+
+	wgpu::ComputePassDescriptor passDesc = {};
+	passDesc.label = pass;
+	passDesc.timestampWrites = &timestampWrites;
+	return encoder.BeginComputePass(&passDesc);
+}
+
+void GpuProfiler::resolveBatch(const wgpu::CommandEncoder& encoder, BatchQueries& queries) {
+
+	if (!enabled || queries.passes.empty()) {
+		return;
+	}
+
+	uint32_t queryCount = static_cast<uint32_t>(queries.passes.size()) * 2;
+	encoder.ResolveQuerySet(queries.querySet, 0, queryCount, queries.resolveBuffer, 0);
+	encoder.CopyBufferToBuffer(queries.resolveBuffer, 0, queries.readbackBuffer, 0, (uint64_t)queryCount * sizeof(uint64_t));
+}
+
+void GpuProfiler::mapBatch(BatchQueries& queries) {
+
+	if (!enabled || queries.passes.empty()) {
+		return;
+	}
+
+	mapBufferAsync(queries.readbackBuffer, wgpu::MapMode::Read, queries.passes.size() * 2 * sizeof(uint64_t), &queries.readbackMap);
+	queries.pending = true;
+}
+
+void GpuProfiler::collectBatch(BatchQueries& queries) {
+
+	if (!queries.pending) {
+		return;
+	}
+	queries.pending = false;
+
+	if (!waitForBufferMap(device, queries.readbackMap)) {
+		ASTC_LOG(LogLevel::Warning, "Failed to map the pass timestamps");
+		return;
+	}
+
+	size_t size = queries.passes.size() * 2 * sizeof(uint64_t);
+	const uint64_t* timestamps = static_cast<const uint64_t*>(queries.readbackBuffer.GetConstMappedRange(0, size));
+
+	for (size_t i = 0; i < queries.passes.size(); i++) {
+		uint64_t begin = timestamps[i * 2];
+		uint64_t end = timestamps[i * 2 + 1];
+
+		//totals reset while the batch was in flight
+		if (queries.passes[i] >= passTimes.size()) {
+			continue;
+		}
+
+		//timestamps are not guaranteed to be monotonic, a pass that went backwards counts as 0
+		PassTimes& times = passTimes[queries.passes[i]];
+		times.nanoseconds += end > begin ? end - begin : 0;
+		times.dispatches++;
+	}
+
+	queries.readbackBuffer.Unmap();
+	batches++;
+}
+
+void GpuProfiler::dropBatch(BatchQueries& queries) {
+
+	if (!queries.pending) {
+		return;
+	}
+	queries.pending = false;
+
+	if (waitForBufferMap(device, queries.readbackMap)) {
+		queries.readbackBuffer.Unmap();
+	}
+}
+
+uint32_t GpuProfiler::passIndex(const char* pass, uint32_t partitionCount) {
+
+	for (uint32_t i = 0; i < passTimes.size(); i++) {
+		if (passTimes[i].partitionCount == partitionCount && passTimes[i].name == pass) {
+			return i;
+		}
+	}
+
+	PassTimes times;
+	times.name = pass;
+	times.partitionCount = partitionCount;
+	passTimes.push_back(times);
+	return static_cast<uint32_t>(passTimes.size() - 1);
+}
+
+void GpuProfiler::printReport() const {
+
+	if (!enabled) {
+		return;
+	}
+
+	//rows are the passes in recording order, columns the partition counts (passes outside the loop only have a total)
+	std::vector<std::string> names;
+	for (const PassTimes& times : passTimes) {
+		bool known = false;
+		for (const std::string& name : names) {
+			known |= name == times.name;
+		}
+		if (!known) {
+			names.push_back(times.name);
+		}
+	}
+
+	double partitionTotals[BLOCK_MAX_PARTITIONS + 1] = {};
+	double total = 0.0;
+	char line[160];
+
+	std::cout << "--- GPU time per pass (" << batches << " batches, ms) ---" << std::endl;
+	snprintf(line, sizeof(line), "%-10s %10s %10s %10s %10s %10s %7s", "pass", "1 part", "2 parts", "3 parts", "4 parts", "total", "share");
+	std::cout << line << std::endl;
+
+	double grandTotal = 0.0;
+	for (const PassTimes& times : passTimes) {
+		grandTotal += times.nanoseconds * 1e-6;
+	}
+
+	for (const std::string& name : names) {
+		double columns[BLOCK_MAX_PARTITIONS + 1] = {};
+		bool used[BLOCK_MAX_PARTITIONS + 1] = {};
+		double passTotal = 0.0;
+
+		for (const PassTimes& times : passTimes) {
+			if (times.name != name) {
+				continue;
+			}
+			double milliseconds = times.nanoseconds * 1e-6;
+			columns[times.partitionCount] += milliseconds;
+			used[times.partitionCount] = true;
+			partitionTotals[times.partitionCount] += milliseconds;
+			passTotal += milliseconds;
+		}
+
+		char cells[BLOCK_MAX_PARTITIONS][16];
+		for (unsigned int p = 1; p <= BLOCK_MAX_PARTITIONS; p++) {
+			if (used[p]) {
+				snprintf(cells[p - 1], sizeof(cells[p - 1]), "%.3f", columns[p]);
+			}
+			else {
+				snprintf(cells[p - 1], sizeof(cells[p - 1]), "-");
+			}
+		}
+
+		snprintf(line, sizeof(line), "%-10s %10s %10s %10s %10s %10.3f %6.1f%%", name.c_str(), cells[0], cells[1], cells[2], cells[3],
+			passTotal, grandTotal > 0.0 ? passTotal * 100.0 / grandTotal : 0.0);
+		std::cout << line << std::endl;
+		total += passTotal;
+	}
+
+	snprintf(line, sizeof(line), "%-10s %10.3f %10.3f %10.3f %10.3f %10.3f", "total", partitionTotals[1], partitionTotals[2], partitionTotals[3],
+		partitionTotals[4], total);
+	std::cout << line << std::endl;
+
+	if (droppedPasses > 0) {
+		std::cout << droppedPasses << " passes were not timed (more than " << MAX_PASSES_PER_BATCH << " in a batch)" << std::endl;
+	}
+	std::cout << "-------------------------------------------" << std::endl;
+}
+
+void GpuProfiler::reset() {
+	passTimes.clear();
+	batches = 0;
+	droppedPasses = 0;
+}
+
+void GpuProfiler::releaseResources(BatchQueries& queries) {
+	if (queries.readbackBuffer) queries.readbackBuffer.Destroy();
+	if (queries.resolveBuffer) queries.resolveBuffer.Destroy();
+	if (queries.querySet) queries.querySet.Destroy();
+	queries = BatchQueries();
+}
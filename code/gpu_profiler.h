@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <webgpu/webgpu.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include "webgpu_utils.h"
+
+/**
+ * @brief GPU time of every compute pass of the encoder, measured with timestamp queries.
+ *
+ * Profiling is opt in (ASTC_GPU_PROFILE=1) and needs a device with the timestamp query feature. Each pass writes a
+ * timestamp at its beginning and end into the query set of its batch slot. The timestamps are resolved behind the
+ * last pass of the batch, read back together with its blocks and summed up per pass and partition count over all
+ * batches until the next reset.
+ */
+class GpuProfiler {
+public:
+	//most passes of one batch that get timestamps, a batch records about 220
+	static const uint32_t MAX_PASSES_PER_BATCH = 512;
+
+	/**
+	 * @brief Timestamp queries of one batch slot.
+	 */
+	struct BatchQueries {
+		wgpu::QuerySet querySet;
+		wgpu::Buffer resolveBuffer;
+		wgpu::Buffer readbackBuffer;
+		BufferMapState readbackMap;
+
+		std::vector<uint32_t> passes; //pass of every timestamp pair, in recording order
+		bool pending = false; //resolved and mapping, not collected yet
+	};
+
+	//true if profiling is requested with ASTC_GPU_PROFILE
+	static bool requested();
+
+	/**
+	 * @brief Request the timestamp query feature in a device descriptor.
+	 *
+	 * Does nothing if profiling is not requested or the adapter does not support the feature.
+	 */
+	static void attach(wgpu::DeviceDescriptor& deviceDescriptor, const wgpu::Adapter& adapter);
+
+	//enables the profiler if profiling is requested and the device was created with the timestamp query feature
+	void init(const wgpu::Device& device);
+
+	bool isEnabled() const { return enabled; }
+
+	//clears the passes of the previous batch of the slot, the query resources are created on first use
+	void beginBatch(BatchQueries& queries);
+
+	//begins a compute pass with timestamp writes, partitionCount is 0 for the passes outside the partition count loop
+	wgpu::ComputePassEncoder beginPass(const wgpu::CommandEncoder& encoder, BatchQueries& queries, const char* pass, uint32_t partitionCount);
+
+	//records the resolve of the timestamps into the readback buffer, after the last pass of the batch
+	void resolveBatch(const wgpu::CommandEncoder& encoder, BatchQueries& queries);
+
+	//starts mapping the timestamps, once the batch is submitted
+	void mapBatch(BatchQueries& queries);
+
+	//adds the pass times of a finished batch to the totals
+	void collectBatch(BatchQueries& queries);
+
+	//drops the timestamps of a batch that was aborted
+	void dropBatch(BatchQueries& queries);
+
+	/**
+	 * @brief Print the GPU time per pass and partition count, and the totals of every partition count.
+	 */
+	void printReport() const;
+
+	void reset();
+
+	void releaseResources(BatchQueries& queries);
+
+private:
+	struct PassTimes {
+		std::string name;
+		uint32_t partitionCount;
+		uint64_t nanoseconds = 0;
+		uint64_t dispatches = 0;
+	};
+
+	uint32_t passIndex(const char* pass, uint32_t partitionCount);
+
+	wgpu::Device device;
+	bool enabled = false;
+
+	std::vector<PassTimes> passTimes; //in the order the passes were first recorded
+	uint64_t batches = 0;
+	uint64_t droppedPasses = 0; //passes beyond MAX_PASSES_PER_BATCH
+};
@@ -0,0 +1,104 @@
+#include <algorithm>
+
+#include "astc.h"
+#include "trace.h"
+
+//host side block extraction, kept apart from the pipeline so tools can use it without WebGPU
+
+std::vector<InputBlock> SplitImageIntoBlocks(
+    uint8_t* imageData,
+    int width,
+    int height,
+    int blockWidth,
+    int blockHeight
+) {
+
+    size_t blocksX = (width + blockWidth - 1) / blockWidth;
+    size_t blocksY = (height + blockHeight - 1) / blockHeight;
+
+    std::vector<InputBlock> blocks(blocksX * blocksY);
+
+    SplitImageIntoBlocks(imageData, width, height, blockWidth, blockHeight, 0, static_cast<uint32_t>(blocks.size()), blocks.data());
+
+    return blocks;
+}
+
+void SplitImageIntoBlocks(
+    const uint8_t* imageData,
+    int width,
+    int height,
+    int blockWidth,
+    int blockHeight,
+    uint64_t firstBlock,
+    uint32_t blockCount,
+    InputBlock* blocksOut
+) {
+    TRACE_SPAN("SplitImageIntoBlocks");
+
+    uint64_t blocksX = (width + blockWidth - 1) / blockWidth;
+
+    for (uint32_t i = 0; i < blockCount; ++i) {
+        int bx = static_cast<int>((firstBlock + i) % blocksX);
+        int by = static_cast<int>((firstBlock + i) / blocksX);
+
+        InputBlock& block = blocksOut[i];
+        block = {};
+
+        float alpha_min = 1e38f;
+        float alpha_max = 0;
+
+        bool grayscale = true;
+
+        int pixelIndex = 0;
+        for (int dy = 0; dy < blockHeight; ++dy) {
+
+            int y = by * blockHeight + dy;
+            int clamped_y = std::min(y, height - 1);
+
+            for (int dx = 0; dx < blockWidth; ++dx) {
+
+                int x = bx * blockWidth + dx;
+                int clamped_x = std::min(x, width - 1);
+
+                size_t idx = ((size_t)clamped_y * width + clamped_x) * 4;
+
+
+                for (int c = 0; c < 4; c++) {
+                    float channel_value = imageData[idx + c] * UNORM8_TO_CHANNEL;
+
+                    block.pixels[pixelIndex][c] = channel_value;
+
+                    if (c == 3) {
+                        alpha_max = std::max(alpha_max, channel_value);
+                        alpha_min = std::min(alpha_min, channel_value);
+                    }
+                }
+
+                grayscale = grayscale && (block.pixels[pixelIndex][0] == block.pixels[pixelIndex][1] && block.pixels[pixelIndex][0] == block.pixels[pixelIndex][2]);
+
+                block.texel_partitions[pixelIndex] = 0;
+
+                ++pixelIndex;
+            }
+        }
+
+        if (grayscale) {
+            block.grayscale = 1;
+        }
+        else {
+            block.grayscale = 0;
+        }
+
+        if (alpha_max == alpha_min) {
+            block.constant_alpha = 1;
+        }
+        else {
+            block.constant_alpha = 0;
+        }
+
+        block.partition_pixel_counts[0] = blockWidth * blockHeight;
+        block.partition_pixel_counts[1] = 0;
+        block.partition_pixel_counts[2] = 0;
+        block.partition_pixel_counts[3] = 0;
+    }
+}
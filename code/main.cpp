@@ -6,11 +6,6 @@
 #include <emscripten/bind.h>
 #endif
 
-#if !defined(EMSCRIPTEN)
-#include <set>
-#include <utility>
-#endif
-
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
@@ -20,9 +15,23 @@
 #include <cstring>
 #include <string>
 
-#include "webgpu_utils.h"
-#include "astc.h"
+#if !defined(EMSCRIPTEN)
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <set>
+#endif
+
 #include "astc_store.h"
+#include "trace.h"
+
+#if defined(EMSCRIPTEN)
+#include "webgpu_utils.h"
+#include "astc_encoder.h"
 
 using namespace wgpu;
 
@@ -32,6 +41,9 @@ Device device = nullptr;
 ASTCEncoder* encoder = nullptr;
 int image_width = 0;
 int image_height = 0;
+#else
+#include "astcgpu.h"
+#endif
 
 struct ImageData {
     uint8_t* pixels;
@@ -42,6 +54,7 @@ struct ImageData {
 
 // Loads an image from file into RGBA8 format
 ImageData LoadImageRGBA(const std::string& filename) {
+    TRACE_SPAN("LoadImageRGBA");
     ImageData image;
     image.pixels = stbi_load(filename.c_str(), &image.width, &image.height, &image.channels, 4);
 
@@ -81,16 +94,12 @@ extern "C" EMSCRIPTEN_KEEPALIVE void process_image(uintptr_t data, size_t size,
 
 	encoder->secondaryInit(width, height, blockXDim, blockYDim);
 
-    unsigned int blocksX = encoder->blocksX;
-    unsigned int blocksY = encoder->blocksY;
-    size_t dataLen = blocksX * blocksY * 16;
-    uint8_t* dataOut = new uint8_t[dataLen];
-
+    size_t dataLen = (size_t)(encoder->numBlocks * 16);
 
-    encoder->encode(image_data, dataOut, dataLen);
+    //the blocks are encoded straight into the file, behind its header
+	AstcFile astcFile = create_astc_file_in_memory(blockXDim, blockYDim, width, height, dataLen);
 
-
-	AstcFile astcFile = create_astc_file_in_memory(blockXDim, blockYDim, width, height, dataOut, dataLen);
+    encoder->encode(image_data, astcFile.blocks(), dataLen);
 
     // Expose the compressed data to JavaScript for download
 	EM_ASM_({
@@ -113,25 +122,237 @@ extern "C" EMSCRIPTEN_KEEPALIVE void process_image(uintptr_t data, size_t size,
 	EM_ASM_({
 			window.onCompressionFinished(true);
 	});
-
-
-    delete[] dataOut;
 }
 #endif
 
 #if !defined(EMSCRIPTEN)
-bool is_valid_astc_block_size(unsigned int block_x, unsigned int block_y) {
-	// Use a static const set for efficient, one-time initialization and fast lookups.
-	static const std::set<std::pair<unsigned int, unsigned int>> valid_sizes = {
-		// The official list of 2D block sizes
-		{4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6},
-		{10, 5}, {10, 6}, {8, 8}, {10, 8}, {10, 10}, {12, 10}, {12, 12}
-	};
-
-	return valid_sizes.count({ block_x, block_y }) > 0;
+//images decoded ahead of the one being encoded, and finished images being written at the same time
+static const size_t BATCH_DECODE_AHEAD = 4;
+static const size_t BATCH_WRITES_IN_FLIGHT = 4;
+
+//write_blocks callback of the library, the blocks go straight into the .astc output
+static int writeOutputBlocks(void* userdata, uint64_t firstBlock, uint32_t blockCount, const uint8_t* blocks) {
+	try {
+		static_cast<AstcOutput*>(userdata)->writeBlocks(firstBlock, blockCount, blocks);
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
 }
-#endif
 
+//files of a batch directory that stb_image can decode
+static bool isImageFile(const std::filesystem::path& path) {
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+
+	static const char* extensions[] = { ".png", ".jpg", ".jpeg", ".bmp", ".tga", ".psd", ".gif", ".hdr", ".pic", ".pgm", ".ppm" };
+	for (const char* imageExtension : extensions) {
+		if (extension == imageExtension) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//inputs of a batch: the images of a directory (sorted by name), or one path per line of a list file
+static std::vector<std::string> collectBatchInputs(const std::string& source) {
+	std::vector<std::string> inputs;
+
+	if (std::filesystem::is_directory(source)) {
+		for (const auto& entry : std::filesystem::directory_iterator(source)) {
+			if (entry.is_regular_file() && isImageFile(entry.path())) {
+				inputs.push_back(entry.path().string());
+			}
+		}
+		std::sort(inputs.begin(), inputs.end());
+		return inputs;
+	}
+
+	std::ifstream list(source);
+	if (!list) {
+		throw std::runtime_error("Could not open batch list: " + source);
+	}
+
+	std::string line;
+	while (std::getline(list, line)) {
+		//trailing whitespace (and the \r of windows line endings) is not part of the path
+		line.erase(line.find_last_not_of(" \t\r\n") + 1);
+		if (!line.empty() && line[0] != '#') {
+			inputs.push_back(line);
+		}
+	}
+	return inputs;
+}
+
+/**
+ * @brief Encode many images with one device and encoder.
+ *
+ * The next images are decoded on background threads while the GPU encodes the current one, and the finished
+ * images are written to disk on background threads as well, so the encoder is not kept waiting by file IO.
+ */
+static int runBatch(const std::string& source, const std::string& outputDirectory, unsigned int blockXDim, unsigned int blockYDim) {
+
+	std::vector<std::string> inputs;
+	try {
+		inputs = collectBatchInputs(source);
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+
+	if (inputs.empty()) {
+		std::cerr << "Error: No images found in " << source << std::endl;
+		return 1;
+	}
+
+	//outputs are named after the inputs, inputs that would overwrite the output of an earlier one are skipped
+	std::vector<std::string> outputs;
+	std::set<std::string> outputPaths;
+	uint32_t failures = 0;
+
+	for (size_t i = 0; i < inputs.size();) {
+		std::string outputPath = (std::filesystem::path(outputDirectory) / std::filesystem::path(inputs[i]).stem()).string() + ".astc";
+		if (!outputPaths.insert(outputPath).second) {
+			std::cerr << "Skipping " << inputs[i] << ", " << outputPath << " is already written by another input" << std::endl;
+			inputs.erase(inputs.begin() + i);
+			failures++;
+			continue;
+		}
+		outputs.push_back(outputPath);
+		i++;
+	}
+
+	std::error_code directoryError;
+	std::filesystem::create_directories(outputDirectory, directoryError);
+	if (directoryError) {
+		std::cerr << "Error: Could not create output directory " << outputDirectory << ": " << directoryError.message() << std::endl;
+		return 1;
+	}
+
+	std::cout << "--- ASTC Batch Encoding ---" << std::endl;
+	std::cout << "  Images: " << inputs.size() << std::endl;
+	std::cout << "  Output: " << outputDirectory << std::endl;
+	std::cout << "  Block Size: " << blockXDim << "x" << blockYDim << std::endl;
+	std::cout << "---------------------------" << std::endl;
+
+	astcgpu_context* context = nullptr;
+	astcgpu_status status = astcgpu_context_create(nullptr, &context);
+	if (status != ASTCGPU_SUCCESS) {
+		std::cerr << "Could not create the encoder: " << astcgpu_status_string(status) << " (" << astcgpu_get_last_error(nullptr) << ")" << std::endl;
+		return 1;
+	}
+
+	auto batchStart = std::chrono::steady_clock::now();
+
+	std::deque<std::future<ImageData>> decodes;
+	std::deque<std::future<bool>> writes;
+	size_t nextDecode = 0;
+
+	uint64_t pixelsEncoded = 0;
+
+	for (size_t i = 0; i < inputs.size(); i++) {
+
+		//keep the decode queue full, the image at the front is the one encoded next
+		while (nextDecode < inputs.size() && decodes.size() < BATCH_DECODE_AHEAD) {
+			decodes.push_back(std::async(std::launch::async, LoadImageRGBA, inputs[nextDecode]));
+			nextDecode++;
+		}
+
+		std::future<ImageData> decode = std::move(decodes.front());
+		decodes.pop_front();
+
+		std::string outputPath = outputs[i];
+
+		ImageData image = {};
+		try {
+			image = decode.get();
+		}
+		catch (const std::exception& e) {
+			std::cerr << "[" << i + 1 << "/" << inputs.size() << "] " << e.what() << std::endl;
+			failures++;
+			continue;
+		}
+
+		unsigned int width = image.width;
+		unsigned int height = image.height;
+
+		std::unique_ptr<AstcOutput> output;
+		try {
+			output = open_astc_output(blockXDim, blockYDim, width, height, outputPath);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "[" << i + 1 << "/" << inputs.size() << "] " << e.what() << std::endl;
+			FreeImage(image);
+			failures++;
+			continue;
+		}
+
+		//the blocks are written into the output as the batches finish
+		status = astcgpu_encode_to_callback(context, image.pixels, width, height, 0, blockXDim, blockYDim, writeOutputBlocks, output.get());
+		FreeImage(image);
+
+		if (status != ASTCGPU_SUCCESS) {
+			std::cerr << "[" << i + 1 << "/" << inputs.size() << "] Encoding " << inputs[i] << " failed: " << astcgpu_get_last_error(context) << std::endl;
+			failures++;
+			continue;
+		}
+
+		pixelsEncoded += (uint64_t)width * height;
+
+		astcgpu_statistics statistics;
+		astcgpu_get_statistics(context, &statistics);
+		std::cout << "[" << i + 1 << "/" << inputs.size() << "] " << inputs[i] << " (" << width << "x" << height << ") in "
+			<< statistics.last_encode_seconds * 1000.0 << " ms" << std::endl;
+
+		//closing the outputs (and flushing the streamed ones) happens in the background, the oldest is waited for
+		//when too many are in flight
+		if (writes.size() >= BATCH_WRITES_IN_FLIGHT) {
+			if (!writes.front().get()) {
+				failures++;
+			}
+			writes.pop_front();
+		}
+
+		writes.push_back(std::async(std::launch::async, [output = std::move(output), outputPath]() {
+			try {
+				output->finish();
+				return true;
+			}
+			catch (const std::exception& e) {
+				std::cerr << "Writing " << outputPath << " failed: " << e.what() << std::endl;
+				return false;
+			}
+		}));
+	}
+
+	for (std::future<bool>& write : writes) {
+		if (!write.get()) {
+			failures++;
+		}
+	}
+
+	std::chrono::duration<double> batchTime = std::chrono::steady_clock::now() - batchStart;
+
+	astcgpu_statistics statistics;
+	astcgpu_get_statistics(context, &statistics);
+	astcgpu_print_gpu_profile(context);
+	astcgpu_context_destroy(context);
+
+	double megapixels = pixelsEncoded / 1000000.0;
+	std::cout << "--- Batch complete ---" << std::endl;
+	std::cout << "  Encoded: " << statistics.images_encoded << " of " << inputs.size() << " images (" << megapixels << " MP)" << std::endl;
+	std::cout << "  Wall time: " << batchTime.count() << " s, " << megapixels / batchTime.count() << " MP/s" << std::endl;
+	if (statistics.encode_seconds > 0.0) {
+		std::cout << "  Encode time: " << statistics.encode_seconds << " s, " << megapixels / statistics.encode_seconds << " MP/s" << std::endl;
+	}
+	std::cout << "----------------------" << std::endl;
+
+	return failures == 0 ? 0 : 1;
+}
+#endif
 
 int main(int argc, char** argv) {
 
@@ -166,11 +387,13 @@ int main(int argc, char** argv) {
 		std::cout << "Description: " << (properties.description ? properties.description : "N/A") << std::endl;
 		std::cout << "--------------------" << std::endl;
 
+		RequiredLimits requiredLimits = getRequiredLimits(adapter);
+
 		DeviceDescriptor deviceDesc = {};
 		deviceDesc.nextInChain = nullptr;
 		deviceDesc.label = "My Device";
 		deviceDesc.requiredFeatureCount = 0;
-		deviceDesc.requiredLimits = nullptr;
+		deviceDesc.requiredLimits = &requiredLimits;
 		deviceDesc.defaultQueue.nextInChain = nullptr;
 		deviceDesc.defaultQueue.label = "The default queue";
 
@@ -222,32 +445,63 @@ int main(int argc, char** argv) {
 
 #else
 
-	if (argc != 5) {
-		std::cerr << "Usage: " << argv[0] << " <input_image> <output_image.astc> <block_x> <block_y>" << std::endl;
+	const char* program = argv[0];
+
+	// Options in front of the arguments of the mode
+	while (argc >= 3) {
+		std::string option = argv[1];
+		if (option == "--trace") {
+			traceStart(argv[2]);
+		}
+		else if (option == "--log-level") {
+			LogLevel level;
+			if (!parseLogLevel(argv[2], level)) {
+				std::cerr << "Error: Unknown log level " << argv[2] << " (error, warning, info or debug)." << std::endl;
+				return 1;
+			}
+			setLogLevel(level);
+		}
+		else {
+			break;
+		}
+		argv += 2;
+		argc -= 2;
+	}
+
+	bool batchMode = argc == 6 && std::string(argv[1]) == "--batch";
+
+	if (argc != 5 && !batchMode) {
+		std::cerr << "Usage: " << program << " [--trace <trace.json>] [--log-level <level>] <input_image> <output_image.astc> <block_x> <block_y>" << std::endl;
+		std::cerr << "       " << program << " [--trace <trace.json>] [--log-level <level>] --batch <list_file|image_directory> <output_directory> <block_x> <block_y>" << std::endl;
 		std::cerr << "NOTE: If debugging in VS Code, set these arguments in the '.vscode/launch.json' file." << std::endl;
 		return 1;
 	}
 
 	// Parse arguments from argv, regardless of build type.
-	std::string inputImagePath = argv[1];
-	std::string outputImagePath = argv[2];
+	int firstArg = batchMode ? 2 : 1;
+	std::string inputImagePath = argv[firstArg];
+	std::string outputImagePath = argv[firstArg + 1];
 	unsigned int blockXDim = 0;
 	unsigned int blockYDim = 0;
 	try {
-		blockXDim = std::stoi(argv[3]);
-		blockYDim = std::stoi(argv[4]);
+		blockXDim = std::stoi(argv[firstArg + 2]);
+		blockYDim = std::stoi(argv[firstArg + 3]);
 	}
 	catch (const std::exception& e) {
 		std::cerr << "Error: Invalid block dimensions. Please provide integers." << std::endl;
 		return 1;
 	}
 
-	if (!is_valid_astc_block_size(blockXDim, blockYDim)) {
+	if (!astcgpu_is_valid_block_size(blockXDim, blockYDim)) {
 		std::cerr << "Error: Invalid block size " << blockXDim << "x" << blockYDim << "." << std::endl;
 		std::cerr << "Please use one of the 14 supported ASTC 2D block dimensions (e.g., 4x4, 8x8, 10x10)." << std::endl;
 		return 1;
 	}
 
+	if (batchMode) {
+		return runBatch(inputImagePath, outputImagePath, blockXDim, blockYDim);
+	}
+
 	std::cout << "--- ASTC Encoder Starting ---" << std::endl;
 	std::cout << "  Input: " << inputImagePath << std::endl;
 	std::cout << "  Output: " << outputImagePath << std::endl;
@@ -256,90 +510,30 @@ int main(int argc, char** argv) {
 
 	std::cerr << "Preparing webgpu adapter..." << std::endl;
 
-	InstanceDescriptor desc = {};
-	desc.nextInChain = nullptr;
-
-	instance = CreateInstance(&desc);
-
-	if (!instance) {
-		std::cerr << "Could not initialize WebGPU!" << std::endl;
+	//the device is created by the library (with the pipeline cache of ASTC_PIPELINE_CACHE_DIR)
+	astcgpu_context* context = nullptr;
+	astcgpu_status status = astcgpu_context_create(nullptr, &context);
+	if (status != ASTCGPU_SUCCESS) {
+		std::cerr << "Could not create the encoder: " << astcgpu_status_string(status) << " (" << astcgpu_get_last_error(nullptr) << ")" << std::endl;
 		return 1;
 	}
 
-	RequestAdapterOptions adapterOpts = {};
-	adapterOpts.powerPreference = PowerPreference::HighPerformance;
-	adapterOpts.nextInChain = nullptr;
-	Adapter adapter = requestAdapterSync(instance, &adapterOpts);
-
-	if (!adapter) {
-		std::cerr << "Could not get adapter!" << std::endl;
-		return 1;
-	}
+	ImageData image = LoadImageRGBA(inputImagePath);
 
-	AdapterInfo properties = {};
-	properties.nextInChain = nullptr;
-	adapter.GetInfo(&properties);
-
-	std::cout << "--- Adapter Info ---" << std::endl;
-	std::cout << "Vendor: " << (properties.vendor ? properties.vendor : "N/A") << std::endl;
-	std::cout << "Architecture: " << (properties.architecture ? properties.architecture : "N/A") << std::endl;
-	std::cout << "Device: " << (properties.device ? properties.device : "N/A - by browser design") << std::endl;
-	std::cout << "Description: " << (properties.description ? properties.description : "N/A") << std::endl;
-	std::cout << "--------------------" << std::endl;
-
-	//clean up instance
-	//wgpuInstanceRelease(instance);	
-
-	std::cout << "Requesting device..." << std::endl;
-	DeviceDescriptor deviceDesc = {};
-	deviceDesc.nextInChain = nullptr;
-	deviceDesc.label = "My Device";
-	deviceDesc.requiredFeatureCount = 0;
-	deviceDesc.requiredLimits = nullptr;
-	deviceDesc.defaultQueue.nextInChain = nullptr;
-	deviceDesc.defaultQueue.label = "The default queue";
-
-	deviceDesc.deviceLostCallback = [](WGPUDeviceLostReason reason, char const* message, void* /* pUserData */) {
-		std::cout << "Device lost: reason " << reason;
-		if (message) std::cout << " (" << message << ")";
-		std::cout << std::endl;
-		};
+	//the output file is preallocated and the blocks are written into it as the batches finish
+	std::unique_ptr<AstcOutput> output = open_astc_output(blockXDim, blockYDim, image.width, image.height, outputImagePath);
 
-	device = requestDeviceSync(adapter, &deviceDesc);
+	status = astcgpu_encode_to_callback(context, image.pixels, image.width, image.height, 0, blockXDim, blockYDim, writeOutputBlocks, output.get());
+	FreeImage(image);
+	astcgpu_print_gpu_profile(context);
+	astcgpu_context_destroy(context);
 
-	if (!device) {
-		std::cerr << "Could not get device!" << std::endl;
+	if (status != ASTCGPU_SUCCESS) {
+		std::cerr << "Encoding failed: " << astcgpu_status_string(status) << std::endl;
 		return 1;
 	}
 
-	auto onDeviceError = [](WGPUErrorType type, char const* message, void* /* pUserData */) {
-		std::cout << "Uncaptured device error: type " << type;
-		if (message) std::cout << " (" << message << ")";
-		std::cout << std::endl;
-		};
-	device.SetUncapturedErrorCallback(onDeviceError, nullptr /* pUserData */);
-
-    ImageData image = LoadImageRGBA(inputImagePath);
-
-	if (encoder) {
-		delete encoder;
-	}
-	encoder = new ASTCEncoder(device);
-
-	encoder->init();
-	encoder->secondaryInit(image.width, image.height, blockXDim, blockYDim);
-
-	unsigned int blocksX = encoder->blocksX;
-	unsigned int blocksY = encoder->blocksY;
-	size_t dataLen = blocksX * blocksY * 16; //number of blocks * 128 bits
-
-	uint8_t* dataOut = new uint8_t[dataLen];
-
-	encoder->encode(image.pixels, dataOut, dataLen);
-
-	store_image(blockXDim, blockYDim, image.width, image.height, dataOut, dataLen, outputImagePath);
-
-	FreeImage(image);
+	output->finish();
 #endif
 
 	return 0;
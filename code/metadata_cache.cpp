@@ -0,0 +1,663 @@
+#include "metadata_cache.h"
+#include "trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#if defined(ASTC_PREBUILT_METADATA)
+#include <prebuilt_metadata_bin.h>
+#endif
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif !defined(EMSCRIPTEN)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const uint32_t METADATA_CACHE_MAGIC = 0x4D435341; //"ASCM"
+
+//bump when the metadata construction or any of the serialized structs change
+static const uint32_t METADATA_CACHE_VERSION = 2;
+
+struct MetadataCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t block_x;
+	uint32_t block_y;
+
+	uint32_t layout_size; //size of the fixed sections, catches struct layout changes between builds
+	uint32_t texel_to_weight_count;
+	uint32_t weight_to_texel_count;
+	uint32_t padding;
+};
+
+static const uint32_t METADATA_BUNDLE_MAGIC = 0x42534D41; //"AMSB"
+
+struct MetadataBundleHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t padding;
+};
+
+struct MetadataBundleEntry {
+	uint32_t block_x;
+	uint32_t block_y;
+	uint32_t offset; //of the compressed image, from the start of the bundle
+	uint32_t compressed_size;
+	uint32_t expanded_size;
+	uint32_t padding;
+};
+
+//LZ scheme of the compressed images: every sequence is a token (literal count << 4 | match length - LZ_MIN_MATCH),
+//the literals and a 16 bit match offset. Counts of 15 continue in extra bytes of up to 255, the last sequence has no match.
+static const size_t LZ_MIN_MATCH = 4;
+static const size_t LZ_WINDOW = 65535;
+static const uint32_t LZ_HASH_BITS = 16;
+static const uint32_t LZ_MAX_CHAIN = 32;
+
+//fixed size sections of the block_descriptor, in serialization order (partitionings_GPU is a plain widened copy of
+//partitionings and is rebuilt when an image is loaded, which keeps the images and the prebuilt bundle smaller)
+#define METADATA_CACHE_SECTIONS(X) \
+	X(uniform_variables) \
+	X(decimation_info_metadata) \
+	X(decimation_modes) \
+	X(block_modes) \
+	X(block_mode_index) \
+	X(partitionings) \
+	X(partitioning_packed_index) \
+	X(kmeans_texels) \
+	X(partitioning_count_selected) \
+	X(partitioning_count_all) \
+	X(coverage_bitmaps_2) \
+	X(coverage_bitmaps_3) \
+	X(coverage_bitmaps_4)
+
+static uint32_t fixed_sections_size() {
+	size_t size = 0;
+#define METADATA_CACHE_SECTION_SIZE(name) size += sizeof(block_descriptor::name);
+	METADATA_CACHE_SECTIONS(METADATA_CACHE_SECTION_SIZE)
+#undef METADATA_CACHE_SECTION_SIZE
+	return static_cast<uint32_t>(size);
+}
+
+template<typename T>
+static void append_bytes(std::vector<uint8_t>& out, const T* data, size_t count) {
+	static_assert(std::is_trivially_copyable<T>::value, "cached metadata must be trivially copyable");
+
+	size_t offset = out.size();
+	out.resize(offset + count * sizeof(T));
+	if (count > 0) {
+		memcpy(out.data() + offset, data, count * sizeof(T));
+	}
+}
+
+template<typename T>
+static bool read_bytes(const uint8_t*& ptr, const uint8_t* end, T* data, size_t count) {
+	static_assert(std::is_trivially_copyable<T>::value, "cached metadata must be trivially copyable");
+
+	if (static_cast<size_t>(end - ptr) < count * sizeof(T)) {
+		return false;
+	}
+	if (count > 0) {
+		memcpy(data, ptr, count * sizeof(T));
+	}
+	ptr += count * sizeof(T);
+	return true;
+}
+
+std::vector<uint8_t> serialize_block_descriptor(
+	uint8_t blockXDim,
+	uint8_t blockYDim,
+	const block_descriptor& block_descriptor
+) {
+	const packed_decimation_data& packed = block_descriptor.decimation_info_packed;
+
+	MetadataCacheHeader header = {};
+	header.magic = METADATA_CACHE_MAGIC;
+	header.version = METADATA_CACHE_VERSION;
+	header.block_x = blockXDim;
+	header.block_y = blockYDim;
+	header.layout_size = fixed_sections_size();
+	header.texel_to_weight_count = static_cast<uint32_t>(packed.texel_to_weight_map_data.size());
+	header.weight_to_texel_count = static_cast<uint32_t>(packed.weight_to_texel_map_data.size());
+
+	std::vector<uint8_t> image;
+	image.reserve(sizeof(header) + header.layout_size +
+		packed.texel_to_weight_map_data.size() * sizeof(TexelToWeightMap) +
+		packed.weight_to_texel_map_data.size() * sizeof(WeightToTexelMap));
+
+	append_bytes(image, &header, 1);
+
+#define METADATA_CACHE_WRITE_SECTION(name) append_bytes(image, &block_descriptor.name, 1);
+	METADATA_CACHE_SECTIONS(METADATA_CACHE_WRITE_SECTION)
+#undef METADATA_CACHE_WRITE_SECTION
+
+	append_bytes(image, packed.texel_to_weight_map_data.data(), packed.texel_to_weight_map_data.size());
+	append_bytes(image, packed.weight_to_texel_map_data.data(), packed.weight_to_texel_map_data.size());
+
+	return image;
+}
+
+bool deserialize_block_descriptor(
+	const uint8_t* data,
+	size_t size,
+	uint8_t blockXDim,
+	uint8_t blockYDim,
+	block_descriptor& block_descriptor
+) {
+	const uint8_t* ptr = data;
+	const uint8_t* end = data + size;
+
+	MetadataCacheHeader header;
+	if (!read_bytes(ptr, end, &header, 1)) {
+		return false;
+	}
+
+	if (header.magic != METADATA_CACHE_MAGIC || header.version != METADATA_CACHE_VERSION ||
+		header.block_x != blockXDim || header.block_y != blockYDim ||
+		header.layout_size != fixed_sections_size()) {
+		return false;
+	}
+
+	size_t expected_size = sizeof(header) + header.layout_size +
+		static_cast<size_t>(header.texel_to_weight_count) * sizeof(TexelToWeightMap) +
+		static_cast<size_t>(header.weight_to_texel_count) * sizeof(WeightToTexelMap);
+	if (size != expected_size) {
+		return false;
+	}
+
+#define METADATA_CACHE_READ_SECTION(name) read_bytes(ptr, end, &block_descriptor.name, 1);
+	METADATA_CACHE_SECTIONS(METADATA_CACHE_READ_SECTION)
+#undef METADATA_CACHE_READ_SECTION
+
+	packed_decimation_data& packed = block_descriptor.decimation_info_packed;
+
+	packed.texel_to_weight_map_data.resize(header.texel_to_weight_count);
+	read_bytes(ptr, end, packed.texel_to_weight_map_data.data(), packed.texel_to_weight_map_data.size());
+
+	packed.weight_to_texel_map_data.resize(header.weight_to_texel_count);
+	read_bytes(ptr, end, packed.weight_to_texel_map_data.data(), packed.weight_to_texel_map_data.size());
+
+	init_partition_tables_GPU(block_descriptor);
+
+	return true;
+}
+
+static void build_block_descriptor(uint8_t blockXDim, uint8_t blockYDim, block_descriptor& block_descriptor) {
+	construct_metadata_structures(blockXDim, blockYDim, block_descriptor);
+
+	init_partition_tables(block_descriptor, false, 4);
+	init_partition_tables_GPU(block_descriptor);
+}
+
+static uint32_t lz_hash(const uint8_t* data) {
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return (value * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static void lz_write_count(std::vector<uint8_t>& out, size_t count) {
+	while (count >= 255) {
+		out.push_back(255);
+		count -= 255;
+	}
+	out.push_back(static_cast<uint8_t>(count));
+}
+
+static void lz_write_sequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength) {
+	size_t matchCount = matchLength > 0 ? matchLength - LZ_MIN_MATCH : 0;
+
+	out.push_back(static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCount, 15)));
+	if (literalCount >= 15) {
+		lz_write_count(out, literalCount - 15);
+	}
+	out.insert(out.end(), literals, literals + literalCount);
+
+	if (matchLength > 0) {
+		out.push_back(static_cast<uint8_t>(offset & 0xFF));
+		out.push_back(static_cast<uint8_t>(offset >> 8));
+		if (matchCount >= 15) {
+			lz_write_count(out, matchCount - 15);
+		}
+	}
+}
+
+static bool lz_read_count(const uint8_t*& ptr, const uint8_t* end, size_t& count) {
+	uint8_t value;
+	do {
+		if (ptr == end) {
+			return false;
+		}
+		value = *ptr++;
+		count += value;
+	} while (value == 255);
+	return true;
+}
+
+std::vector<uint8_t> compress_metadata_image(const std::vector<uint8_t>& image) {
+
+	const uint8_t* data = image.data();
+	size_t size = image.size();
+
+	std::vector<uint8_t> out;
+	out.reserve(size / 4);
+
+	std::vector<int64_t> head(size_t(1) << LZ_HASH_BITS, -1);
+	std::vector<int64_t> chain(size, -1);
+
+	auto insert = [&](size_t pos) {
+		uint32_t hash = lz_hash(data + pos);
+		chain[pos] = head[hash];
+		head[hash] = static_cast<int64_t>(pos);
+	};
+
+	size_t anchor = 0;
+	size_t pos = 0;
+	while (pos + LZ_MIN_MATCH <= size) {
+
+		size_t bestLength = 0;
+		size_t bestOffset = 0;
+
+		int64_t candidate = head[lz_hash(data + pos)];
+		for (uint32_t step = 0; candidate >= 0 && pos - candidate <= LZ_WINDOW && step < LZ_MAX_CHAIN; step++) {
+			size_t length = 0;
+			while (pos + length < size && data[candidate + length] == data[pos + length]) {
+				length++;
+			}
+
+			if (length > bestLength) {
+				bestLength = length;
+				bestOffset = pos - candidate;
+			}
+			candidate = chain[candidate];
+		}
+
+		if (bestLength < LZ_MIN_MATCH) {
+			insert(pos);
+			pos++;
+			continue;
+		}
+
+		lz_write_sequence(out, data + anchor, pos - anchor, bestOffset, bestLength);
+
+		for (size_t end = pos + bestLength; pos < end; pos++) {
+			if (pos + LZ_MIN_MATCH <= size) {
+				insert(pos);
+			}
+		}
+		anchor = pos;
+	}
+
+	lz_write_sequence(out, data + anchor, size - anchor, 0, 0);
+
+	return out;
+}
+
+bool expand_metadata_image(
+	const uint8_t* data,
+	size_t size,
+	size_t expandedSize,
+	std::vector<uint8_t>& image
+) {
+	image.resize(expandedSize);
+
+	const uint8_t* ptr = data;
+	const uint8_t* end = data + size;
+	size_t out = 0;
+
+	while (ptr < end) {
+		uint8_t token = *ptr++;
+
+		size_t literalCount = token >> 4;
+		if (literalCount == 15 && !lz_read_count(ptr, end, literalCount)) {
+			return false;
+		}
+		if (static_cast<size_t>(end - ptr) < literalCount || expandedSize - out < literalCount) {
+			return false;
+		}
+		memcpy(image.data() + out, ptr, literalCount);
+		ptr += literalCount;
+		out += literalCount;
+
+		if (ptr == end) {
+			break;
+		}
+
+		if (end - ptr < 2) {
+			return false;
+		}
+		size_t offset = ptr[0] | (ptr[1] << 8);
+		ptr += 2;
+
+		size_t matchLength = token & 0xF;
+		if (matchLength == 15 && !lz_read_count(ptr, end, matchLength)) {
+			return false;
+		}
+		matchLength += LZ_MIN_MATCH;
+
+		if (offset == 0 || offset > out || expandedSize - out < matchLength) {
+			return false;
+		}
+
+		//matches can overlap their own output (runs), so non overlapping parts are copied in chunks
+		uint8_t* dst = image.data() + out;
+		const uint8_t* src = dst - offset;
+		while (matchLength > 0) {
+			size_t chunk = std::min(matchLength, offset);
+			memcpy(dst, src, chunk);
+			dst += chunk;
+			matchLength -= chunk;
+			out += chunk;
+		}
+	}
+
+	return out == expandedSize;
+}
+
+std::vector<uint8_t> build_metadata_bundle() {
+
+	std::vector<std::vector<uint8_t>> compressedImages;
+	std::vector<MetadataBundleEntry> entries;
+
+	for (unsigned int i = 0; i < ASTC_BLOCK_SIZE_COUNT_2D; i++) {
+		uint8_t blockXDim = ASTC_BLOCK_SIZES_2D[i][0];
+		uint8_t blockYDim = ASTC_BLOCK_SIZES_2D[i][1];
+
+		//too large for the stack, zero initialized like the encoder sessions
+		std::unique_ptr<block_descriptor> descriptor = std::make_unique<block_descriptor>();
+		build_block_descriptor(blockXDim, blockYDim, *descriptor);
+
+		std::vector<uint8_t> image = serialize_block_descriptor(blockXDim, blockYDim, *descriptor);
+
+		MetadataBundleEntry entry = {};
+		entry.block_x = blockXDim;
+		entry.block_y = blockYDim;
+		entry.expanded_size = static_cast<uint32_t>(image.size());
+
+		compressedImages.push_back(compress_metadata_image(image));
+		entry.compressed_size = static_cast<uint32_t>(compressedImages.back().size());
+		entries.push_back(entry);
+	}
+
+	MetadataBundleHeader header = {};
+	header.magic = METADATA_BUNDLE_MAGIC;
+	header.version = METADATA_CACHE_VERSION;
+	header.count = static_cast<uint32_t>(entries.size());
+
+	size_t offset = sizeof(header) + entries.size() * sizeof(MetadataBundleEntry);
+	for (MetadataBundleEntry& entry : entries) {
+		entry.offset = static_cast<uint32_t>(offset);
+		offset += entry.compressed_size;
+	}
+
+	std::vector<uint8_t> bundle;
+	bundle.reserve(offset);
+
+	append_bytes(bundle, &header, 1);
+	append_bytes(bundle, entries.data(), entries.size());
+	for (const std::vector<uint8_t>& compressed : compressedImages) {
+		append_bytes(bundle, compressed.data(), compressed.size());
+	}
+
+	return bundle;
+}
+
+bool find_bundle_image(
+	const uint8_t* bundle,
+	size_t size,
+	uint8_t blockXDim,
+	uint8_t blockYDim,
+	std::vector<uint8_t>& image
+) {
+	const uint8_t* ptr = bundle;
+	const uint8_t* end = bundle + size;
+
+	MetadataBundleHeader header;
+	if (!read_bytes(ptr, end, &header, 1) || header.magic != METADATA_BUNDLE_MAGIC || header.version != METADATA_CACHE_VERSION) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header.count; i++) {
+		MetadataBundleEntry entry;
+		if (!read_bytes(ptr, end, &entry, 1)) {
+			return false;
+		}
+
+		if (entry.block_x != blockXDim || entry.block_y != blockYDim) {
+			continue;
+		}
+
+		if (entry.offset > size || size - entry.offset < entry.compressed_size) {
+			return false;
+		}
+		return expand_metadata_image(bundle + entry.offset, entry.compressed_size, entry.expanded_size, image);
+	}
+
+	return false;
+}
+
+/**
+ * @brief Read only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& path) {
+#if defined(_WIN32)
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+			return;
+		}
+
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) {
+			return;
+		}
+
+		data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (data != nullptr) {
+			size = static_cast<size_t>(fileSize.QuadPart);
+		}
+#elif !defined(EMSCRIPTEN)
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return;
+		}
+
+		struct stat fileStat;
+		if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+			void* mapped = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped != MAP_FAILED) {
+				data = static_cast<const uint8_t*>(mapped);
+				size = static_cast<size_t>(fileStat.st_size);
+			}
+		}
+		close(fd); //the mapping stays valid after the descriptor is closed
+#else
+		(void)path;
+#endif
+	}
+
+	~MappedFile() {
+#if defined(_WIN32)
+		if (data != nullptr) {
+			UnmapViewOfFile(data);
+		}
+		if (mapping != nullptr) {
+			CloseHandle(mapping);
+		}
+		if (file != INVALID_HANDLE_VALUE) {
+			CloseHandle(file);
+		}
+#elif !defined(EMSCRIPTEN)
+		if (data != nullptr) {
+			munmap(const_cast<uint8_t*>(data), size);
+		}
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+private:
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+};
+
+static unsigned long process_id() {
+#if defined(_WIN32)
+	return static_cast<unsigned long>(GetCurrentProcessId());
+#elif !defined(EMSCRIPTEN)
+	return static_cast<unsigned long>(getpid());
+#else
+	return 0;
+#endif
+}
+
+MetadataCache::MetadataCache(std::string directory) : directory(std::move(directory)) {
+
+#if !defined(EMSCRIPTEN)
+	if (this->directory.empty()) {
+		const char* envDirectory = std::getenv("ASTC_METADATA_CACHE_DIR");
+		if (envDirectory != nullptr) {
+			this->directory = envDirectory;
+		}
+	}
+#else
+	//no persistent file system in the browser, the cache only lives in memory
+	this->directory.clear();
+#endif
+}
+
+MetadataCache& MetadataCache::shared() {
+	static MetadataCache cache;
+	return cache;
+}
+
+std::string MetadataCache::filePath(uint8_t blockXDim, uint8_t blockYDim) const {
+	std::string path = directory;
+	if (!path.empty() && path.back() != '/' && path.back() != '\\') {
+		path += '/';
+	}
+
+	return path + "astc_metadata_" + std::to_string(blockXDim) + "x" + std::to_string(blockYDim) +
+		"_v" + std::to_string(METADATA_CACHE_VERSION) + ".bin";
+}
+
+const uint8_t* MetadataCache::Image::data() const {
+	return file ? file->data : bytes.data();
+}
+
+size_t MetadataCache::Image::size() const {
+	return file ? file->size : bytes.size();
+}
+
+bool MetadataCache::loadFile(uint8_t blockXDim, uint8_t blockYDim, block_descriptor& block_descriptor) {
+
+	std::string path = filePath(blockXDim, blockYDim);
+
+	std::shared_ptr<const MappedFile> file = std::make_shared<const MappedFile>(path);
+	if (file->data == nullptr) {
+		return false;
+	}
+
+	if (!deserialize_block_descriptor(file->data, file->size, blockXDim, blockYDim, block_descriptor)) {
+		ASTC_LOG(LogLevel::Warning, "Ignoring outdated metadata cache file " << path);
+		return false;
+	}
+
+	//the image is served from the mapping from now on (a replaced cache file keeps the mapped pages of the old one)
+	images[(blockXDim << 8) | blockYDim].file = std::move(file);
+
+	ASTC_LOG(LogLevel::Debug, "Loaded metadata from " << path);
+	return true;
+}
+
+void MetadataCache::storeFile(uint8_t blockXDim, uint8_t blockYDim, const std::vector<uint8_t>& image) {
+
+	std::string path = filePath(blockXDim, blockYDim);
+
+	//written to a temporary file first, so concurrent processes never map a partially written cache file
+	std::string tempPath = path + ".tmp" + std::to_string(process_id());
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			ASTC_LOG(LogLevel::Warning, "Could not write metadata cache file " << path);
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(image.data()), image.size());
+		if (!file) {
+			ASTC_LOG(LogLevel::Warning, "Could not write metadata cache file " << path);
+			file.close();
+			std::remove(tempPath.c_str());
+			return;
+		}
+	}
+
+#if defined(_WIN32)
+	//rename does not replace existing files on windows
+	std::remove(path.c_str());
+#endif
+	if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+		std::remove(tempPath.c_str());
+	}
+}
+
+void MetadataCache::load(uint8_t blockXDim, uint8_t blockYDim, block_descriptor& block_descriptor) {
+
+	std::lock_guard<std::mutex> lock(imagesMutex);
+
+	uint16_t key = static_cast<uint16_t>((blockXDim << 8) | blockYDim);
+
+	auto it = images.find(key);
+	if (it != images.end() &&
+		deserialize_block_descriptor(it->second.data(), it->second.size(), blockXDim, blockYDim, block_descriptor)) {
+		return;
+	}
+
+#if defined(ASTC_PREBUILT_METADATA)
+	//tables generated at build time for every 2D block size
+	std::vector<uint8_t> prebuilt;
+	if (find_bundle_image(Metadata::prebuilt_metadata_bin, Metadata::prebuilt_metadata_bin_len, blockXDim, blockYDim, prebuilt) &&
+		deserialize_block_descriptor(prebuilt.data(), prebuilt.size(), blockXDim, blockYDim, block_descriptor)) {
+		images[key].bytes = std::move(prebuilt);
+		return;
+	}
+#endif
+
+	if (!directory.empty() && loadFile(blockXDim, blockYDim, block_descriptor)) {
+		return;
+	}
+
+	build_block_descriptor(blockXDim, blockYDim, block_descriptor);
+
+	Image& image = images[key];
+	image.file = nullptr;
+	image.bytes = serialize_block_descriptor(blockXDim, blockYDim, block_descriptor);
+
+	if (!directory.empty()) {
+		storeFile(blockXDim, blockYDim, image.bytes);
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "astc.h"
+
+class MappedFile;
+
+/**
+ * @brief Cache of the precomputed block size metadata (block modes, decimation tables, partition tables).
+ *
+ * Building a block_descriptor takes a noticeable amount of time, so every block size is built once and kept
+ * as a versioned binary image in memory. Builds with ASTC_PREBUILT_METADATA embed the images of all 2D block sizes,
+ * generated at build time, so no block size has to be built at runtime. When a cache directory is set (ASTC_METADATA_CACHE_DIR, or the
+ * constructor argument), the images are also written to disk and later served straight from a memory mapping, so
+ * a new process does not rebuild or copy the tables either. Invalid or outdated cache files are rebuilt and replaced.
+ */
+class MetadataCache {
+public:
+	/**
+	 * @param directory   Directory of the cache files, empty uses ASTC_METADATA_CACHE_DIR (no disk cache when it is not set).
+	 */
+	explicit MetadataCache(std::string directory = "");
+
+	MetadataCache(const MetadataCache&) = delete;
+	MetadataCache& operator=(const MetadataCache&) = delete;
+
+	/**
+	 * @brief Cache shared by all encoders of the process.
+	 */
+	static MetadataCache& shared();
+
+	/**
+	 * @brief Fill block_descriptor with the metadata of the block size, from memory, disk or by building it.
+	 */
+	void load(uint8_t blockXDim, uint8_t blockYDim, block_descriptor& block_descriptor);
+
+	const std::string& getDirectory() const { return directory; }
+
+private:
+	std::string filePath(uint8_t blockXDim, uint8_t blockYDim) const;
+
+	bool loadFile(uint8_t blockXDim, uint8_t blockYDim, block_descriptor& block_descriptor);
+	void storeFile(uint8_t blockXDim, uint8_t blockYDim, const std::vector<uint8_t>& image);
+
+	//serialized block descriptor: built or expanded in memory, or a cache file that stays mapped
+	struct Image {
+		std::vector<uint8_t> bytes;
+		std::shared_ptr<const MappedFile> file;
+
+		const uint8_t* data() const;
+		size_t size() const;
+	};
+
+	std::string directory;
+
+	std::map<uint16_t, Image> images; //keyed by (x << 8) | y
+	std::mutex imagesMutex;
+};
+
+/**
+ * @brief Serialize a block_descriptor into a versioned binary image.
+ */
+std::vector<uint8_t> serialize_block_descriptor(
+	uint8_t blockXDim,
+	uint8_t blockYDim,
+	const block_descriptor& block_descriptor
+);
+
+/**
+ * @brief Restore a block_descriptor from a binary image.
+ *
+ * @return false if the image is truncated, from a different version or built for a different block size.
+ */
+bool deserialize_block_descriptor(
+	const uint8_t* data,
+	size_t size,
+	uint8_t blockXDim,
+	uint8_t blockYDim,
+	block_descriptor& block_descriptor
+);
+
+/**
+ * @brief Compress a metadata image with a byte oriented LZ scheme.
+ *
+ * The images are dominated by zero padding and repeated table entries, which the matches of the scheme cover
+ * well, while expanding stays a sequence of memory copies.
+ */
+std::vector<uint8_t> compress_metadata_image(const std::vector<uint8_t>& image);
+
+/**
+ * @brief Expand an image compressed with compress_metadata_image.
+ *
+ * @return false if the compressed data is corrupt or does not expand to expandedSize bytes.
+ */
+bool expand_metadata_image(
+	const uint8_t* data,
+	size_t size,
+	size_t expandedSize,
+	std::vector<uint8_t>& image
+);
+
+/**
+ * @brief Build the compressed metadata images of all 2D block sizes into one bundle (used by the build time generator).
+ */
+std::vector<uint8_t> build_metadata_bundle();
+
+/**
+ * @brief Find the image of a block size in a metadata bundle and expand it.
+ */
+bool find_bundle_image(
+	const uint8_t* bundle,
+	size_t size,
+	uint8_t blockXDim,
+	uint8_t blockYDim,
+	std::vector<uint8_t>& image
+);
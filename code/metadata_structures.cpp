@@ -1,4 +1,5 @@
 #include "astc.h"
+#include <cmath>
 
 static inline uint64_t rotl(uint64_t val, int count)
 {
@@ -273,6 +273,33 @@ static transfer_table transfet_tables[12] = {
 	{{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31}}
 };
 
+/**
+ * @brief Unquantized weight (0 to 64) to scrambled quantized weight, for every weight quant method.
+ */
+struct weight_pack_table {
+	uint8_t values[12][65];
+};
+
+static weight_pack_table build_weight_pack_tables()
+{
+	weight_pack_table table;
+
+	for (int q = 0; q < 12; q++) {
+		float quant_levels = static_cast<float>(get_quant_level(static_cast<quant_method>(q)));
+
+		for (int uqw = 0; uqw <= 64; uqw++) {
+			// Same rounding as the per weight computation this table replaces
+			float qw = (static_cast<float>(uqw) / 64.0f) * (quant_levels - 1.0f);
+			int qwi = static_cast<int>(qw + 0.5f);
+			table.values[q][uqw] = transfet_tables[q].scramble_map[qwi];
+		}
+	}
+
+	return table;
+}
+
+static const weight_pack_table weight_pack_tables = build_weight_pack_tables();
+
 /**
  * @brief The precomputed table for packing quantized color values.
  *
@@ -669,6 +696,52 @@ static inline void write_bits(
 	ptr[1] |= value >> 8;
 }
 
+/**
+ * @brief Little endian bit accumulator used for packing BISE strings.
+ *
+ * Bits are collected in a 64 bit register and only complete bytes are stored, so a whole trit or
+ * quint group is packed with a single flush. Bits of the output before the start offset and after
+ * the end of the sequence are preserved.
+ */
+struct ise_bit_writer {
+	uint8_t* ptr;        // next byte to store
+	uint64_t bits;       // pending bits, LSB first
+	unsigned int count;  // number of pending bits
+};
+
+static inline void ise_writer_begin(ise_bit_writer& writer, uint8_t* output_data, unsigned int bit_offset)
+{
+	writer.ptr = output_data + (bit_offset >> 3);
+	writer.count = bit_offset & 7;
+	writer.bits = *writer.ptr & ((1u << writer.count) - 1);
+}
+
+static inline void ise_writer_put(ise_bit_writer& writer, unsigned int value, unsigned int bitcount)
+{
+	writer.bits |= static_cast<uint64_t>(value & ((1u << bitcount) - 1)) << writer.count;
+	writer.count += bitcount;
+}
+
+static inline void ise_writer_flush(ise_bit_writer& writer)
+{
+	while (writer.count >= 8)
+	{
+		*writer.ptr++ = static_cast<uint8_t>(writer.bits);
+		writer.bits >>= 8;
+		writer.count -= 8;
+	}
+}
+
+static inline void ise_writer_end(ise_bit_writer& writer)
+{
+	ise_writer_flush(writer);
+	if (writer.count)
+	{
+		uint8_t mask = static_cast<uint8_t>((1u << writer.count) - 1);
+		*writer.ptr = (*writer.ptr & ~mask) | (static_cast<uint8_t>(writer.bits) & mask);
+	}
+}
+
 void encode_ise(
 	quant_method quant_level,
 	unsigned int character_count,
@@ -676,142 +749,68 @@ void encode_ise(
 	uint8_t* output_data,
 	unsigned int bit_offset
 ) {
-	
+
 	unsigned int bits = btq_counts[quant_level].bits;
 	unsigned int trits = btq_counts[quant_level].trits;
 	unsigned int quints = btq_counts[quant_level].quints;
 	unsigned int mask = (1 << bits) - 1;
 
+	ise_bit_writer writer;
+	ise_writer_begin(writer, output_data, bit_offset);
+
 	// Write out trits and bits
 	if (trits)
 	{
-		unsigned int i = 0;
-		unsigned int full_trit_blocks = character_count / 5;
+		// Number of T bits stored after each element of a 5 element group, and their position in T
+		static const uint8_t tbits[5]{ 2, 2, 1, 2, 1 };
+		static const uint8_t tshift[5]{ 0, 2, 4, 5, 7 };
 
-		for (unsigned int j = 0; j < full_trit_blocks; j++)
+		for (unsigned int i = 0; i < character_count; i += 5)
 		{
-			unsigned int i4 = input_data[i + 4] >> bits;
-			unsigned int i3 = input_data[i + 3] >> bits;
-			unsigned int i2 = input_data[i + 2] >> bits;
-			unsigned int i1 = input_data[i + 1] >> bits;
-			unsigned int i0 = input_data[i + 0] >> bits;
-
-			uint8_t T = integer_of_trits[i4][i3][i2][i1][i0];
-
-			// The max size of a trit bit count is 6, so we can always safely
-			// pack a single MX value with the following 1 or 2 T bits.
-			uint8_t pack;
-
-			// Element 0 + T0 + T1
-			pack = (input_data[i++] & mask) | (((T >> 0) & 0x3) << bits);
-			write_bits(pack, bits + 2, bit_offset, output_data);
-			bit_offset += bits + 2;
-
-			// Element 1 + T2 + T3
-			pack = (input_data[i++] & mask) | (((T >> 2) & 0x3) << bits);
-			write_bits(pack, bits + 2, bit_offset, output_data);
-			bit_offset += bits + 2;
-
-			// Element 2 + T4
-			pack = (input_data[i++] & mask) | (((T >> 4) & 0x1) << bits);
-			write_bits(pack, bits + 1, bit_offset, output_data);
-			bit_offset += bits + 1;
-
-			// Element 3 + T5 + T6
-			pack = (input_data[i++] & mask) | (((T >> 5) & 0x3) << bits);
-			write_bits(pack, bits + 2, bit_offset, output_data);
-			bit_offset += bits + 2;
-
-			// Element 4 + T7
-			pack = (input_data[i++] & mask) | (((T >> 7) & 0x1) << bits);
-			write_bits(pack, bits + 1, bit_offset, output_data);
-			bit_offset += bits + 1;
-		}
-
-		// Loop tail for a partial block
-		if (i != character_count)
-		{
-			// i4 cannot be present - we know the block is partial
-			// i0 must be present - we know the block isn't empty
-			unsigned int i4 = 0;
-			unsigned int i3 = i + 3 >= character_count ? 0 : input_data[i + 3] >> bits;
-			unsigned int i2 = i + 2 >= character_count ? 0 : input_data[i + 2] >> bits;
-			unsigned int i1 = i + 1 >= character_count ? 0 : input_data[i + 1] >> bits;
-			unsigned int i0 = input_data[i + 0] >> bits;
-
-			uint8_t T = integer_of_trits[i4][i3][i2][i1][i0];
-
-			for (unsigned int j = 0; i < character_count; i++, j++)
+			// Missing elements of a partial group encode as zero
+			unsigned int group_count = std::min(character_count - i, 5u);
+			unsigned int t[5]{ 0, 0, 0, 0, 0 };
+			for (unsigned int j = 0; j < group_count; j++)
 			{
-				// Truncated table as this iteration is always partital
-				static const uint8_t tbits[4]{ 2, 2, 1, 2 };
-				static const uint8_t tshift[4]{ 0, 2, 4, 5 };
+				t[j] = input_data[i + j] >> bits;
+			}
 
-				uint8_t pack = (input_data[i] & mask) |
-					(((T >> tshift[j]) & ((1 << tbits[j]) - 1)) << bits);
+			unsigned int T = integer_of_trits[t[4]][t[3]][t[2]][t[1]][t[0]];
 
-				write_bits(pack, bits + tbits[j], bit_offset, output_data);
-				bit_offset += bits + tbits[j];
+			// At most 5 * 8 + 8 bits per group, fits the accumulator next to a partial byte
+			for (unsigned int j = 0; j < group_count; j++)
+			{
+				ise_writer_put(writer, input_data[i + j] & mask, bits);
+				ise_writer_put(writer, T >> tshift[j], tbits[j]);
 			}
+			ise_writer_flush(writer);
 		}
 	}
 	// Write out quints and bits
 	else if (quints)
 	{
-		unsigned int i = 0;
-		unsigned int full_quint_blocks = character_count / 3;
-
-		for (unsigned int j = 0; j < full_quint_blocks; j++)
-		{
-			unsigned int i2 = input_data[i + 2] >> bits;
-			unsigned int i1 = input_data[i + 1] >> bits;
-			unsigned int i0 = input_data[i + 0] >> bits;
-
-			uint8_t T = integer_of_quints[i2][i1][i0];
-
-			// The max size of a quint bit count is 5, so we can always safely
-			// pack a single M value with the following 2 or 3 T bits.
-			uint8_t pack;
-
-			// Element 0
-			pack = (input_data[i++] & mask) | (((T >> 0) & 0x7) << bits);
-			write_bits(pack, bits + 3, bit_offset, output_data);
-			bit_offset += bits + 3;
-
-			// Element 1
-			pack = (input_data[i++] & mask) | (((T >> 3) & 0x3) << bits);
-			write_bits(pack, bits + 2, bit_offset, output_data);
-			bit_offset += bits + 2;
-
-			// Element 2
-			pack = (input_data[i++] & mask) | (((T >> 5) & 0x3) << bits);
-			write_bits(pack, bits + 2, bit_offset, output_data);
-			bit_offset += bits + 2;
-		}
+		// Number of Q bits stored after each element of a 3 element group, and their position in Q
+		static const uint8_t qbits[3]{ 3, 2, 2 };
+		static const uint8_t qshift[3]{ 0, 3, 5 };
 
-		// Loop tail for a partial block
-		if (i != character_count)
+		for (unsigned int i = 0; i < character_count; i += 3)
 		{
-			// i2 cannot be present - we know the block is partial
-			// i0 must be present - we know the block isn't empty
-			unsigned int i2 = 0;
-			unsigned int i1 = i + 1 >= character_count ? 0 : input_data[i + 1] >> bits;
-			unsigned int i0 = input_data[i + 0] >> bits;
-
-			uint8_t T = integer_of_quints[i2][i1][i0];
-
-			for (unsigned int j = 0; i < character_count; i++, j++)
+			// Missing elements of a partial group encode as zero
+			unsigned int group_count = std::min(character_count - i, 3u);
+			unsigned int q[3]{ 0, 0, 0 };
+			for (unsigned int j = 0; j < group_count; j++)
 			{
-				// Truncated table as this iteration is always partital
-				static const uint8_t tbits[2]{ 3, 2 };
-				static const uint8_t tshift[2]{ 0, 3 };
+				q[j] = input_data[i + j] >> bits;
+			}
 
-				uint8_t pack = (input_data[i] & mask) |
-					(((T >> tshift[j]) & ((1 << tbits[j]) - 1)) << bits);
+			unsigned int Q = integer_of_quints[q[2]][q[1]][q[0]];
 
-				write_bits(pack, bits + tbits[j], bit_offset, output_data);
-				bit_offset += bits + tbits[j];
+			for (unsigned int j = 0; j < group_count; j++)
+			{
+				ise_writer_put(writer, input_data[i + j] & mask, bits);
+				ise_writer_put(writer, Q >> qshift[j], qbits[j]);
 			}
+			ise_writer_flush(writer);
 		}
 	}
 	// Write out just bits
@@ -819,12 +818,13 @@ void encode_ise(
 	{
 		for (unsigned int i = 0; i < character_count; i++)
 		{
-			write_bits(input_data[i], bits, bit_offset, output_data);
-			bit_offset += bits;
+			ise_writer_put(writer, input_data[i], bits);
+			ise_writer_flush(writer);
 		}
 	}
-}
 
+	ise_writer_end(writer);
+}
 /**
  * @brief Reverse bits in a byte.
  *
@@ -859,12 +859,11 @@ void symbolic_to_physical(
 	decimation_info di = block_descriptor.decimation_info_metadata[bm.decimation_mode];
 	int weight_count = di.weight_count;
 	quant_method weight_quant_method = static_cast<quant_method>(bm.quant_mode);
-	float weight_qunat_levels = static_cast<float>(get_quant_level(weight_quant_method));
 	int is_dual_plane = bm.is_dual_plane;
 
 	int real_weight_count = is_dual_plane ? 2 * weight_count : weight_count;
 
-	const auto& weight_scramble_map = transfet_tables[weight_quant_method].scramble_map;
+	const uint8_t* packed_weights = weight_pack_tables.values[weight_quant_method];
 
 	int bits_for_weights = get_ise_sequence_bitcount(real_weight_count, weight_quant_method);
 
@@ -872,28 +871,17 @@ void symbolic_to_physical(
 
 	//std::cout << "weights... " << std::endl;
 
+	//quantization and scrambling of each weight is a single table lookup
 	uint8_t weights[64];
 	if (is_dual_plane) {
 		for (int i = 0; i < weight_count; i++) {
-			float uqw = static_cast<float>(symbolic_compressed_block.quantized_weights[i]);
-			float qw = (uqw / 64.0f) * (weight_qunat_levels - 1.0f);
-			int qwi = static_cast<int>(qw + 0.5f);
-			weights[2 * i] = weight_scramble_map[qwi];
-
-			uqw = static_cast<float>(symbolic_compressed_block.quantized_weights[i + WEIGHTS_PLANE2_OFFSET]);
-			qw = (uqw / 64.0f) * (weight_qunat_levels - 1.0f);
-			qwi = static_cast<int>(qw + 0.5f);
-			weights[2 * i + 1] = weight_scramble_map[qwi];
+			weights[2 * i] = packed_weights[std::min(symbolic_compressed_block.quantized_weights[i], 64u)];
+			weights[2 * i + 1] = packed_weights[std::min(symbolic_compressed_block.quantized_weights[i + WEIGHTS_PLANE2_OFFSET], 64u)];
 		}
 	}
 	else {
 		for (int i = 0; i < weight_count; i++) {
-			float uqw = static_cast<float>(symbolic_compressed_block.quantized_weights[i]);
-			float qw = (uqw / 64.0f) * (weight_qunat_levels - 1.0f);
-			int qwi = static_cast<int>(qw + 0.5f);
-			weights[i] = weight_scramble_map[qwi];
-
-			//std::cout << qwi << " -> " << static_cast<unsigned int>(weights[i]) << std::endl;
+			weights[i] = packed_weights[std::min(symbolic_compressed_block.quantized_weights[i], 64u)];
 		}
 	}
 
@@ -1000,4 +988,35 @@ void symbolic_to_physical(
 	//std::cout << "weight YX... " << di.weight_x << " " << di.weight_y << std::endl;
 	//std::cout << "weight quant level... " << weight_quant_method << std::endl;
 	//std::cout << "color quant level... " << symbolic_compressed_block.quant_mode << std::endl;
-}
\ No newline at end of file
+}
+
+void init_ise_tables_GPU(ise_tables_GPU& tables) {
+
+	for (int i = 0; i < 21; i++) {
+		tables.quant_levels[i] = get_quant_level(static_cast<quant_method>(i));
+		tables.btq_counts[i] = btq_counts[i].bits | (btq_counts[i].trits << 8) | (btq_counts[i].quints << 16);
+		tables.ise_sizes[i] = ise_sizes[i].scale | (ise_sizes[i].divisor << 8);
+	}
+
+	const uint8_t* trits = &integer_of_trits[0][0][0][0][0];
+	for (int i = 0; i < 243; i++) {
+		tables.integer_of_trits[i] = trits[i];
+	}
+
+	const uint8_t* quints = &integer_of_quints[0][0][0];
+	for (int i = 0; i < 125; i++) {
+		tables.integer_of_quints[i] = quints[i];
+	}
+
+	for (int q = 0; q < 12; q++) {
+		for (int i = 0; i < 32; i++) {
+			tables.weight_scramble_maps[q][i] = transfet_tables[q].scramble_map[i];
+		}
+	}
+
+	for (int q = 0; q < 17; q++) {
+		for (int i = 0; i < 256; i++) {
+			tables.color_scrambled_pquant[q][i] = color_uquant_to_scrambled_pquant_tables[q][i];
+		}
+	}
+}
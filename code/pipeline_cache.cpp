@@ -0,0 +1,187 @@
+#include "pipeline_cache.h"
+#include "trace.h"
+
+#if !defined(EMSCRIPTEN)
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <process.h>
+#define ASTC_GETPID _getpid
+#else
+#include <unistd.h>
+#define ASTC_GETPID getpid
+#endif
+
+static const uint32_t PIPELINE_CACHE_MAGIC = 0x46435041; //"APCF"
+
+struct PipelineCacheFileHeader {
+	uint32_t magic;
+	uint32_t keySize;
+	uint64_t valueSize;
+};
+
+static uint64_t fnv1a_64(const uint8_t* data, size_t size) {
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+//reads the header of a cache file and checks that it belongs to the key, the stream is left at the start of the value
+static bool openEntry(std::ifstream& file, void const* key, size_t keySize, PipelineCacheFileHeader& header) {
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		return false;
+	}
+
+	if (header.magic != PIPELINE_CACHE_MAGIC || header.keySize != keySize) {
+		return false;
+	}
+
+	std::vector<char> storedKey(keySize);
+	if (!file.read(storedKey.data(), keySize)) {
+		return false;
+	}
+
+	return memcmp(storedKey.data(), key, keySize) == 0;
+}
+
+PipelineCache::PipelineCache(std::string directory) : directory(std::move(directory)) {
+
+	if (this->directory.empty()) {
+		const char* envDirectory = std::getenv("ASTC_PIPELINE_CACHE_DIR");
+		if (envDirectory != nullptr) {
+			this->directory = envDirectory;
+		}
+	}
+
+	//the stores of Dawn would fail silently without the directory, and the cache would never warm
+	if (!this->directory.empty()) {
+		std::error_code error;
+		std::filesystem::create_directories(this->directory, error);
+		if (error) {
+			ASTC_LOG(LogLevel::Warning, "Could not create the pipeline cache directory " << this->directory << " (" << error.message() << "), caching is disabled");
+			this->directory.clear();
+		}
+	}
+
+	cacheDescriptor.isolationKey = "webgpu_astc";
+	cacheDescriptor.loadDataFunction = &PipelineCache::loadData;
+	cacheDescriptor.storeDataFunction = &PipelineCache::storeData;
+	cacheDescriptor.functionUserdata = this;
+}
+
+void PipelineCache::attach(wgpu::DeviceDescriptor& deviceDescriptor) {
+
+	if (!isEnabled()) {
+		return;
+	}
+
+	cacheDescriptor.nextInChain = deviceDescriptor.nextInChain;
+	deviceDescriptor.nextInChain = &cacheDescriptor;
+
+	ASTC_LOG(LogLevel::Info, "Using pipeline cache in " << directory);
+}
+
+void PipelineCache::printStats(const char* label) {
+
+	if (!isEnabled()) {
+		return;
+	}
+
+	ASTC_LOG(LogLevel::Info, "Pipeline cache (" << label << "): " << hits.exchange(0) << " hits, " << misses.exchange(0) << " misses, "
+		<< stores.exchange(0) << " entries stored");
+}
+
+std::string PipelineCache::filePath(void const* key, size_t keySize) const {
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(fnv1a_64(static_cast<const uint8_t*>(key), keySize)));
+
+	std::string path = directory;
+	if (path.back() != '/' && path.back() != '\\') {
+		path += '/';
+	}
+	return path + name;
+}
+
+//Dawn first asks for the size of an entry (value is null), then for its data
+size_t PipelineCache::loadData(void const* key, size_t keySize, void* value, size_t valueSize, void* userdata) {
+
+	PipelineCache* cache = static_cast<PipelineCache*>(userdata);
+
+	std::ifstream file(cache->filePath(key, keySize), std::ios::binary);
+
+	PipelineCacheFileHeader header;
+	if (!file || !openEntry(file, key, keySize, header)) {
+		if (value == nullptr) {
+			cache->misses++;
+		}
+		return 0;
+	}
+
+	if (value == nullptr || valueSize == 0) {
+		return static_cast<size_t>(header.valueSize);
+	}
+
+	if (valueSize < header.valueSize || !file.read(static_cast<char*>(value), header.valueSize)) {
+		cache->misses++;
+		return 0;
+	}
+
+	cache->hits++;
+	return static_cast<size_t>(header.valueSize);
+}
+
+void PipelineCache::storeData(void const* key, size_t keySize, void const* value, size_t valueSize, void* userdata) {
+
+	PipelineCache* cache = static_cast<PipelineCache*>(userdata);
+
+	std::string path = cache->filePath(key, keySize);
+
+	//written to a temporary file first, so concurrent jobs never read a partially written entry
+	std::string tempPath = path + ".tmp" + std::to_string(ASTC_GETPID());
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			return;
+		}
+
+		PipelineCacheFileHeader header = {};
+		header.magic = PIPELINE_CACHE_MAGIC;
+		header.keySize = static_cast<uint32_t>(keySize);
+		header.valueSize = valueSize;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(static_cast<const char*>(key), keySize);
+		file.write(static_cast<const char*>(value), valueSize);
+
+		if (!file) {
+			file.close();
+			std::remove(tempPath.c_str());
+			return;
+		}
+	}
+
+#if defined(_WIN32)
+	//rename does not replace existing files on windows
+	std::remove(path.c_str());
+#endif
+	if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+		std::remove(tempPath.c_str());
+		return;
+	}
+
+	cache->stores++;
+}
+
+#endif
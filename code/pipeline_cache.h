@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <webgpu/webgpu.h>
+#include <webgpu/webgpu_cpp.h>
+
+#if !defined(EMSCRIPTEN)
+
+/**
+ * @brief File backed blob cache of the device (compiled shaders and pipelines).
+ *
+ * Chained into the device descriptor, Dawn then stores the results of Tint and the driver compilers through it
+ * and looks them up again when the same pipelines are created by a later process. Every entry is one file in the
+ * cache directory, named after a hash of its key. The key is stored in the file as well and compared on load.
+ */
+class PipelineCache {
+public:
+	/**
+	 * @param directory   Directory of the cache files, empty uses ASTC_PIPELINE_CACHE_DIR (caching is disabled when it is not set).
+	 *                    It is created when missing.
+	 */
+	explicit PipelineCache(std::string directory = "");
+
+	PipelineCache(const PipelineCache&) = delete;
+	PipelineCache& operator=(const PipelineCache&) = delete;
+
+	bool isEnabled() const { return !directory.empty(); }
+
+	/**
+	 * @brief Chain the cache into a device descriptor (does nothing when caching is disabled).
+	 *
+	 * The cache has to outlive the device.
+	 */
+	void attach(wgpu::DeviceDescriptor& deviceDescriptor);
+
+	/**
+	 * @brief Print the hits, misses and stores since the last call.
+	 */
+	void printStats(const char* label);
+
+private:
+	static size_t loadData(void const* key, size_t keySize, void* value, size_t valueSize, void* userdata);
+	static void storeData(void const* key, size_t keySize, void const* value, size_t valueSize, void* userdata);
+
+	std::string filePath(void const* key, size_t keySize) const;
+
+	std::string directory;
+
+	wgpu::DawnCacheDeviceDescriptor cacheDescriptor;
+
+	std::atomic<uint32_t> hits{ 0 };
+	std::atomic<uint32_t> misses{ 0 };
+	std::atomic<uint32_t> stores{ 0 };
+};
+
+#endif
@@ -1,7 +1,9 @@
-#include "astc.h"
+#include "astc_encoder.h"
 #include "webgpu_utils.h"
+#include "trace.h"
 
 #if !defined(EMSCRIPTEN)
+#include <shaders_pass000_extract_blocks_wgsl.h>
 #include <shaders_pass001_init_kmeans_wgsl.h>
 #include <shaders_pass002_assign_kmeans_wgsl.h>
 #include <shaders_pass003_update_kmeans_wgsl.h>
@@ -9,15 +11,25 @@
 #include <shaders_pass005_partition_ordering_wgsl.h>
 #include <shaders_pass006_evaluate_partition_candidates_wgsl.h>
 #include <shaders_pass007_prepare_partitioned_blocks_wgsl.h>
-#include <shaders_pass01_ideal_endpoints_and_weights_wgsl.h>
+#include <shaders_pass008_compact_active_blocks_wgsl.h>
+#include <shaders_pass01_ideal_endpoints_and_weights_1part_wgsl.h>
+#include <shaders_pass01_ideal_endpoints_and_weights_2part_wgsl.h>
+#include <shaders_pass01_ideal_endpoints_and_weights_3part_wgsl.h>
+#include <shaders_pass01_ideal_endpoints_and_weights_4part_wgsl.h>
 #include <shaders_pass02_decimated_weights_wgsl.h>
 #include <shaders_pass03_compute_angular_offsets_wgsl.h>
 #include <shaders_pass04_lowest_and_highest_weight_wgsl.h>
 #include <shaders_pass05_best_values_for_quant_levels_wgsl.h>
 #include <shaders_pass06_remap_low_and_high_values_wgsl.h>
 #include <shaders_pass07_weights_and_error_for_bm_wgsl.h>
-#include <shaders_pass08_compute_encoding_choice_errors_wgsl.h>
-#include <shaders_pass09_compute_color_error_wgsl.h>
+#include <shaders_pass08_compute_encoding_choice_errors_1part_wgsl.h>
+#include <shaders_pass08_compute_encoding_choice_errors_2part_wgsl.h>
+#include <shaders_pass08_compute_encoding_choice_errors_3part_wgsl.h>
+#include <shaders_pass08_compute_encoding_choice_errors_4part_wgsl.h>
+#include <shaders_pass09_compute_color_error_1part_wgsl.h>
+#include <shaders_pass09_compute_color_error_2part_wgsl.h>
+#include <shaders_pass09_compute_color_error_3part_wgsl.h>
+#include <shaders_pass09_compute_color_error_4part_wgsl.h>
 #include <shaders_pass10_color_combinations_for_quant_2part_wgsl.h>
 #include <shaders_pass10_color_combinations_for_quant_3part_wgsl.h>
 #include <shaders_pass10_color_combinations_for_quant_4part_wgsl.h>
@@ -26,22 +38,50 @@
 #include <shaders_pass11_best_color_combination_for_mode_3part_wgsl.h>
 #include <shaders_pass11_best_color_combination_for_mode_4part_wgsl.h>
 #include <shaders_pass12_find_top_N_candidates_wgsl.h>
-#include <shaders_pass13_recompute_ideal_endpoints_wgsl.h>
-#include <shaders_pass14_pack_color_endpoints_wgsl.h>
-#include <shaders_pass15_unpack_color_endpoints_wgsl.h>
-#include <shaders_pass16_realign_weights_wgsl.h>
-#include <shaders_pass17_compute_final_error_wgsl.h>
+#include <shaders_pass13_recompute_ideal_endpoints_1part_wgsl.h>
+#include <shaders_pass13_recompute_ideal_endpoints_2part_wgsl.h>
+#include <shaders_pass13_recompute_ideal_endpoints_3part_wgsl.h>
+#include <shaders_pass13_recompute_ideal_endpoints_4part_wgsl.h>
+#include <shaders_pass14_pack_color_endpoints_1part_wgsl.h>
+#include <shaders_pass14_pack_color_endpoints_2part_wgsl.h>
+#include <shaders_pass14_pack_color_endpoints_3part_wgsl.h>
+#include <shaders_pass14_pack_color_endpoints_4part_wgsl.h>
+#include <shaders_pass15_unpack_color_endpoints_1part_wgsl.h>
+#include <shaders_pass15_unpack_color_endpoints_2part_wgsl.h>
+#include <shaders_pass15_unpack_color_endpoints_3part_wgsl.h>
+#include <shaders_pass15_unpack_color_endpoints_4part_wgsl.h>
+#include <shaders_pass16_realign_weights_1part_wgsl.h>
+#include <shaders_pass16_realign_weights_2part_wgsl.h>
+#include <shaders_pass16_realign_weights_3part_wgsl.h>
+#include <shaders_pass16_realign_weights_4part_wgsl.h>
+#include <shaders_pass17_compute_final_error_1part_wgsl.h>
+#include <shaders_pass17_compute_final_error_2part_wgsl.h>
+#include <shaders_pass17_compute_final_error_3part_wgsl.h>
+#include <shaders_pass17_compute_final_error_4part_wgsl.h>
 #include <shaders_pass18_pick_best_candidate_wgsl.h>
+#include <shaders_pass19_symbolic_to_physical_wgsl.h>
 #endif
 
 
 void ASTCEncoder::initBindGroupLayouts() {
 
+    //bind group layout for pass 000
+    std::vector<wgpu::BindGroupLayoutEntry> bg000_entries;
+    bg000_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Extraction uniforms buffer
+    bg000_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Image rows buffer
+    bg000_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Input block buffer
+
+    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc000 = {};
+    bindGroupLayoutDesc000.entryCount = (uint32_t)bg000_entries.size();
+    bindGroupLayoutDesc000.entries = bg000_entries.data();
+    pass000_bindGroupLayout = device.CreateBindGroupLayout(&bindGroupLayoutDesc000);
+
     //bind group layout for pass 001
     std::vector<wgpu::BindGroupLayoutEntry> bg001_entries;
-    bg001_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms buffer
+    bg001_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms buffer
     bg001_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Input block buffer
     bg001_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass001 (cluster centers)
+    bg001_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass008 (active blocks)
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc001 = {};
     bindGroupLayoutDesc001.entryCount = (uint32_t)bg001_entries.size();
@@ -50,10 +90,11 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 002
     std::vector<wgpu::BindGroupLayoutEntry> bg002_entries;
-    bg002_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms buffer
+    bg002_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms buffer
     bg002_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Input block buffer
     bg002_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass001 (cluster centers)
     bg002_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass002 (texel assignments)
+    bg002_entries.push_back({ .binding = 4, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass008 (active blocks)
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc002 = {};
     bindGroupLayoutDesc002.entryCount = (uint32_t)bg002_entries.size();
@@ -63,10 +104,11 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 003
     std::vector<wgpu::BindGroupLayoutEntry> bg003_entries;
-    bg003_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms buffer
+    bg003_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms buffer
     bg003_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Input block buffer
     bg003_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass002 (texel assignments)
     bg003_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass001 (cluster centers)
+    bg003_entries.push_back({ .binding = 4, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass008 (active blocks)
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc003 = {};
     bindGroupLayoutDesc003.entryCount = (uint32_t)bg003_entries.size();
@@ -76,7 +118,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 004
     std::vector<wgpu::BindGroupLayoutEntry> bg004_entries;
-    bg004_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms buffer
+    bg004_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms buffer
     bg004_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //k-means texels buffer
     bg004_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Coverage bitmaps 2 buffer
     bg004_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Coverage bitmaps 3 buffer
@@ -92,7 +134,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 005
     std::vector<wgpu::BindGroupLayoutEntry> bg005_entries;
-    bg005_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms buffer
+    bg005_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms buffer
     bg005_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass004 (mismatch counts)
     bg005_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass005 (partition ordering)
 
@@ -104,11 +146,12 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 006
     std::vector<wgpu::BindGroupLayoutEntry> bg006_entries;
-    bg006_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms buffer
+    bg006_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms buffer
     bg006_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Partition infos buffer
 	bg006_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Input block buffer
     bg006_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass005 (partition ordering)
     bg006_entries.push_back({ .binding = 4, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass006 (final partition errors)
+    bg006_entries.push_back({ .binding = 5, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass008 (active blocks)
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc006 = {};
     bindGroupLayoutDesc006.entryCount = (uint32_t)bg006_entries.size();
@@ -118,22 +161,35 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 007
     std::vector<wgpu::BindGroupLayoutEntry> bg007_entries;
-    bg007_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms buffer
-    bg007_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Partition infos buffer
-    bg007_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Input block buffer
+    bg007_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms buffer
     bg007_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass006 (final partition errors)
     bg007_entries.push_back({ .binding = 4, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass007 (partitioned blocks)
+    bg007_entries.push_back({ .binding = 5, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass008 (active blocks)
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc007 = {};
     bindGroupLayoutDesc007.entryCount = (uint32_t)bg007_entries.size();
     bindGroupLayoutDesc007.entries = bg007_entries.data();
     pass007_bindGroupLayout = device.CreateBindGroupLayout(&bindGroupLayoutDesc007);
 
+    //bind group layout for pass 008
+    std::vector<wgpu::BindGroupLayoutEntry> bg008_entries;
+    bg008_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms buffer
+    bg008_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass18 (best symbolic blocks so far)
+    bg008_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass008 (active blocks)
+    bg008_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass008 (indirect dispatch arguments)
+
+    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc008 = {};
+    bindGroupLayoutDesc008.entryCount = (uint32_t)bg008_entries.size();
+    bindGroupLayoutDesc008.entries = bg008_entries.data();
+    pass008_bindGroupLayout = device.CreateBindGroupLayout(&bindGroupLayoutDesc008);
+
     //bind group layout for pass 1
     std::vector<wgpu::BindGroupLayoutEntry> bg1_entries;
-    bg1_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms buffer
+    bg1_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms buffer
     bg1_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Input block buffer
     bg1_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass1
+    bg1_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass007 (partitioned blocks)
+    bg1_entries.push_back({ .binding = 4, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Partition infos buffer
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc1 = {};
     bindGroupLayoutDesc1.entryCount = (uint32_t)bg1_entries.size();
@@ -143,7 +199,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 2
     std::vector<wgpu::BindGroupLayoutEntry> bg2_entries;
-    bg2_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg2_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg2_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Valid decimation modes buffer
     bg2_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Decimation infos buffer
     bg2_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Texel to weight map buffer
@@ -158,7 +214,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 3
     std::vector<wgpu::BindGroupLayoutEntry> bg3_entries;
-    bg3_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg3_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg3_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Valid decimation modes buffer
     bg3_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Decimation infos buffer
     bg3_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Sin table buffer
@@ -174,7 +230,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 4
     std::vector<wgpu::BindGroupLayoutEntry> bg4_entries;
-    bg4_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg4_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg4_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Valid decimation modes buffer
     bg4_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Decimation infos buffer
     bg4_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass2 (decimated weights)
@@ -189,7 +245,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 5
     std::vector<wgpu::BindGroupLayoutEntry> bg5_entries;
-    bg5_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg5_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg5_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Valid decimation modes buffer
     bg5_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Decimation infos buffer
     bg5_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass3 (angular offsets)
@@ -205,7 +261,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 6
     std::vector<wgpu::BindGroupLayoutEntry> bg6_entries;
-    bg6_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg6_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg6_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Valid block modes buffer
     bg6_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Block modes buffer
     bg6_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass5 (low values)
@@ -220,7 +276,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind group layout for pass 7
     std::vector<wgpu::BindGroupLayoutEntry> bg7_entries;
-    bg7_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg7_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg7_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Valid block modes buffer
     bg7_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Block modes buffer
     bg7_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Decimation infos buffer
@@ -237,10 +293,12 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 8
     std::vector<wgpu::BindGroupLayoutEntry> bg8_entries;
-    bg8_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg8_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg8_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Input blocks buffer
     bg8_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass1 (ideal endpoints and weights)
     bg8_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass8 (encoding choice errors)
+    bg8_entries.push_back({ .binding = 4, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass007 (partitioned blocks)
+    bg8_entries.push_back({ .binding = 5, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Partition infos buffer
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc8 = {};
     bindGroupLayoutDesc8.entryCount = (uint32_t)bg8_entries.size();
@@ -249,12 +307,13 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 9
     std::vector<wgpu::BindGroupLayoutEntry> bg9_entries;
-    bg9_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
-    bg9_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Input blocks buffer
+    bg9_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
+    bg9_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass007 (partitioned blocks)
     bg9_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass1 (ideal endpoints and weights)
     bg9_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass8 (encoding choice errors)
     bg9_entries.push_back({ .binding = 4, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass9 (color format errors)
     bg9_entries.push_back({ .binding = 5, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass9 (color formats)
+    bg9_entries.push_back({ .binding = 6, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Partition infos buffer
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc9 = {};
     bindGroupLayoutDesc9.entryCount = (uint32_t)bg9_entries.size();
@@ -263,7 +322,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 10
     std::vector<wgpu::BindGroupLayoutEntry> bg10_entries;
-    bg10_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg10_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg10_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass9 (color format errors)
     bg10_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass9 (color formats)
     bg10_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass10 (color format combinations)
@@ -275,7 +334,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 11, 1 partition
     std::vector<wgpu::BindGroupLayoutEntry> bg11_1_entries;
-    bg11_1_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg11_1_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg11_1_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Valid block modes buffer
     bg11_1_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass7 (quantization results)
     bg11_1_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass9 (color format errors)
@@ -289,7 +348,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 11, 2,3,4 partitions
     std::vector<wgpu::BindGroupLayoutEntry> bg11_234_entries;
-    bg11_234_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg11_234_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg11_234_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Valid block modes buffer
     bg11_234_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass7 (quantization results)
     bg11_234_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass10 (color format combinations)
@@ -302,7 +361,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 12
     std::vector<wgpu::BindGroupLayoutEntry> bg12_entries;
-    bg12_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg12_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg12_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Valid block modes buffer
     bg12_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass 1 (ideal endpoints and weights)
     bg12_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //output of pass 7 (quantization results)
@@ -317,13 +376,15 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 13
     std::vector<wgpu::BindGroupLayoutEntry> bg13_entries;
-    bg13_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg13_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg13_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Decimation infos buffer
     bg13_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Texel to weight map buffer
     bg13_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Block modes buffer
     bg13_entries.push_back({ .binding = 4, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Input blocks buffer
     bg13_entries.push_back({ .binding = 5, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass12 (final candidates)
     bg13_entries.push_back({ .binding = 6, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass13 (rgbs vectors)
+    bg13_entries.push_back({ .binding = 7, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass007 (partitioned blocks)
+    bg13_entries.push_back({ .binding = 8, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Partition infos buffer
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc13 = {};
     bindGroupLayoutDesc13.entryCount = (uint32_t)bg13_entries.size();
@@ -332,7 +393,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 14
     std::vector<wgpu::BindGroupLayoutEntry> bg14_entries;
-    bg14_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg14_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg14_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass13 (rgbs vectors)
     bg14_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass12 (final candidates)
 
@@ -343,7 +404,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 15
     std::vector<wgpu::BindGroupLayoutEntry> bg15_entries;
-    bg15_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg15_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg15_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass12 (final candidates)
     bg15_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass15 (unpacked endpoints)
 
@@ -354,7 +415,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 16
     std::vector<wgpu::BindGroupLayoutEntry> bg16_entries;
-    bg16_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg16_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg16_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Block modes
     bg16_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Decimation infos
     bg16_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Texel to weight map
@@ -362,6 +423,8 @@ void ASTCEncoder::initBindGroupLayouts() {
     bg16_entries.push_back({ .binding = 5, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Input blocks
     bg16_entries.push_back({ .binding = 6, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass15 (unpacked endpoints)
     bg16_entries.push_back({ .binding = 7, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass12 (final candidates)
+    bg16_entries.push_back({ .binding = 8, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass007 (partitioned blocks)
+    bg16_entries.push_back({ .binding = 9, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Partition infos buffer
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc16 = {};
     bindGroupLayoutDesc16.entryCount = (uint32_t)bg16_entries.size();
@@ -370,7 +433,7 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 17
     std::vector<wgpu::BindGroupLayoutEntry> bg17_entries;
-    bg17_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
+    bg17_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
     bg17_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Block modes
     bg17_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Decimation infos
     bg17_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Texel to weight map
@@ -378,6 +441,8 @@ void ASTCEncoder::initBindGroupLayouts() {
     bg17_entries.push_back({ .binding = 5, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass15 (unpacked endpoints)
     bg17_entries.push_back({ .binding = 6, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass12 (final candidates)
     bg17_entries.push_back({ .binding = 7, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass12 (top candidates)
+    bg17_entries.push_back({ .binding = 8, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass007 (partitioned blocks)
+    bg17_entries.push_back({ .binding = 9, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Partition infos buffer
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc17 = {};
     bindGroupLayoutDesc17.entryCount = (uint32_t)bg17_entries.size();
@@ -386,900 +451,777 @@ void ASTCEncoder::initBindGroupLayouts() {
 
     //bind grup layout for pass 18
     std::vector<wgpu::BindGroupLayoutEntry> bg18_entries;
-    bg18_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform} }); //Uniforms Buffer
-    bg18_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Input blocks
+    bg18_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
+    bg18_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass007 (partitioned blocks)
     bg18_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass12 (top candidates)
     bg18_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Block modes
     bg18_entries.push_back({ .binding = 4, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass18 (symbolic blocks)
+    bg18_entries.push_back({ .binding = 5, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass008 (active blocks)
+    bg18_entries.push_back({ .binding = 6, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Partition infos
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc18 = {};
     bindGroupLayoutDesc18.entryCount = (uint32_t)bg18_entries.size();
     bindGroupLayoutDesc18.entries = bg18_entries.data();
     pass18_bindGroupLayout = device.CreateBindGroupLayout(&bindGroupLayoutDesc18);
+
+    //bind grup layout for pass 19
+    std::vector<wgpu::BindGroupLayoutEntry> bg19_entries;
+    bg19_entries.push_back({ .binding = 0, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Uniform, .hasDynamicOffset = true} }); //Uniforms Buffer
+    bg19_entries.push_back({ .binding = 1, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Output of pass18 (symbolic blocks)
+    bg19_entries.push_back({ .binding = 2, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Block modes
+    bg19_entries.push_back({ .binding = 3, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Block mode index
+    bg19_entries.push_back({ .binding = 4, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //Decimation infos
+    bg19_entries.push_back({ .binding = 5, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage} }); //ISE tables
+    bg19_entries.push_back({ .binding = 6, .visibility = wgpu::ShaderStage::Compute, .buffer = {.type = wgpu::BufferBindingType::Storage} }); //Output of pass19 (physical blocks)
+
+    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc19 = {};
+    bindGroupLayoutDesc19.entryCount = (uint32_t)bg19_entries.size();
+    bindGroupLayoutDesc19.entries = bg19_entries.data();
+    pass19_bindGroupLayout = device.CreateBindGroupLayout(&bindGroupLayoutDesc19);
 }
 
-#if !defined(EMSCRIPTEN)
-void ASTCEncoder::initPipelines() {
+#if defined(EMSCRIPTEN)
+#define SHADER_SOURCE(name) "/shaders/" #name ".wgsl"
+#else
+#define SHADER_SOURCE(name) Shaders::shaders_##name##_wgsl, Shaders::shaders_##name##_wgsl_len
+#endif
 
-    // Load shader modules form embbeded shader code
-    pass001_initKmeansShader = prepareShaderModule(device, Shaders::shaders_pass001_init_kmeans_wgsl, Shaders::shaders_pass001_init_kmeans_wgsl_len, "Init k-means (pass001)");
-    pass002_assignKmeansShader = prepareShaderModule(device, Shaders::shaders_pass002_assign_kmeans_wgsl, Shaders::shaders_pass002_assign_kmeans_wgsl_len, "Assign k-means (pass002)");
-    pass003_updateKmeansShader = prepareShaderModule(device, Shaders::shaders_pass003_update_kmeans_wgsl, Shaders::shaders_pass003_update_kmeans_wgsl_len, "Update k-means (pass003)");
-    pass004_partitionMismatchShader = prepareShaderModule(device, Shaders::shaders_pass004_count_partition_mismatch_wgsl, Shaders::shaders_pass004_count_partition_mismatch_wgsl_len, "Count partition mismatch (pass004)");
-    pass005_partitionOrderingShader = prepareShaderModule(device, Shaders::shaders_pass005_partition_ordering_wgsl, Shaders::shaders_pass005_partition_ordering_wgsl_len, "Partition ordering (pass005)");
-    pass006_evaluatePartitionShader = prepareShaderModule(device, Shaders::shaders_pass006_evaluate_partition_candidates_wgsl, Shaders::shaders_pass006_evaluate_partition_candidates_wgsl_len, "Evaluate partition candidates (pass006)");
-	pass007_preparePartitionedBlocksShader = prepareShaderModule(device, Shaders::shaders_pass007_prepare_partitioned_blocks_wgsl, Shaders::shaders_pass007_prepare_partitioned_blocks_wgsl_len, "Prepare partitioned blocks (pass007)");
-    pass1_idealEndpointsShader = prepareShaderModule(device, Shaders::shaders_pass01_ideal_endpoints_and_weights_wgsl, Shaders::shaders_pass01_ideal_endpoints_and_weights_wgsl_len, "Ideal endpoints and weights (pass1)");
-    pass2_decimatedWeightsShader = prepareShaderModule(device, Shaders::shaders_pass02_decimated_weights_wgsl, Shaders::shaders_pass02_decimated_weights_wgsl_len, "decimated weights (pass2)");
-    pass3_angularOffsetsShader = prepareShaderModule(device, Shaders::shaders_pass03_compute_angular_offsets_wgsl, Shaders::shaders_pass03_compute_angular_offsets_wgsl_len, "angular offsets (pass3)");
-    pass4_lowestAndHighestWeightShader = prepareShaderModule(device, Shaders::shaders_pass04_lowest_and_highest_weight_wgsl, Shaders::shaders_pass04_lowest_and_highest_weight_wgsl_len, "lowest and highest weight (pass4)");
-    pass5_valuesForQuantLevelsShader = prepareShaderModule(device, Shaders::shaders_pass05_best_values_for_quant_levels_wgsl, Shaders::shaders_pass05_best_values_for_quant_levels_wgsl_len, "best values for quant levels (pass5)");
-    pass6_remapLowAndHighValuesShader = prepareShaderModule(device, Shaders::shaders_pass06_remap_low_and_high_values_wgsl, Shaders::shaders_pass06_remap_low_and_high_values_wgsl_len, "remap low and high values (pass6)");
-    pass7_weightsAndErrorForBMShader = prepareShaderModule(device, Shaders::shaders_pass07_weights_and_error_for_bm_wgsl, Shaders::shaders_pass07_weights_and_error_for_bm_wgsl_len, "weights and error for block mode (pass7)");
-    pass8_encodingChoiceErrorsShader = prepareShaderModule(device, Shaders::shaders_pass08_compute_encoding_choice_errors_wgsl, Shaders::shaders_pass08_compute_encoding_choice_errors_wgsl_len, "encoding choice errors (pass8)");
-    pass9_computeColorErrorShader = prepareShaderModule(device, Shaders::shaders_pass09_compute_color_error_wgsl, Shaders::shaders_pass09_compute_color_error_wgsl_len, "color format errors (pass9)");
-    pass10_colorEndpointCombinationsShader_2part = prepareShaderModule(device, Shaders::shaders_pass10_color_combinations_for_quant_2part_wgsl, Shaders::shaders_pass10_color_combinations_for_quant_2part_wgsl_len, "color endpoint combinations (pass10, 2part)");
-    pass10_colorEndpointCombinationsShader_3part = prepareShaderModule(device, Shaders::shaders_pass10_color_combinations_for_quant_3part_wgsl, Shaders::shaders_pass10_color_combinations_for_quant_3part_wgsl_len, "color endpoint combinations (pass10, 3part)");
-    pass10_colorEndpointCombinationsShader_4part = prepareShaderModule(device, Shaders::shaders_pass10_color_combinations_for_quant_4part_wgsl, Shaders::shaders_pass10_color_combinations_for_quant_4part_wgsl_len, "color endpoint combinations (pass10, 4part)");
-    pass11_bestEndpointCombinationsForModeShader_1part = prepareShaderModule(device, Shaders::shaders_pass11_best_color_combination_for_mode_1part_wgsl, Shaders::shaders_pass11_best_color_combination_for_mode_1part_wgsl_len, "best endpoint combinations for mode (pass11, 1part)");
-    pass11_bestEndpointCombinationsForModeShader_2part = prepareShaderModule(device, Shaders::shaders_pass11_best_color_combination_for_mode_2part_wgsl, Shaders::shaders_pass11_best_color_combination_for_mode_2part_wgsl_len, "best endpoint combinations for mode (pass11, 2part)");
-    pass11_bestEndpointCombinationsForModeShader_3part = prepareShaderModule(device, Shaders::shaders_pass11_best_color_combination_for_mode_3part_wgsl, Shaders::shaders_pass11_best_color_combination_for_mode_3part_wgsl_len, "best endpoint combinations for mode (pass11, 3part)");
-    pass11_bestEndpointCombinationsForModeShader_4part = prepareShaderModule(device, Shaders::shaders_pass11_best_color_combination_for_mode_4part_wgsl, Shaders::shaders_pass11_best_color_combination_for_mode_4part_wgsl_len, "best endpoint combinations for mode (pass11, 4part)");
-    pass12_findTopNCandidatesShader = prepareShaderModule(device, Shaders::shaders_pass12_find_top_N_candidates_wgsl, Shaders::shaders_pass12_find_top_N_candidates_wgsl_len, "find top N candidates (pass12)");
-    pass13_recomputeIdealEndpointsShader = prepareShaderModule(device, Shaders::shaders_pass13_recompute_ideal_endpoints_wgsl, Shaders::shaders_pass13_recompute_ideal_endpoints_wgsl_len, "recompute ideal endpoints (pass13)");
-    pass14_packColorEndpointsShader = prepareShaderModule(device, Shaders::shaders_pass14_pack_color_endpoints_wgsl, Shaders::shaders_pass14_pack_color_endpoints_wgsl_len, "pack color endpoints (pass14)");
-    pass15_unpackColorEndpointsShader = prepareShaderModule(device, Shaders::shaders_pass15_unpack_color_endpoints_wgsl, Shaders::shaders_pass15_unpack_color_endpoints_wgsl_len, "unpack color endpoints (pass15)");
-    pass16_realignWeightsShader = prepareShaderModule(device, Shaders::shaders_pass16_realign_weights_wgsl, Shaders::shaders_pass16_realign_weights_wgsl_len, "realign weights (pass16)");
-    pass17_computeFinalErrorShader = prepareShaderModule(device, Shaders::shaders_pass17_compute_final_error_wgsl, Shaders::shaders_pass17_compute_final_error_wgsl_len, "compute final error (pass17)");
-    pass18_pickBestCandidateShader = prepareShaderModule(device, Shaders::shaders_pass18_pick_best_candidate_wgsl, Shaders::shaders_pass18_pick_best_candidate_wgsl_len, "pick best candidate (pass18)");
-
-
-    if (!pass1_idealEndpointsShader) {
-        std::cerr << "FATAL ERROR: Failed to create shader module for pass 1. Check shader file paths." << std::endl;
-        // You could even throw an exception here to halt execution
-        throw std::runtime_error("Failed to load a critical shader.");
-    }
+void ASTCEncoder::initPipelineBuildQueue() {
+    //the partition count column is the lowest partition count that uses the pipeline (partitioning passes and the
+    //partition count variants composed by compose_wgsl.py are not needed by batches with fewer partitions), passes
+    //with per texel workgroup arrays are specialised for the texel capacity of the block size
+    m_pipeline_build_queue = {
+        {&pass000_extractBlocksShader, SHADER_SOURCE(pass000_extract_blocks), "Extract blocks (pass000)", &pass000_pipeline, &pass000_bindGroupLayout, 1},
+        {&pass001_initKmeansShader, SHADER_SOURCE(pass001_init_kmeans), "Init k-means (pass001)", &pass001_pipeline, &pass001_bindGroupLayout, 2, PipelineSpecialization::TexelCapacityAndWorkgroupSize},
+        {&pass002_assignKmeansShader, SHADER_SOURCE(pass002_assign_kmeans), "Assign k-means (pass002)", &pass002_pipeline, &pass002_bindGroupLayout, 2},
+        {&pass003_updateKmeansShader, SHADER_SOURCE(pass003_update_kmeans), "Update k-means (pass003)", &pass003_pipeline, &pass003_bindGroupLayout, 2},
+        {&pass004_partitionMismatchShader, SHADER_SOURCE(pass004_count_partition_mismatch), "Count partition mismatch (pass004)", &pass004_pipeline, &pass004_bindGroupLayout, 2},
+        {&pass005_partitionOrderingShader, SHADER_SOURCE(pass005_partition_ordering), "Partition ordering (pass005)", &pass005_pipeline, &pass005_bindGroupLayout, 2},
+        {&pass006_evaluatePartitionShader, SHADER_SOURCE(pass006_evaluate_partition_candidates), "Evaluate partition candidates (pass006)", &pass006_pipeline, &pass006_bindGroupLayout, 2, PipelineSpecialization::TexelCapacityAndWorkgroupSize},
+        {&pass007_preparePartitionedBlocksShader, SHADER_SOURCE(pass007_prepare_partitioned_blocks), "Prepare partitioned blocks (pass007)", &pass007_pipeline, &pass007_bindGroupLayout, 2},
+        {&pass008_compactActiveBlocksShader, SHADER_SOURCE(pass008_compact_active_blocks), "Compact active blocks (pass008)", &pass008_pipeline, &pass008_bindGroupLayout, 1},
+        {&pass1_idealEndpointsShader[0], SHADER_SOURCE(pass01_ideal_endpoints_and_weights_1part), "Ideal endpoints and weights (pass1, 1part)", &pass1_pipeline[0], &pass1_bindGroupLayout, 1},
+        {&pass1_idealEndpointsShader[1], SHADER_SOURCE(pass01_ideal_endpoints_and_weights_2part), "Ideal endpoints and weights (pass1, 2part)", &pass1_pipeline[1], &pass1_bindGroupLayout, 2},
+        {&pass1_idealEndpointsShader[2], SHADER_SOURCE(pass01_ideal_endpoints_and_weights_3part), "Ideal endpoints and weights (pass1, 3part)", &pass1_pipeline[2], &pass1_bindGroupLayout, 3},
+        {&pass1_idealEndpointsShader[3], SHADER_SOURCE(pass01_ideal_endpoints_and_weights_4part), "Ideal endpoints and weights (pass1, 4part)", &pass1_pipeline[3], &pass1_bindGroupLayout, 4},
+        {&pass2_decimatedWeightsShader, SHADER_SOURCE(pass02_decimated_weights), "decimated weights (pass2)", &pass2_pipeline, &pass2_bindGroupLayout, 1, PipelineSpecialization::TexelCapacity},
+        {&pass3_angularOffsetsShader, SHADER_SOURCE(pass03_compute_angular_offsets), "angular offsets (pass3)", &pass3_pipeline, &pass3_bindGroupLayout, 1},
+        {&pass4_lowestAndHighestWeightShader, SHADER_SOURCE(pass04_lowest_and_highest_weight), "lowest and highest weight (pass4)", &pass4_pipeline, &pass4_bindGroupLayout, 1},
+        {&pass5_valuesForQuantLevelsShader, SHADER_SOURCE(pass05_best_values_for_quant_levels), "best values for quant levels (pass5)", &pass5_pipeline, &pass5_bindGroupLayout, 1},
+        {&pass6_remapLowAndHighValuesShader, SHADER_SOURCE(pass06_remap_low_and_high_values), "remap low and high values (pass6)", &pass6_pipeline, &pass6_bindGroupLayout, 1},
+        {&pass7_weightsAndErrorForBMShader, SHADER_SOURCE(pass07_weights_and_error_for_bm), "weights and error for block mode (pass7)", &pass7_pipeline, &pass7_bindGroupLayout, 1, PipelineSpecialization::TexelCapacity},
+        {&pass8_encodingChoiceErrorsShader[0], SHADER_SOURCE(pass08_compute_encoding_choice_errors_1part), "encoding choice errors (pass8, 1part)", &pass8_pipeline[0], &pass8_bindGroupLayout, 1},
+        {&pass8_encodingChoiceErrorsShader[1], SHADER_SOURCE(pass08_compute_encoding_choice_errors_2part), "encoding choice errors (pass8, 2part)", &pass8_pipeline[1], &pass8_bindGroupLayout, 2},
+        {&pass8_encodingChoiceErrorsShader[2], SHADER_SOURCE(pass08_compute_encoding_choice_errors_3part), "encoding choice errors (pass8, 3part)", &pass8_pipeline[2], &pass8_bindGroupLayout, 3},
+        {&pass8_encodingChoiceErrorsShader[3], SHADER_SOURCE(pass08_compute_encoding_choice_errors_4part), "encoding choice errors (pass8, 4part)", &pass8_pipeline[3], &pass8_bindGroupLayout, 4},
+        {&pass9_computeColorErrorShader[0], SHADER_SOURCE(pass09_compute_color_error_1part), "color format errors (pass9, 1part)", &pass9_pipeline[0], &pass9_bindGroupLayout, 1},
+        {&pass9_computeColorErrorShader[1], SHADER_SOURCE(pass09_compute_color_error_2part), "color format errors (pass9, 2part)", &pass9_pipeline[1], &pass9_bindGroupLayout, 2},
+        {&pass9_computeColorErrorShader[2], SHADER_SOURCE(pass09_compute_color_error_3part), "color format errors (pass9, 3part)", &pass9_pipeline[2], &pass9_bindGroupLayout, 3},
+        {&pass9_computeColorErrorShader[3], SHADER_SOURCE(pass09_compute_color_error_4part), "color format errors (pass9, 4part)", &pass9_pipeline[3], &pass9_bindGroupLayout, 4},
+        {&pass10_colorEndpointCombinationsShader_2part, SHADER_SOURCE(pass10_color_combinations_for_quant_2part), "color endpoint combinations (pass10, 2part)", &pass10_pipeline_2part, &pass10_bindGroupLayout, 2},
+        {&pass10_colorEndpointCombinationsShader_3part, SHADER_SOURCE(pass10_color_combinations_for_quant_3part), "color endpoint combinations (pass10, 3part)", &pass10_pipeline_3part, &pass10_bindGroupLayout, 3},
+        {&pass10_colorEndpointCombinationsShader_4part, SHADER_SOURCE(pass10_color_combinations_for_quant_4part), "color endpoint combinations (pass10, 4part)", &pass10_pipeline_4part, &pass10_bindGroupLayout, 4},
+        {&pass11_bestEndpointCombinationsForModeShader_1part, SHADER_SOURCE(pass11_best_color_combination_for_mode_1part), "best endpoint combinations for mode (pass11, 1part)", &pass11_pipeline_1part, &pass11_bindGroupLayout_1part, 1},
+        {&pass11_bestEndpointCombinationsForModeShader_2part, SHADER_SOURCE(pass11_best_color_combination_for_mode_2part), "best endpoint combinations for mode (pass11, 2part)", &pass11_pipeline_2part, &pass11_bindGroupLayout_234part, 2},
+        {&pass11_bestEndpointCombinationsForModeShader_3part, SHADER_SOURCE(pass11_best_color_combination_for_mode_3part), "best endpoint combinations for mode (pass11, 3part)", &pass11_pipeline_3part, &pass11_bindGroupLayout_234part, 3},
+        {&pass11_bestEndpointCombinationsForModeShader_4part, SHADER_SOURCE(pass11_best_color_combination_for_mode_4part), "best endpoint combinations for mode (pass11, 4part)", &pass11_pipeline_4part, &pass11_bindGroupLayout_234part, 4},
+        {&pass12_findTopNCandidatesShader, SHADER_SOURCE(pass12_find_top_N_candidates), "find top N candidates (pass12)", &pass12_pipeline, &pass12_bindGroupLayout, 1},
+        {&pass13_recomputeIdealEndpointsShader[0], SHADER_SOURCE(pass13_recompute_ideal_endpoints_1part), "recompute ideal endpoints (pass13, 1part)", &pass13_pipeline[0], &pass13_bindGroupLayout, 1, PipelineSpecialization::TexelCapacity},
+        {&pass13_recomputeIdealEndpointsShader[1], SHADER_SOURCE(pass13_recompute_ideal_endpoints_2part), "recompute ideal endpoints (pass13, 2part)", &pass13_pipeline[1], &pass13_bindGroupLayout, 2, PipelineSpecialization::TexelCapacity},
+        {&pass13_recomputeIdealEndpointsShader[2], SHADER_SOURCE(pass13_recompute_ideal_endpoints_3part), "recompute ideal endpoints (pass13, 3part)", &pass13_pipeline[2], &pass13_bindGroupLayout, 3, PipelineSpecialization::TexelCapacity},
+        {&pass13_recomputeIdealEndpointsShader[3], SHADER_SOURCE(pass13_recompute_ideal_endpoints_4part), "recompute ideal endpoints (pass13, 4part)", &pass13_pipeline[3], &pass13_bindGroupLayout, 4, PipelineSpecialization::TexelCapacity},
+        {&pass14_packColorEndpointsShader[0], SHADER_SOURCE(pass14_pack_color_endpoints_1part), "pack color endpoints (pass14, 1part)", &pass14_pipeline[0], &pass14_bindGroupLayout, 1},
+        {&pass14_packColorEndpointsShader[1], SHADER_SOURCE(pass14_pack_color_endpoints_2part), "pack color endpoints (pass14, 2part)", &pass14_pipeline[1], &pass14_bindGroupLayout, 2},
+        {&pass14_packColorEndpointsShader[2], SHADER_SOURCE(pass14_pack_color_endpoints_3part), "pack color endpoints (pass14, 3part)", &pass14_pipeline[2], &pass14_bindGroupLayout, 3},
+        {&pass14_packColorEndpointsShader[3], SHADER_SOURCE(pass14_pack_color_endpoints_4part), "pack color endpoints (pass14, 4part)", &pass14_pipeline[3], &pass14_bindGroupLayout, 4},
+        {&pass15_unpackColorEndpointsShader[0], SHADER_SOURCE(pass15_unpack_color_endpoints_1part), "unpack color endpoints (pass15, 1part)", &pass15_pipeline[0], &pass15_bindGroupLayout, 1},
+        {&pass15_unpackColorEndpointsShader[1], SHADER_SOURCE(pass15_unpack_color_endpoints_2part), "unpack color endpoints (pass15, 2part)", &pass15_pipeline[1], &pass15_bindGroupLayout, 2},
+        {&pass15_unpackColorEndpointsShader[2], SHADER_SOURCE(pass15_unpack_color_endpoints_3part), "unpack color endpoints (pass15, 3part)", &pass15_pipeline[2], &pass15_bindGroupLayout, 3},
+        {&pass15_unpackColorEndpointsShader[3], SHADER_SOURCE(pass15_unpack_color_endpoints_4part), "unpack color endpoints (pass15, 4part)", &pass15_pipeline[3], &pass15_bindGroupLayout, 4},
+        {&pass16_realignWeightsShader[0], SHADER_SOURCE(pass16_realign_weights_1part), "realign weights (pass16, 1part)", &pass16_pipeline[0], &pass16_bindGroupLayout, 1},
+        {&pass16_realignWeightsShader[1], SHADER_SOURCE(pass16_realign_weights_2part), "realign weights (pass16, 2part)", &pass16_pipeline[1], &pass16_bindGroupLayout, 2},
+        {&pass16_realignWeightsShader[2], SHADER_SOURCE(pass16_realign_weights_3part), "realign weights (pass16, 3part)", &pass16_pipeline[2], &pass16_bindGroupLayout, 3},
+        {&pass16_realignWeightsShader[3], SHADER_SOURCE(pass16_realign_weights_4part), "realign weights (pass16, 4part)", &pass16_pipeline[3], &pass16_bindGroupLayout, 4},
+        {&pass17_computeFinalErrorShader[0], SHADER_SOURCE(pass17_compute_final_error_1part), "compute final error (pass17, 1part)", &pass17_pipeline[0], &pass17_bindGroupLayout, 1, PipelineSpecialization::TexelCapacity},
+        {&pass17_computeFinalErrorShader[1], SHADER_SOURCE(pass17_compute_final_error_2part), "compute final error (pass17, 2part)", &pass17_pipeline[1], &pass17_bindGroupLayout, 2, PipelineSpecialization::TexelCapacity},
+        {&pass17_computeFinalErrorShader[2], SHADER_SOURCE(pass17_compute_final_error_3part), "compute final error (pass17, 3part)", &pass17_pipeline[2], &pass17_bindGroupLayout, 3, PipelineSpecialization::TexelCapacity},
+        {&pass17_computeFinalErrorShader[3], SHADER_SOURCE(pass17_compute_final_error_4part), "compute final error (pass17, 4part)", &pass17_pipeline[3], &pass17_bindGroupLayout, 4, PipelineSpecialization::TexelCapacity},
+        {&pass18_pickBestCandidateShader, SHADER_SOURCE(pass18_pick_best_candidate), "pick best candidate (pass18)", &pass18_pipeline, &pass18_bindGroupLayout, 1},
+        {&pass19_symbolicToPhysicalShader, SHADER_SOURCE(pass19_symbolic_to_physical), "symbolic to physical (pass19)", &pass19_pipeline, &pass19_bindGroupLayout, 1},
+    };
+}
 
-    //pass001 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass001_layoutDesc = {};
-    pass001_layoutDesc.bindGroupLayoutCount = 1;
-    pass001_layoutDesc.bindGroupLayouts = &pass001_bindGroupLayout;
-    wgpu::PipelineLayout pass001_pipelineLayout = device.CreatePipelineLayout(&pass001_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass001_pipelineDesc = {};
-    pass001_pipelineDesc.compute.constantCount = 0;
-    pass001_pipelineDesc.compute.constants = nullptr;
-    pass001_pipelineDesc.compute.entryPoint = "main";
-    pass001_pipelineDesc.compute.module = pass001_initKmeansShader;
-    pass001_pipelineDesc.layout = pass001_pipelineLayout;
+#undef SHADER_SOURCE
 
-    pass001_pipeline = device.CreateComputePipeline(&pass001_pipelineDesc);
-    
-
-    //pass002 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass002_layoutDesc = {};
-    pass002_layoutDesc.bindGroupLayoutCount = 1;
-    pass002_layoutDesc.bindGroupLayouts = &pass002_bindGroupLayout;
-    wgpu::PipelineLayout pass002_pipelineLayout = device.CreatePipelineLayout(&pass002_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass002_pipelineDesc = {};
-    pass002_pipelineDesc.compute.constantCount = 0;
-    pass002_pipelineDesc.compute.constants = nullptr;
-    pass002_pipelineDesc.compute.entryPoint = "main";
-    pass002_pipelineDesc.compute.module = pass002_assignKmeansShader;
-    pass002_pipelineDesc.layout = pass002_pipelineLayout;
+void ASTCEncoder::createPipelineAsync(const PipelineBuildInfo& info) {
 
-    pass002_pipeline = device.CreateComputePipeline(&pass002_pipelineDesc);
-
-
-    //pass003 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass003_layoutDesc = {};
-    pass003_layoutDesc.bindGroupLayoutCount = 1;
-    pass003_layoutDesc.bindGroupLayouts = &pass003_bindGroupLayout;
-    wgpu::PipelineLayout pass003_pipelineLayout = device.CreatePipelineLayout(&pass003_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass003_pipelineDesc = {};
-    pass003_pipelineDesc.compute.constantCount = 0;
-    pass003_pipelineDesc.compute.constants = nullptr;
-    pass003_pipelineDesc.compute.entryPoint = "main";
-    pass003_pipelineDesc.compute.module = pass003_updateKmeansShader;
-    pass003_pipelineDesc.layout = pass003_pipelineLayout;
+    //shader modules are kept, specialised pipelines are created from them again for other texel capacities
+    if (!*info.shaderModule) {
+#if defined(EMSCRIPTEN)
+        *info.shaderModule = prepareShaderModule(device, info.shaderPath, info.shaderLabel.c_str());
+#else
+        *info.shaderModule = prepareShaderModule(device, info.shaderData, info.shaderDataLen, info.shaderLabel.c_str());
+#endif
+    }
 
-    pass003_pipeline = device.CreateComputePipeline(&pass003_pipelineDesc);
-
-
-    //pass004 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass004_layoutDesc = {};
-    pass004_layoutDesc.bindGroupLayoutCount = 1;
-    pass004_layoutDesc.bindGroupLayouts = &pass004_bindGroupLayout;
-    wgpu::PipelineLayout pass004_pipelineLayout = device.CreatePipelineLayout(&pass004_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass004_pipelineDesc = {};
-    pass004_pipelineDesc.compute.constantCount = 0;
-    pass004_pipelineDesc.compute.constants = nullptr;
-    pass004_pipelineDesc.compute.entryPoint = "main";
-    pass004_pipelineDesc.compute.module = pass004_partitionMismatchShader;
-    pass004_pipelineDesc.layout = pass004_pipelineLayout;
+    if (!*info.shaderModule) {
+        throw std::runtime_error("Failed to create the shader module of " + info.shaderLabel);
+    }
 
-    pass004_pipeline = device.CreateComputePipeline(&pass004_pipelineDesc);
-
-
-    //pass005 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass005_layoutDesc = {};
-    pass005_layoutDesc.bindGroupLayoutCount = 1;
-    pass005_layoutDesc.bindGroupLayouts = &pass005_bindGroupLayout;
-    wgpu::PipelineLayout pass005_pipelineLayout = device.CreatePipelineLayout(&pass005_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass005_pipelineDesc = {};
-    pass005_pipelineDesc.compute.constantCount = 0;
-    pass005_pipelineDesc.compute.constants = nullptr;
-    pass005_pipelineDesc.compute.entryPoint = "main";
-    pass005_pipelineDesc.compute.module = pass005_partitionOrderingShader;
-    pass005_pipelineDesc.layout = pass005_pipelineLayout;
+    //override constants of the specialised shaders, the rest of the passes is independent of the block size
+    std::vector<wgpu::ConstantEntry> constants;
+    if (info.specialization != PipelineSpecialization::None) {
+        wgpu::ConstantEntry texelCapacity = {};
+        texelCapacity.key = "TEXEL_CAPACITY";
+        texelCapacity.value = m_texel_capacity;
+        constants.push_back(texelCapacity);
+    }
+    if (info.specialization == PipelineSpecialization::TexelCapacityAndWorkgroupSize) {
+        //whole subgroups of 32 invocations
+        wgpu::ConstantEntry workgroupSize = {};
+        workgroupSize.key = "WORKGROUP_SIZE";
+        workgroupSize.value = (m_texel_capacity + 31) / 32 * 32;
+        constants.push_back(workgroupSize);
+    }
 
-    pass005_pipeline = device.CreateComputePipeline(&pass005_pipelineDesc);
-
-
-    //pass006 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass006_layoutDesc = {};
-    pass006_layoutDesc.bindGroupLayoutCount = 1;
-    pass006_layoutDesc.bindGroupLayouts = &pass006_bindGroupLayout;
-    wgpu::PipelineLayout pass006_pipelineLayout = device.CreatePipelineLayout(&pass006_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass006_pipelineDesc = {};
-    pass006_pipelineDesc.compute.constantCount = 0;
-    pass006_pipelineDesc.compute.constants = nullptr;
-    pass006_pipelineDesc.compute.entryPoint = "main";
-    pass006_pipelineDesc.compute.module = pass006_evaluatePartitionShader;
-    pass006_pipelineDesc.layout = pass006_pipelineLayout;
+    wgpu::PipelineLayoutDescriptor layoutDesc = {};
+    layoutDesc.bindGroupLayoutCount = 1;
+    layoutDesc.bindGroupLayouts = info.bindGroupLayout;
+    wgpu::PipelineLayout pipelineLayout = device.CreatePipelineLayout(&layoutDesc);
 
-    pass006_pipeline = device.CreateComputePipeline(&pass006_pipelineDesc);
-
-
-    //pass007 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass007_layoutDesc = {};
-    pass007_layoutDesc.bindGroupLayoutCount = 1;
-    pass007_layoutDesc.bindGroupLayouts = &pass007_bindGroupLayout;
-    wgpu::PipelineLayout pass007_pipelineLayout = device.CreatePipelineLayout(&pass007_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass007_pipelineDesc = {};
-    pass007_pipelineDesc.compute.constantCount = 0;
-    pass007_pipelineDesc.compute.constants = nullptr;
-    pass007_pipelineDesc.compute.entryPoint = "main";
-	pass007_pipelineDesc.compute.module = pass007_preparePartitionedBlocksShader;
-    pass007_pipelineDesc.layout = pass007_pipelineLayout;
+    wgpu::ComputePipelineDescriptor pipelineDesc = {};
+    pipelineDesc.compute.constantCount = constants.size();
+    pipelineDesc.compute.constants = constants.empty() ? nullptr : constants.data();
+    pipelineDesc.compute.entryPoint = "main";
+    pipelineDesc.compute.module = *info.shaderModule;
+    pipelineDesc.layout = pipelineLayout;
 
-    pass007_pipeline = device.CreateComputePipeline(&pass007_pipelineDesc);
+    auto* context = new PipelineCreationContext{
+        this,
+        info.targetPipeline,
+        info.partitionCount,
+        info.shaderLabel
+    };
 
+    device.CreateComputePipelineAsync(&pipelineDesc, &ASTCEncoder::OnPipelineCreated, context);
+}
 
-    //pass1 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass1_layoutDesc = {};
-    pass1_layoutDesc.bindGroupLayoutCount = 1;
-    pass1_layoutDesc.bindGroupLayouts = &pass1_bindGroupLayout;
-    wgpu::PipelineLayout pass1_pipelineLayout = device.CreatePipelineLayout(&pass1_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass1_pipelineDesc = {};
-    pass1_pipelineDesc.compute.constantCount = 0;
-    pass1_pipelineDesc.compute.constants = nullptr;
-    pass1_pipelineDesc.compute.entryPoint = "main";
-    pass1_pipelineDesc.compute.module = pass1_idealEndpointsShader;
-    pass1_pipelineDesc.layout = pass1_pipelineLayout;
+void ASTCEncoder::OnPipelineCreated(WGPUCreatePipelineAsyncStatus status, WGPUComputePipeline pipeline, char const* message, void* userdata) {
 
-    pass1_pipeline = device.CreateComputePipeline(&pass1_pipelineDesc);
+    auto* context = static_cast<PipelineCreationContext*>(userdata);
+    ASTCEncoder* encoder = context->encoderInstance;
 
+    if (status != WGPUCreatePipelineAsyncStatus_Success) {
+        ASTC_LOG(LogLevel::Error, "FATAL: Failed to create compute pipeline " << context->shaderLabel << ": " << (message ? message : ""));
+        encoder->m_pipeline_creation_failed = true;
+    }
+    else {
+        *context->targetPipeline = wgpu::ComputePipeline::Acquire(pipeline);
+    }
 
-    //pass2 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass2_layoutDesc = {};
-    pass2_layoutDesc.bindGroupLayoutCount = 1;
-    pass2_layoutDesc.bindGroupLayouts = &pass2_bindGroupLayout;
-    wgpu::PipelineLayout pass2_pipelineLayout = device.CreatePipelineLayout(&pass2_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass2_pipelineDesc = {};
-    pass2_pipelineDesc.compute.constantCount = 0;
-    pass2_pipelineDesc.compute.constants = nullptr;
-    pass2_pipelineDesc.compute.entryPoint = "main";
-    pass2_pipelineDesc.compute.module = pass2_decimatedWeightsShader;
-    pass2_pipelineDesc.layout = pass2_pipelineLayout;
-
-    pass2_pipeline = device.CreateComputePipeline(&pass2_pipelineDesc);
-
+    int remaining = --encoder->m_pending_pipelines[context->partitionCount];
 
-    //pass3 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass3_layoutDesc = {};
-    pass3_layoutDesc.bindGroupLayoutCount = 1;
-    pass3_layoutDesc.bindGroupLayouts = &pass3_bindGroupLayout;
-    wgpu::PipelineLayout pass3_pipelineLayout = device.CreatePipelineLayout(&pass3_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass3_pipelineDesc = {};
-    pass3_pipelineDesc.compute.constantCount = 0;
-    pass3_pipelineDesc.compute.constants = nullptr;
-    pass3_pipelineDesc.compute.entryPoint = "main";
-    pass3_pipelineDesc.compute.module = pass3_angularOffsetsShader;
-    pass3_pipelineDesc.layout = pass3_pipelineLayout;
-
-    pass3_pipeline = device.CreateComputePipeline(&pass3_pipelineDesc);
-
-
-    //pass4 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass4_layoutDesc = {};
-    pass4_layoutDesc.bindGroupLayoutCount = 1;
-    pass4_layoutDesc.bindGroupLayouts = &pass4_bindGroupLayout;
-    wgpu::PipelineLayout pass4_pipelineLayout = device.CreatePipelineLayout(&pass4_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass4_pipelineDesc = {};
-    pass4_pipelineDesc.compute.constantCount = 0;
-    pass4_pipelineDesc.compute.constants = nullptr;
-    pass4_pipelineDesc.compute.entryPoint = "main";
-    pass4_pipelineDesc.compute.module = pass4_lowestAndHighestWeightShader;
-    pass4_pipelineDesc.layout = pass4_pipelineLayout;
-
-    pass4_pipeline = device.CreateComputePipeline(&pass4_pipelineDesc);
-
-
-    //pass5 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass5_layoutDesc = {};
-    pass5_layoutDesc.bindGroupLayoutCount = 1;
-    pass5_layoutDesc.bindGroupLayouts = &pass5_bindGroupLayout;
-    wgpu::PipelineLayout pass5_pipelineLayout = device.CreatePipelineLayout(&pass5_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass5_pipelineDesc = {};
-    pass5_pipelineDesc.compute.constantCount = 0;
-    pass5_pipelineDesc.compute.constants = nullptr;
-    pass5_pipelineDesc.compute.entryPoint = "main";
-    pass5_pipelineDesc.compute.module = pass5_valuesForQuantLevelsShader;
-    pass5_pipelineDesc.layout = pass5_pipelineLayout;
-
-    pass5_pipeline = device.CreateComputePipeline(&pass5_pipelineDesc);
-
-
-    //pass6 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass6_layoutDesc = {};
-    pass6_layoutDesc.bindGroupLayoutCount = 1;
-    pass6_layoutDesc.bindGroupLayouts = &pass6_bindGroupLayout;
-    wgpu::PipelineLayout pass6_pipelineLayout = device.CreatePipelineLayout(&pass6_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass6_pipelineDesc = {};
-    pass6_pipelineDesc.compute.constantCount = 0;
-    pass6_pipelineDesc.compute.constants = nullptr;
-    pass6_pipelineDesc.compute.entryPoint = "main";
-    pass6_pipelineDesc.compute.module = pass6_remapLowAndHighValuesShader;
-    pass6_pipelineDesc.layout = pass6_pipelineLayout;
-
-    pass6_pipeline = device.CreateComputePipeline(&pass6_pipelineDesc);
-
-
-    //pass7 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass7_layoutDesc = {};
-    pass7_layoutDesc.bindGroupLayoutCount = 1;
-    pass7_layoutDesc.bindGroupLayouts = &pass7_bindGroupLayout;
-    wgpu::PipelineLayout pass7_pipelineLayout = device.CreatePipelineLayout(&pass7_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass7_pipelineDesc = {};
-    pass7_pipelineDesc.compute.constantCount = 0;
-    pass7_pipelineDesc.compute.constants = nullptr;
-    pass7_pipelineDesc.compute.entryPoint = "main";
-    pass7_pipelineDesc.compute.module = pass7_weightsAndErrorForBMShader;
-    pass7_pipelineDesc.layout = pass7_pipelineLayout;
-
-    pass7_pipeline = device.CreateComputePipeline(&pass7_pipelineDesc);
-
-    //pass8 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass8_layoutDesc = {};
-    pass8_layoutDesc.bindGroupLayoutCount = 1;
-    pass8_layoutDesc.bindGroupLayouts = &pass8_bindGroupLayout;
-    wgpu::PipelineLayout pass8_pipelineLayout = device.CreatePipelineLayout(&pass8_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass8_pipelineDesc = {};
-    pass8_pipelineDesc.compute.constantCount = 0;
-    pass8_pipelineDesc.compute.constants = nullptr;
-    pass8_pipelineDesc.compute.entryPoint = "main";
-    pass8_pipelineDesc.compute.module = pass8_encodingChoiceErrorsShader;
-    pass8_pipelineDesc.layout = pass8_pipelineLayout;
-
-    pass8_pipeline = device.CreateComputePipeline(&pass8_pipelineDesc);
-
-    //pass9 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass9_layoutDesc = {};
-    pass9_layoutDesc.bindGroupLayoutCount = 1;
-    pass9_layoutDesc.bindGroupLayouts = &pass9_bindGroupLayout;
-    wgpu::PipelineLayout pass9_pipelineLayout = device.CreatePipelineLayout(&pass9_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass9_pipelineDesc = {};
-    pass9_pipelineDesc.compute.constantCount = 0;
-    pass9_pipelineDesc.compute.constants = nullptr;
-    pass9_pipelineDesc.compute.entryPoint = "main";
-    pass9_pipelineDesc.compute.module = pass9_computeColorErrorShader;
-    pass9_pipelineDesc.layout = pass9_pipelineLayout;
-
-    pass9_pipeline = device.CreateComputePipeline(&pass9_pipelineDesc);
-
-    //pass10 2partitions compute pipeline
-    wgpu::PipelineLayoutDescriptor pass10_2_layoutDesc = {};
-    pass10_2_layoutDesc.bindGroupLayoutCount = 1;
-    pass10_2_layoutDesc.bindGroupLayouts = &pass10_bindGroupLayout;
-    wgpu::PipelineLayout pass10_2_pipelineLayout = device.CreatePipelineLayout(&pass10_2_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass10_2_pipelineDesc = {};
-    pass10_2_pipelineDesc.compute.constantCount = 0;
-    pass10_2_pipelineDesc.compute.constants = nullptr;
-    pass10_2_pipelineDesc.compute.entryPoint = "main";
-    pass10_2_pipelineDesc.compute.module = pass10_colorEndpointCombinationsShader_2part;
-    pass10_2_pipelineDesc.layout = pass10_2_pipelineLayout;
-
-    pass10_pipeline_2part = device.CreateComputePipeline(&pass10_2_pipelineDesc);
-
-    //pass10 3partitions compute pipeline
-    wgpu::PipelineLayoutDescriptor pass10_3_layoutDesc = {};
-    pass10_3_layoutDesc.bindGroupLayoutCount = 1;
-    pass10_3_layoutDesc.bindGroupLayouts = &pass10_bindGroupLayout;
-    wgpu::PipelineLayout pass10_3_pipelineLayout = device.CreatePipelineLayout(&pass10_3_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass10_3_pipelineDesc = {};
-    pass10_3_pipelineDesc.compute.constantCount = 0;
-    pass10_3_pipelineDesc.compute.constants = nullptr;
-    pass10_3_pipelineDesc.compute.entryPoint = "main";
-    pass10_3_pipelineDesc.compute.module = pass10_colorEndpointCombinationsShader_3part;
-    pass10_3_pipelineDesc.layout = pass10_3_pipelineLayout;
-
-    pass10_pipeline_3part = device.CreateComputePipeline(&pass10_3_pipelineDesc);
-
-    //pass10 4partitions compute pipeline
-    wgpu::PipelineLayoutDescriptor pass10_4_layoutDesc = {};
-    pass10_4_layoutDesc.bindGroupLayoutCount = 1;
-    pass10_4_layoutDesc.bindGroupLayouts = &pass10_bindGroupLayout;
-    wgpu::PipelineLayout pass10_4_pipelineLayout = device.CreatePipelineLayout(&pass10_4_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass10_4_pipelineDesc = {};
-    pass10_4_pipelineDesc.compute.constantCount = 0;
-    pass10_4_pipelineDesc.compute.constants = nullptr;
-    pass10_4_pipelineDesc.compute.entryPoint = "main";
-    pass10_4_pipelineDesc.compute.module = pass10_colorEndpointCombinationsShader_4part;
-    pass10_4_pipelineDesc.layout = pass10_4_pipelineLayout;
-
-    pass10_pipeline_4part = device.CreateComputePipeline(&pass10_4_pipelineDesc);
-
-    //pass11 1partition compute pipeline
-    wgpu::PipelineLayoutDescriptor pass11_1_layoutDesc = {};
-    pass11_1_layoutDesc.bindGroupLayoutCount = 1;
-    pass11_1_layoutDesc.bindGroupLayouts = &pass11_bindGroupLayout_1part;
-    wgpu::PipelineLayout pass11_1_pipelineLayout = device.CreatePipelineLayout(&pass11_1_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass11_1_pipelineDesc = {};
-    pass11_1_pipelineDesc.compute.constantCount = 0;
-    pass11_1_pipelineDesc.compute.constants = nullptr;
-    pass11_1_pipelineDesc.compute.entryPoint = "main";
-    pass11_1_pipelineDesc.compute.module = pass11_bestEndpointCombinationsForModeShader_1part;
-    pass11_1_pipelineDesc.layout = pass11_1_pipelineLayout;
-
-    pass11_pipeline_1part = device.CreateComputePipeline(&pass11_1_pipelineDesc);
-
-    //pass11 2partitions compute pipeline
-    wgpu::PipelineLayoutDescriptor pass11_2_layoutDesc = {};
-    pass11_2_layoutDesc.bindGroupLayoutCount = 1;
-    pass11_2_layoutDesc.bindGroupLayouts = &pass11_bindGroupLayout_234part;
-    wgpu::PipelineLayout pass11_2_pipelineLayout = device.CreatePipelineLayout(&pass11_2_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass11_2_pipelineDesc = {};
-    pass11_2_pipelineDesc.compute.constantCount = 0;
-    pass11_2_pipelineDesc.compute.constants = nullptr;
-    pass11_2_pipelineDesc.compute.entryPoint = "main";
-    pass11_2_pipelineDesc.compute.module = pass11_bestEndpointCombinationsForModeShader_2part;
-    pass11_2_pipelineDesc.layout = pass11_2_pipelineLayout;
-
-    pass11_pipeline_2part = device.CreateComputePipeline(&pass11_2_pipelineDesc);
-
-    //pass11 3partitions compute pipeline
-    wgpu::PipelineLayoutDescriptor pass11_3_layoutDesc = {};
-    pass11_3_layoutDesc.bindGroupLayoutCount = 1;
-    pass11_3_layoutDesc.bindGroupLayouts = &pass11_bindGroupLayout_234part;
-    wgpu::PipelineLayout pass11_3_pipelineLayout = device.CreatePipelineLayout(&pass11_3_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass11_3_pipelineDesc = {};
-    pass11_3_pipelineDesc.compute.constantCount = 0;
-    pass11_3_pipelineDesc.compute.constants = nullptr;
-    pass11_3_pipelineDesc.compute.entryPoint = "main";
-    pass11_3_pipelineDesc.compute.module = pass11_bestEndpointCombinationsForModeShader_3part;
-    pass11_3_pipelineDesc.layout = pass11_3_pipelineLayout;
-
-    pass11_pipeline_3part = device.CreateComputePipeline(&pass11_3_pipelineDesc);
-
-    //pass11 4partitions compute pipeline
-    wgpu::PipelineLayoutDescriptor pass11_4_layoutDesc = {};
-    pass11_4_layoutDesc.bindGroupLayoutCount = 1;
-    pass11_4_layoutDesc.bindGroupLayouts = &pass11_bindGroupLayout_234part;
-    wgpu::PipelineLayout pass11_4_pipelineLayout = device.CreatePipelineLayout(&pass11_4_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass11_4_pipelineDesc = {};
-    pass11_4_pipelineDesc.compute.constantCount = 0;
-    pass11_4_pipelineDesc.compute.constants = nullptr;
-    pass11_4_pipelineDesc.compute.entryPoint = "main";
-    pass11_4_pipelineDesc.compute.module = pass11_bestEndpointCombinationsForModeShader_4part;
-    pass11_4_pipelineDesc.layout = pass11_4_pipelineLayout;
-
-    pass11_pipeline_4part = device.CreateComputePipeline(&pass11_4_pipelineDesc);
-
-    //pass12 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass12_layoutDesc = {};
-    pass12_layoutDesc.bindGroupLayoutCount = 1;
-    pass12_layoutDesc.bindGroupLayouts = &pass12_bindGroupLayout;
-    wgpu::PipelineLayout pass12_pipelineLayout = device.CreatePipelineLayout(&pass12_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass12_pipelineDesc = {};
-    pass12_pipelineDesc.compute.constantCount = 0;
-    pass12_pipelineDesc.compute.constants = nullptr;
-    pass12_pipelineDesc.compute.entryPoint = "main";
-    pass12_pipelineDesc.compute.module = pass12_findTopNCandidatesShader;
-    pass12_pipelineDesc.layout = pass12_pipelineLayout;
-
-    pass12_pipeline = device.CreateComputePipeline(&pass12_pipelineDesc);
-
-    //pass13 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass13_layoutDesc = {};
-    pass13_layoutDesc.bindGroupLayoutCount = 1;
-    pass13_layoutDesc.bindGroupLayouts = &pass13_bindGroupLayout;
-    wgpu::PipelineLayout pass13_pipelineLayout = device.CreatePipelineLayout(&pass13_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass13_pipelineDesc = {};
-    pass13_pipelineDesc.compute.constantCount = 0;
-    pass13_pipelineDesc.compute.constants = nullptr;
-    pass13_pipelineDesc.compute.entryPoint = "main";
-    pass13_pipelineDesc.compute.module = pass13_recomputeIdealEndpointsShader;
-    pass13_pipelineDesc.layout = pass13_pipelineLayout;
-
-    pass13_pipeline = device.CreateComputePipeline(&pass13_pipelineDesc);
-
-    //pass14 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass14_layoutDesc = {};
-    pass14_layoutDesc.bindGroupLayoutCount = 1;
-    pass14_layoutDesc.bindGroupLayouts = &pass14_bindGroupLayout;
-    wgpu::PipelineLayout pass14_pipelineLayout = device.CreatePipelineLayout(&pass14_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass14_pipelineDesc = {};
-    pass14_pipelineDesc.compute.constantCount = 0;
-    pass14_pipelineDesc.compute.constants = nullptr;
-    pass14_pipelineDesc.compute.entryPoint = "main";
-    pass14_pipelineDesc.compute.module = pass14_packColorEndpointsShader;
-    pass14_pipelineDesc.layout = pass14_pipelineLayout;
-
-    pass14_pipeline = device.CreateComputePipeline(&pass14_pipelineDesc);
-
-    //pass15 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass15_layoutDesc = {};
-    pass15_layoutDesc.bindGroupLayoutCount = 1;
-    pass15_layoutDesc.bindGroupLayouts = &pass15_bindGroupLayout;
-    wgpu::PipelineLayout pass15_pipelineLayout = device.CreatePipelineLayout(&pass15_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass15_pipelineDesc = {};
-    pass15_pipelineDesc.compute.constantCount = 0;
-    pass15_pipelineDesc.compute.constants = nullptr;
-    pass15_pipelineDesc.compute.entryPoint = "main";
-    pass15_pipelineDesc.compute.module = pass15_unpackColorEndpointsShader;
-    pass15_pipelineDesc.layout = pass15_pipelineLayout;
-
-    pass15_pipeline = device.CreateComputePipeline(&pass15_pipelineDesc);
-
-    //pass16 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass16_layoutDesc = {};
-    pass16_layoutDesc.bindGroupLayoutCount = 1;
-    pass16_layoutDesc.bindGroupLayouts = &pass16_bindGroupLayout;
-    wgpu::PipelineLayout pass16_pipelineLayout = device.CreatePipelineLayout(&pass16_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass16_pipelineDesc = {};
-    pass16_pipelineDesc.compute.constantCount = 0;
-    pass16_pipelineDesc.compute.constants = nullptr;
-    pass16_pipelineDesc.compute.entryPoint = "main";
-    pass16_pipelineDesc.compute.module = pass16_realignWeightsShader;
-    pass16_pipelineDesc.layout = pass16_pipelineLayout;
-
-    pass16_pipeline = device.CreateComputePipeline(&pass16_pipelineDesc);
-
-    //pass17 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass17_layoutDesc = {};
-    pass17_layoutDesc.bindGroupLayoutCount = 1;
-    pass17_layoutDesc.bindGroupLayouts = &pass17_bindGroupLayout;
-    wgpu::PipelineLayout pass17_pipelineLayout = device.CreatePipelineLayout(&pass17_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass17_pipelineDesc = {};
-    pass17_pipelineDesc.compute.constantCount = 0;
-    pass17_pipelineDesc.compute.constants = nullptr;
-    pass17_pipelineDesc.compute.entryPoint = "main";
-    pass17_pipelineDesc.compute.module = pass17_computeFinalErrorShader;
-    pass17_pipelineDesc.layout = pass17_pipelineLayout;
-
-    pass17_pipeline = device.CreateComputePipeline(&pass17_pipelineDesc);
-
-    //pass18 compute pipeline
-    wgpu::PipelineLayoutDescriptor pass18_layoutDesc = {};
-    pass18_layoutDesc.bindGroupLayoutCount = 1;
-    pass18_layoutDesc.bindGroupLayouts = &pass18_bindGroupLayout;
-    wgpu::PipelineLayout pass18_pipelineLayout = device.CreatePipelineLayout(&pass18_layoutDesc);
-
-    wgpu::ComputePipelineDescriptor pass18_pipelineDesc = {};
-    pass18_pipelineDesc.compute.constantCount = 0;
-    pass18_pipelineDesc.compute.constants = nullptr;
-    pass18_pipelineDesc.compute.entryPoint = "main";
-    pass18_pipelineDesc.compute.module = pass18_pickBestCandidateShader;
-    pass18_pipelineDesc.layout = pass18_pipelineLayout;
-
-    pass18_pipeline = device.CreateComputePipeline(&pass18_pipelineDesc);
-}
+#if defined(EMSCRIPTEN)
+    //initialization completes with the pipelines of 1 partition, the others keep compiling
+    if (context->partitionCount == 1 && remaining == 0 && encoder->m_on_first_pipelines_created) {
+        std::function<void()> on_first_pipelines_created = std::move(encoder->m_on_first_pipelines_created);
+        encoder->m_on_first_pipelines_created = nullptr;
+        on_first_pipelines_created();
+    }
+#else
+    (void)remaining;
 #endif
 
-#if defined(EMSCRIPTEN)
-void ASTCEncoder::initPipelinesAsync(std::function<void()> on_all_pipelines_created) {
-    m_pipeline_build_queue = {
-        {&pass001_initKmeansShader, "/shaders/pass001_init_kmeans.wgsl", "Init k-means (pass001)", &pass001_pipeline, &pass001_bindGroupLayout},
-        {&pass002_assignKmeansShader, "/shaders/pass002_assign_kmeans.wgsl", "Assign k-means (pass002)", &pass002_pipeline, &pass002_bindGroupLayout},
-        {&pass003_updateKmeansShader, "/shaders/pass003_update_kmeans.wgsl", "Update k-means (pass003)", &pass003_pipeline, &pass003_bindGroupLayout},
-        {&pass004_partitionMismatchShader, "/shaders/pass004_count_partition_mismatch.wgsl", "Count partition mismatch (pass004)", &pass004_pipeline, &pass004_bindGroupLayout},
-        {&pass005_partitionOrderingShader, "/shaders/pass005_partition_ordering.wgsl", "Partition ordering (pass005)", &pass005_pipeline, &pass005_bindGroupLayout},
-        {&pass006_evaluatePartitionShader, "/shaders/pass006_evaluate_partition_candidates.wgsl", "Evaluate partition candidates (pass006)", &pass006_pipeline, &pass006_bindGroupLayout},
-        {&pass007_preparePartitionedBlocksShader, "/shaders/pass007_prepare_partitioned_blocks.wgsl", "Prepare partitioned blocks (pass007)", &pass007_pipeline, &pass007_bindGroupLayout},
-        {&pass1_idealEndpointsShader, "/shaders/pass01_ideal_endpoints_and_weights.wgsl", "Ideal endpoints and weights (pass1)", &pass1_pipeline, &pass1_bindGroupLayout},
-        {&pass2_decimatedWeightsShader, "/shaders/pass02_decimated_weights.wgsl", "decimated weights (pass2)", &pass2_pipeline, &pass2_bindGroupLayout},
-        {&pass3_angularOffsetsShader, "/shaders/pass03_compute_angular_offsets.wgsl", "angular offsets (pass3)", &pass3_pipeline, &pass3_bindGroupLayout},
-        {&pass4_lowestAndHighestWeightShader, "/shaders/pass04_lowest_and_highest_weight.wgsl", "lowest and highest weight (pass4)", &pass4_pipeline, &pass4_bindGroupLayout},
-        {&pass5_valuesForQuantLevelsShader, "/shaders/pass05_best_values_for_quant_levels.wgsl", "best values for quant levels (pass5)", &pass5_pipeline, &pass5_bindGroupLayout},
-        {&pass6_remapLowAndHighValuesShader, "/shaders/pass06_remap_low_and_high_values.wgsl", "remap low and high values (pass6)", &pass6_pipeline, &pass6_bindGroupLayout},
-        {&pass7_weightsAndErrorForBMShader, "/shaders/pass07_weights_and_error_for_bm.wgsl", "weights and error for block mode (pass7)", &pass7_pipeline, &pass7_bindGroupLayout},
-        {&pass8_encodingChoiceErrorsShader, "/shaders/pass08_compute_encoding_choice_errors.wgsl", "encoding choice errors (pass8)", &pass8_pipeline, &pass8_bindGroupLayout},
-        {&pass9_computeColorErrorShader, "/shaders/pass09_compute_color_error.wgsl", "color format errors (pass9)", &pass9_pipeline, &pass9_bindGroupLayout},
-        {&pass10_colorEndpointCombinationsShader_2part, "/shaders/pass10_color_combinations_for_quant_2part.wgsl", "color endpoint combinations (pass10, 2part)", &pass10_pipeline_2part, &pass10_bindGroupLayout},
-        {&pass10_colorEndpointCombinationsShader_3part, "/shaders/pass10_color_combinations_for_quant_3part.wgsl", "color endpoint combinations (pass10, 3part)", &pass10_pipeline_3part, &pass10_bindGroupLayout},
-        {&pass10_colorEndpointCombinationsShader_4part, "/shaders/pass10_color_combinations_for_quant_4part.wgsl", "color endpoint combinations (pass10, 4part)", &pass10_pipeline_4part, &pass10_bindGroupLayout},
-        {&pass11_bestEndpointCombinationsForModeShader_1part, "/shaders/pass11_best_color_combination_for_mode_1part.wgsl", "best endpoint combinations for mode (pass11, 1part)", &pass11_pipeline_1part, &pass11_bindGroupLayout_1part},
-        {&pass11_bestEndpointCombinationsForModeShader_2part, "/shaders/pass11_best_color_combination_for_mode_2part.wgsl", "best endpoint combinations for mode (pass11, 2part)", &pass11_pipeline_2part, &pass11_bindGroupLayout_234part},
-        {&pass11_bestEndpointCombinationsForModeShader_3part, "/shaders/pass11_best_color_combination_for_mode_3part.wgsl", "best endpoint combinations for mode (pass11, 3part)", &pass11_pipeline_3part, &pass11_bindGroupLayout_234part},
-        {&pass11_bestEndpointCombinationsForModeShader_4part, "/shaders/pass11_best_color_combination_for_mode_4part.wgsl", "best endpoint combinations for mode (pass11, 4part)", &pass11_pipeline_4part, &pass11_bindGroupLayout_234part},
-        {&pass12_findTopNCandidatesShader, "/shaders/pass12_find_top_N_candidates.wgsl", "find top N candidates (pass12)", &pass12_pipeline, &pass12_bindGroupLayout},
-        {&pass13_recomputeIdealEndpointsShader, "/shaders/pass13_recompute_ideal_endpoints.wgsl", "recompute ideal endpoints (pass13)", &pass13_pipeline, &pass13_bindGroupLayout},
-        {&pass14_packColorEndpointsShader, "/shaders/pass14_pack_color_endpoints.wgsl", "pack color endpoints (pass14)", &pass14_pipeline, &pass14_bindGroupLayout},
-        {&pass15_unpackColorEndpointsShader, "/shaders/pass15_unpack_color_endpoints.wgsl", "unpack color endpoints (pass15)", &pass15_pipeline, &pass15_bindGroupLayout},
-        {&pass16_realignWeightsShader, "/shaders/pass16_realign_weights.wgsl", "realign weights (pass16)", &pass16_pipeline, &pass16_bindGroupLayout},
-        {&pass17_computeFinalErrorShader, "/shaders/pass17_compute_final_error.wgsl", "compute final error (pass17)", &pass17_pipeline, &pass17_bindGroupLayout},
-        {&pass18_pickBestCandidateShader, "/shaders/pass18_pick_best_candidate.wgsl", "pick best candidate (pass18)", &pass18_pipeline, &pass18_bindGroupLayout},
-    };
+    delete context;
+}
 
-    m_current_pipeline_index = 0;
-    createNextPipeline(on_all_pipelines_created);
+bool ASTCEncoder::pipelinesReady(uint32_t partitionCount) {
+    for (uint32_t p = 1; p <= partitionCount; p++) {
+        if (m_pending_pipelines[p].load() > 0) {
+            return false;
+        }
+    }
+    return true;
 }
 
-void ASTCEncoder::OnPipelineCreated(WGPUCreatePipelineAsyncStatus status, WGPUComputePipeline pipeline, char const* message, void* userdata) {
+void ASTCEncoder::waitForPipelines(uint32_t partitionCount) {
 
-    auto* context = static_cast<PipelineCreationContext*>(userdata);
+    if (!pipelinesReady(partitionCount)) {
+        ASTC_LOG(LogLevel::Debug, "Waiting for the pipelines of " << partitionCount << " partition(s)...");
 
-    if (status != WGPUCreatePipelineAsyncStatus_Success) {
-        std::cerr << "FATAL: Failed to create compute pipeline: " << message << std::endl;
+        while (!pipelinesReady(partitionCount)) {
+#if defined(__EMSCRIPTEN__)
+            emscripten_sleep(1);
+#else
+            device.Tick();
+#endif
+        }
     }
-    else {
-        *context->targetPipeline = wgpu::ComputePipeline::Acquire(pipeline);
+
+    if (m_pipeline_creation_failed) {
+        throw std::runtime_error("Failed to create a compute pipeline.");
     }
+}
 
-    ASTCEncoder* encoder = context->encoderInstance;
-    encoder->m_current_pipeline_index++;
+void ASTCEncoder::selectTexelCapacity(uint32_t texelCount) {
+
+    uint32_t capacity = BLOCK_MAX_TEXELS;
+    for (uint32_t i = 0; i < TEXEL_CAPACITY_CLASS_COUNT; i++) {
+        if (texelCount <= TEXEL_CAPACITY_CLASSES[i]) {
+            capacity = TEXEL_CAPACITY_CLASSES[i];
+            break;
+        }
+    }
 
-    emscripten_sleep(0);
+    if (capacity == m_texel_capacity) {
+        return;
+    }
 
-    encoder->createNextPipeline(context->onAllPipelinesCreated);
+    //pipelines still being created write into the current pipeline members when they finish
+    waitForPipelines(BLOCK_MAX_PARTITIONS);
 
-    delete context;
-}
+    //keep the variants of the current capacity, so switching back to it doesn't compile them again
+    std::vector<wgpu::ComputePipeline>& current = m_texel_capacity_variants[m_texel_capacity];
+    current.resize(m_pipeline_build_queue.size());
+    for (size_t i = 0; i < m_pipeline_build_queue.size(); i++) {
+        if (m_pipeline_build_queue[i].specialization != PipelineSpecialization::None) {
+            current[i] = *m_pipeline_build_queue[i].targetPipeline;
+        }
+    }
+
+    m_texel_capacity = capacity;
 
-void ASTCEncoder::createNextPipeline(std::function<void()> on_all_pipelines_created) {
-    if (m_current_pipeline_index >= m_pipeline_build_queue.size()) {
-        if (on_all_pipelines_created) {
-            on_all_pipelines_created();
+    auto cached = m_texel_capacity_variants.find(capacity);
+    if (cached != m_texel_capacity_variants.end()) {
+        for (size_t i = 0; i < m_pipeline_build_queue.size(); i++) {
+            if (m_pipeline_build_queue[i].specialization != PipelineSpecialization::None) {
+                *m_pipeline_build_queue[i].targetPipeline = cached->second[i];
+            }
         }
         return;
     }
 
-    const auto& info = m_pipeline_build_queue[m_current_pipeline_index];
+    ASTC_LOG(LogLevel::Debug, "Creating pipelines for blocks of up to " << capacity << " texels...");
 
-    std::cout << "Creating pipeline " << (m_current_pipeline_index + 1) << "/" << m_pipeline_build_queue.size() << ": " << info.shaderLabel << std::endl;
+    for (const PipelineBuildInfo& info : m_pipeline_build_queue) {
+        if (info.specialization != PipelineSpecialization::None) {
+            m_pending_pipelines[info.partitionCount]++;
+        }
+    }
 
-    *info.shaderModule = prepareShaderModule(device, info.shaderPath, info.shaderLabel.c_str());
+    //waited for like at initialization, by the first batch that records them
+    for (const PipelineBuildInfo& info : m_pipeline_build_queue) {
+        if (info.specialization != PipelineSpecialization::None) {
+            createPipelineAsync(info);
+        }
+    }
+}
 
-    wgpu::PipelineLayoutDescriptor layoutDesc = {};
-    layoutDesc.bindGroupLayoutCount = 1;
-    layoutDesc.bindGroupLayouts = info.bindGroupLayout;
-    wgpu::PipelineLayout pipelineLayout = device.CreatePipelineLayout(&layoutDesc);
+#if !defined(EMSCRIPTEN)
+void ASTCEncoder::initPipelines() {
 
-    wgpu::ComputePipelineDescriptor pipelineDesc = {};
-    pipelineDesc.layout = pipelineLayout;
-    pipelineDesc.compute.module = *info.shaderModule;
-    pipelineDesc.compute.entryPoint = "main";
+    initPipelineBuildQueue();
 
+    //counted before any creation starts, callbacks may run as soon as a pipeline is requested
+    for (const PipelineBuildInfo& info : m_pipeline_build_queue) {
+        m_pending_pipelines[info.partitionCount]++;
+    }
 
-    auto* context = new PipelineCreationContext{
-        this,
-        info.targetPipeline,
-        on_all_pipelines_created
-    };
+    for (const PipelineBuildInfo& info : m_pipeline_build_queue) {
+        createPipelineAsync(info);
+    }
 
-    device.CreateComputePipelineAsync(&pipelineDesc, &ASTCEncoder::OnPipelineCreated, context);
+    //the remaining pipelines are waited for by the first batch that uses them
+    waitForPipelines(1);
 }
 #endif
 
-void ASTCEncoder::initBuffers() {
+#if defined(EMSCRIPTEN)
+void ASTCEncoder::initPipelinesAsync(std::function<void()> on_first_pipelines_created) {
 
-    int max_partitioned_blocks = batchSize * TUNE_MAX_PARTITIONING_CANDIDATES;
-    int max_decimation_mode_trials = max_partitioned_blocks * valid_decimation_modes.size();
-    int max_block_mode_trials = max_partitioned_blocks * valid_block_modes.size();
+    initPipelineBuildQueue();
+
+    for (const PipelineBuildInfo& info : m_pipeline_build_queue) {
+        m_pending_pipelines[info.partitionCount]++;
+    }
+
+    m_on_first_pipelines_created = on_first_pipelines_created;
+
+    for (const PipelineBuildInfo& info : m_pipeline_build_queue) {
+        createPipelineAsync(info);
+    }
+}
+#endif
+
+uint32_t ASTCEncoder::computeBatchSize() {
+
+    wgpu::SupportedLimits supportedLimits = {};
+    device.GetLimits(&supportedLimits);
+    const wgpu::Limits& limits = supportedLimits.limits;
+
+    uint64_t partitioned_blocks = TUNE_MAX_PARTITIONING_CANDIDATES;
+    uint64_t decimation_mode_trials = partitioned_blocks * session->valid_decimation_modes.size();
+    uint64_t block_mode_trials = partitioned_blocks * session->valid_block_modes.size();
+
+    uint64_t texelsPerBlock = blockXDim * blockYDim;
+
+    //Size of every per batch buffer of initBuffers for a single block of the batch
+    std::vector<uint64_t> perBlockSizes = {
+        sizeof(InputBlock_GPU),                                                                     //input blocks
+        sizeof(uint32_t),                                                                           //pass008 active blocks
+        4 * 4 * sizeof(float),                                                                      //pass001
+        BLOCK_MAX_TEXELS * sizeof(uint32_t),                                                        //pass002
+        BLOCK_MAX_PARTITIONINGS * sizeof(uint32_t),                                                 //pass004
+        TUNE_MAX_PARTITIONING_CANDIDATE_LIMIT * sizeof(uint32_t),                                   //pass005
+        TUNE_MAX_PARTITIONING_CANDIDATE_LIMIT * 2 * sizeof(uint32_t),                               //pass006
+        partitioned_blocks * sizeof(PartitionedBlock),                                              //partitioned blocks
+        partitioned_blocks * sizeof(IdealEndpointsAndWeights),                                      //pass1
+        decimation_mode_trials * BLOCK_MAX_WEIGHTS * sizeof(float),                                 //pass2
+        decimation_mode_trials * ANGULAR_STEPS * sizeof(float),                                     //pass3
+        decimation_mode_trials * ANGULAR_STEPS * sizeof(HighestAndLowestWeight),                    //pass4
+        decimation_mode_trials * (MAX_ANGULAR_QUANT + 1) * sizeof(float),                           //pass5 low values
+        decimation_mode_trials * (MAX_ANGULAR_QUANT + 1) * sizeof(float),                           //pass5 high values
+        block_mode_trials * sizeof(FinalValueRange),                                                //pass6
+        block_mode_trials * sizeof(QuantizationResult),                                             //pass7
+        partitioned_blocks * BLOCK_MAX_PARTITIONS * sizeof(EncodingChoiceErrors),                   //pass8
+        partitioned_blocks * BLOCK_MAX_PARTITIONS * QUANT_LEVELS * NUM_INT_COUNTS * sizeof(float),  //pass9 color format errors
+        partitioned_blocks * BLOCK_MAX_PARTITIONS * QUANT_LEVELS * NUM_INT_COUNTS * sizeof(uint32_t), //pass9 color formats
+        partitioned_blocks * QUANT_LEVELS * MAX_INT_COUNT_COMBINATIONS * sizeof(CombinedEndpointFormats), //pass10
+        block_mode_trials * sizeof(ColorCombinationResult),                                         //pass11
+        partitioned_blocks * TUNE_MAX_TRIAL_CANDIDATES * sizeof(FinalCandidate),                    //pass12 final candidates
+        partitioned_blocks * TUNE_MAX_TRIAL_CANDIDATES * sizeof(FinalCandidate),                    //pass12 top candidates
+        partitioned_blocks * TUNE_MAX_TRIAL_CANDIDATES * BLOCK_MAX_PARTITIONS * 4 * sizeof(float),  //pass13
+        partitioned_blocks * TUNE_MAX_TRIAL_CANDIDATES * sizeof(UnpackedEndpoints),                 //pass15
+        sizeof(SymbolicBlock),                                                                      //pass18
+        4 * sizeof(uint32_t),                                                                       //pass19
+        (BATCHES_IN_FLIGHT + 1) * texelsPerBlock * 4,                                               //image rows and their staging buffers
+        BATCHES_IN_FLIGHT * 4 * sizeof(uint32_t),                                                   //readback buffers
+    };
+
+    //Every buffer has to fit into a single storage binding
+    uint64_t maxBindingSize = std::min(limits.maxStorageBufferBindingSize, limits.maxBufferSize);
 
-    //Buffer for uniform variables
+    //Partitioned blocks are dispatched one workgroup each
+    uint64_t maxBlocks = limits.maxComputeWorkgroupsPerDimension / TUNE_MAX_PARTITIONING_CANDIDATES;
+
+    uint64_t totalPerBlock = 0;
+    for (uint64_t size : perBlockSizes) {
+        maxBlocks = std::min(maxBlocks, maxBindingSize / size);
+        totalPerBlock += size;
+    }
+    maxBlocks = std::min(maxBlocks, BATCH_MEMORY_BUDGET / totalPerBlock);
+
+    //No point in allocating for more blocks than the image has
+    maxBlocks = std::min<uint64_t>(maxBlocks, numBlocks);
+
+    ASTC_LOG(LogLevel::Debug, "Per block memory: " << (float)totalPerBlock / 1000000 << " MB, batch size: " << maxBlocks);
+
+    return static_cast<uint32_t>(std::max<uint64_t>(maxBlocks, 1));
+}
+
+uint64_t ASTCEncoder::maxBatchImageRows(uint32_t batch_size) {
+
+    //a batch covers at most this many block rows, since it can start in the middle of a row
+    uint64_t blockRows = std::min<uint64_t>((batch_size + blocksX - 1) / blocksX + 1, blocksY);
+    return std::min<uint64_t>(blockRows * blockYDim, textureHeight);
+}
+
+void ASTCEncoder::initSharedBuffers() {
+
+    //Buffer for uniform variables (one slot per partition count, bound with a dynamic offset)
     wgpu::BufferDescriptor uniformDesc;
-    uniformDesc.size = sizeof(uniform_variables);
+    uniformDesc.size = BLOCK_MAX_PARTITIONS * UNIFORM_SLOT_STRIDE;
     uniformDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
     uniformsBuffer = device.CreateBuffer(&uniformDesc);
 
+    //Buffer for the lookup tables of the physical block packing
+    wgpu::BufferDescriptor iseTablesDesc;
+    iseTablesDesc.size = sizeof(ise_tables_GPU);
+    iseTablesDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+    iseTablesBuffer = device.CreateBuffer(&iseTablesDesc);
+
+    //Buffers for sin and cos tables
+    construct_angular_tables(sin_table, cos_table);
+
+    //Buffer for sin table
+    wgpu::BufferDescriptor sinTableDesc;
+    sinTableDesc.size = SINCOS_STEPS * ANGULAR_STEPS * sizeof(float);
+    sinTableDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+    sinBuffer = device.CreateBuffer(&sinTableDesc);
+
+    //Buffer for cos table
+    wgpu::BufferDescriptor cosTableDesc;
+    cosTableDesc.size = SINCOS_STEPS * ANGULAR_STEPS * sizeof(float);
+    cosTableDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+    cosBuffer = device.CreateBuffer(&cosTableDesc);
+
+    //Buffer for the uniforms of the extraction pass
+    wgpu::BufferDescriptor extractionUniformsDesc;
+    extractionUniformsDesc.size = sizeof(extraction_variables);
+    extractionUniformsDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+    extractionUniformsBuffer = device.CreateBuffer(&extractionUniformsDesc);
+
+    //Indirect dispatch arguments written by pass008
+    wgpu::BufferDescriptor indirectArgsDesc = {};
+    indirectArgsDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect;
+    indirectArgsDesc.size = INDIRECT_ARGS_SIZE;
+    indirectArgsBuffer = device.CreateBuffer(&indirectArgsDesc);
+
+    //write the physical block packing tables
+    std::unique_ptr<ise_tables_GPU> iseTables = std::make_unique<ise_tables_GPU>();
+    init_ise_tables_GPU(*iseTables);
+    queue.WriteBuffer(iseTablesBuffer, 0, iseTables.get(), sizeof(ise_tables_GPU));
+
+    //write to sin and cos table buffers
+    queue.WriteBuffer(sinBuffer, 0, sin_table.data(), SINCOS_STEPS * ANGULAR_STEPS * sizeof(float));
+    queue.WriteBuffer(cosBuffer, 0, cos_table.data(), SINCOS_STEPS * ANGULAR_STEPS * sizeof(float));
+}
+
+void ASTCEncoder::initSessionBuffers(BlockSizeSession& blockSession) {
+
+    const block_descriptor& bd = blockSession.block_descriptor;
+
     //K-means texels
     wgpu::BufferDescriptor kmeansDesc;
     kmeansDesc.size = BLOCK_MAX_KMEANS_TEXELS * sizeof(uint32_t);
     kmeansDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    kmeansTexelsBuffer = device.CreateBuffer(&kmeansDesc);
+    blockSession.kmeansTexelsBuffer = device.CreateBuffer(&kmeansDesc);
 
     //Coverage bitmaps for 2 partitions
     wgpu::BufferDescriptor covarageBitmaps2Desc;
     covarageBitmaps2Desc.size = BLOCK_MAX_PARTITIONINGS * 2 * sizeof(uint64_t);
     covarageBitmaps2Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    coverageBitmaps2Buffer = device.CreateBuffer(&covarageBitmaps2Desc);
+    blockSession.coverageBitmaps2Buffer = device.CreateBuffer(&covarageBitmaps2Desc);
 
     //Coverage bitmaps for 3 partitions
     wgpu::BufferDescriptor covarageBitmaps3Desc;
     covarageBitmaps3Desc.size = BLOCK_MAX_PARTITIONINGS * 3 * sizeof(uint64_t);
     covarageBitmaps3Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    coverageBitmaps3Buffer = device.CreateBuffer(&covarageBitmaps3Desc);
+    blockSession.coverageBitmaps3Buffer = device.CreateBuffer(&covarageBitmaps3Desc);
 
     //Coverage bitmaps for 4 partitions
     wgpu::BufferDescriptor covarageBitmaps4Desc;
     covarageBitmaps4Desc.size = BLOCK_MAX_PARTITIONINGS * 4 * sizeof(uint64_t);
     covarageBitmaps4Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    coverageBitmaps4Buffer = device.CreateBuffer(&covarageBitmaps4Desc);
+    blockSession.coverageBitmaps4Buffer = device.CreateBuffer(&covarageBitmaps4Desc);
 
     //Buffer for partition infos
     wgpu::BufferDescriptor partitionInfoDesc;
     partitionInfoDesc.size = ((3 * BLOCK_MAX_PARTITIONINGS) + 1) * sizeof(partition_info_GPU);
     partitionInfoDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    partitionInfoBuffer = device.CreateBuffer(&partitionInfoDesc);
+    blockSession.partitionInfoBuffer = device.CreateBuffer(&partitionInfoDesc);
 
     //Buffer for block modes
     wgpu::BufferDescriptor blockModesDesc;
-    blockModesDesc.size = block_descriptor.uniform_variables.block_mode_count * sizeof(block_mode);
+    blockModesDesc.size = blockSession.block_descriptor.uniform_variables.block_mode_count * sizeof(block_mode);
     blockModesDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    blockModesBuffer = device.CreateBuffer(&blockModesDesc);
+    blockSession.blockModesBuffer = device.CreateBuffer(&blockModesDesc);
 
-    //Buffer for block mode index
+    //Buffer for block mode index (indexed by the raw 11 bit block mode)
     wgpu::BufferDescriptor blockModeIndexDesc;
-    blockModeIndexDesc.size = block_descriptor.uniform_variables.block_mode_count * sizeof(uint32_t);
+    blockModeIndexDesc.size = WEIGHTS_MAX_BLOCK_MODES * sizeof(uint32_t);
     blockModeIndexDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    blockModeIndexBuffer = device.CreateBuffer(&blockModeIndexDesc);
+    blockSession.blockModeIndexBuffer = device.CreateBuffer(&blockModeIndexDesc);
 
     //Buffer for decimation modes
     wgpu::BufferDescriptor decimationModesDesc;
-    decimationModesDesc.size = block_descriptor.uniform_variables.decimation_mode_count * sizeof(decimation_mode);
+    decimationModesDesc.size = blockSession.block_descriptor.uniform_variables.decimation_mode_count * sizeof(decimation_mode);
     decimationModesDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    decimationModesBuffer = device.CreateBuffer(&decimationModesDesc);
+    blockSession.decimationModesBuffer = device.CreateBuffer(&decimationModesDesc);
 
     //Buffer for decimation infos
     wgpu::BufferDescriptor decimatioInfoDesc;
-    decimatioInfoDesc.size = block_descriptor.uniform_variables.decimation_mode_count * sizeof(decimation_info);
+    decimatioInfoDesc.size = blockSession.block_descriptor.uniform_variables.decimation_mode_count * sizeof(decimation_info);
     decimatioInfoDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    decimationInfoBuffer = device.CreateBuffer(&decimatioInfoDesc);
+    blockSession.decimationInfoBuffer = device.CreateBuffer(&decimatioInfoDesc);
 
     //Buffer stores info for reconstructing original weights from decimated weights  decimated weights -> reconstructed weights (for every decimation mode)
     wgpu::BufferDescriptor texelToWeightMapDesc;
-    texelToWeightMapDesc.size = block_descriptor.decimation_info_packed.texel_to_weight_map_data.size() * sizeof(TexelToWeightMap);
+    texelToWeightMapDesc.size = blockSession.block_descriptor.decimation_info_packed.texel_to_weight_map_data.size() * sizeof(TexelToWeightMap);
     texelToWeightMapDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    texelToWeightMapBuffer = device.CreateBuffer(&texelToWeightMapDesc);
+    blockSession.texelToWeightMapBuffer = device.CreateBuffer(&texelToWeightMapDesc);
 
     //Buffer stores info for decimation of texel weights  ideal weights -> decimated weights  (for every decimation mode)
     wgpu::BufferDescriptor weightToTexelMapDesc;
-    weightToTexelMapDesc.size = block_descriptor.decimation_info_packed.weight_to_texel_map_data.size() * sizeof(WeightToTexelMap);
+    weightToTexelMapDesc.size = blockSession.block_descriptor.decimation_info_packed.weight_to_texel_map_data.size() * sizeof(WeightToTexelMap);
     weightToTexelMapDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    weightToTexelMapBuffer = device.CreateBuffer(&weightToTexelMapDesc);
+    blockSession.weightToTexelMapBuffer = device.CreateBuffer(&weightToTexelMapDesc);
 
     //Buffer for deciamtion mode indeces consirered during compression
     wgpu::BufferDescriptor validDecModesDesc;
-    validDecModesDesc.size = valid_decimation_modes.size() * sizeof(uint32_t);
+    validDecModesDesc.size = blockSession.valid_decimation_modes.size() * sizeof(uint32_t);
     validDecModesDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    validDecimationModesBuffer = device.CreateBuffer(&validDecModesDesc);
+    blockSession.validDecimationModesBuffer = device.CreateBuffer(&validDecModesDesc);
 
     //Buffer for block mode indeces consirered during compression
     wgpu::BufferDescriptor validBlockModesDesc;
-    validBlockModesDesc.size = valid_block_modes.size() * sizeof(PackedBlockModeLookup);
+    validBlockModesDesc.size = blockSession.valid_block_modes.size() * sizeof(PackedBlockModeLookup);
     validBlockModesDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    validBlockModesBuffer = device.CreateBuffer(&validBlockModesDesc);
+    blockSession.validBlockModesBuffer = device.CreateBuffer(&validBlockModesDesc);
+
+    //write the precomputed metadata to the buffers
+    queue.WriteBuffer(blockSession.blockModesBuffer, 0, bd.block_modes, bd.uniform_variables.block_mode_count * sizeof(block_mode));
+    queue.WriteBuffer(blockSession.blockModeIndexBuffer, 0, bd.block_mode_index, WEIGHTS_MAX_BLOCK_MODES * sizeof(uint32_t));
+    queue.WriteBuffer(blockSession.decimationModesBuffer, 0, bd.decimation_modes, bd.uniform_variables.decimation_mode_count * sizeof(decimation_mode));
+    queue.WriteBuffer(blockSession.decimationInfoBuffer, 0, bd.decimation_info_metadata, bd.uniform_variables.decimation_mode_count * sizeof(decimation_info));
+    queue.WriteBuffer(blockSession.texelToWeightMapBuffer, 0, bd.decimation_info_packed.texel_to_weight_map_data.data(), bd.decimation_info_packed.texel_to_weight_map_data.size() * sizeof(TexelToWeightMap));
+    queue.WriteBuffer(blockSession.weightToTexelMapBuffer, 0, bd.decimation_info_packed.weight_to_texel_map_data.data(), bd.decimation_info_packed.weight_to_texel_map_data.size() * sizeof(WeightToTexelMap));
+
+    queue.WriteBuffer(blockSession.validDecimationModesBuffer, 0, blockSession.valid_decimation_modes.data(), blockSession.valid_decimation_modes.size() * sizeof(uint32_t));
+    queue.WriteBuffer(blockSession.validBlockModesBuffer, 0, blockSession.valid_block_modes.data(), blockSession.valid_block_modes.size() * sizeof(PackedBlockModeLookup));
+
+    //write to partitioning buffers
+    queue.WriteBuffer(blockSession.kmeansTexelsBuffer, 0, bd.kmeans_texels, BLOCK_MAX_KMEANS_TEXELS * sizeof(uint32_t));
+    queue.WriteBuffer(blockSession.coverageBitmaps2Buffer, 0, bd.coverage_bitmaps_2, BLOCK_MAX_PARTITIONINGS * 2 * sizeof(uint64_t));
+    queue.WriteBuffer(blockSession.coverageBitmaps3Buffer, 0, bd.coverage_bitmaps_3, BLOCK_MAX_PARTITIONINGS * 3 * sizeof(uint64_t));
+    queue.WriteBuffer(blockSession.coverageBitmaps4Buffer, 0, bd.coverage_bitmaps_4, BLOCK_MAX_PARTITIONINGS * 4 * sizeof(uint64_t));
+
+    queue.WriteBuffer(blockSession.partitionInfoBuffer, 0, bd.partitionings_GPU, ((3 * BLOCK_MAX_PARTITIONINGS) + 1) * sizeof(partition_info_GPU));
+}
 
-    //Buffer for sin table
-    wgpu::BufferDescriptor sinTableDesc;
-    sinTableDesc.size = SINCOS_STEPS * ANGULAR_STEPS * sizeof(float);
-    sinTableDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    sinBuffer = device.CreateBuffer(&sinTableDesc);
+bool ASTCEncoder::growBuffer(wgpu::Buffer& buffer, const wgpu::BufferDescriptor& descriptor) {
 
-    //Buffer for cos table
-    wgpu::BufferDescriptor cosTableDesc;
-    cosTableDesc.size = SINCOS_STEPS * ANGULAR_STEPS * sizeof(float);
-    cosTableDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    cosBuffer = device.CreateBuffer(&cosTableDesc);
+    //buffers are only ever replaced by larger ones, smaller images and batches use the front of them
+    if (buffer && buffer.GetSize() >= descriptor.size) {
+        return false;
+    }
 
-    //Buffer for input blocks
+    if (buffer) {
+        buffer.Destroy();
+    }
+    buffer = device.CreateBuffer(&descriptor);
+    return true;
+}
+
+bool ASTCEncoder::initBuffers() {
+
+    int max_partitioned_blocks = batchSize * TUNE_MAX_PARTITIONING_CANDIDATES;
+    int max_decimation_mode_trials = max_partitioned_blocks * session->valid_decimation_modes.size();
+    int max_block_mode_trials = max_partitioned_blocks * session->valid_block_modes.size();
+
+    //Per batch buffers, returns true if any of them was replaced (the bind groups have to be recreated then)
+    bool changed = false;
+
+    //Buffer for the raw RGBA8 image rows covered by a batch
+    wgpu::BufferDescriptor imageRowsDesc;
+    imageRowsDesc.size = maxBatchImageRows(batchSize) * textureWidth * 4;
+    imageRowsDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+    changed |= growBuffer(imageRowsBuffer, imageRowsDesc);
+
+    //Buffer for input blocks (written by pass000)
     wgpu::BufferDescriptor inputDesc;
-    inputDesc.size = batchSize * sizeof(InputBlock);
-    inputDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
-    inputBlocksBuffer = device.CreateBuffer(&inputDesc);
+    inputDesc.size = batchSize * sizeof(InputBlock_GPU);
+    inputDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
+    changed |= growBuffer(inputBlocksBuffer, inputDesc);
+
+    //Output buffers of pass 008 (active block list and indirect dispatch arguments)
+    wgpu::BufferDescriptor activeBlocksDesc = {};
+    activeBlocksDesc.usage = wgpu::BufferUsage::Storage;
+    activeBlocksDesc.size = batchSize * sizeof(uint32_t);
+    changed |= growBuffer(activeBlocksBuffer, activeBlocksDesc);
 
     //Output buffer of pass 001 (cluster centers)
     wgpu::BufferDescriptor pass001Desc = {};
     pass001Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
 	pass001Desc.size = batchSize * 4 * 4 * sizeof(float); //4 cluster centers, each with RGBA channels
-    pass001_output_clusterCenters = device.CreateBuffer(&pass001Desc);
+    changed |= growBuffer(pass001_output_clusterCenters, pass001Desc);
 
     //Output buffer of pass 002 (texel assignments)
     wgpu::BufferDescriptor pass002Desc = {};
     pass002Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass002Desc.size = batchSize * BLOCK_MAX_TEXELS * sizeof(uint32_t);
-    pass002_output_texelAssignments = device.CreateBuffer(&pass002Desc);
+    changed |= growBuffer(pass002_output_texelAssignments, pass002Desc);
 
     //Output buffer of pass 004 (mismatch counts)
     wgpu::BufferDescriptor pass004Desc = {};
     pass004Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass004Desc.size = batchSize * BLOCK_MAX_PARTITIONINGS * sizeof(uint32_t);
-    pass004_output_mismatchCounts = device.CreateBuffer(&pass004Desc);
+    changed |= growBuffer(pass004_output_mismatchCounts, pass004Desc);
 
     //Output buffer of pass 005 (partition ordering)
     wgpu::BufferDescriptor pass005Desc = {};
     pass005Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass005Desc.size = batchSize * TUNE_MAX_PARTITIONING_CANDIDATE_LIMIT * sizeof(uint32_t);
-    pass005_output_partitionOrdering = device.CreateBuffer(&pass005Desc);
+    changed |= growBuffer(pass005_output_partitionOrdering, pass005Desc);
 
     //Output buffer of pass 006 (final partitioning errors)
     wgpu::BufferDescriptor pass006Desc = {};
     pass006Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass006Desc.size = batchSize * TUNE_MAX_PARTITIONING_CANDIDATE_LIMIT * 2 * sizeof(uint32_t);
-    pass006_output_partitioningErrors = device.CreateBuffer(&pass006Desc);
+    changed |= growBuffer(pass006_output_partitioningErrors, pass006Desc);
 
-    //Buffer for partitioned blocks
+    //Buffer for partitioned blocks (input block and partition table references written by pass007)
     wgpu::BufferDescriptor partBlocksDesc;
-    partBlocksDesc.size = max_partitioned_blocks * sizeof(InputBlock);
-    partBlocksDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc;
-    partitionedBlocksBuffer = device.CreateBuffer(&partBlocksDesc);
+    partBlocksDesc.size = max_partitioned_blocks * sizeof(PartitionedBlock);
+    partBlocksDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
+    changed |= growBuffer(partitionedBlocksBuffer, partBlocksDesc);
 
     //Output buffer of pass 1 (ideal endpoints and weights)
     wgpu::BufferDescriptor pass1Desc = {};
     pass1Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass1Desc.size = max_partitioned_blocks * sizeof(IdealEndpointsAndWeights);
-    pass1_output_idealEndpointsAndWeights = device.CreateBuffer(&pass1Desc);
+    changed |= growBuffer(pass1_output_idealEndpointsAndWeights, pass1Desc);
 
     //Output buffer of pass 2 (decimated weights)
     //indexing pattern: decimation_mode_trial_index * BLOCK_MAX_WEIGHTS + weight_index
     wgpu::BufferDescriptor pass2Desc = {};
     pass2Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass2Desc.size = max_decimation_mode_trials * BLOCK_MAX_WEIGHTS * sizeof(float);
-    pass2_output_decimatedWeights = device.CreateBuffer(&pass2Desc);
+    changed |= growBuffer(pass2_output_decimatedWeights, pass2Desc);
 
     //Output buffer of pass 3 (angular offsets)
     //indexing pattern: decimation_mode_trial_index * ANGULAR_STEPS + angular_offset_index
     wgpu::BufferDescriptor pass3Desc = {};
     pass3Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass3Desc.size = max_decimation_mode_trials * ANGULAR_STEPS * sizeof(float);
-    pass3_output_angular_offsets = device.CreateBuffer(&pass3Desc);
+    changed |= growBuffer(pass3_output_angular_offsets, pass3Desc);
 
     //Output buffer of pass 4 (lowest and highest weights)
     wgpu::BufferDescriptor pass4Desc = {};
     pass4Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass4Desc.size = max_decimation_mode_trials * ANGULAR_STEPS * sizeof(HighestAndLowestWeight);
-    pass4_output_lowestAndHighestWeight = device.CreateBuffer(&pass4Desc);
+    changed |= growBuffer(pass4_output_lowestAndHighestWeight, pass4Desc);
 
     //Output buffer of pass 5 (low values)
     wgpu::BufferDescriptor pass5_1Desc = {};
     pass5_1Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass5_1Desc.size = max_decimation_mode_trials * (MAX_ANGULAR_QUANT + 1) * sizeof(float);
-    pass5_output_lowValues = device.CreateBuffer(&pass5_1Desc);
+    changed |= growBuffer(pass5_output_lowValues, pass5_1Desc);
 
     //Output buffer of pass 5 (high values)
     wgpu::BufferDescriptor pass5_2Desc = {};
     pass5_2Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass5_2Desc.size = max_decimation_mode_trials * (MAX_ANGULAR_QUANT + 1) * sizeof(float);
-    pass5_output_highValues = device.CreateBuffer(&pass5_2Desc);
+    changed |= growBuffer(pass5_output_highValues, pass5_2Desc);
 
     //Output buffer of pass 6 (final value ranges)
     wgpu::BufferDescriptor pass6Desc = {};
     pass6Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass6Desc.size = max_block_mode_trials * sizeof(FinalValueRange);
-    pass6_output_finalValueRanges = device.CreateBuffer(&pass6Desc);
+    changed |= growBuffer(pass6_output_finalValueRanges, pass6Desc);
 
     //Output buffer of pass 7 (quantization results)
     wgpu::BufferDescriptor pass7Desc = {};
     pass7Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass7Desc.size = max_block_mode_trials * sizeof(QuantizationResult);
-    pass7_output_quantizationResults = device.CreateBuffer(&pass7Desc);
+    changed |= growBuffer(pass7_output_quantizationResults, pass7Desc);
 
     //Output buffer of pass 8 (encoding choice errors)
     wgpu::BufferDescriptor pass8Desc = {};
     pass8Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass8Desc.size = max_partitioned_blocks * BLOCK_MAX_PARTITIONS * sizeof(EncodingChoiceErrors);
-    pass8_output_encodingChoiceErrors = device.CreateBuffer(&pass8Desc);
+    changed |= growBuffer(pass8_output_encodingChoiceErrors, pass8Desc);
 
     //Output buffer of pass 9 (color format errors)
     //indexing pattern: ((block_index * BLOCK_MAX_PARTITIONS + partition_index) * QUANT_LEVELS + quant_level_index) * NUM_INT_COUNTS + integer_count
     wgpu::BufferDescriptor pass9_1Desc = {};
     pass9_1Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass9_1Desc.size = max_partitioned_blocks * BLOCK_MAX_PARTITIONS * QUANT_LEVELS * NUM_INT_COUNTS * sizeof(float);
-    pass9_output_colorFormatErrors = device.CreateBuffer(&pass9_1Desc);
+    changed |= growBuffer(pass9_output_colorFormatErrors, pass9_1Desc);
 
     //Output buffer of pass 9 (color formats)
     //indexing pattern: ((block_index * BLOCK_MAX_PARTITIONS + partition_index) * QUANT_LEVELS + quant_level_index) * NUM_INT_COUNTS + integer_count
     wgpu::BufferDescriptor pass9_2Desc = {};
     pass9_2Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass9_2Desc.size = max_partitioned_blocks * BLOCK_MAX_PARTITIONS * QUANT_LEVELS * NUM_INT_COUNTS * sizeof(uint32_t);
-    pass9_output_colorFormats = device.CreateBuffer(&pass9_2Desc);
+    changed |= growBuffer(pass9_output_colorFormats, pass9_2Desc);
 
     //Output buffer of pass 10 (color format combinations)
     //indexing pattern: (block_index * QUANT_LEVELS + quant_level) * MAX_INT_COUNT_COMBINATIONS + integer_count
     wgpu::BufferDescriptor pass10Desc = {};
     pass10Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass10Desc.size = max_partitioned_blocks * QUANT_LEVELS * MAX_INT_COUNT_COMBINATIONS * sizeof(CombinedEndpointFormats);
-    pass10_output_colorEndpointCombinations = device.CreateBuffer(&pass10Desc);
+    changed |= growBuffer(pass10_output_colorEndpointCombinations, pass10Desc);
 
     //Output buffer of pass 11 (best endpoint combinations for mode)
     wgpu::BufferDescriptor pass11Desc = {};
     pass11Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass11Desc.size = max_block_mode_trials * sizeof(ColorCombinationResult);
-    pass11_output_bestEndpointCombinationsForMode = device.CreateBuffer(&pass11Desc);
+    changed |= growBuffer(pass11_output_bestEndpointCombinationsForMode, pass11Desc);
 
     //Output buffer of pass 12 (final candidates)
     //indexing pattern: (block_index * block_descriptor.uniform_variables.tune_candidate_limit + i-th best candidate)
     wgpu::BufferDescriptor pass12Desc = {};
     pass12Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass12Desc.size = max_partitioned_blocks * TUNE_MAX_TRIAL_CANDIDATES * sizeof(FinalCandidate);
-    pass12_output_finalCandidates = device.CreateBuffer(&pass12Desc);
+    changed |= growBuffer(pass12_output_finalCandidates, pass12Desc);
 
     //Output buffer of pass 12 (best iteration of each final candidate)
     //indexing pattern: (block_index * block_descriptor.uniform_variables.tune_candidate_limit + i-th best candidate)
     wgpu::BufferDescriptor pass12Desc1 = {};
     pass12Desc1.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass12Desc1.size = max_partitioned_blocks * TUNE_MAX_TRIAL_CANDIDATES * sizeof(FinalCandidate);
-    pass12_output_topCandidates = device.CreateBuffer(&pass12Desc1);
+    changed |= growBuffer(pass12_output_topCandidates, pass12Desc1);
 
     //Output buffer of pass 13 (recomputed ideal endpoints)
     wgpu::BufferDescriptor pass13Desc = {};
     pass13Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass13Desc.size = max_partitioned_blocks * TUNE_MAX_TRIAL_CANDIDATES * BLOCK_MAX_PARTITIONS * 4 * sizeof(float);
-    pass13_output_rgbsVectors = device.CreateBuffer(&pass13Desc);
+    changed |= growBuffer(pass13_output_rgbsVectors, pass13Desc);
 
     //Output buffer of pass 15 (unpacked endpoints)
     wgpu::BufferDescriptor pass15Desc = {};
     pass15Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     pass15Desc.size = max_partitioned_blocks * TUNE_MAX_TRIAL_CANDIDATES * sizeof(UnpackedEndpoints);
-    pass15_output_unpackedEndpoints = device.CreateBuffer(&pass15Desc);
+    changed |= growBuffer(pass15_output_unpackedEndpoints, pass15Desc);
 
-    //Output buffer of pass 18 (symbolic blocks)
+    //Output buffer of pass 18 (best symbolic block of each block in the batch)
     wgpu::BufferDescriptor pass18Desc = {};
     pass18Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
-    pass18Desc.size = max_partitioned_blocks * sizeof(SymbolicBlock);
-    pass18_output_symbolicBlocks = device.CreateBuffer(&pass18Desc);
-
-    //Readback buffer for final output
-    wgpu::BufferDescriptor outputDesc = {};
-    outputDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
-    outputDesc.size = max_partitioned_blocks * sizeof(SymbolicBlock);
-    outputReadbackBuffer = device.CreateBuffer(&outputDesc);
-
-    //Readback buffer for debugging
-    wgpu::BufferDescriptor outputDesc1 = {};
-    outputDesc1.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
-    outputDesc1.size = batchSize * 8 * sizeof(InputBlock);
-    pass1111ReadbackBuffer = device.CreateBuffer(&outputDesc1);
+    pass18Desc.size = batchSize * sizeof(SymbolicBlock);
+    changed |= growBuffer(pass18_output_symbolicBlocks, pass18Desc);
+
+    //Output buffer of pass 19 (physical blocks of the batch)
+    wgpu::BufferDescriptor pass19Desc = {};
+    pass19Desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
+    pass19Desc.size = batchSize * 4 * sizeof(uint32_t);
+    changed |= growBuffer(pass19_output_physicalBlocks, pass19Desc);
+
+    //Staging buffers of the batch slots, pending map requests must complete before they can be replaced
+    waitForBatchSlots();
+    for (BatchSlot& slot : batchSlots) {
+        //image rows of the batch, written by the host while mapped (first use is mapped at creation)
+        wgpu::BufferDescriptor inputStagingDesc = {};
+        inputStagingDesc.usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc;
+        inputStagingDesc.size = imageRowsBuffer.GetSize();
+        inputStagingDesc.mappedAtCreation = true;
+        growBuffer(slot.inputStagingBuffer, inputStagingDesc);
+
+        //readback of the encoded physical blocks
+        wgpu::BufferDescriptor readbackDesc = {};
+        readbackDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+        readbackDesc.size = batchSize * 4 * sizeof(uint32_t);
+        growBuffer(slot.readbackBuffer, readbackDesc);
+
+        slot.inputMap = {};
+        slot.readbackMap = {};
+        slot.inFlight = false;
+    }
 
+    return changed;
 }
 
 void ASTCEncoder::initBindGroups() {
 
+    //bind group for pass000 (extract blocks)
+    std::vector<wgpu::BindGroupEntry> bg000_entries;
+    bg000_entries.push_back({ .binding = 0, .buffer = extractionUniformsBuffer, .offset = 0, .size = extractionUniformsBuffer.GetSize() });
+    bg000_entries.push_back({ .binding = 1, .buffer = imageRowsBuffer, .offset = 0, .size = imageRowsBuffer.GetSize() });
+    bg000_entries.push_back({ .binding = 2, .buffer = inputBlocksBuffer, .offset = 0, .size = inputBlocksBuffer.GetSize() });
+
+    wgpu::BindGroupDescriptor bg000_desc = {};
+    bg000_desc.layout = pass000_bindGroupLayout;
+    bg000_desc.entryCount = bg000_entries.size();
+    bg000_desc.entries = bg000_entries.data();
+    pass000_bindGroup = device.CreateBindGroup(&bg000_desc);
+
+
     //bind group for pass001 (init k-means)
     std::vector<wgpu::BindGroupEntry> bg001_entries;
-    bg001_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
+    bg001_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
     bg001_entries.push_back({ .binding = 1, .buffer = inputBlocksBuffer, .offset = 0, .size = inputBlocksBuffer.GetSize() });
     bg001_entries.push_back({ .binding = 2, .buffer = pass001_output_clusterCenters, .offset = 0, .size = pass001_output_clusterCenters.GetSize() });
+    bg001_entries.push_back({ .binding = 3, .buffer = activeBlocksBuffer, .offset = 0, .size = activeBlocksBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg001_desc = {};
     bg001_desc.layout = pass001_bindGroupLayout;
@@ -1290,10 +1232,11 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass002 (assign k-means)
     std::vector<wgpu::BindGroupEntry> bg002_entries;
-    bg002_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
+    bg002_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
     bg002_entries.push_back({ .binding = 1, .buffer = inputBlocksBuffer, .offset = 0, .size = inputBlocksBuffer.GetSize() });
     bg002_entries.push_back({ .binding = 2, .buffer = pass001_output_clusterCenters, .offset = 0, .size = pass001_output_clusterCenters.GetSize() });
     bg002_entries.push_back({ .binding = 3, .buffer = pass002_output_texelAssignments, .offset = 0, .size = pass002_output_texelAssignments.GetSize() });
+    bg002_entries.push_back({ .binding = 4, .buffer = activeBlocksBuffer, .offset = 0, .size = activeBlocksBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg002_desc = {};
     bg002_desc.layout = pass002_bindGroupLayout;
@@ -1304,10 +1247,11 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass003 (update k-means)
     std::vector<wgpu::BindGroupEntry> bg003_entries;
-    bg003_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
+    bg003_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
     bg003_entries.push_back({ .binding = 1, .buffer = inputBlocksBuffer, .offset = 0, .size = inputBlocksBuffer.GetSize() });
     bg003_entries.push_back({ .binding = 2, .buffer = pass002_output_texelAssignments, .offset = 0, .size = pass002_output_texelAssignments.GetSize() });
     bg003_entries.push_back({ .binding = 3, .buffer = pass001_output_clusterCenters, .offset = 0, .size = pass001_output_clusterCenters.GetSize() });
+    bg003_entries.push_back({ .binding = 4, .buffer = activeBlocksBuffer, .offset = 0, .size = activeBlocksBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg003_desc = {};
     bg003_desc.layout = pass003_bindGroupLayout;
@@ -1318,11 +1262,11 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass004 (count partition mismatch)
     std::vector<wgpu::BindGroupEntry> bg004_entries;
-    bg004_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg004_entries.push_back({ .binding = 1, .buffer = kmeansTexelsBuffer, .offset = 0, .size = kmeansTexelsBuffer.GetSize() });
-    bg004_entries.push_back({ .binding = 2, .buffer = coverageBitmaps2Buffer, .offset = 0, .size = coverageBitmaps2Buffer.GetSize() });
-    bg004_entries.push_back({ .binding = 3, .buffer = coverageBitmaps3Buffer, .offset = 0, .size = coverageBitmaps3Buffer.GetSize() });
-    bg004_entries.push_back({ .binding = 4, .buffer = coverageBitmaps4Buffer, .offset = 0, .size = coverageBitmaps4Buffer.GetSize() });
+    bg004_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg004_entries.push_back({ .binding = 1, .buffer = session->kmeansTexelsBuffer, .offset = 0, .size = session->kmeansTexelsBuffer.GetSize() });
+    bg004_entries.push_back({ .binding = 2, .buffer = session->coverageBitmaps2Buffer, .offset = 0, .size = session->coverageBitmaps2Buffer.GetSize() });
+    bg004_entries.push_back({ .binding = 3, .buffer = session->coverageBitmaps3Buffer, .offset = 0, .size = session->coverageBitmaps3Buffer.GetSize() });
+    bg004_entries.push_back({ .binding = 4, .buffer = session->coverageBitmaps4Buffer, .offset = 0, .size = session->coverageBitmaps4Buffer.GetSize() });
     bg004_entries.push_back({ .binding = 5, .buffer = pass002_output_texelAssignments, .offset = 0, .size = pass002_output_texelAssignments.GetSize() });
     bg004_entries.push_back({ .binding = 6, .buffer = pass004_output_mismatchCounts, .offset = 0, .size = pass004_output_mismatchCounts.GetSize() });
 
@@ -1335,7 +1279,7 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass005 (partition ordering)
     std::vector<wgpu::BindGroupEntry> bg005_entries;
-    bg005_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
+    bg005_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
     bg005_entries.push_back({ .binding = 1, .buffer = pass004_output_mismatchCounts, .offset = 0, .size = pass004_output_mismatchCounts.GetSize() });
     bg005_entries.push_back({ .binding = 2, .buffer = pass005_output_partitionOrdering, .offset = 0, .size = pass005_output_partitionOrdering.GetSize() });
 
@@ -1348,11 +1292,12 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass006 (evaluate partition candidates)
     std::vector<wgpu::BindGroupEntry> bg006_entries;
-    bg006_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg006_entries.push_back({ .binding = 1, .buffer = partitionInfoBuffer, .offset = 0, .size = partitionInfoBuffer.GetSize() });
+    bg006_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg006_entries.push_back({ .binding = 1, .buffer = session->partitionInfoBuffer, .offset = 0, .size = session->partitionInfoBuffer.GetSize() });
     bg006_entries.push_back({ .binding = 2, .buffer = inputBlocksBuffer, .offset = 0, .size = inputBlocksBuffer.GetSize() });
     bg006_entries.push_back({ .binding = 3, .buffer = pass005_output_partitionOrdering, .offset = 0, .size = pass005_output_partitionOrdering.GetSize() });
     bg006_entries.push_back({ .binding = 4, .buffer = pass006_output_partitioningErrors, .offset = 0, .size = pass006_output_partitioningErrors.GetSize() });
+    bg006_entries.push_back({ .binding = 5, .buffer = activeBlocksBuffer, .offset = 0, .size = activeBlocksBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg006_desc = {};
     bg006_desc.layout = pass006_bindGroupLayout;
@@ -1363,11 +1308,10 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass007 (evaluate partition candidates)
     std::vector<wgpu::BindGroupEntry> bg007_entries;
-    bg007_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg007_entries.push_back({ .binding = 1, .buffer = partitionInfoBuffer, .offset = 0, .size = partitionInfoBuffer.GetSize() });
-    bg007_entries.push_back({ .binding = 2, .buffer = inputBlocksBuffer, .offset = 0, .size = inputBlocksBuffer.GetSize() });
+    bg007_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
     bg007_entries.push_back({ .binding = 3, .buffer = pass006_output_partitioningErrors, .offset = 0, .size = pass006_output_partitioningErrors.GetSize() });
     bg007_entries.push_back({ .binding = 4, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
+    bg007_entries.push_back({ .binding = 5, .buffer = activeBlocksBuffer, .offset = 0, .size = activeBlocksBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg007_desc = {};
     bg007_desc.layout = pass007_bindGroupLayout;
@@ -1375,12 +1319,27 @@ void ASTCEncoder::initBindGroups() {
     bg007_desc.entries = bg007_entries.data();
     pass007_bindGroup = device.CreateBindGroup(&bg007_desc);
 
+    //bind group for pass008 (compact active blocks)
+    std::vector<wgpu::BindGroupEntry> bg008_entries;
+    bg008_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg008_entries.push_back({ .binding = 1, .buffer = pass18_output_symbolicBlocks, .offset = 0, .size = pass18_output_symbolicBlocks.GetSize() });
+    bg008_entries.push_back({ .binding = 2, .buffer = activeBlocksBuffer, .offset = 0, .size = activeBlocksBuffer.GetSize() });
+    bg008_entries.push_back({ .binding = 3, .buffer = indirectArgsBuffer, .offset = 0, .size = indirectArgsBuffer.GetSize() });
+
+    wgpu::BindGroupDescriptor bg008_desc = {};
+    bg008_desc.layout = pass008_bindGroupLayout;
+    bg008_desc.entryCount = bg008_entries.size();
+    bg008_desc.entries = bg008_entries.data();
+    pass008_bindGroup = device.CreateBindGroup(&bg008_desc);
+
 
     //bind group for pass1 (ideal endpoints and weights)
     std::vector<wgpu::BindGroupEntry> bg1_entries;
-    bg1_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg1_entries.push_back({ .binding = 1, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
+    bg1_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg1_entries.push_back({ .binding = 1, .buffer = inputBlocksBuffer, .offset = 0, .size = inputBlocksBuffer.GetSize() });
     bg1_entries.push_back({ .binding = 2, .buffer = pass1_output_idealEndpointsAndWeights, .offset = 0, .size = pass1_output_idealEndpointsAndWeights.GetSize() });
+    bg1_entries.push_back({ .binding = 3, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
+    bg1_entries.push_back({ .binding = 4, .buffer = session->partitionInfoBuffer, .offset = 0, .size = session->partitionInfoBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg1_desc = {};
     bg1_desc.layout = pass1_bindGroupLayout;
@@ -1391,11 +1350,11 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass2 (decimated weights)
     std::vector<wgpu::BindGroupEntry> bg2_entries;
-    bg2_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg2_entries.push_back({ .binding = 1, .buffer = validDecimationModesBuffer, .offset = 0, .size = validDecimationModesBuffer.GetSize() });
-    bg2_entries.push_back({ .binding = 2, .buffer = decimationInfoBuffer, .offset = 0, .size = decimationInfoBuffer.GetSize() });
-    bg2_entries.push_back({ .binding = 3, .buffer = texelToWeightMapBuffer, .offset = 0, .size = texelToWeightMapBuffer.GetSize() });
-    bg2_entries.push_back({ .binding = 4, .buffer = weightToTexelMapBuffer, .offset = 0, .size = weightToTexelMapBuffer.GetSize() });
+    bg2_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg2_entries.push_back({ .binding = 1, .buffer = session->validDecimationModesBuffer, .offset = 0, .size = session->validDecimationModesBuffer.GetSize() });
+    bg2_entries.push_back({ .binding = 2, .buffer = session->decimationInfoBuffer, .offset = 0, .size = session->decimationInfoBuffer.GetSize() });
+    bg2_entries.push_back({ .binding = 3, .buffer = session->texelToWeightMapBuffer, .offset = 0, .size = session->texelToWeightMapBuffer.GetSize() });
+    bg2_entries.push_back({ .binding = 4, .buffer = session->weightToTexelMapBuffer, .offset = 0, .size = session->weightToTexelMapBuffer.GetSize() });
     bg2_entries.push_back({ .binding = 5, .buffer = pass1_output_idealEndpointsAndWeights, .offset = 0, .size = pass1_output_idealEndpointsAndWeights.GetSize() });
     bg2_entries.push_back({ .binding = 6, .buffer = pass2_output_decimatedWeights, .offset = 0, .size = pass2_output_decimatedWeights.GetSize() });
 
@@ -1408,9 +1367,9 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass3 (angular offsets)
     std::vector<wgpu::BindGroupEntry> bg3_entries;
-    bg3_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg3_entries.push_back({ .binding = 1, .buffer = validDecimationModesBuffer, .offset = 0, .size = validDecimationModesBuffer.GetSize() });
-    bg3_entries.push_back({ .binding = 2, .buffer = decimationInfoBuffer, .offset = 0, .size = decimationInfoBuffer.GetSize() });
+    bg3_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg3_entries.push_back({ .binding = 1, .buffer = session->validDecimationModesBuffer, .offset = 0, .size = session->validDecimationModesBuffer.GetSize() });
+    bg3_entries.push_back({ .binding = 2, .buffer = session->decimationInfoBuffer, .offset = 0, .size = session->decimationInfoBuffer.GetSize() });
     bg3_entries.push_back({ .binding = 3, .buffer = sinBuffer, .offset = 0, .size = sinBuffer.GetSize() });
     bg3_entries.push_back({ .binding = 4, .buffer = cosBuffer, .offset = 0, .size = cosBuffer.GetSize() });
     bg3_entries.push_back({ .binding = 5, .buffer = pass2_output_decimatedWeights, .offset = 0, .size = pass2_output_decimatedWeights.GetSize() });
@@ -1425,9 +1384,9 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass4 (lowest nad highest weight)
     std::vector<wgpu::BindGroupEntry> bg4_entries;
-    bg4_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg4_entries.push_back({ .binding = 1, .buffer = validDecimationModesBuffer, .offset = 0, .size = validDecimationModesBuffer.GetSize() });
-    bg4_entries.push_back({ .binding = 2, .buffer = decimationInfoBuffer, .offset = 0, .size = decimationInfoBuffer.GetSize() });
+    bg4_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg4_entries.push_back({ .binding = 1, .buffer = session->validDecimationModesBuffer, .offset = 0, .size = session->validDecimationModesBuffer.GetSize() });
+    bg4_entries.push_back({ .binding = 2, .buffer = session->decimationInfoBuffer, .offset = 0, .size = session->decimationInfoBuffer.GetSize() });
     bg4_entries.push_back({ .binding = 3, .buffer = pass2_output_decimatedWeights, .offset = 0, .size = pass2_output_decimatedWeights.GetSize() });
     bg4_entries.push_back({ .binding = 4, .buffer = pass3_output_angular_offsets, .offset = 0, .size = pass3_output_angular_offsets.GetSize() });
     bg4_entries.push_back({ .binding = 5, .buffer = pass4_output_lowestAndHighestWeight, .offset = 0, .size = pass4_output_lowestAndHighestWeight.GetSize() });
@@ -1441,9 +1400,9 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass5 (best values for quant levels)
     std::vector<wgpu::BindGroupEntry> bg5_entries;
-    bg5_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg5_entries.push_back({ .binding = 1, .buffer = validDecimationModesBuffer, .offset = 0, .size = validDecimationModesBuffer.GetSize() });
-    bg5_entries.push_back({ .binding = 2, .buffer = decimationInfoBuffer, .offset = 0, .size = decimationInfoBuffer.GetSize() });
+    bg5_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg5_entries.push_back({ .binding = 1, .buffer = session->validDecimationModesBuffer, .offset = 0, .size = session->validDecimationModesBuffer.GetSize() });
+    bg5_entries.push_back({ .binding = 2, .buffer = session->decimationInfoBuffer, .offset = 0, .size = session->decimationInfoBuffer.GetSize() });
     bg5_entries.push_back({ .binding = 3, .buffer = pass3_output_angular_offsets, .offset = 0, .size = pass3_output_angular_offsets.GetSize() });
     bg5_entries.push_back({ .binding = 4, .buffer = pass4_output_lowestAndHighestWeight, .offset = 0, .size = pass4_output_lowestAndHighestWeight.GetSize() });
     bg5_entries.push_back({ .binding = 5, .buffer = pass5_output_lowValues, .offset = 0, .size = pass5_output_lowValues.GetSize() });
@@ -1458,9 +1417,9 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass6 (remap low and high values)
     std::vector<wgpu::BindGroupEntry> bg6_entries;
-    bg6_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg6_entries.push_back({ .binding = 1, .buffer = validBlockModesBuffer, .offset = 0, .size = validBlockModesBuffer.GetSize() });
-    bg6_entries.push_back({ .binding = 2, .buffer = blockModesBuffer, .offset = 0, .size = blockModesBuffer.GetSize() });
+    bg6_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg6_entries.push_back({ .binding = 1, .buffer = session->validBlockModesBuffer, .offset = 0, .size = session->validBlockModesBuffer.GetSize() });
+    bg6_entries.push_back({ .binding = 2, .buffer = session->blockModesBuffer, .offset = 0, .size = session->blockModesBuffer.GetSize() });
     bg6_entries.push_back({ .binding = 3, .buffer = pass5_output_lowValues, .offset = 0, .size = pass5_output_lowValues.GetSize() });
     bg6_entries.push_back({ .binding = 4, .buffer = pass5_output_highValues, .offset = 0, .size = pass5_output_highValues.GetSize() });
     bg6_entries.push_back({ .binding = 5, .buffer = pass6_output_finalValueRanges, .offset = 0, .size = pass6_output_finalValueRanges.GetSize() });
@@ -1474,14 +1433,14 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass7 (weights and error for block mode)
     std::vector<wgpu::BindGroupEntry> bg7_entries;
-    bg7_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg7_entries.push_back({ .binding = 1, .buffer = validBlockModesBuffer, .offset = 0, .size = validBlockModesBuffer.GetSize() });
-    bg7_entries.push_back({ .binding = 2, .buffer = blockModesBuffer, .offset = 0, .size = blockModesBuffer.GetSize() });
-    bg7_entries.push_back({ .binding = 3, .buffer = decimationInfoBuffer, .offset = 0, .size = decimationInfoBuffer.GetSize() });
+    bg7_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg7_entries.push_back({ .binding = 1, .buffer = session->validBlockModesBuffer, .offset = 0, .size = session->validBlockModesBuffer.GetSize() });
+    bg7_entries.push_back({ .binding = 2, .buffer = session->blockModesBuffer, .offset = 0, .size = session->blockModesBuffer.GetSize() });
+    bg7_entries.push_back({ .binding = 3, .buffer = session->decimationInfoBuffer, .offset = 0, .size = session->decimationInfoBuffer.GetSize() });
     bg7_entries.push_back({ .binding = 4, .buffer = pass2_output_decimatedWeights, .offset = 0, .size = pass2_output_decimatedWeights.GetSize() });
     bg7_entries.push_back({ .binding = 5, .buffer = pass6_output_finalValueRanges, .offset = 0, .size = pass6_output_finalValueRanges.GetSize() });
     bg7_entries.push_back({ .binding = 6, .buffer = pass1_output_idealEndpointsAndWeights, .offset = 0, .size = pass1_output_idealEndpointsAndWeights.GetSize() });
-    bg7_entries.push_back({ .binding = 7, .buffer = texelToWeightMapBuffer, .offset = 0, .size = texelToWeightMapBuffer.GetSize() });
+    bg7_entries.push_back({ .binding = 7, .buffer = session->texelToWeightMapBuffer, .offset = 0, .size = session->texelToWeightMapBuffer.GetSize() });
     bg7_entries.push_back({ .binding = 8, .buffer = pass7_output_quantizationResults, .offset = 0, .size = pass7_output_quantizationResults.GetSize() });
 
     wgpu::BindGroupDescriptor bg7_desc = {};
@@ -1492,10 +1451,12 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass8 (encoding choice errors)
     std::vector<wgpu::BindGroupEntry> bg8_entries;
-    bg8_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg8_entries.push_back({ .binding = 1, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
+    bg8_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg8_entries.push_back({ .binding = 1, .buffer = inputBlocksBuffer, .offset = 0, .size = inputBlocksBuffer.GetSize() });
     bg8_entries.push_back({ .binding = 2, .buffer = pass1_output_idealEndpointsAndWeights, .offset = 0, .size = pass1_output_idealEndpointsAndWeights.GetSize() });
     bg8_entries.push_back({ .binding = 3, .buffer = pass8_output_encodingChoiceErrors, .offset = 0, .size = pass8_output_encodingChoiceErrors.GetSize() });
+    bg8_entries.push_back({ .binding = 4, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
+    bg8_entries.push_back({ .binding = 5, .buffer = session->partitionInfoBuffer, .offset = 0, .size = session->partitionInfoBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg8_desc = {};
     bg8_desc.layout = pass8_bindGroupLayout;
@@ -1505,12 +1466,13 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass9 (color format errors)
     std::vector<wgpu::BindGroupEntry> bg9_entries;
-    bg9_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
+    bg9_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
     bg9_entries.push_back({ .binding = 1, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
     bg9_entries.push_back({ .binding = 2, .buffer = pass1_output_idealEndpointsAndWeights, .offset = 0, .size = pass1_output_idealEndpointsAndWeights.GetSize() });
     bg9_entries.push_back({ .binding = 3, .buffer = pass8_output_encodingChoiceErrors, .offset = 0, .size = pass8_output_encodingChoiceErrors.GetSize() });
     bg9_entries.push_back({ .binding = 4, .buffer = pass9_output_colorFormatErrors, .offset = 0, .size = pass9_output_colorFormatErrors.GetSize() });
     bg9_entries.push_back({ .binding = 5, .buffer = pass9_output_colorFormats, .offset = 0, .size = pass9_output_colorFormats.GetSize() });
+    bg9_entries.push_back({ .binding = 6, .buffer = session->partitionInfoBuffer, .offset = 0, .size = session->partitionInfoBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg9_desc = {};
     bg9_desc.layout = pass9_bindGroupLayout;
@@ -1520,7 +1482,7 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass10 (color endpoint combinations)
     std::vector<wgpu::BindGroupEntry> bg10_entries;
-    bg10_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
+    bg10_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
     bg10_entries.push_back({ .binding = 1, .buffer = pass9_output_colorFormatErrors, .offset = 0, .size = pass9_output_colorFormatErrors.GetSize() });
     bg10_entries.push_back({ .binding = 2, .buffer = pass9_output_colorFormats, .offset = 0, .size = pass9_output_colorFormats.GetSize() });
     bg10_entries.push_back({ .binding = 3, .buffer = pass10_output_colorEndpointCombinations, .offset = 0, .size = pass10_output_colorEndpointCombinations.GetSize() });
@@ -1533,8 +1495,8 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass11, 1 partition (best endpoint combinations for mode)
     std::vector<wgpu::BindGroupEntry> bg11_1_entries;
-    bg11_1_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg11_1_entries.push_back({ .binding = 1, .buffer = validBlockModesBuffer, .offset = 0, .size = validBlockModesBuffer.GetSize() });
+    bg11_1_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg11_1_entries.push_back({ .binding = 1, .buffer = session->validBlockModesBuffer, .offset = 0, .size = session->validBlockModesBuffer.GetSize() });
     bg11_1_entries.push_back({ .binding = 2, .buffer = pass7_output_quantizationResults, .offset = 0, .size = pass7_output_quantizationResults.GetSize() });
     bg11_1_entries.push_back({ .binding = 3, .buffer = pass9_output_colorFormatErrors, .offset = 0, .size = pass9_output_colorFormatErrors.GetSize() });
     bg11_1_entries.push_back({ .binding = 4, .buffer = pass9_output_colorFormats, .offset = 0, .size = pass9_output_colorFormats.GetSize() });
@@ -1548,8 +1510,8 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass11, 2,3,4 partitions (best endpoint combinations for mode)
     std::vector<wgpu::BindGroupEntry> bg11_234_entries;
-    bg11_234_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg11_234_entries.push_back({ .binding = 1, .buffer = validBlockModesBuffer, .offset = 0, .size = validBlockModesBuffer.GetSize() });
+    bg11_234_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg11_234_entries.push_back({ .binding = 1, .buffer = session->validBlockModesBuffer, .offset = 0, .size = session->validBlockModesBuffer.GetSize() });
     bg11_234_entries.push_back({ .binding = 2, .buffer = pass7_output_quantizationResults, .offset = 0, .size = pass7_output_quantizationResults.GetSize() });
     bg11_234_entries.push_back({ .binding = 3, .buffer = pass10_output_colorEndpointCombinations, .offset = 0, .size = pass10_output_colorEndpointCombinations.GetSize() });
     bg11_234_entries.push_back({ .binding = 4, .buffer = pass11_output_bestEndpointCombinationsForMode, .offset = 0, .size = pass11_output_bestEndpointCombinationsForMode.GetSize() });
@@ -1562,8 +1524,8 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass12 (final candidates)
     std::vector<wgpu::BindGroupEntry> bg12_entries;
-    bg12_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg12_entries.push_back({ .binding = 1, .buffer = validBlockModesBuffer, .offset = 0, .size = validBlockModesBuffer.GetSize() });
+    bg12_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg12_entries.push_back({ .binding = 1, .buffer = session->validBlockModesBuffer, .offset = 0, .size = session->validBlockModesBuffer.GetSize() });
     bg12_entries.push_back({ .binding = 2, .buffer = pass1_output_idealEndpointsAndWeights, .offset = 0, .size = pass1_output_idealEndpointsAndWeights.GetSize() });
     bg12_entries.push_back({ .binding = 3, .buffer = pass7_output_quantizationResults, .offset = 0, .size = pass7_output_quantizationResults.GetSize() });
     bg12_entries.push_back({ .binding = 4, .buffer = pass11_output_bestEndpointCombinationsForMode, .offset = 0, .size = pass11_output_bestEndpointCombinationsForMode.GetSize() });
@@ -1578,13 +1540,15 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass13 (recompute ideal endpoints)
     std::vector<wgpu::BindGroupEntry> bg13_entries;
-    bg13_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg13_entries.push_back({ .binding = 1, .buffer = decimationInfoBuffer, .offset = 0, .size = decimationInfoBuffer.GetSize() });
-    bg13_entries.push_back({ .binding = 2, .buffer = texelToWeightMapBuffer, .offset = 0, .size = texelToWeightMapBuffer.GetSize() });
-    bg13_entries.push_back({ .binding = 3, .buffer = blockModesBuffer, .offset = 0, .size = blockModesBuffer.GetSize() });
-    bg13_entries.push_back({ .binding = 4, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
+    bg13_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg13_entries.push_back({ .binding = 1, .buffer = session->decimationInfoBuffer, .offset = 0, .size = session->decimationInfoBuffer.GetSize() });
+    bg13_entries.push_back({ .binding = 2, .buffer = session->texelToWeightMapBuffer, .offset = 0, .size = session->texelToWeightMapBuffer.GetSize() });
+    bg13_entries.push_back({ .binding = 3, .buffer = session->blockModesBuffer, .offset = 0, .size = session->blockModesBuffer.GetSize() });
+    bg13_entries.push_back({ .binding = 4, .buffer = inputBlocksBuffer, .offset = 0, .size = inputBlocksBuffer.GetSize() });
     bg13_entries.push_back({ .binding = 5, .buffer = pass12_output_finalCandidates, .offset = 0, .size = pass12_output_finalCandidates.GetSize() });
     bg13_entries.push_back({ .binding = 6, .buffer = pass13_output_rgbsVectors, .offset = 0, .size = pass13_output_rgbsVectors.GetSize() });
+    bg13_entries.push_back({ .binding = 7, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
+    bg13_entries.push_back({ .binding = 8, .buffer = session->partitionInfoBuffer, .offset = 0, .size = session->partitionInfoBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg13_desc = {};
     bg13_desc.layout = pass13_bindGroupLayout;
@@ -1594,7 +1558,7 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass14 (pack color endpoints)
     std::vector<wgpu::BindGroupEntry> bg14_entries;
-    bg14_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
+    bg14_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
     bg14_entries.push_back({ .binding = 1, .buffer = pass13_output_rgbsVectors, .offset = 0, .size = pass13_output_rgbsVectors.GetSize() });
     bg14_entries.push_back({ .binding = 2, .buffer = pass12_output_finalCandidates, .offset = 0, .size = pass12_output_finalCandidates.GetSize() });
 
@@ -1606,7 +1570,7 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass15 (unpack color endpoints)
     std::vector<wgpu::BindGroupEntry> bg15_entries;
-    bg15_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
+    bg15_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
     bg15_entries.push_back({ .binding = 1, .buffer = pass12_output_finalCandidates, .offset = 0, .size = pass12_output_finalCandidates.GetSize() });
     bg15_entries.push_back({ .binding = 2, .buffer = pass15_output_unpackedEndpoints, .offset = 0, .size = pass15_output_unpackedEndpoints.GetSize() });
 
@@ -1618,14 +1582,16 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass16 (realign weights)
     std::vector<wgpu::BindGroupEntry> bg16_entries;
-    bg16_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg16_entries.push_back({ .binding = 1, .buffer = blockModesBuffer, .offset = 0, .size = blockModesBuffer.GetSize() });
-    bg16_entries.push_back({ .binding = 2, .buffer = decimationInfoBuffer, .offset = 0, .size = decimationInfoBuffer.GetSize() });
-    bg16_entries.push_back({ .binding = 3, .buffer = texelToWeightMapBuffer, .offset = 0, .size = texelToWeightMapBuffer.GetSize() });
-    bg16_entries.push_back({ .binding = 4, .buffer = weightToTexelMapBuffer, .offset = 0, .size = weightToTexelMapBuffer.GetSize() });
-    bg16_entries.push_back({ .binding = 5, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
+    bg16_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg16_entries.push_back({ .binding = 1, .buffer = session->blockModesBuffer, .offset = 0, .size = session->blockModesBuffer.GetSize() });
+    bg16_entries.push_back({ .binding = 2, .buffer = session->decimationInfoBuffer, .offset = 0, .size = session->decimationInfoBuffer.GetSize() });
+    bg16_entries.push_back({ .binding = 3, .buffer = session->texelToWeightMapBuffer, .offset = 0, .size = session->texelToWeightMapBuffer.GetSize() });
+    bg16_entries.push_back({ .binding = 4, .buffer = session->weightToTexelMapBuffer, .offset = 0, .size = session->weightToTexelMapBuffer.GetSize() });
+    bg16_entries.push_back({ .binding = 5, .buffer = inputBlocksBuffer, .offset = 0, .size = inputBlocksBuffer.GetSize() });
     bg16_entries.push_back({ .binding = 6, .buffer = pass15_output_unpackedEndpoints, .offset = 0, .size = pass15_output_unpackedEndpoints.GetSize() });
     bg16_entries.push_back({ .binding = 7, .buffer = pass12_output_finalCandidates, .offset = 0, .size = pass12_output_finalCandidates.GetSize() });
+    bg16_entries.push_back({ .binding = 8, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
+    bg16_entries.push_back({ .binding = 9, .buffer = session->partitionInfoBuffer, .offset = 0, .size = session->partitionInfoBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg16_desc = {};
     bg16_desc.layout = pass16_bindGroupLayout;
@@ -1635,14 +1601,16 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass17 (compute final error)
     std::vector<wgpu::BindGroupEntry> bg17_entries;
-    bg17_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
-    bg17_entries.push_back({ .binding = 1, .buffer = blockModesBuffer, .offset = 0, .size = blockModesBuffer.GetSize() });
-    bg17_entries.push_back({ .binding = 2, .buffer = decimationInfoBuffer, .offset = 0, .size = decimationInfoBuffer.GetSize() });
-    bg17_entries.push_back({ .binding = 3, .buffer = texelToWeightMapBuffer, .offset = 0, .size = texelToWeightMapBuffer.GetSize() });
-    bg17_entries.push_back({ .binding = 4, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
+    bg17_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg17_entries.push_back({ .binding = 1, .buffer = session->blockModesBuffer, .offset = 0, .size = session->blockModesBuffer.GetSize() });
+    bg17_entries.push_back({ .binding = 2, .buffer = session->decimationInfoBuffer, .offset = 0, .size = session->decimationInfoBuffer.GetSize() });
+    bg17_entries.push_back({ .binding = 3, .buffer = session->texelToWeightMapBuffer, .offset = 0, .size = session->texelToWeightMapBuffer.GetSize() });
+    bg17_entries.push_back({ .binding = 4, .buffer = inputBlocksBuffer, .offset = 0, .size = inputBlocksBuffer.GetSize() });
     bg17_entries.push_back({ .binding = 5, .buffer = pass15_output_unpackedEndpoints, .offset = 0, .size = pass15_output_unpackedEndpoints.GetSize() });
     bg17_entries.push_back({ .binding = 6, .buffer = pass12_output_finalCandidates, .offset = 0, .size = pass12_output_finalCandidates.GetSize() });
     bg17_entries.push_back({ .binding = 7, .buffer = pass12_output_topCandidates, .offset = 0, .size = pass12_output_topCandidates.GetSize() });
+    bg17_entries.push_back({ .binding = 8, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
+    bg17_entries.push_back({ .binding = 9, .buffer = session->partitionInfoBuffer, .offset = 0, .size = session->partitionInfoBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg17_desc = {};
     bg17_desc.layout = pass17_bindGroupLayout;
@@ -1652,38 +1620,49 @@ void ASTCEncoder::initBindGroups() {
 
     //bind group for pass18 (pick best candidate)
     std::vector<wgpu::BindGroupEntry> bg18_entries;
-    bg18_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = uniformsBuffer.GetSize() });
+    bg18_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
     bg18_entries.push_back({ .binding = 1, .buffer = partitionedBlocksBuffer, .offset = 0, .size = partitionedBlocksBuffer.GetSize() });
     bg18_entries.push_back({ .binding = 2, .buffer = pass12_output_topCandidates, .offset = 0, .size = pass12_output_topCandidates.GetSize() });
-    bg18_entries.push_back({ .binding = 3, .buffer = blockModesBuffer, .offset = 0, .size = blockModesBuffer.GetSize() });
+    bg18_entries.push_back({ .binding = 3, .buffer = session->blockModesBuffer, .offset = 0, .size = session->blockModesBuffer.GetSize() });
     bg18_entries.push_back({ .binding = 4, .buffer = pass18_output_symbolicBlocks, .offset = 0, .size = pass18_output_symbolicBlocks.GetSize() });
+    bg18_entries.push_back({ .binding = 5, .buffer = activeBlocksBuffer, .offset = 0, .size = activeBlocksBuffer.GetSize() });
+    bg18_entries.push_back({ .binding = 6, .buffer = session->partitionInfoBuffer, .offset = 0, .size = session->partitionInfoBuffer.GetSize() });
 
     wgpu::BindGroupDescriptor bg18_desc = {};
     bg18_desc.layout = pass18_bindGroupLayout;
     bg18_desc.entryCount = bg18_entries.size();
     bg18_desc.entries = bg18_entries.data();
     pass18_bindGroup = device.CreateBindGroup(&bg18_desc);
+
+    //bind group for pass19 (symbolic to physical)
+    std::vector<wgpu::BindGroupEntry> bg19_entries;
+    bg19_entries.push_back({ .binding = 0, .buffer = uniformsBuffer, .offset = 0, .size = sizeof(uniform_variables) });
+    bg19_entries.push_back({ .binding = 1, .buffer = pass18_output_symbolicBlocks, .offset = 0, .size = pass18_output_symbolicBlocks.GetSize() });
+    bg19_entries.push_back({ .binding = 2, .buffer = session->blockModesBuffer, .offset = 0, .size = session->blockModesBuffer.GetSize() });
+    bg19_entries.push_back({ .binding = 3, .buffer = session->blockModeIndexBuffer, .offset = 0, .size = session->blockModeIndexBuffer.GetSize() });
+    bg19_entries.push_back({ .binding = 4, .buffer = session->decimationInfoBuffer, .offset = 0, .size = session->decimationInfoBuffer.GetSize() });
+    bg19_entries.push_back({ .binding = 5, .buffer = iseTablesBuffer, .offset = 0, .size = iseTablesBuffer.GetSize() });
+    bg19_entries.push_back({ .binding = 6, .buffer = pass19_output_physicalBlocks, .offset = 0, .size = pass19_output_physicalBlocks.GetSize() });
+
+    wgpu::BindGroupDescriptor bg19_desc = {};
+    bg19_desc.layout = pass19_bindGroupLayout;
+    bg19_desc.entryCount = bg19_entries.size();
+    bg19_desc.entries = bg19_entries.data();
+    pass19_bindGroup = device.CreateBindGroup(&bg19_desc);
 }
 
-void ASTCEncoder::releasePerImageResources() {
-    // This function explicitly destroys all GPU buffers that are created
-    // on a per-image basis, preventing memory leaks.
+void ASTCEncoder::releaseResources() {
+    // This function explicitly destroys all GPU buffers of the encoder
+    // (shared, per batch and the constant buffers of every session).
     if (uniformsBuffer) uniformsBuffer.Destroy();
-	if (kmeansTexelsBuffer) kmeansTexelsBuffer.Destroy();
-	if (coverageBitmaps2Buffer) coverageBitmaps2Buffer.Destroy();
-	if (coverageBitmaps3Buffer) coverageBitmaps3Buffer.Destroy();
-	if (coverageBitmaps4Buffer) coverageBitmaps4Buffer.Destroy();
-    if (blockModesBuffer) blockModesBuffer.Destroy();
-    if (blockModeIndexBuffer) blockModeIndexBuffer.Destroy();
-    if (decimationModesBuffer) decimationModesBuffer.Destroy();
-    if (decimationInfoBuffer) decimationInfoBuffer.Destroy();
-    if (texelToWeightMapBuffer) texelToWeightMapBuffer.Destroy();
-    if (weightToTexelMapBuffer) weightToTexelMapBuffer.Destroy();
-    if (validDecimationModesBuffer) validDecimationModesBuffer.Destroy();
-    if (validBlockModesBuffer) validBlockModesBuffer.Destroy();
+    if (iseTablesBuffer) iseTablesBuffer.Destroy();
     if (sinBuffer) sinBuffer.Destroy();
     if (cosBuffer) cosBuffer.Destroy();
+    if (extractionUniformsBuffer) extractionUniformsBuffer.Destroy();
+    if (imageRowsBuffer) imageRowsBuffer.Destroy();
     if (inputBlocksBuffer) inputBlocksBuffer.Destroy();
+    if (activeBlocksBuffer) activeBlocksBuffer.Destroy();
+    if (indirectArgsBuffer) indirectArgsBuffer.Destroy();
 	if (pass001_output_clusterCenters) pass001_output_clusterCenters.Destroy();
     if (pass002_output_texelAssignments) pass002_output_texelAssignments.Destroy();
 	if (pass004_output_mismatchCounts) pass004_output_mismatchCounts.Destroy();
@@ -1708,33 +1687,64 @@ void ASTCEncoder::releasePerImageResources() {
     if (pass13_output_rgbsVectors) pass13_output_rgbsVectors.Destroy();
     if (pass15_output_unpackedEndpoints) pass15_output_unpackedEndpoints.Destroy();
     if (pass18_output_symbolicBlocks) pass18_output_symbolicBlocks.Destroy();
-    if (outputReadbackBuffer) outputReadbackBuffer.Destroy();
+    if (pass19_output_physicalBlocks) pass19_output_physicalBlocks.Destroy();
+
+    //pending map requests must complete before their buffers go away
+    waitForBatchSlots();
+    for (BatchSlot& slot : batchSlots) {
+        if (slot.inputStagingBuffer) slot.inputStagingBuffer.Destroy();
+        if (slot.readbackBuffer) slot.readbackBuffer.Destroy();
+        gpuProfiler.releaseResources(slot.queries);
+    }
+
+    for (auto& entry : sessions) {
+        BlockSizeSession& blockSession = *entry.second;
+        if (blockSession.kmeansTexelsBuffer) blockSession.kmeansTexelsBuffer.Destroy();
+        if (blockSession.coverageBitmaps2Buffer) blockSession.coverageBitmaps2Buffer.Destroy();
+        if (blockSession.coverageBitmaps3Buffer) blockSession.coverageBitmaps3Buffer.Destroy();
+        if (blockSession.coverageBitmaps4Buffer) blockSession.coverageBitmaps4Buffer.Destroy();
+        if (blockSession.partitionInfoBuffer) blockSession.partitionInfoBuffer.Destroy();
+        if (blockSession.blockModesBuffer) blockSession.blockModesBuffer.Destroy();
+        if (blockSession.blockModeIndexBuffer) blockSession.blockModeIndexBuffer.Destroy();
+        if (blockSession.decimationModesBuffer) blockSession.decimationModesBuffer.Destroy();
+        if (blockSession.decimationInfoBuffer) blockSession.decimationInfoBuffer.Destroy();
+        if (blockSession.texelToWeightMapBuffer) blockSession.texelToWeightMapBuffer.Destroy();
+        if (blockSession.weightToTexelMapBuffer) blockSession.weightToTexelMapBuffer.Destroy();
+        if (blockSession.validDecimationModesBuffer) blockSession.validDecimationModesBuffer.Destroy();
+        if (blockSession.validBlockModesBuffer) blockSession.validBlockModesBuffer.Destroy();
+    }
+    sessions.clear();
+    session = nullptr;
+    boundSession = nullptr;
 }
 
 void ASTCEncoder::printBufferSizes() {
-    std::cout << "Input_blocks_buffer: " << (float)(inputBlocksBuffer.GetSize()) / 1000000 << std::endl;
-    std::cout << "Pass001_output_clusterCenters: " << (float)(pass001_output_clusterCenters.GetSize()) / 1000000 << std::endl;
-    std::cout << "Pass002_output_texelAssignments: " << (float)(pass002_output_texelAssignments.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass004_output_mismatchCounts: " << (float)(pass004_output_mismatchCounts.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass005_output_partitionOrdering: " << (float)(pass005_output_partitionOrdering.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass006_output_partitioningErrors: " << (float)(pass006_output_partitioningErrors.GetSize()) / 1000000 << std::endl;
-	std::cout << "Partitioned_blocks_buffer: " << (float)(partitionedBlocksBuffer.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass1_output_idealEndpointsAndWeights: " << (float)(pass1_output_idealEndpointsAndWeights.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass2_output_decimatedWeights: " << (float)(pass2_output_decimatedWeights.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass3_output_angular_offsets: " << (float)(pass3_output_angular_offsets.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass4_output_lowestAndHighestWeight: " << (float)(pass4_output_lowestAndHighestWeight.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass5_output_lowValues: " << (float)(pass5_output_lowValues.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass5_output_highValues: " << (float)(pass5_output_highValues.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass6_output_finalValueRanges: " << (float)(pass6_output_finalValueRanges.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass7_output_quantizationResults: " << (float)(pass7_output_quantizationResults.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass8_output_encodingChoiceErrors: " << (float)(pass8_output_encodingChoiceErrors.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass9_output_colorFormatErrors: " << (float)(pass9_output_colorFormatErrors.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass9_output_colorFormats: " << (float)(pass9_output_colorFormats.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass10_output_colorEndpointCombinations: " << (float)(pass10_output_colorEndpointCombinations.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass11_output_bestEndpointCombinationsForMode: " << (float)(pass11_output_bestEndpointCombinationsForMode.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass12_output_finalCandidates: " << (float)(pass12_output_finalCandidates.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass12_output_topCandidates: " << (float)(pass12_output_topCandidates.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass13_output_rgbsVectors: " << (float)(pass13_output_rgbsVectors.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass15_output_unpackedEndpoints: " << (float)(pass15_output_unpackedEndpoints.GetSize()) / 1000000 << std::endl;
-	std::cout << "Pass18_output_symbolicBlocks: " << (float)(pass18_output_symbolicBlocks.GetSize()) / 1000000 << std::endl;
+    ASTC_LOG(LogLevel::Debug, "Image_rows_buffer: " << (float)(imageRowsBuffer.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Input_blocks_buffer: " << (float)(inputBlocksBuffer.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Active_blocks_buffer: " << (float)(activeBlocksBuffer.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass001_output_clusterCenters: " << (float)(pass001_output_clusterCenters.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass002_output_texelAssignments: " << (float)(pass002_output_texelAssignments.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass004_output_mismatchCounts: " << (float)(pass004_output_mismatchCounts.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass005_output_partitionOrdering: " << (float)(pass005_output_partitionOrdering.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass006_output_partitioningErrors: " << (float)(pass006_output_partitioningErrors.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Partitioned_blocks_buffer: " << (float)(partitionedBlocksBuffer.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass1_output_idealEndpointsAndWeights: " << (float)(pass1_output_idealEndpointsAndWeights.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass2_output_decimatedWeights: " << (float)(pass2_output_decimatedWeights.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass3_output_angular_offsets: " << (float)(pass3_output_angular_offsets.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass4_output_lowestAndHighestWeight: " << (float)(pass4_output_lowestAndHighestWeight.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass5_output_lowValues: " << (float)(pass5_output_lowValues.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass5_output_highValues: " << (float)(pass5_output_highValues.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass6_output_finalValueRanges: " << (float)(pass6_output_finalValueRanges.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass7_output_quantizationResults: " << (float)(pass7_output_quantizationResults.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass8_output_encodingChoiceErrors: " << (float)(pass8_output_encodingChoiceErrors.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass9_output_colorFormatErrors: " << (float)(pass9_output_colorFormatErrors.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass9_output_colorFormats: " << (float)(pass9_output_colorFormats.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass10_output_colorEndpointCombinations: " << (float)(pass10_output_colorEndpointCombinations.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass11_output_bestEndpointCombinationsForMode: " << (float)(pass11_output_bestEndpointCombinationsForMode.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass12_output_finalCandidates: " << (float)(pass12_output_finalCandidates.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass12_output_topCandidates: " << (float)(pass12_output_topCandidates.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass13_output_rgbsVectors: " << (float)(pass13_output_rgbsVectors.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass15_output_unpackedEndpoints: " << (float)(pass15_output_unpackedEndpoints.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass18_output_symbolicBlocks: " << (float)(pass18_output_symbolicBlocks.GetSize()) / 1000000);
+    ASTC_LOG(LogLevel::Debug, "Pass19_output_physicalBlocks: " << (float)(pass19_output_physicalBlocks.GetSize()) / 1000000);
 }
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+
+#if defined(EMSCRIPTEN) && !defined(__EMSCRIPTEN_PTHREADS__)
+	//no threads available, parallelFor runs everything on the calling thread
+	threadCount = 0;
+#else
+	if (threadCount == 0) {
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+#endif
+
+	for (unsigned int i = 0; i < threadCount; i++) {
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		stopping = true;
+	}
+	tasksAvailable.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::workerLoop() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(tasksMutex);
+			tasksAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+			if (stopping && tasks.empty()) {
+				return;
+			}
+
+			task = std::move(tasks.front());
+			tasks.pop();
+		}
+		task();
+	}
+}
+
+void ThreadPool::parallelFor(uint32_t count, uint32_t minRange, const std::function<void(uint32_t, uint32_t)>& fn) {
+
+	if (count == 0) {
+		return;
+	}
+
+	uint32_t rangeCount = std::min<uint32_t>(concurrency(), (count + std::max(minRange, 1u) - 1) / std::max(minRange, 1u));
+	if (rangeCount <= 1) {
+		fn(0, count);
+		return;
+	}
+
+	uint32_t rangeSize = (count + rangeCount - 1) / rangeCount;
+
+	//shared with the tasks, which may still hold it for a moment after the caller has returned
+	struct RangeState {
+		uint32_t remaining;
+		std::exception_ptr error;
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+	std::shared_ptr<RangeState> state = std::make_shared<RangeState>();
+	state->remaining = rangeCount - 1;
+
+	//ranges 1..n go to the workers, the calling thread takes range 0
+	{
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		for (uint32_t r = 1; r < rangeCount; r++) {
+			uint32_t begin = r * rangeSize;
+			uint32_t end = std::min(begin + rangeSize, count);
+
+			tasks.push([state, &fn, begin, end] {
+				std::exception_ptr error;
+				try {
+					if (begin < end) {
+						fn(begin, end);
+					}
+				}
+				catch (...) {
+					error = std::current_exception();
+				}
+
+				std::lock_guard<std::mutex> doneLock(state->mutex);
+				if (error && !state->error) {
+					state->error = error;
+				}
+				if (--state->remaining == 0) {
+					state->done.notify_one();
+				}
+			});
+		}
+	}
+	tasksAvailable.notify_all();
+
+	//fn is referenced by the queued ranges, so they are waited for even when the calling thread's range throws
+	std::exception_ptr error;
+	try {
+		fn(0, std::min(rangeSize, count));
+	}
+	catch (...) {
+		error = std::current_exception();
+	}
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->done.wait(lock, [&] { return state->remaining == 0; });
+
+	if (!error) {
+		error = state->error;
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
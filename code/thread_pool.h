@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * @brief Fixed set of worker threads for the host side stages of the encoder.
+ *
+ * Work is handed out as contiguous ranges of an index space, the calling thread works on one of
+ * the ranges as well. Without thread support (Emscripten builds without pthreads) the pool has no
+ * workers and everything runs on the calling thread.
+ */
+class ThreadPool {
+public:
+	/**
+	 * @param threadCount   Number of worker threads, 0 picks one less than the hardware concurrency.
+	 */
+	explicit ThreadPool(unsigned int threadCount = 0);
+
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * @brief Number of threads working on a parallelFor, including the calling thread.
+	 */
+	unsigned int concurrency() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+	/**
+	 * @brief Split [0, count) into contiguous ranges and call fn(begin, end) for each of them in parallel.
+	 *
+	 * Blocks until every range has been processed. Ranges are never smaller than minRange items, so
+	 * small workloads are not spread over more threads than they can use. An exception thrown by fn
+	 * (on any thread) is rethrown on the calling thread once all ranges have finished.
+	 */
+	void parallelFor(uint32_t count, uint32_t minRange, const std::function<void(uint32_t, uint32_t)>& fn);
+
+private:
+	void workerLoop();
+
+	std::vector<std::thread> workers;
+
+	std::queue<std::function<void()>> tasks;
+	std::mutex tasksMutex;
+	std::condition_variable tasksAvailable;
+	bool stopping = false;
+};
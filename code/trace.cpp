@@ -0,0 +1,139 @@
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+struct TraceEvent {
+	const char* name;
+	uint64_t start;
+	uint64_t duration;
+	uint32_t thread;
+};
+
+struct TraceState {
+	std::atomic<bool> enabled{ false };
+	std::mutex mutex;
+	std::vector<TraceEvent> events;
+	std::string path;
+	bool exitHandlerRegistered = false;
+};
+
+static TraceState& traceState() {
+	static TraceState state;
+	return state;
+}
+
+//small sequential ids instead of the system thread ids, they are easier to read in the viewer
+static uint32_t traceThreadId() {
+	static std::atomic<uint32_t> nextThread{ 1 };
+	thread_local uint32_t thread = nextThread++;
+	return thread;
+}
+
+static bool startFromEnvironment() {
+	//an explicitly started trace takes precedence
+	const char* path = std::getenv("ASTC_TRACE");
+	if (path != nullptr && path[0] != '\0' && !traceState().enabled) {
+		traceStart(path);
+	}
+	return true;
+}
+
+bool traceEnabled() {
+	static bool environmentChecked = startFromEnvironment();
+	(void)environmentChecked;
+	return traceState().enabled.load(std::memory_order_relaxed);
+}
+
+void traceStart(const std::string& path) {
+	TraceState& state = traceState();
+	std::lock_guard<std::mutex> lock(state.mutex);
+
+	state.path = path;
+	state.events.clear();
+	state.events.reserve(1 << 16);
+	state.enabled = true;
+
+	if (!state.exitHandlerRegistered) {
+		std::atexit(traceStop);
+		state.exitHandlerRegistered = true;
+	}
+}
+
+void traceStop() {
+	TraceState& state = traceState();
+	std::lock_guard<std::mutex> lock(state.mutex);
+
+	if (!state.enabled) {
+		return;
+	}
+	state.enabled = false;
+
+	std::ofstream file(state.path, std::ios::out | std::ios::trunc);
+	if (!file) {
+		std::cerr << "Could not write the trace to " << state.path << std::endl;
+		return;
+	}
+
+	//complete events ("X"), timestamps and durations in microseconds
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (size_t i = 0; i < state.events.size(); i++) {
+		const TraceEvent& event = state.events[i];
+		file << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"astc\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+			<< ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+	}
+	file << "\n]}\n";
+
+	std::cout << "Trace with " << state.events.size() << " spans written to " << state.path << std::endl;
+	state.events.clear();
+}
+
+void traceRecord(const char* name, uint64_t startMicroseconds, uint64_t endMicroseconds) {
+	TraceState& state = traceState();
+	uint32_t thread = traceThreadId();
+
+	std::lock_guard<std::mutex> lock(state.mutex);
+	if (state.enabled) {
+		state.events.push_back({ name, startMicroseconds, endMicroseconds - startMicroseconds, thread });
+	}
+}
+
+uint64_t traceNow() {
+	static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+static LogLevel initialLogLevel() {
+	LogLevel level = LogLevel::Info;
+	const char* name = std::getenv("ASTC_LOG_LEVEL");
+	if (name != nullptr && !parseLogLevel(name, level)) {
+		std::cerr << "Unknown ASTC_LOG_LEVEL " << name << ", using info" << std::endl;
+	}
+	return level;
+}
+
+static std::atomic<int>& logLevelState() {
+	static std::atomic<int> level{ static_cast<int>(initialLogLevel()) };
+	return level;
+}
+
+LogLevel logLevel() {
+	return static_cast<LogLevel>(logLevelState().load(std::memory_order_relaxed));
+}
+
+void setLogLevel(LogLevel level) {
+	logLevelState() = static_cast<int>(level);
+}
+
+bool parseLogLevel(const std::string& name, LogLevel& level) {
+	if (name == "error") level = LogLevel::Error;
+	else if (name == "warning") level = LogLevel::Warning;
+	else if (name == "info") level = LogLevel::Info;
+	else if (name == "debug") level = LogLevel::Debug;
+	else return false;
+	return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+/*
+ * Host side tracing and logging of the encoder.
+ *
+ * Spans are recorded in memory while tracing is on and written as a Chrome trace (JSON, opens in
+ * chrome://tracing and Perfetto) when it is stopped or the process exits. Tracing is started with ASTC_TRACE=<file>
+ * or traceStart. Recording a span costs a single flag check while tracing is off.
+ *
+ * Messages of the encode loop go through ASTC_LOG with a level, ASTC_LOG_LEVEL=error|warning|info|debug (info by
+ * default) selects what is printed.
+ */
+
+//exported from a shared astcgpu, the tool records spans and messages of its own (same rules as ASTCGPU_API)
+#if defined(_WIN32) && defined(ASTCGPU_SHARED)
+#if defined(ASTCGPU_BUILD)
+#define TRACE_API __declspec(dllexport)
+#else
+#define TRACE_API __declspec(dllimport)
+#endif
+#elif defined(ASTCGPU_SHARED)
+#define TRACE_API __attribute__((visibility("default")))
+#else
+#define TRACE_API
+#endif
+
+TRACE_API bool traceEnabled();
+
+//starts recording spans, they are written to the file by traceStop (or at exit)
+TRACE_API void traceStart(const std::string& path);
+
+//writes the recorded spans and stops recording
+TRACE_API void traceStop();
+
+TRACE_API void traceRecord(const char* name, uint64_t startMicroseconds, uint64_t endMicroseconds);
+
+TRACE_API uint64_t traceNow();
+
+/**
+ * @brief Span from its construction to the end of its scope, name has to be a string literal.
+ */
+class TraceSpan {
+public:
+	explicit TraceSpan(const char* name) : name(traceEnabled() ? name : nullptr), start(this->name ? traceNow() : 0) {}
+
+	~TraceSpan() {
+		if (name) {
+			traceRecord(name, start, traceNow());
+		}
+	}
+
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+	const char* name;
+	uint64_t start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+enum class LogLevel {
+	Error,
+	Warning,
+	Info,
+	Debug,
+};
+
+TRACE_API LogLevel logLevel();
+
+TRACE_API void setLogLevel(LogLevel level);
+
+//false for unknown names
+TRACE_API bool parseLogLevel(const std::string& name, LogLevel& level);
+
+inline bool logEnabled(LogLevel level) {
+	return level <= logLevel();
+}
+
+//message is only formatted when the level is enabled
+#define ASTC_LOG(level, message) \
+	do { if (logEnabled(level)) { std::cout << message << std::endl; } } while (0)
@@ -12,6 +12,9 @@
 #include <tuple>
 #include <fstream>
 
+#include "webgpu_utils.h"
+#include "trace.h"
+
 wgpu::Adapter requestAdapterSync(wgpu::Instance instance, wgpu::RequestAdapterOptions const* options) {
 
 	struct UserData {
@@ -26,7 +29,7 @@ wgpu::Adapter requestAdapterSync(wgpu::Instance instance, wgpu::RequestAdapterOp
 			userData.adapter = wgpu::Adapter::Acquire(receivedAdapter);
 		}
 		else {
-			std::cout << "Could not get WebGPU adapter: " << message << std::endl;
+			ASTC_LOG(LogLevel::Error, "Could not get WebGPU adapter: " << message);
 		}
 		userData.requestEnded = true;
 		};
@@ -62,7 +65,7 @@ void requestAdapterAsync(
 			(*cb)(wgpu::Adapter::Acquire(receivedAdapter));
 		}
 		else {
-			std::cout << "Could not get WebGPU adapter: " << message << std::endl;
+			ASTC_LOG(LogLevel::Error, "Could not get WebGPU adapter: " << message);
 			// On failure, call the callback with a null adapter.
 			(*cb)(nullptr);
 		}
@@ -99,7 +102,7 @@ WGPUAdapter requestAdapterSync(WGPUInstance instance, WGPURequestAdapterOptions
 			userData.adapter = adapter;
 		}
 		else {
-			std::cout << "Could not get WebGPU adapter: " << message << std::endl;
+			ASTC_LOG(LogLevel::Error, "Could not get WebGPU adapter: " << message);
 		}
 		userData.requestEnded = true;
 		};
@@ -139,7 +142,7 @@ wgpu::Device requestDeviceSync(wgpu::Adapter adapter, wgpu::DeviceDescriptor con
 			userData.device = wgpu::Device::Acquire(receivedDevice);
 		}
 		else {
-			std::cout << "Could not get WebGPU device: " << message << std::endl;
+			ASTC_LOG(LogLevel::Error, "Could not get WebGPU device: " << message);
 		}
 		userData.requestEnded = true;
 		};
@@ -173,7 +176,7 @@ void requestDeviceAsync(
 			(*cb)(wgpu::Device::Acquire(receivedDevice));
 		}
 		else {
-			std::cout << "Could not get WebGPU device: " << message << std::endl;
+			ASTC_LOG(LogLevel::Error, "Could not get WebGPU device: " << message);
 			// On failure, call the callback with a null device.
 			(*cb)(nullptr);
 		}
@@ -186,6 +189,26 @@ void requestDeviceAsync(
 	adapter.RequestDevice(descriptor, onDeviceReady, userdata);
 }
 
+wgpu::RequiredLimits getRequiredLimits(wgpu::Adapter adapter) {
+
+	wgpu::SupportedLimits supportedLimits = {};
+	adapter.GetLimits(&supportedLimits);
+
+	// The batch size is derived from these
+	wgpu::RequiredLimits requiredLimits = {};
+	requiredLimits.limits.maxStorageBufferBindingSize = supportedLimits.limits.maxStorageBufferBindingSize;
+	requiredLimits.limits.maxBufferSize = supportedLimits.limits.maxBufferSize;
+	requiredLimits.limits.maxComputeWorkgroupsPerDimension = supportedLimits.limits.maxComputeWorkgroupsPerDimension;
+
+	// The later encoding passes bind more storage buffers than the default limit allows
+	requiredLimits.limits.maxStorageBuffersPerShaderStage = supportedLimits.limits.maxStorageBuffersPerShaderStage;
+
+	ASTC_LOG(LogLevel::Debug, "Max storage buffer binding size: " << supportedLimits.limits.maxStorageBufferBindingSize);
+	ASTC_LOG(LogLevel::Debug, "Max buffer size: " << supportedLimits.limits.maxBufferSize);
+
+	return requiredLimits;
+}
+
 /*
 WGPUDevice requestDeviceSync(WGPUAdapter adapter, WGPUDeviceDescriptor const* descriptor) {
 	struct UserData {
@@ -200,7 +223,7 @@ WGPUDevice requestDeviceSync(WGPUAdapter adapter, WGPUDeviceDescriptor const* de
 			userData.device = device;
 		}
 		else {
-			std::cout << "Could not get WebGPU device: " << message << std::endl;
+			ASTC_LOG(LogLevel::Error, "Could not get WebGPU device: " << message);
 		}
 		userData.requestEnded = true;
 		};
@@ -228,7 +251,7 @@ WGPUDevice requestDeviceSync(WGPUAdapter adapter, WGPUDeviceDescriptor const* de
 std::string LoadWGSL(const std::string& path) {
 	std::ifstream file(path);
 	if (!file.is_open()) {
-		std::cerr << "!!! ERROR: Failed to open shader file at path: " << path << std::endl;
+		ASTC_LOG(LogLevel::Error, "!!! ERROR: Failed to open shader file at path: " << path);
 		return nullptr;
 	}
 	return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
@@ -279,7 +302,7 @@ wgpu::ShaderModule prepareShaderModule(
 	const char* label
 ) {
 	if (!shaderData || shaderDataLen == 0) {
-		std::cerr << "Embedded shader source is empty for " << label << ". Cannot create module." << std::endl;
+		ASTC_LOG(LogLevel::Error, "Embedded shader source is empty for " << label << ". Cannot create module.");
 		return nullptr;
 	}
 
@@ -296,4 +319,32 @@ wgpu::ShaderModule prepareShaderModule(
 
 	return device.CreateShaderModule(&shaderDesc);
 }
-#endif
\ No newline at end of file
+#endif
+void mapBufferAsync(wgpu::Buffer buffer, wgpu::MapMode mode, uint64_t size, BufferMapState* state) {
+	state->done = false;
+
+	auto onMapComplete = [](WGPUBufferMapAsyncStatus status, void* userdata) {
+		BufferMapState* mapState = reinterpret_cast<BufferMapState*>(userdata);
+		mapState->status = status;
+		mapState->done = true;
+		};
+
+	buffer.MapAsync(mode, 0, size, onMapComplete, state);
+}
+
+bool waitForBufferMap(wgpu::Device device, BufferMapState& state) {
+	while (!state.done) {
+#if defined(__EMSCRIPTEN__)
+		emscripten_sleep(1);
+#else
+		device.Tick();
+#endif
+	}
+
+	if (state.status != WGPUBufferMapAsyncStatus_Success) {
+		ASTC_LOG(LogLevel::Error, "Buffer mapping failed! Status: " << state.status);
+		return false;
+	}
+
+	return true;
+}
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <iostream>
 
 #include <webgpu/webgpu.h>
@@ -7,6 +9,8 @@
 #include <emscripten.h>
 #endif
 
+#include "trace.h"
+
 wgpu::Adapter requestAdapterSync(wgpu::Instance instance, wgpu::RequestAdapterOptions const* options);
 
 void requestAdapterAsync(
@@ -23,6 +27,9 @@ void requestDeviceAsync(
     std::function<void(wgpu::Device)> callback
 );
 
+//limits to request for the encoder device: the largest buffers and dispatches the adapter supports, defaults for the rest
+wgpu::RequiredLimits getRequiredLimits(wgpu::Adapter adapter);
+
 //WGPUAdapter requestAdapterSync(WGPUInstance instance, WGPURequestAdapterOptions const* options);
 
 //WGPUDevice requestDeviceSync(WGPUAdapter adapter, WGPUDeviceDescriptor const* descriptor);
@@ -40,49 +47,14 @@ wgpu::ShaderModule prepareShaderModule(
 );
 #endif
 
-template <typename T>
-void mapOutputBufferSync(wgpu::Device device, wgpu::Buffer buffer, uint64_t blockCount, std::vector<T>& output) {
-
-    uint64_t outputSize = sizeof(T) * blockCount;
-
-    struct BufferMapContext {
-        bool done;
-        wgpu::Buffer buffer;
-        uint64_t bufferSize;
-        std::vector<T>& output;
-    };
-
-    BufferMapContext context = { false, buffer, outputSize, output };
-
-    auto onMapComplete = [](WGPUBufferMapAsyncStatus status, void* userdata) {
-        BufferMapContext* ctx = reinterpret_cast<BufferMapContext*>(userdata);
-
-        if (status == WGPUBufferMapAsyncStatus_Success) {
-            std::cout << "Buffer mapped successfully!" << std::endl;
-
-            const void* mappedData = ctx->buffer.GetConstMappedRange(0, ctx->bufferSize);
-            if (mappedData) {
-                std::memcpy(ctx->output.data(), mappedData, ctx->bufferSize);
-            }
-            else {
-                std::cout << "Output buffer could not be mapped (mappedData is null)!" << std::endl;
-            }
-            ctx->buffer.Unmap();
-        }
-        else {
-            std::cout << "Output buffer mapping failed! Status: " << status << std::endl;
-
-        }
-        ctx->done = true;
-        };
-
-    buffer.MapAsync(wgpu::MapMode::Read, 0, outputSize, onMapComplete, &context);
-
-    while (!context.done) {
-#if defined(__EMSCRIPTEN__)
-        emscripten_sleep(10);
-#else
-        device.Tick();
-#endif
-    }
-}
\ No newline at end of file
+//state of a MapAsync request issued with mapBufferAsync
+struct BufferMapState {
+    bool done = true;
+    WGPUBufferMapAsyncStatus status = WGPUBufferMapAsyncStatus_Success;
+};
+
+//starts mapping the buffer without blocking, the state is updated once the GPU is done with the buffer
+void mapBufferAsync(wgpu::Buffer buffer, wgpu::MapMode mode, uint64_t size, BufferMapState* state);
+
+//blocks until the mapping started with mapBufferAsync has completed, returns true on success
+bool waitForBufferMap(wgpu::Device device, BufferMapState& state);
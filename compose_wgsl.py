@@ -0,0 +1,173 @@
+import sys
+import os
+import re
+
+# Composes the WGSL shaders from their sources in /shaders. WGSL has no preprocessor, so the sources
+# use a few line directives of their own:
+#
+#   #include "common/uniforms.wgsl"     inserts a shared module (relative to the including file, once per shader)
+#   #partition_variants 1 2 3 4          emits one shader per partition count, named <source>_<N>part.wgsl, each
+#                                        with "const PARTITION_COUNT: u32 = N;" in front
+#   #if / #elif / #else / #endif         keeps lines depending on PARTITION_COUNT (e.g. "#if PARTITION_COUNT == 1")
+
+DIRECTIVE = re.compile(r'^\s*#(\w+)\s*(.*?)\s*$')
+DECLARATION = re.compile(r'^(?:@[^\n]*?\s)?(?:struct|fn|const|override|alias|var(?:<[^>]*>)?)\s+(\w+)')
+
+
+class ComposeError(Exception):
+    pass
+
+
+def read_lines(path):
+    try:
+        with open(path, 'r') as f:
+            return f.read().splitlines()
+    except IOError as e:
+        raise ComposeError(f"Error reading {path}: {e}")
+
+
+def partition_variants(source_path):
+    """Partition counts of the variants of a source, None if it is a single shader."""
+    for line in read_lines(source_path):
+        match = DIRECTIVE.match(line)
+        if match and match.group(1) == "partition_variants":
+            counts = [int(value) for value in match.group(2).split()]
+            if not counts:
+                raise ComposeError(f"{source_path}: #partition_variants without partition counts")
+            return counts
+    return None
+
+
+def output_names(source_path):
+    stem = os.path.splitext(os.path.basename(source_path))[0]
+    counts = partition_variants(source_path)
+    if counts is None:
+        return [f"{stem}.wgsl"]
+    return [f"{stem}_{count}part.wgsl" for count in counts]
+
+
+def evaluate(expression, defines, location):
+    # C style operators, evaluated as a python expression over the defines only
+    expression = expression.replace("&&", " and ").replace("||", " or ")
+    expression = re.sub(r'!(?!=)', ' not ', expression)
+    try:
+        return bool(eval(expression, {"__builtins__": {}}, dict(defines)))
+    except Exception as e:
+        raise ComposeError(f"{location}: invalid condition '{expression.strip()}': {e}")
+
+
+def compose(path, defines, included, output):
+    """Append the lines of a source and its includes to output."""
+    path = os.path.normpath(path)
+    if path in included:
+        return
+    included.add(path)
+
+    # every entry is (keeping lines, a branch was taken, the enclosing block is kept)
+    conditions = []
+
+    for number, line in enumerate(read_lines(path), 1):
+        location = f"{path}:{number}"
+        keeping = all(condition[0] for condition in conditions)
+
+        match = DIRECTIVE.match(line)
+        if not match:
+            if keeping:
+                output.append(line)
+            continue
+
+        directive, argument = match.group(1), match.group(2)
+
+        if directive == "if":
+            result = keeping and evaluate(argument, defines, location)
+            conditions.append([result, result, keeping])
+        elif directive == "elif":
+            if not conditions:
+                raise ComposeError(f"{location}: #elif without #if")
+            condition = conditions[-1]
+            result = condition[2] and not condition[1] and evaluate(argument, defines, location)
+            condition[0] = result
+            condition[1] = condition[1] or result
+        elif directive == "else":
+            if not conditions:
+                raise ComposeError(f"{location}: #else without #if")
+            condition = conditions[-1]
+            condition[0] = condition[2] and not condition[1]
+            condition[1] = True
+        elif directive == "endif":
+            if not conditions:
+                raise ComposeError(f"{location}: #endif without #if")
+            conditions.pop()
+        elif directive == "include":
+            if keeping:
+                include = argument.strip('"')
+                output.append(f"//---- {include}")
+                compose(os.path.join(os.path.dirname(path), include), defines, included, output)
+                output.append(f"//---- end of {include}")
+        elif directive == "partition_variants":
+            pass
+        else:
+            raise ComposeError(f"{location}: unknown directive #{directive}")
+
+    if conditions:
+        raise ComposeError(f"{path}: #if without #endif")
+
+
+def check_declarations(lines, name):
+    """Module scope names have to be unique, a shared module must not be declared again by a shader."""
+    declared = {}
+    for number, line in enumerate(lines, 1):
+        match = DECLARATION.match(line)
+        if not match:
+            continue
+        identifier = match.group(1)
+        if identifier in declared:
+            raise ComposeError(f"{name}: '{identifier}' is declared twice (lines {declared[identifier]} and {number} of the composed shader)")
+        declared[identifier] = number
+
+
+def compose_source(source_path, output_dir):
+    counts = partition_variants(source_path)
+    names = output_names(source_path)
+
+    for index, name in enumerate(names):
+        defines = {}
+        lines = [f"//composed from {os.path.basename(source_path)} by compose_wgsl.py"]
+
+        if counts is not None:
+            defines["PARTITION_COUNT"] = counts[index]
+            lines.append(f"const PARTITION_COUNT: u32 = {counts[index]}u;")
+
+        compose(source_path, defines, set(), lines)
+        check_declarations(lines, name)
+
+        try:
+            os.makedirs(output_dir, exist_ok=True)
+            with open(os.path.join(output_dir, name), 'w') as f:
+                f.write("\n".join(lines) + "\n")
+        except IOError as e:
+            raise ComposeError(f"Error writing {name}: {e}")
+
+
+def main():
+    if len(sys.argv) == 3 and sys.argv[1] == "--list":
+        mode = "list"
+    elif len(sys.argv) == 3:
+        mode = "compose"
+    else:
+        print("Usage: python compose_wgsl.py <input_file> <output_directory>")
+        print("       python compose_wgsl.py --list <input_file>")
+        sys.exit(1)
+
+    try:
+        if mode == "list":
+            # names of the composed shaders, used by CMake to declare the outputs
+            print(";".join(output_names(sys.argv[2])))
+        else:
+            compose_source(sys.argv[1], sys.argv[2])
+    except ComposeError as e:
+        print(e)
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <webgpu/webgpu.h>
+
+/*
+ * C API of the ASTC encoder.
+ *
+ * A context owns one encoder and the compute pipelines it compiled, so it should be created once and reused for
+ * all images. Images are RGBA8 with the rows a caller defined stride apart, the output is the array of 16 byte
+ * ASTC blocks in row major order (without the .astc file header). A context must not be used by several threads
+ * at the same time.
+ */
+
+#if defined(_WIN32) && defined(ASTCGPU_SHARED)
+#if defined(ASTCGPU_BUILD)
+#define ASTCGPU_API __declspec(dllexport)
+#else
+#define ASTCGPU_API __declspec(dllimport)
+#endif
+#elif defined(ASTCGPU_SHARED)
+#define ASTCGPU_API __attribute__((visibility("default")))
+#else
+#define ASTCGPU_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct astcgpu_context astcgpu_context;
+
+typedef enum astcgpu_status {
+	ASTCGPU_SUCCESS = 0,
+	ASTCGPU_ERROR_INVALID_ARGUMENT = 1,
+	ASTCGPU_ERROR_UNSUPPORTED_BLOCK_SIZE = 2,
+	ASTCGPU_ERROR_OUTPUT_TOO_SMALL = 3,
+	ASTCGPU_ERROR_DEVICE = 4,   /* no device, or the pipelines could not be created */
+	ASTCGPU_ERROR_ENCODE = 5,
+	ASTCGPU_ERROR_NO_ADAPTER = 6, /* an auto created device found no WebGPU instance or adapter (of the requested kind) */
+} astcgpu_status;
+
+typedef struct astcgpu_statistics {
+	uint64_t images_encoded;
+	uint64_t blocks_encoded;
+	uint64_t batches_submitted;
+	double encode_seconds;      /* wall time of all encode calls, including the wait for the GPU */
+	double last_encode_seconds;
+	uint32_t batch_size;        /* blocks per batch of the last image */
+	double setup_seconds;       /* preparing the encoder for the image size and block size, not part of encode_seconds */
+	double read_rows_seconds;   /* parts of encode_seconds: staging the image rows, */
+	double submit_seconds;      /* recording and submitting the GPU work, */
+	double wait_seconds;        /* waiting for the GPU results */
+	double write_seconds;       /* and handing the blocks to the output */
+} astcgpu_statistics;
+
+/*
+ * Create a context on an existing device, or on a device of the high performance adapter when device is NULL.
+ * The context keeps its own reference to the device. Auto created devices use the pipeline cache in
+ * ASTC_PIPELINE_CACHE_DIR when it is set, and the fallback (software) adapter with ASTC_FALLBACK_ADAPTER=1.
+ *
+ * An existing device has to be created with the limits of astcgpu_get_required_limits. The later passes bind 9
+ * storage buffers (maxStorageBuffersPerShaderStage), one more than the WebGPU default of 8, and the batch size
+ * follows maxStorageBufferBindingSize and maxBufferSize, so a device with the default limits fails with
+ * ASTCGPU_ERROR_DEVICE. An auto created device returns ASTCGPU_ERROR_NO_ADAPTER when the machine has no adapter to
+ * create it on. The message of a failed create is returned by astcgpu_get_last_error(NULL).
+ */
+ASTCGPU_API astcgpu_status astcgpu_context_create(WGPUDevice device, astcgpu_context** context);
+
+/*
+ * Fill the limits to request for a device of the adapter (nextInChain is set to NULL). Returns ASTCGPU_ERROR_DEVICE
+ * when the adapter supports fewer than 9 storage buffers per shader stage.
+ */
+ASTCGPU_API astcgpu_status astcgpu_get_required_limits(WGPUAdapter adapter, WGPURequiredLimits* limits);
+
+ASTCGPU_API void astcgpu_context_destroy(astcgpu_context* context);
+
+/* Size of the compressed blocks of an image in bytes. */
+ASTCGPU_API uint64_t astcgpu_compressed_size(uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y);
+
+/* Non zero if the block size is one of the 2D ASTC block sizes. */
+ASTCGPU_API int astcgpu_is_valid_block_size(uint32_t block_x, uint32_t block_y);
+
+/*
+ * Encode an RGBA8 image. row_stride is the distance between the rows in bytes (0 for width * 4), output_size has
+ * to be at least astcgpu_compressed_size.
+ */
+ASTCGPU_API astcgpu_status astcgpu_encode(
+	astcgpu_context* context,
+	const uint8_t* pixels,
+	uint32_t width,
+	uint32_t height,
+	size_t row_stride,
+	uint32_t block_x,
+	uint32_t block_y,
+	uint8_t* output,
+	size_t output_size
+);
+
+/* Fills row_count tightly packed RGBA8 rows, starting at first_row, into rows. Returns 0 on success. */
+typedef int (*astcgpu_read_rows_fn)(void* userdata, uint32_t first_row, uint32_t row_count, uint8_t* rows);
+
+/* Receives block_count finished 16 byte blocks, first_block is the row major index of the first one. Returns 0 on success. */
+typedef int (*astcgpu_write_blocks_fn)(void* userdata, uint64_t first_block, uint32_t block_count, const uint8_t* blocks);
+
+/*
+ * Encode an RGBA8 image in memory and hand the blocks to write_blocks batch by batch (in block order), e.g. straight
+ * into an output file. A callback returning non zero aborts the encode.
+ */
+ASTCGPU_API astcgpu_status astcgpu_encode_to_callback(
+	astcgpu_context* context,
+	const uint8_t* pixels,
+	uint32_t width,
+	uint32_t height,
+	size_t row_stride,
+	uint32_t block_x,
+	uint32_t block_y,
+	astcgpu_write_blocks_fn write_blocks,
+	void* userdata
+);
+
+/*
+ * Encode an image that is never held in memory as a whole. Rows are read batch by batch in image order (rows
+ * shared by two batches are read twice), the blocks are written in block order as soon as their batch is finished.
+ * Host memory stays bounded by the batch size. A callback returning non zero aborts the encode.
+ */
+ASTCGPU_API astcgpu_status astcgpu_encode_streaming(
+	astcgpu_context* context,
+	uint32_t width,
+	uint32_t height,
+	uint32_t block_x,
+	uint32_t block_y,
+	astcgpu_read_rows_fn read_rows,
+	astcgpu_write_blocks_fn write_blocks,
+	void* userdata
+);
+
+ASTCGPU_API astcgpu_status astcgpu_get_statistics(const astcgpu_context* context, astcgpu_statistics* statistics);
+
+/* Also resets the GPU profile. */
+ASTCGPU_API void astcgpu_reset_statistics(astcgpu_context* context);
+
+/*
+ * Print the GPU time of every compute pass and partition count since the last reset. Profiling is enabled with
+ * ASTC_GPU_PROFILE=1 and needs the timestamp query feature (requested automatically for devices created by the
+ * context), otherwise nothing is printed.
+ */
+ASTCGPU_API void astcgpu_print_gpu_profile(const astcgpu_context* context);
+
+/*
+ * Message of the last failed call on the context, empty if there was none. With a NULL context, the message of the
+ * last failed astcgpu_context_create of the calling thread.
+ */
+ASTCGPU_API const char* astcgpu_get_last_error(const astcgpu_context* context);
+
+ASTCGPU_API const char* astcgpu_status_string(astcgpu_status status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+#include "limits.wgsl"
+
+//input blocks and their partitionings
+
+struct InputBlock {
+    pixels: array<u32, BLOCK_MAX_TEXELS>, //RGBA8 texels
+    partition_pixel_counts: array<u32, 4>,
+
+    partitioning_idx: u32,
+    grayscale: u32,
+    constant_alpha: u32,
+    padding: u32,
+};
+
+struct PartitonInfo {
+    partition_count: u32,
+    partition_index: u32,
+    _padding1: u32,
+    _padding2: u32,
+
+    partition_texel_count: array<u32, BLOCK_MAX_PARTITIONS>,
+    partition_of_texel: array<u32, BLOCK_MAX_TEXELS>,
+};
+
+//input block partitioned with one of the partitionings (written by pass007)
+struct PartitionedBlock {
+    source_block: u32, //index of the input block in the batch
+    partition_table_idx: u32, //index into the partition info table
+};
+
+const ONE_PARTITION_TABLE_IDX: u32 = 3u * 1024u; //the 1 partition table entry follows the 2, 3 and 4 partition tables
+
+//8 bit unorm channel -> encoder channel range (0 to 65536)
+const UNORM8_TO_CHANNEL: f32 = 65536.0 / 255.0;
+
+fn decode_texel(texel: u32) -> vec4<f32> {
+    return vec4<f32>(f32(texel & 0xFFu), f32((texel >> 8u) & 0xFFu), f32((texel >> 16u) & 0xFFu), f32(texel >> 24u)) * UNORM8_TO_CHANNEL;
+}
@@ -0,0 +1,45 @@
+#include "limits.wgsl"
+#include "endpoints.wgsl"
+
+//final candidates of the refinement passes and the symbolic blocks built from them
+
+struct FinalCandidate {
+    block_mode_index: u32,
+    block_mode_trial_index: u32,
+    total_error: f32,
+    quant_level: u32, // The original quant level
+    quant_level_mod: u32,
+
+    _padding1: u32,
+
+	color_formats_matched: u32,
+    final_quant_mode: u32, // The quant mode after checking the mod version
+
+    formats: vec4<u32>,
+    quantized_weights: array<u32, BLOCK_MAX_WEIGHTS>,
+    candidate_partitions: array<IdealEndpointsAndWeightsPartition, 4>,
+
+	final_formats: vec4<u32>,
+	//8 integers per partition
+    packed_color_values: array<u32, 32>,
+};
+
+struct SymbolicBlock {
+    errorval: f32,
+
+    block_mode_index: u32,
+    partition_count: u32,
+    partition_index: u32,
+
+    partition_formats_matched: u32,
+    quant_mode: u32,
+
+    _padding1: u32,
+    _padding2: u32,
+
+    partition_formats: vec4<u32>,
+
+    packed_color_values: array<u32, 32>, //8 integers per partition
+
+    quantized_weights: array<u32, BLOCK_MAX_WEIGHTS>,
+};
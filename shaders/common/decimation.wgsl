@@ -0,0 +1,57 @@
+#include "limits.wgsl"
+
+//decimation modes and block modes of the block size
+
+struct DecimationInfo {
+    texel_count : u32,
+    weight_count : u32,
+    weight_x : u32,
+    weight_y : u32,
+
+    max_quant_level : u32,
+    max_angular_steps : u32,
+    max_quant_steps: u32,
+    _padding: u32,
+
+    texel_weight_count : array<u32, BLOCK_MAX_TEXELS>,
+    texel_weights_offset : array<u32, BLOCK_MAX_TEXELS>,
+
+    weight_texel_count : array<u32, BLOCK_MAX_WEIGHTS>,
+    weight_texels_offset : array<u32, BLOCK_MAX_WEIGHTS>,
+};
+
+struct TexelToWeightMap {
+	weight_index : u32,
+	contribution : f32,
+
+    _padding1 : u32,
+    _padding2 : u32,
+};
+
+struct WeightToTexelMap {
+    texel_index : u32,
+	contribution : f32,
+
+    _padding1 : u32,
+    _padding2 : u32,
+};
+
+struct BlockMode {
+	mode_index : u32,
+    decimation_mode : u32,
+    quant_mode : u32,
+    weight_bits : u32,
+    is_dual_plane : u32,
+
+    _padding1 : u32,
+    _padding2 : u32,
+    _padding3 : u32,
+};
+
+struct PackedBlockModeLookup {
+    block_mode_index: u32,
+    decimation_mode_lookup_idx: u32, //index of corresponding decimation mode in the valid decimation modes buffer
+
+    _padding1: u32,
+    _padding2: u32,
+};
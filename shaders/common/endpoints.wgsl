@@ -0,0 +1,27 @@
+#include "limits.wgsl"
+
+//ideal endpoints and weights of the partitioned blocks
+
+struct IdealEndpointsAndWeightsPartition {
+    avg: vec4<f32>,
+    dir: vec4<f32>,
+    endpoint0: vec4<f32>,
+    endpoint1: vec4<f32>,
+};
+
+struct IdealEndpointsAndWeights {
+    partitions: array<IdealEndpointsAndWeightsPartition, 4>,
+    weights: array<f32, BLOCK_MAX_TEXELS>,
+
+    weight_error_scale: array<f32, BLOCK_MAX_TEXELS>,
+
+    is_constant_weight_error_scale : u32,
+    min_weight_cuttof : f32,
+    _padding1 : u32,
+    _padding2 : u32,
+};
+
+struct UnpackedEndpoints {
+    endpoint0: array<vec4<i32>, 4>,
+    endpoint1: array<vec4<i32>, 4>,
+}
@@ -0,0 +1,4 @@
+//limits of the ASTC format (BLOCK_MAX_* in astc.h)
+const BLOCK_MAX_TEXELS: u32 = 144u;
+const BLOCK_MAX_WEIGHTS: u32 = 64u;
+const BLOCK_MAX_PARTITIONS: u32 = 4u;
@@ -0,0 +1,12 @@
+#include "blocks.wgsl"
+
+//lookup of the partitioned blocks, reads the partitioned_blocks binding of the including shader
+//(its binding index differs between the passes, so it is not declared here)
+
+//with a single partition the blocks are not partitioned: partitioned block i is input block i with the 1 partition table entry
+fn partitioned_block(block_idx: u32, partition_count: u32) -> PartitionedBlock {
+    if (partition_count == 1u) {
+        return PartitionedBlock(block_idx, ONE_PARTITION_TABLE_IDX);
+    }
+    return partitioned_blocks[block_idx];
+}
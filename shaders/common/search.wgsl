@@ -0,0 +1,66 @@
+#include "limits.wgsl"
+
+//intermediate results of the weight, color format and quantization search
+
+struct HighestAndLowestWeight {
+    lowest_weight : f32,
+    weight_span : i32,
+    error : f32,
+    cut_low_error : f32,
+    cut_high_error : f32,
+
+    _padding1 : u32,
+    _padding2 : u32,
+    _padding3 : u32,
+};
+
+struct FinalValueRange {
+    low : f32,
+    high : f32,
+
+    _padding1 : u32,
+    _padding2 : u32,
+};
+
+struct QuantizationResult {
+    error: f32,
+    bitcount: i32,
+
+    _padding1: u32,
+    _padding2: u32,
+
+    quantized_weights: array<u32, (BLOCK_MAX_WEIGHTS/4)>,
+};
+
+struct EncodingChoiceErrors {
+    rgb_scale_error: f32,
+    rgb_luma_error: f32,
+    luminance_error: f32,
+    alpha_drop_error: f32,
+
+    can_offset_encode: u32,
+    can_blue_contract: u32,
+
+    _padding1: u32,
+    _padding2: u32,
+}
+
+struct CombinedEndpointFormats {
+	error: f32,
+
+    _padding0: u32,
+    _padding1: u32,
+    _padding2: u32,
+
+    formats: vec4<u32>,
+};
+
+struct ColorCombinationResult {
+    total_error: f32,
+    best_quant_level: u32,
+    best_quant_level_mod: u32,
+
+    _padding1: u32,
+
+    best_ep_formats: vec4<u32>,
+};
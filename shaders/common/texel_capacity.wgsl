@@ -0,0 +1,4 @@
+#include "limits.wgsl"
+
+//texel count of the largest block size of the pipeline variant, sizes the workgroup arrays (set by the encoder)
+override TEXEL_CAPACITY: u32 = BLOCK_MAX_TEXELS;
@@ -0,0 +1,31 @@
+//uniform variables of one partition count (uniform_variables in astc.h)
+struct UniformVariables {
+    xdim : u32,
+    ydim : u32,
+
+    texel_count : u32,
+
+    decimation_mode_count : u32,
+    block_mode_count : u32,
+
+    valid_decimation_mode_count: u32,
+	valid_block_mode_count: u32,
+
+    quant_limit : u32,
+    partition_count : u32,
+    tune_candidate_limit : u32,
+
+    tune_partitoning_candidate_limit: u32,
+    requested_partitionings: u32,
+
+    channel_weights : vec4<f32>,
+
+    partitioning_count_selected : vec4<u32>,
+    partitioning_count_all : vec4<u32>,
+
+    tune_error_limit: f32,
+    batch_block_count: u32,
+
+    _padding1: u32,
+    _padding2: u32,
+};
@@ -0,0 +1,85 @@
+#include "common/blocks.wgsl"
+
+const WORKGROUP_SIZE: u32 = 64u;
+
+struct ExtractionVariables {
+    image_width: u32,
+    image_height: u32,
+    blocks_x: u32,
+    first_block: u32, //counted from the start of the first block row of the batch, so it stays small for any image size
+
+    first_row: u32, //first image row stored in image_rows
+    xdim: u32,
+    ydim: u32,
+    block_count: u32,
+};
+
+
+@group(0) @binding(0) var<uniform> uniforms: ExtractionVariables;
+@group(0) @binding(1) var<storage, read> image_rows: array<u32>; //RGBA8 texels of the image rows covered by the batch
+
+@group(0) @binding(2) var<storage, read_write> inputBlocks: array<InputBlock>;
+
+var<workgroup> not_grayscale: atomic<u32>;
+var<workgroup> alpha_min: atomic<u32>;
+var<workgroup> alpha_max: atomic<u32>;
+
+
+//One workgroup per block of the batch: gathers the block texels from the uploaded rows (edge texels are clamped
+//to the image), stores them as RGBA8 and computes the grayscale and constant alpha flags
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn main( @builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_index) local_idx: u32) {
+
+    let block_idx = group_id.x;
+
+    if (local_idx == 0u) {
+        atomicStore(&not_grayscale, 0u);
+        atomicStore(&alpha_min, 255u);
+        atomicStore(&alpha_max, 0u);
+    }
+    workgroupBarrier();
+
+    //block row relative to the first block row of the batch
+    let batch_block = uniforms.first_block + block_idx;
+    let bx = batch_block % uniforms.blocks_x;
+    let by = batch_block / uniforms.blocks_x;
+
+    let texel_count = uniforms.xdim * uniforms.ydim;
+
+    for (var t = local_idx; t < texel_count; t += WORKGROUP_SIZE) {
+        let dx = t % uniforms.xdim;
+        let dy = t / uniforms.xdim;
+
+        let x = min(bx * uniforms.xdim + dx, uniforms.image_width - 1u);
+        let y = min(uniforms.first_row + by * uniforms.ydim + dy, uniforms.image_height - 1u);
+
+        let texel = image_rows[(y - uniforms.first_row) * uniforms.image_width + x];
+
+        let r = texel & 0xFFu;
+        let g = (texel >> 8u) & 0xFFu;
+        let b = (texel >> 16u) & 0xFFu;
+        let a = texel >> 24u;
+
+        inputBlocks[block_idx].pixels[t] = texel;
+
+        if (r != g || r != b) {
+            atomicOr(&not_grayscale, 1u);
+        }
+        atomicMin(&alpha_min, a);
+        atomicMax(&alpha_max, a);
+    }
+
+    //unused texels of smaller block sizes are cleared, like the host side zero initialized blocks
+    for (var t = texel_count + local_idx; t < BLOCK_MAX_TEXELS; t += WORKGROUP_SIZE) {
+        inputBlocks[block_idx].pixels[t] = 0u;
+    }
+    workgroupBarrier();
+
+    if (local_idx == 0u) {
+        inputBlocks[block_idx].partition_pixel_counts = array<u32, 4>(texel_count, 0u, 0u, 0u);
+        inputBlocks[block_idx].partitioning_idx = 0u;
+        inputBlocks[block_idx].grayscale = select(1u, 0u, atomicLoad(&not_grayscale) != 0u);
+        inputBlocks[block_idx].constant_alpha = select(0u, 1u, atomicLoad(&alpha_min) == atomicLoad(&alpha_max));
+        inputBlocks[block_idx].padding = 0u;
+    }
+}
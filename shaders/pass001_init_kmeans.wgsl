@@ -1,50 +1,18 @@
-const BLOCK_MAX_TEXELS : u32 = 144;
-const WORKGROUP_SIZE: u32 = 256u;
+#include "common/uniforms.wgsl"
+#include "common/blocks.wgsl"
+#include "common/texel_capacity.wgsl"
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct InputBlock {
-    pixels: array<vec4<f32>, BLOCK_MAX_TEXELS>,
-    texel_partitions: array<u32, BLOCK_MAX_TEXELS>,
-    partition_pixel_counts: array<u32, 4>,
-
-    partitioning_idx: u32,
-    grayscale: u32,
-    constant_alpha: u32,
-    padding: u32,
-};
+override WORKGROUP_SIZE: u32 = 256u; //one invocation per texel, at least TEXEL_CAPACITY
 
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
 @group(0) @binding(1) var<storage, read> inputBlocks: array<InputBlock>;
 @group(0) @binding(2) var<storage, read_write> cluster_centers: array<vec4<f32>>;
+@group(0) @binding(3) var<storage, read> active_blocks: array<u32>; //compacted list of the blocks still being searched
 
 
-var<workgroup> pixels: array<vec4<f32>, BLOCK_MAX_TEXELS>;
-var<workgroup> distances: array<f32, BLOCK_MAX_TEXELS>;
+var<workgroup> pixels: array<vec4<f32>, TEXEL_CAPACITY>;
+var<workgroup> distances: array<f32, TEXEL_CAPACITY>;
 var<workgroup> centers: array<vec4<f32>, 4>;
 
 var<workgroup> s_reduction_value: atomic<u32>;
@@ -62,9 +30,10 @@ fn dist_sq(c1: vec4<f32>, c2: vec4<f32>) -> f32 {
 fn main( @builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_index) local_idx: u32) {
 
     let block_idx = group_id.x;
+    let source_idx = active_blocks[block_idx];
 
     if (local_idx < uniforms.texel_count) {
-        pixels[local_idx] = inputBlocks[block_idx].pixels[local_idx];
+        pixels[local_idx] = decode_texel(inputBlocks[source_idx].pixels[local_idx]);
     }
     workgroupBarrier();
 
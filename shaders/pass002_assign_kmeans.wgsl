@@ -1,41 +1,7 @@
-const BLOCK_MAX_TEXELS: u32 = 144u;
-const WORKGROUP_SIZE: u32 = 256u;
-
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
+#include "common/uniforms.wgsl"
+#include "common/blocks.wgsl"
 
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct InputBlock {
-    pixels: array<vec4<f32>, BLOCK_MAX_TEXELS>,
-    texel_partitions: array<u32, BLOCK_MAX_TEXELS>,
-    partition_pixel_counts: array<u32, 4>,
-
-    partitioning_idx: u32,
-    grayscale: u32,
-    constant_alpha: u32,
-    padding: u32,
-};
+const WORKGROUP_SIZE: u32 = 256u;
 
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
@@ -43,6 +9,7 @@ struct InputBlock {
 @group(0) @binding(2) var<storage, read> cluster_centers: array<vec4<f32>>;
 
 @group(0) @binding(3) var<storage, read_write> texel_assignments : array<u32>;
+@group(0) @binding(4) var<storage, read> active_blocks: array<u32>; //compacted list of the blocks still being searched
 
 
 fn dist_sq(c1: vec4f, c2: vec4f) -> f32 {
@@ -62,6 +29,7 @@ var<workgroup> is_problematic: atomic<u32>;
 fn main( @builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_index) local_idx: u32) {
 
     let block_idx = group_id.x;
+    let source_idx = active_blocks[block_idx];
 
     //copy cluster centers to local memory
     if(local_idx < uniforms.partition_count) {
@@ -73,7 +41,7 @@ fn main( @builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_i
 
     //find colosest center for every texel
     if(local_idx < uniforms.texel_count) {
-        let pixel = inputBlocks[block_idx].pixels[local_idx];
+        let pixel = decode_texel(inputBlocks[source_idx].pixels[local_idx]);
 
         var best_dist = 1e30; // Initialize with a very large number
         var best_partition_idx = 0u;
@@ -1,42 +1,7 @@
-const BLOCK_MAX_TEXELS: u32 = 144u;
-const WORKGROUP_SIZE: u32 = 256u;
-
-
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
+#include "common/uniforms.wgsl"
+#include "common/blocks.wgsl"
 
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct InputBlock {
-    pixels: array<vec4<f32>, BLOCK_MAX_TEXELS>,
-    texel_partitions: array<u32, BLOCK_MAX_TEXELS>,
-    partition_pixel_counts: array<u32, 4>,
-
-    partitioning_idx: u32,
-    grayscale: u32,
-    constant_alpha: u32,
-    padding: u32,
-};
+const WORKGROUP_SIZE: u32 = 256u;
 
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
@@ -44,6 +9,7 @@ struct InputBlock {
 @group(0) @binding(2) var<storage, read> texel_assignments : array<u32>;
 
 @group(0) @binding(3) var<storage, read_write> cluster_centers: array<vec4<f32>>;
+@group(0) @binding(4) var<storage, read> active_blocks: array<u32>; //compacted list of the blocks still being searched
 
 
 var<workgroup> partition_sums: array<array<atomic<u32>, 4>, 4>;
@@ -54,6 +20,7 @@ var<workgroup> partition_counts: array<atomic<u32>, 4>;
 fn main( @builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_index) local_idx: u32) {
     
     let block_idx = group_id.x;
+    let source_idx = active_blocks[block_idx];
 
     //init atomic variables to zero
     if (local_idx < uniforms.partition_count) {
@@ -69,7 +36,7 @@ fn main( @builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_i
     if (local_idx < uniforms.texel_count) {
         let global_idx = block_idx * BLOCK_MAX_TEXELS + local_idx;
         let p = texel_assignments[global_idx];
-        let pixel = inputBlocks[block_idx].pixels[local_idx];
+        let pixel = decode_texel(inputBlocks[source_idx].pixels[local_idx]);
         
         // Convert f32 color to u32 fixed-point for atomic operations.
         let pixel_u32 = vec4<u32>(pixel);
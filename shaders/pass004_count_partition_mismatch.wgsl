@@ -1,34 +1,11 @@
+#include "common/uniforms.wgsl"
+
 const BLOCK_MAX_TEXELS: u32 = 144u;
 const KMEANS_TEXELS: u32 = 64u;
 const WORKGROUP_SIZE: u32 = 256u;
 const BLOCK_MAX_PARTITIONINGS: u32 = 1024u;
 
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
 
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
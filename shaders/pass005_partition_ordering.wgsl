@@ -1,33 +1,10 @@
+#include "common/uniforms.wgsl"
+
 const BLOCK_MAX_PARTITIONINGS: u32 = 1024u;
 const SORT_ITEM_COUNT: u32 = BLOCK_MAX_PARTITIONINGS;
 const WORKGROUP_SIZE: u32 = 256u;
 const MAX_PARTITIONING_CANDIDATE_LIMIT: u32 = 512u;
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    tune_partitoning_candidate_limit: u32,
-    _padding1: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
 struct sortElement {
 	score : u32,
 	index : u32,
@@ -1,4 +1,6 @@
-const BLOCK_MAX_TEXELS: u32 = 144u;
+#include "common/uniforms.wgsl"
+#include "common/blocks.wgsl"
+
 const MAX_PARTITIONS: u32 = 4u;
 
 const WORKGROUP_SIZE: u32 = 64u;
@@ -7,52 +9,6 @@ const BLOCK_MAX_PARTITIONINGS: u32 = 1024u;
 const MAX_PARTITIONING_CANDIDATE_LIMIT: u32 = 512u;
 const MAX_PARTITIONINGS: u32 = 8u;
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    tune_partitoning_candidate_limit: u32,
-    requested_partitionings: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct InputBlock {
-    pixels: array<vec4<f32>, BLOCK_MAX_TEXELS>,
-    texel_partitions: array<u32, BLOCK_MAX_TEXELS>,
-    partition_pixel_counts: array<u32, 4>,
-
-    partitioning_idx: u32,
-    grayscale: u32,
-    constant_alpha: u32,
-    padding: u32,
-};
-
-struct PartitonInfo {
-    partition_count: u32,
-    partition_index: u32,
-    _padding1: u32,
-    _padding2: u32,
-
-    partition_texel_count: array<u32, MAX_PARTITIONS>,
-    partition_of_texel: array<u32, BLOCK_MAX_TEXELS>,
-};
-
 
 struct BestChoice {
     index: u32,
@@ -61,11 +17,10 @@ struct BestChoice {
 
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
-@group(0) @binding(1) var<storage, read> partitionInfos: array<PartitonInfo>;
-@group(0) @binding(2) var<storage, read> inputBlocks: array<InputBlock>;
 @group(0) @binding(3) var<storage, read> final_partitioning_errors: array<vec2<f32>>;
 
-@group(0) @binding(4) var<storage, read_write> partitionedBlocks: array<InputBlock>;
+@group(0) @binding(4) var<storage, read_write> partitionedBlocks: array<PartitionedBlock>;
+@group(0) @binding(5) var<storage, read> active_blocks: array<u32>; //compacted list of the blocks still being searched
 
 
 @compute @workgroup_size(1)
@@ -149,27 +104,15 @@ fn main(@builtin(global_invocation_id) global_id : vec3<u32>) {
     }
     let num_final = emitted;
 
-    //generate partitoned blocks
-    let original_block = inputBlocks[blockIndex];
+    //generate partitoned blocks (references to the input block and the partition table entry)
+    let source_block = active_blocks[blockIndex];
 
     for(var i = 0u; i < num_final; i += 1u) {
         let part_idx = final_indices[i];
         let table_idx = (uniforms.partition_count - 2) * BLOCK_MAX_PARTITIONINGS + part_idx;
-        let pi = partitionInfos[table_idx];
-
-        var new_block: InputBlock;
-
-        new_block.pixels = original_block.pixels;
-        new_block.grayscale = original_block.grayscale;
-        new_block.constant_alpha = original_block.constant_alpha;
-
-        new_block.partitioning_idx = pi.partition_index;
-        new_block.partition_pixel_counts = pi.partition_texel_count;
-        new_block.texel_partitions = pi.partition_of_texel;
 
         let out_idx = blockIndex * uniforms.requested_partitionings + i;
-        partitionedBlocks[out_idx] = new_block;
-
+        partitionedBlocks[out_idx] = PartitionedBlock(source_block, table_idx);
     }
 
 }
\ No newline at end of file
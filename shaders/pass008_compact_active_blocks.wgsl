@@ -0,0 +1,62 @@
+#include "common/uniforms.wgsl"
+#include "common/candidates.wgsl"
+
+
+const WORKGROUP_SIZE: u32 = 64u;
+
+
+@group(0) @binding(0) var<uniform> uniforms: UniformVariables;
+@group(0) @binding(1) var<storage, read> best_symbolic_blocks: array<SymbolicBlock>;
+
+@group(0) @binding(2) var<storage, read_write> active_blocks: array<u32>;
+
+//Indirect dispatch arguments (x, y, z) of the current partition count:
+//[0] blocks (passes 001-007, 18), [1] partitioned blocks (passes 1, 8-10, 12),
+//[2] decimation mode trials (passes 2-5), [3] block mode trials (passes 6, 7, 11), [4] candidates (passes 13-17)
+@group(0) @binding(3) var<storage, read_write> indirect_args: array<u32>;
+
+var<workgroup> active_count: atomic<u32>;
+
+fn write_args(slot: u32, x: u32, y: u32) {
+    indirect_args[slot * 3u + 0u] = x;
+    indirect_args[slot * 3u + 1u] = y;
+    indirect_args[slot * 3u + 2u] = 1u;
+}
+
+//Single workgroup: collects the blocks of the batch that still need to be searched with the current partition count.
+//With 1 partition every block is active and the list is the identity, later partition counts only keep the
+//blocks whose best encoding so far is not under the error limit.
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn main(@builtin(local_invocation_index) local_idx: u32) {
+
+    if (local_idx == 0u) {
+        atomicStore(&active_count, 0u);
+    }
+    workgroupBarrier();
+
+    for (var i = local_idx; i < uniforms.batch_block_count; i += WORKGROUP_SIZE) {
+        if (uniforms.partition_count == 1u) {
+            active_blocks[i] = i;
+        }
+        else if (best_symbolic_blocks[i].errorval >= uniforms.tune_error_limit) {
+            let slot = atomicAdd(&active_count, 1u);
+            active_blocks[slot] = i;
+        }
+    }
+    workgroupBarrier();
+
+    if (local_idx == 0u) {
+        var count = atomicLoad(&active_count);
+        if (uniforms.partition_count == 1u) {
+            count = uniforms.batch_block_count;
+        }
+
+        let partitioned_count = count * uniforms.requested_partitionings;
+
+        write_args(0u, count, 1u);
+        write_args(1u, partitioned_count, 1u);
+        write_args(2u, partitioned_count, uniforms.valid_decimation_mode_count);
+        write_args(3u, partitioned_count, uniforms.valid_block_mode_count);
+        write_args(4u, partitioned_count, uniforms.tune_candidate_limit);
+    }
+}
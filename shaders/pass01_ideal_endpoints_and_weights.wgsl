@@ -1,69 +1,21 @@
-const BLOCK_MAX_TEXELS : u32 = 144;
-
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct InputBlock {
-    pixels: array<vec4<f32>, BLOCK_MAX_TEXELS>,
-    texel_partitions: array<u32, BLOCK_MAX_TEXELS>,
-    partition_pixel_counts: array<u32, 4>,
-
-    partitioning_idx: u32,
-    grayscale: u32,
-    constant_alpha: u32,
-    padding: u32,
-};
-
-struct IdealEndpointsAndWeightsPartition {
-    avg: vec4<f32>,
-    dir: vec4<f32>,
-    endpoint0: vec4<f32>,
-    endpoint1: vec4<f32>,
-};
-
-struct IdealEndpointsAndWeights {
-    partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-    weights: array<f32, BLOCK_MAX_TEXELS>,
-
-    weight_error_scale: array<f32, BLOCK_MAX_TEXELS>,
-
-    is_constant_weight_error_scale : u32,
-    min_weight_cuttof : f32,
-    _padding1 : u32,
-    _padding2 : u32,
-};
+#partition_variants 1 2 3 4
+#include "common/uniforms.wgsl"
+#include "common/partitioned_blocks.wgsl"
+#include "common/endpoints.wgsl"
 
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
 @group(0) @binding(1) var<storage, read> inputBlocks: array<InputBlock>;
 @group(0) @binding(2) var<storage, read_write> outputBlocks: array<IdealEndpointsAndWeights>;
+@group(0) @binding(3) var<storage, read> partitioned_blocks: array<PartitionedBlock>;
+@group(0) @binding(4) var<storage, read> partitionInfos: array<PartitonInfo>;
+
 
 @compute @workgroup_size(1)
 fn main(@builtin(global_invocation_id) global_id : vec3<u32>) {
     let blockIndex = global_id.x;
-    let inputBlock = inputBlocks[blockIndex];
+    let partitioned = partitioned_block(blockIndex, PARTITION_COUNT);
+    let inputBlock = inputBlocks[partitioned.source_block];
 
     let texelCount = uniforms.texel_count;
 
@@ -75,21 +27,21 @@ fn main(@builtin(global_invocation_id) global_id : vec3<u32>) {
     //compute per partition averages
     var sum: array<vec4<f32>, 4>;
     var count: array<f32, 4>;
-    for (var i = 0u; i < 4u; i = i + 1u) {
+    for (var i = 0u; i < PARTITION_COUNT; i = i + 1u) {
         sum[i] = vec4<f32>(0.0);
         count[i] = 0.0;
     }
 
     for (var i = 0u; i < texelCount; i = i + 1u) {
-        let p = inputBlock.texel_partitions[i];
-        if (p < 4u) {
-            sum[p] += inputBlock.pixels[i];
+        let p = partitionInfos[partitioned.partition_table_idx].partition_of_texel[i];
+        if (p < PARTITION_COUNT) {
+            sum[p] += decode_texel(inputBlock.pixels[i]);
             count[p] += 1.0;
         }
     }
 
     var avg: array<vec4<f32>, 4>;
-    for (var p = 0u; p < 4u; p = p + 1u) {
+    for (var p = 0u; p < PARTITION_COUNT; p = p + 1u) {
         avg[p] = select(vec4<f32>(0.0), sum[p] / count[p], count[p] > 0.0);
 
         //store avg
@@ -103,22 +55,22 @@ fn main(@builtin(global_invocation_id) global_id : vec3<u32>) {
     var minProj: array<f32, 4>;
     var maxProj: array<f32, 4>;
 
-    for (var p = 0u; p < 4u; p = p + 1u) {
+    for (var p = 0u; p < PARTITION_COUNT; p = p + 1u) {
         direction[p] = vec4<f32>(0.0);
         minProj[p] = 1e10;
         maxProj[p] = -1e10;
     }
 
     for (var i = 0u; i < texelCount; i = i + 1u) {
-        let p = inputBlock.texel_partitions[i];
-        if (p < 4u) {
-            let diff = inputBlock.pixels[i] - avg[p];
+        let p = partitionInfos[partitioned.partition_table_idx].partition_of_texel[i];
+        if (p < PARTITION_COUNT) {
+            let diff = decode_texel(inputBlock.pixels[i]) - avg[p];
             let pd = max(diff, vec4<f32>(0.0));
             direction[p] += pd * pd;
         }
     }
 
-    for (var p = 0u; p < 4u; p = p + 1u) {
+    for (var p = 0u; p < PARTITION_COUNT; p = p + 1u) {
         direction[p] = normalize(direction[p]);
 
         //store dir
@@ -128,9 +80,9 @@ fn main(@builtin(global_invocation_id) global_id : vec3<u32>) {
 
     //find ideal endpoints
     for (var i = 0u; i < texelCount; i = i + 1u) {
-        let p = inputBlock.texel_partitions[i];
-        if (p < 4u) {
-            let proj = dot(inputBlock.pixels[i] - avg[p], direction[p]);
+        let p = partitionInfos[partitioned.partition_table_idx].partition_of_texel[i];
+        if (p < PARTITION_COUNT) {
+            let proj = dot(decode_texel(inputBlock.pixels[i]) - avg[p], direction[p]);
             minProj[p] = min(minProj[p], proj);
             maxProj[p] = max(maxProj[p], proj);
         }
@@ -139,7 +91,7 @@ fn main(@builtin(global_invocation_id) global_id : vec3<u32>) {
     var partition0_lenSqr = 0.0f;
     var lenghtsSqr = vec4<f32>(0.0);
 
-    for (var p = 0u; p < 4u; p = p + 1u) {
+    for (var p = 0u; p < PARTITION_COUNT; p = p + 1u) {
         let d = direction[p];
 
         if(minProj[p] >= maxProj[p]) {
@@ -173,10 +125,10 @@ fn main(@builtin(global_invocation_id) global_id : vec3<u32>) {
 
     //assign weights
     for (var i = 0u; i < texelCount; i = i + 1u) {
-        let p = inputBlock.texel_partitions[i];
+        let p = partitionInfos[partitioned.partition_table_idx].partition_of_texel[i];
 
-        if (p < 4u) {
-            let proj = dot(inputBlock.pixels[i] - avg[p], direction[p]);
+        if (p < PARTITION_COUNT) {
+            let proj = dot(decode_texel(inputBlock.pixels[i]) - avg[p], direction[p]);
             let span = max(maxProj[p] - minProj[p], 1e-6);
             let w = clamp((proj - minProj[p]) / span, 0.0, 1.0);
             outputBlocks[blockIndex].weights[i] = w;
@@ -191,7 +143,7 @@ fn main(@builtin(global_invocation_id) global_id : vec3<u32>) {
     //calculate min_endpoint for endpoint quality metric
     var min_ep = vec4<f32>(10.0);
 
-    for (var p = 0u; p < 4u; p = p + 1u) {
+    for (var p = 0u; p < PARTITION_COUNT; p = p + 1u) {
         let ep0 = outputBlocks[blockIndex].partitions[p].endpoint0;
         let ep1 = outputBlocks[blockIndex].partitions[p].endpoint1;
 
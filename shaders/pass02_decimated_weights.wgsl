@@ -1,84 +1,9 @@
-const WORKGROUP_SIZE: u32 = 64u;
-const BLOCK_MAX_TEXELS: u32 = 144u; // Max texels (e.g., 12x12)
-const BLOCK_MAX_WEIGHTS: u32 = 64u;  // Max decimated weights (e.g., 8x8)
-
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct DecimationInfo {
-    texel_count : u32,
-    weight_count : u32,
-    weight_x : u32,
-    weight_y : u32,
-
-    max_quant_level : u32,
-    max_angular_steps : u32,
-    max_quant_steps: u32,
-    _padding: u32,
+#include "common/uniforms.wgsl"
+#include "common/decimation.wgsl"
+#include "common/endpoints.wgsl"
+#include "common/texel_capacity.wgsl"
 
-    texel_weight_count : array<u32, BLOCK_MAX_TEXELS>,
-    texel_weights_offset : array<u32, BLOCK_MAX_TEXELS>,
-
-    weight_texel_count : array<u32, BLOCK_MAX_WEIGHTS>,
-    weight_texels_offset : array<u32, BLOCK_MAX_WEIGHTS>,
-};
-
-struct TexelToWeightMap {
-	weight_index : u32,
-	contribution : f32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct WeightToTexelMap {
-    texel_index : u32,
-	contribution : f32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct IdealEndpointsAndWeightsPartition { //same as OutputPartition in shader pass 1
-    avg: vec4<f32>,
-    dir: vec4<f32>,
-    endpoint0: vec4<f32>,
-    endpoint1: vec4<f32>,
-};
-
-struct IdealEndpointsAndWeights {
-    partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-    weights: array<f32, BLOCK_MAX_TEXELS>,
-
-    weight_error_scale: array<f32, BLOCK_MAX_TEXELS>,
-
-    is_constant_weight_error_scale : u32,
-    min_weight_cuttof : f32,
-    _padding1 : u32,
-    _padding2 : u32,
-};
+const WORKGROUP_SIZE: u32 = 64u;
 
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
@@ -95,7 +20,7 @@ struct IdealEndpointsAndWeights {
 var<workgroup> shared_decimated_weights: array<f32, BLOCK_MAX_WEIGHTS>;
 
 //Reconstructed weight grid from the initial estimation of decimated weights
-var<workgroup> shared_infilled_weights: array<f32, BLOCK_MAX_TEXELS>;
+var<workgroup> shared_infilled_weights: array<f32, TEXEL_CAPACITY>;
 
 // Temporary storage for the refinement step's error calculation (the values are actually f32, but are stored as u32)
 var<workgroup> shared_error_change0: array<atomic<u32>, BLOCK_MAX_WEIGHTS>;
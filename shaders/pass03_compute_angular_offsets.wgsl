@@ -1,54 +1,12 @@
+#include "common/uniforms.wgsl"
+#include "common/decimation.wgsl"
+
 const WORKGROUP_SIZE: u32 = 64u;
-const BLOCK_MAX_TEXELS: u32 = 144u; // Max texels (e.g., 12x12)
-const BLOCK_MAX_WEIGHTS: u32 = 64u;  // Max decimated weights (e.g., 8x8)
 const MAX_ANGULAR_STEPS: u32 = 16u;
 const SINCOS_STEPS: f32 = 1024.0;
 const PI: f32 = 3.14159265358979323846;
 
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct DecimationInfo {
-    texel_count : u32,
-    weight_count : u32,
-    weight_x : u32,
-    weight_y : u32,
-
-    max_quant_level : u32,
-    max_angular_steps : u32,
-    max_quant_steps: u32,
-    _padding: u32,
-
-    texel_weight_count : array<u32, BLOCK_MAX_TEXELS>,
-    texel_weights_offset : array<u32, BLOCK_MAX_TEXELS>,
-
-    weight_texel_count : array<u32, BLOCK_MAX_WEIGHTS>,
-    weight_texels_offset : array<u32, BLOCK_MAX_WEIGHTS>,
-};
-
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
 @group(0) @binding(1) var<storage, read> valid_decimation_modes: array<u32>;
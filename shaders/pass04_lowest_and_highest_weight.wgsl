@@ -1,63 +1,9 @@
+#include "common/uniforms.wgsl"
+#include "common/decimation.wgsl"
+#include "common/search.wgsl"
+
 const WORKGROUP_SIZE: u32 = 64u;
-const BLOCK_MAX_WEIGHTS: u32 = 64u;
 const MAX_ANGULAR_STEPS: u32 = 16u;
-const BLOCK_MAX_TEXELS: u32 = 144u;
-
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct DecimationInfo {
-    texel_count : u32,
-    weight_count : u32,
-    weight_x : u32,
-    weight_y : u32,
-
-    max_quant_level : u32,
-    max_angular_steps : u32,
-    max_quant_steps: u32,
-    _padding: u32,
-
-    texel_weight_count : array<u32, BLOCK_MAX_TEXELS>,
-    texel_weights_offset : array<u32, BLOCK_MAX_TEXELS>,
-
-    weight_texel_count : array<u32, BLOCK_MAX_WEIGHTS>,
-    weight_texels_offset : array<u32, BLOCK_MAX_WEIGHTS>,
-};
-
-//output struct
-struct HighestAndLowestWeight {
-    lowest_weight : f32,
-    weight_span : i32,
-    error : f32,
-    cut_low_error : f32,
-    cut_high_error : f32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-    _padding3 : u32,
-};
 
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
@@ -1,64 +1,13 @@
+#include "common/uniforms.wgsl"
+#include "common/decimation.wgsl"
+#include "common/search.wgsl"
+
 const WORKGROUP_SIZE: u32 = 64u;
 const MAX_ANGULAR_QUANT = 12;
 const MAX_BEST_RESULTS = 36;
-const BLOCK_MAX_TEXELS: u32 = 144u;
-const BLOCK_MAX_WEIGHTS: u32 = 64u;
 const MAX_ANGULAR_STEPS: u32 = 16u;
 
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct PackedBlockModeLookup {
-    block_mode_index: u32,
-    decimation_mode_lookup_idx: u32, //index of corresponding decimation mode in the valid decimation modes buffer
-
-    _padding1: u32,
-    _padding2: u32,
-};
-
-struct BlockMode {
-	mode_index : u32,
-    decimation_mode : u32,
-    quant_mode : u32,
-    weight_bits : u32,
-    is_dual_plane : u32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-    _padding3 : u32,
-};
-
-struct FinalValueRange {
-    low : f32,
-    high : f32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
 @group(0) @binding(1) var<storage, read> valid_block_modes: array<PackedBlockModeLookup>;
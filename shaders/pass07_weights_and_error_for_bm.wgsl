@@ -1,6 +1,10 @@
+#include "common/uniforms.wgsl"
+#include "common/decimation.wgsl"
+#include "common/endpoints.wgsl"
+#include "common/search.wgsl"
+#include "common/texel_capacity.wgsl"
+
 const WORKGROUP_SIZE: u32 = 64u;
-const BLOCK_MAX_TEXELS: u32 = 144u;
-const BLOCK_MAX_WEIGHTS: u32 = 64u;
 
 const FREE_BITS_FOR_PARTITION_COUNT = array<i32, 4>(111, 111 - 4 - 10, 108 - 4 - 10, 105 - 4 - 10);
 const QUANT_MODES = array<u32, 12>(2, 3, 4, 5, 6, 8, 10, 12, 16, 20, 24, 32);
@@ -37,114 +41,6 @@ const QUANT_TO_UNQUANT = array<u32, 142>(
 );
 
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct PackedBlockModeLookup {
-    block_mode_index: u32,
-    decimation_mode_lookup_idx: u32, //index of corresponding decimation mode in the valid decimation modes buffer
-
-    _padding1: u32,
-    _padding2: u32,
-};
-
-struct BlockMode {
-	mode_index : u32,
-    decimation_mode : u32,
-    quant_mode : u32,
-    weight_bits : u32,
-    is_dual_plane : u32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-    _padding3 : u32,
-};
-
-struct DecimationInfo {
-    texel_count : u32,
-    weight_count : u32,
-    weight_x : u32,
-    weight_y : u32,
-
-    max_quant_level : u32,
-    max_angular_steps : u32,
-    max_quant_steps: u32,
-    _padding: u32,
-
-    texel_weight_count : array<u32, BLOCK_MAX_TEXELS>,
-    texel_weights_offset : array<u32, BLOCK_MAX_TEXELS>,
-
-    weight_texel_count : array<u32, BLOCK_MAX_WEIGHTS>,
-    weight_texels_offset : array<u32, BLOCK_MAX_WEIGHTS>,
-};
-
-struct FinalValueRange {
-    low : f32,
-    high : f32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct IdealEndpointsAndWeightsPartition {
-    avg: vec4<f32>,
-    dir: vec4<f32>,
-    endpoint0: vec4<f32>,
-    endpoint1: vec4<f32>,
-};
-
-struct IdealEndpointsAndWeights {
-    partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-    weights: array<f32, BLOCK_MAX_TEXELS>,
-
-    weight_error_scale: array<f32, BLOCK_MAX_TEXELS>,
-
-    is_constant_weight_error_scale : u32,
-    min_weight_cuttof : f32,
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct TexelToWeightMap {
-	weight_index : u32,
-	contribution : f32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct QuantizationResult {
-    error: f32,
-    bitcount: i32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    quantized_weights: array<u32, (BLOCK_MAX_WEIGHTS/4)>,
-};
-
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
 @group(0) @binding(1) var<storage, read> valid_block_modes: array<PackedBlockModeLookup>;
 @group(0) @binding(2) var<storage, read> block_modes: array<BlockMode>;
@@ -177,7 +73,7 @@ var<workgroup> shared_skip_work: u32;
 var<workgroup> shared_bitcount: i32; // Store bitcount for the final writer thread
 var<workgroup> shared_quantized_weights_float: array<f32, BLOCK_MAX_WEIGHTS>;
 var<workgroup> shared_quantized_weights_int: array<u32, BLOCK_MAX_WEIGHTS>;
-var<workgroup> shared_infilled_weights: array<f32, BLOCK_MAX_TEXELS>;
+var<workgroup> shared_infilled_weights: array<f32, TEXEL_CAPACITY>;
 var<workgroup> shared_total_error: atomic<u32>;
 
 @compute @workgroup_size(WORKGROUP_SIZE)
@@ -1,75 +1,13 @@
+#partition_variants 1 2 3 4
+#include "common/uniforms.wgsl"
+#include "common/partitioned_blocks.wgsl"
+#include "common/endpoints.wgsl"
+#include "common/search.wgsl"
+
 const WORKGROUP_SIZE: u32 = 64u;
-const BLOCK_MAX_TEXELS: u32 = 144u;
 
 const DEFAULT_ALPHA: f32 = 65536.0;
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct InputBlock {
-    pixels: array<vec4<f32>, BLOCK_MAX_TEXELS>,
-    texel_partitions: array<u32, BLOCK_MAX_TEXELS>,
-    partition_pixel_counts: array<u32, 4>,
-
-    partitioning_idx: u32,
-    grayscale: u32,
-    constant_alpha: u32,
-    padding: u32,
-};
-
-struct IdealEndpointsAndWeightsPartition {
-    avg: vec4<f32>,
-    dir: vec4<f32>,
-    endpoint0: vec4<f32>,
-    endpoint1: vec4<f32>,
-};
-
-struct IdealEndpointsAndWeights {
-    partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-    weights: array<f32, BLOCK_MAX_TEXELS>,
-
-    weight_error_scale: array<f32, BLOCK_MAX_TEXELS>,
-
-    is_constant_weight_error_scale : u32,
-    min_weight_cuttof : f32,
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct EncodingChoiceErrors {
-    rgb_scale_error: f32,
-    rgb_luma_error: f32,
-    luminance_error: f32,
-    alpha_drop_error: f32,
-
-    can_offset_encode: u32,
-    can_blue_contract: u32,
-
-    _padding1: u32,
-    _padding2: u32,
-}
 
 struct ProcessedLine {
 	amod: vec4<f32>,
@@ -81,6 +19,8 @@ struct ProcessedLine {
 @group(0) @binding(2) var<storage, read> ideal_endpoints_and_weights: array<IdealEndpointsAndWeights>;
 
 @group(0) @binding(3) var<storage, read_write> encoding_choice_errors: array<EncodingChoiceErrors>;
+@group(0) @binding(4) var<storage, read> partitioned_blocks: array<PartitionedBlock>;
+@group(0) @binding(5) var<storage, read> partitionInfos: array<PartitonInfo>;
 
 
 var<workgroup> shared_sum_xp: array<atomic<u32>, 16>;
@@ -116,10 +56,11 @@ fn atomicAdd_f32(atomic_target: ptr<workgroup, atomic<u32>>, value_to_add: f32)
 fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_index) local_idx: u32) {
     
     let block_index = group_id.x;
-    let partitionCount = uniforms.partition_count;
+    let partitionCount = PARTITION_COUNT;
 
     //compute averages and directions for partitions
-    let input_block = inputBlocks[block_index];
+    let partitioned = partitioned_block(block_index, PARTITION_COUNT);
+    let input_block = inputBlocks[partitioned.source_block];
     let ideal_endpoints_and_weights_block = ideal_endpoints_and_weights[block_index];
 
     //Initialize shared memory
@@ -133,11 +74,11 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
 
     // Calculate averages and directions for all partitions simultaneously
     for(var i = local_idx; i < uniforms.texel_count; i += WORKGROUP_SIZE) {
-        let p = input_block.texel_partitions[i];
+        let p = partitionInfos[partitioned.partition_table_idx].partition_of_texel[i];
 
 		if (p < partitionCount) {
 			let average = ideal_endpoints_and_weights_block.partitions[p].avg;
-            var texel_datum = input_block.pixels[i] - average;
+            var texel_datum = decode_texel(input_block.pixels[i]) - average;
             texel_datum.w = 0.0; // Ignore alpha channel for direction calculation
 
             if(texel_datum.x > 0.0) {
@@ -245,15 +186,16 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
     workgroupBarrier();
 
     for(var i = local_idx; i < uniforms.texel_count; i += WORKGROUP_SIZE) {
-        let p = input_block.texel_partitions[i];
+        let p = partitionInfos[partitioned.partition_table_idx].partition_of_texel[i];
 
         if(p < partitionCount) {
 
             let cw = uniforms.channel_weights;
-            let rgb_data = input_block.pixels[i].xyz;
+            let texel = decode_texel(input_block.pixels[i]);
+            let rgb_data = texel.xyz;
 
             //Alpha drop error
-            let alpha_diff = input_block.pixels[i].a - DEFAULT_ALPHA;
+            let alpha_diff = texel.a - DEFAULT_ALPHA;
             let a_drop_error = alpha_diff * alpha_diff * cw.w;
             atomicAdd_f32(&error_accumulators[p * 5u + 0u], a_drop_error);
 
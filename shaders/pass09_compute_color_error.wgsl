@@ -1,6 +1,10 @@
+#partition_variants 1 2 3 4
+#include "common/uniforms.wgsl"
+#include "common/partitioned_blocks.wgsl"
+#include "common/endpoints.wgsl"
+#include "common/search.wgsl"
+
 const WORKGROUP_SIZE: u32 = 64u;
-const BLOCK_MAX_PARTITIONS: u32 = 4u;
-const BLOCK_MAX_TEXELS: u32 = 144u;
 
 const NUM_QUANT_LEVELS = 21u;
 const NUM_INT_COUNTS = 4u; //8,6,4,2
@@ -46,84 +50,14 @@ const FMT_HDR_RGB_LDR_ALPHA = 14u;
 const FMT_HDR_RGBA = 15u;
 
 
-
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct InputBlock {
-    pixels: array<vec4<f32>, BLOCK_MAX_TEXELS>,
-    texel_partitions: array<u32, BLOCK_MAX_TEXELS>,
-    partition_pixel_counts: array<u32, 4>,
-
-    partitioning_idx: u32,
-    grayscale: u32,
-    constant_alpha: u32,
-    padding: u32,
-};
-
-struct IdealEndpointsAndWeightsPartition {
-    avg: vec4<f32>,
-    dir: vec4<f32>,
-    endpoint0: vec4<f32>,
-    endpoint1: vec4<f32>,
-};
-
-struct IdealEndpointsAndWeights {
-    partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-    weights: array<f32, BLOCK_MAX_TEXELS>,
-
-    weight_error_scale: array<f32, BLOCK_MAX_TEXELS>,
-
-    is_constant_weight_error_scale : u32,
-    min_weight_cuttof : f32,
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct EncodingChoiceErrors {
-    rgb_scale_error: f32,
-    rgb_luma_error: f32,
-    luminance_error: f32,
-    alpha_drop_error: f32,
-
-    can_offset_encode: u32,
-    can_blue_contract: u32,
-
-    _padding1: u32,
-    _padding2: u32,
-}
-
-
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
-@group(0) @binding(1) var<storage, read> inputBlocks: array<InputBlock>;
+@group(0) @binding(1) var<storage, read> partitioned_blocks: array<PartitionedBlock>;
 @group(0) @binding(2) var<storage, read> ideal_endpoints_and_weights: array<IdealEndpointsAndWeights>;
 @group(0) @binding(3) var<storage, read> encoding_choice_errors: array<EncodingChoiceErrors>;
 
 @group(0) @binding(4) var<storage, read_write> output_best_error: array<f32>;
 @group(0) @binding(5) var<storage, read_write> output_format_of_choice: array<u32>;
-
+@group(0) @binding(6) var<storage, read> partitionInfos: array<PartitonInfo>;
 
 
 // Pre-calculated values, one for each partition in the block.
@@ -140,18 +74,18 @@ var<workgroup> part_error_scale_oe_rgb: array<f32, 4>;
 @compute @workgroup_size(WORKGROUP_SIZE)
 fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_index) local_idx: u32) {
     let block_idx = group_id.x;
-    let partition_count = uniforms.partition_count;
+    let partition_count = PARTITION_COUNT;
 
     //precomputation
     if(local_idx < partition_count) {
         let p = local_idx;
-        let part_global_idx = block_idx * uniforms.partition_count + p;
+        let part_global_idx = block_idx * PARTITION_COUNT + p;
 
         let ep0 = ideal_endpoints_and_weights[block_idx].partitions[p].endpoint0;
         let ep1 = ideal_endpoints_and_weights[block_idx].partitions[p].endpoint1;
 
         let eci = encoding_choice_errors[part_global_idx];
-        let partition_size = f32(inputBlocks[block_idx].partition_pixel_counts[p]);
+        let partition_size = f32(partitionInfos[partitioned_block(block_idx, PARTITION_COUNT).partition_table_idx].partition_texel_count[p]);
 
         //Calculate range error (endpoints going out of [0, 65535] range)
         let offset = vec4<f32>(65535.0);
@@ -201,7 +135,7 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
         let quant_idx = i + 4u; //start at QUANT_6
 
         for(var p = 0u; p < partition_count; p += 1u) {
-			let part_global_idx = block_idx * uniforms.partition_count + p;
+			let part_global_idx = block_idx * PARTITION_COUNT + p;
             let eci = encoding_choice_errors[part_global_idx];
 
             //get precomputed values from shared memory
@@ -0,0 +1,86 @@
+#partition_variants 2 3 4
+#include "common/uniforms.wgsl"
+#include "common/search.wgsl"
+
+const WORKGROUP_SIZE: u32 = 64u;
+const NUM_QUANT_LEVELS: u32 = 21u;
+const NUM_INT_COUNTS: u32 = 4u;  // 2, 4, 6, 8 integers
+const NUM_COMBINED_INT_COUNTS: u32 = 3u * PARTITION_COUNT + 1u; // Sum of the integer count choices of all partitions
+const NUM_INT_COUNT_COMBINATIONS: u32 = 1u << (2u * PARTITION_COUNT); // 4 integer count choices per partition
+const ERROR_CALC_DEFAULT: f32 = 1e37;
+
+
+@group(0) @binding(0) var<uniform> uniforms: UniformVariables;
+@group(0) @binding(1) var<storage, read> color_error_table: array<f32>;
+@group(0) @binding(2) var<storage, read> format_choice_table: array<u32>;
+
+@group(0) @binding(3) var<storage, read_write> combined_endpoint_formats: array<CombinedEndpointFormats>;
+
+//integer count choice of a partition, the choice of partition 0 is the most significant digit of the combination
+fn int_count_of_partition(combination: u32, partition: u32) -> u32 {
+    return (combination >> (2u * (PARTITION_COUNT - 1u - partition))) & 3u;
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_index) local_idx: u32) {
+    let block_idx = group_id.x;
+
+    //Initialize output buffer to highest possible error
+    let total_slots_to_init = NUM_QUANT_LEVELS * NUM_COMBINED_INT_COUNTS;
+    let output_base_idx = block_idx * NUM_QUANT_LEVELS * NUM_COMBINED_INT_COUNTS;
+
+    for(var i = local_idx; i < total_slots_to_init; i += WORKGROUP_SIZE) {
+        let out_ptr = &combined_endpoint_formats[output_base_idx + i];
+        (*out_ptr).error = ERROR_CALC_DEFAULT;
+    }
+
+    workgroupBarrier();
+
+    //For every quant level, find the best color format combinatoin for every integer count
+    let error_base = block_idx * PARTITION_COUNT * NUM_QUANT_LEVELS * NUM_INT_COUNTS;
+
+    if(local_idx < (NUM_QUANT_LEVELS - 4)) { //QUANT_6 = 4
+        let quant_level = local_idx + 4u; //Start from QUANT_6
+
+        // Loop through all combinations of the 4 integer count choices of the partitions
+        for (var combination = 0u; combination < NUM_INT_COUNT_COMBINATIONS; combination = combination + 1u) {
+
+            //Number of integers used for each partition can only differ by one step
+            var low = 3u;
+            var high = 0u;
+            var total_int_count = 0u;
+            for (var p = 0u; p < PARTITION_COUNT; p = p + 1u) {
+                let int_count = int_count_of_partition(combination, p);
+                low = min(low, int_count);
+                high = max(high, int_count);
+                total_int_count += int_count;
+            }
+
+            if (high - low > 1u) {
+                continue; // Skip if the difference is more than 1
+            }
+
+            // Read the pre-computed errors for this combination.
+            var total_error = 0.0;
+            for (var p = 0u; p < PARTITION_COUNT; p = p + 1u) {
+                let partition_error_base = error_base + p * NUM_QUANT_LEVELS * NUM_INT_COUNTS;
+                total_error += color_error_table[partition_error_base + quant_level * NUM_INT_COUNTS + int_count_of_partition(combination, p)];
+            }
+            total_error = min(total_error, 1e10); // Clamp to avoid huge values
+
+            // Check if this combination is the new best for this total_int_count.
+            let out_idx = output_base_idx + quant_level * NUM_COMBINED_INT_COUNTS + total_int_count;
+            let out_ptr = &combined_endpoint_formats[out_idx];
+
+            if (total_error < (*out_ptr).error) {
+                var formats = vec4<u32>(0u);
+                for (var p = 0u; p < PARTITION_COUNT; p = p + 1u) {
+                    let partition_error_base = error_base + p * NUM_QUANT_LEVELS * NUM_INT_COUNTS;
+                    formats[p] = format_choice_table[partition_error_base + quant_level * NUM_INT_COUNTS + int_count_of_partition(combination, p)];
+                }
+                (*out_ptr).error = total_error;
+                (*out_ptr).formats = formats;
+            }
+        }
+    }
+}
@@ -1,11 +1,23 @@
-const WORKGROUP_SIZE: u32 = 1u;
-const BLOCK_MAX_WEIGHTS: u32 = 64u;
+#partition_variants 1 2 3 4
+#include "common/uniforms.wgsl"
+#include "common/decimation.wgsl"
+#include "common/search.wgsl"
+
 const NUM_QUANT_LEVELS: u32 = 21u;
-const NUM_INT_COUNTS: u32 = 4u; // The 4 integer counts (2, 4, 6, 8 ints)
+const NUM_INT_COUNTS: u32 = 4u; // The 4 integer counts (2, 4, 6, 8 ints) of a partition
+const NUM_COMBINED_INT_COUNTS: u32 = 3u * PARTITION_COUNT + 1u; // Sum of the integer count choices of all partitions
 const MAX_BITS: u32 = 128u;
-const BLOCK_MAX_PARTITIONS: u32 = 4u;
 const ERROR_CALC_DEFAULT: f32 = 1e37;
 
+#if PARTITION_COUNT > 1
+//range of the total integer counts (in pairs of integers) of the partitions, color endpoints use 18 integers at most
+const MIN_TOTAL_INT_COUNT_IDX: u32 = PARTITION_COUNT;
+const MAX_TOTAL_INT_COUNT_IDX: u32 = min(4u * PARTITION_COUNT, 9u);
+
+//bits freed for the quantized endpoints when all partitions use the same endpoint format class
+const MATCHED_FORMATS_EXTRA_BITS: u32 = 3u * PARTITION_COUNT - 4u;
+#endif
+
 //precomputed quantization levels for integer count and avalible bits
 //-1 if integer count cannot fit in the available bits
 //the table is flattened, indexed by: integer_count * MAX_BITS + bit_count
@@ -80,69 +92,19 @@ const FMT_RGBA_DELTA = 13u;
 const FMT_HDR_RGB_LDR_ALPHA = 14u;
 const FMT_HDR_RGBA = 15u;
 
-
-
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct PackedBlockModeLookup {
-    block_mode_index: u32,
-    decimation_mode_lookup_idx: u32, //index of corresponding decimation mode in the valid decimation modes buffer
-
-    _padding1: u32,
-    _padding2: u32,
-};
-
-struct QuantizationResult {
-    error: f32,
-    bitcount: i32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    quantized_weights: array<u32, (BLOCK_MAX_WEIGHTS/4)>,
-};
-
-struct ColorCombinationResult {
-    total_error: f32,
-    best_quant_level: u32,
-    best_quant_level_mod: u32,
-
-    _padding1: u32,
-
-    best_ep_formats: vec4<u32>,
-};
-
-
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
 @group(0) @binding(1) var<storage, read> valid_block_modes: array<PackedBlockModeLookup>;
 @group(0) @binding(2) var<storage, read> quantization_results: array<QuantizationResult>;
+#if PARTITION_COUNT == 1
 @group(0) @binding(3) var<storage, read> color_error_table: array<f32>;
 @group(0) @binding(4) var<storage, read> format_choice_table: array<u32>;
 
 @group(0) @binding(5) var<storage, read_write> output_color_combination_results: array<ColorCombinationResult>;
+#else
+@group(0) @binding(3) var<storage, read> combined_endpoint_formats: array<CombinedEndpointFormats>;
+
+@group(0) @binding(4) var<storage, read_write> output_color_combination_results: array<ColorCombinationResult>;
+#endif
 
 @compute @workgroup_size(1)
 fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
@@ -154,23 +116,23 @@ fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
     let num_valid_bms = uniforms.valid_block_mode_count;
     let block_mode_trial_index = block_index * num_valid_bms + bm_lookup_idx;
 
-
     let quant_result = quantization_results[block_mode_trial_index];
     let weight_error = quant_result.error;
     let bits_avalible = quant_result.bitcount;
 
 
-    //skip if error is already to high
+    //Skip if error is already to high
     if(weight_error >= ERROR_CALC_DEFAULT) {
         let out_ptr = &output_color_combination_results[block_mode_trial_index];
         (*out_ptr).total_error = ERROR_CALC_DEFAULT;
         return;
     }
 
+#if PARTITION_COUNT == 1
     var best_integer_count_idx = 0u;
     var best_integer_count_error = ERROR_CALC_DEFAULT;
 
-    let integer_count_error_idx_base = (block_index * uniforms.partition_count + 0u) * NUM_QUANT_LEVELS;
+    let integer_count_error_idx_base = block_index * NUM_QUANT_LEVELS;
 
     //Loop through 4 integer counts (2,4,6,8)
     for(var int_count_idx = 1u; int_count_idx <= 4u; int_count_idx = int_count_idx + 1u) {
@@ -197,7 +159,7 @@ fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
 
     var best_ep_format = FMT_LUMINANCE;
     if(final_quant_level >= 4) {
-        let format_choice_idx = ((block_index * uniforms.partition_count + 0u) * NUM_QUANT_LEVELS + u32(final_quant_level)) * NUM_INT_COUNTS + best_integer_count_idx - 1u;
+        let format_choice_idx = (block_index * NUM_QUANT_LEVELS + u32(final_quant_level)) * NUM_INT_COUNTS + best_integer_count_idx - 1u;
         best_ep_format = format_choice_table[format_choice_idx];
     }
 
@@ -212,4 +174,47 @@ fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
 
     (*out_ptr).best_ep_formats = vec4<u32>(0u); //Init to default values
     (*out_ptr).best_ep_formats[0] = best_ep_format;
-}
\ No newline at end of file
+#else
+    var best_total_int_count_idx = 0u;
+    var best_color_error = ERROR_CALC_DEFAULT;
+
+    let combined_error_base = block_index * NUM_QUANT_LEVELS * NUM_COMBINED_INT_COUNTS;
+
+    // Loop through the possible total integer counts (in pairs of integers, every partition uses at least 2 integers, 18 integers at most)
+    for (var int_count_idx = MIN_TOTAL_INT_COUNT_IDX; int_count_idx <= MAX_TOTAL_INT_COUNT_IDX; int_count_idx = int_count_idx + 1u) {
+
+        let quant_table_idx = (int_count_idx * MAX_BITS) + u32(bits_avalible);
+        let quant_level = QUANT_MODE_TABLE[quant_table_idx];
+
+        //We don't have enough bits to represent a given endpoint format
+        if(quant_level < 4) { //QUANT_6 = 4
+			break;
+		}
+
+        let combined_error_idx = combined_error_base + u32(quant_level) * NUM_COMBINED_INT_COUNTS + int_count_idx - MIN_TOTAL_INT_COUNT_IDX;
+        let combined_error = combined_endpoint_formats[combined_error_idx].error;
+        if (combined_error < best_color_error) {
+            best_color_error = combined_error;
+            best_total_int_count_idx = int_count_idx;
+        }
+    }
+
+    let final_quant_level = QUANT_MODE_TABLE[(best_total_int_count_idx * MAX_BITS) + u32(bits_avalible)];
+    let final_quant_level_mod = QUANT_MODE_TABLE[(best_total_int_count_idx * MAX_BITS) + u32(bits_avalible) + MATCHED_FORMATS_EXTRA_BITS];
+
+    var final_best_formats = vec4<u32>(0u); //default formats
+    if (final_quant_level >= 4) { //QUANT_6 = 4
+		let combined_error_idx = combined_error_base + u32(final_quant_level) * NUM_COMBINED_INT_COUNTS + best_total_int_count_idx - MIN_TOTAL_INT_COUNT_IDX;
+		final_best_formats = combined_endpoint_formats[combined_error_idx].formats;
+	}
+
+    //Finalization
+    let total_error = best_color_error + weight_error;
+
+    let out_ptr = &output_color_combination_results[block_mode_trial_index];
+    (*out_ptr).total_error = total_error;
+    (*out_ptr).best_quant_level = u32(final_quant_level);
+    (*out_ptr).best_quant_level_mod = u32(final_quant_level_mod);
+    (*out_ptr).best_ep_formats = final_best_formats;
+#endif
+}
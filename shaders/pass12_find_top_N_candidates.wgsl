@@ -1,109 +1,20 @@
+#include "common/uniforms.wgsl"
+#include "common/decimation.wgsl"
+#include "common/endpoints.wgsl"
+#include "common/search.wgsl"
+#include "common/candidates.wgsl"
+
 const WORKGROUP_SIZE: u32 = 64u;
-const BLOCK_MAX_TEXELS: u32 = 144u;
-const BLOCK_MAX_WEIGHTS: u32 = 64u;
 
 const TUNE_MAX_TRIAL_CANDIDATES = 8u;
 const ERROR_CALC_DEFAULT: f32 = 1e37;
 
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct PackedBlockModeLookup {
-    block_mode_index: u32,
-    decimation_mode_lookup_idx: u32, //index of corresponding decimation mode in the valid decimation modes buffer
-
-    _padding1: u32,
-    _padding2: u32,
-};
-
-struct IdealEndpointsAndWeightsPartition {
-    avg: vec4<f32>,
-    dir: vec4<f32>,
-    endpoint0: vec4<f32>,
-    endpoint1: vec4<f32>,
-};
-
-struct IdealEndpointsAndWeights {
-    partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-    weights: array<f32, BLOCK_MAX_TEXELS>,
-
-    weight_error_scale: array<f32, BLOCK_MAX_TEXELS>,
-
-    is_constant_weight_error_scale : u32,
-    min_weight_cuttof : f32,
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct QuantizationResult {
-    error: f32,
-    bitcount: i32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    quantized_weights: array<u32, (BLOCK_MAX_WEIGHTS/4)>,
-};
-
-struct ColorCombinationResult {
-    total_error: f32,
-    best_quant_level: u32,
-    best_quant_level_mod: u32,
-
-    _padding1: u32,
-
-    best_ep_formats: vec4<u32>,
-};
-
 struct SortItem {
 	error: f32,
 	bm_trial_idx: u32,
 };
 
-struct FinalCandidate {
-    block_mode_index: u32,
-    block_mode_trial_index: u32,
-    total_error: f32,
-    quant_level: u32, // The original quant level
-    quant_level_mod: u32,
-
-    _padding1: u32,
-
-	color_formats_matched: u32,
-    final_quant_mode: u32, // The quant mode after checking the mod version
-
-    formats: vec4<u32>,
-    quantized_weights: array<u32, BLOCK_MAX_WEIGHTS>,
-    candidate_partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-
-	final_formats: vec4<u32>,
-	//8 integers per partition
-    packed_color_values: array<u32, 32>,
-};
-
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
 @group(0) @binding(1) var<storage, read> valid_block_modes: array<PackedBlockModeLookup>;
@@ -1,113 +1,15 @@
+#partition_variants 1 2 3 4
+#include "common/uniforms.wgsl"
+#include "common/partitioned_blocks.wgsl"
+#include "common/decimation.wgsl"
+#include "common/endpoints.wgsl"
+#include "common/candidates.wgsl"
+#include "common/texel_capacity.wgsl"
+
 const WORKGROUP_SIZE: u32 = 64u;
-const BLOCK_MAX_TEXELS: u32 = 144u;
-const BLOCK_MAX_WEIGHTS: u32 = 64u;
-const BLOCK_MAX_PARTITIONS: u32 = 4u;
 
 const TUNE_MAX_TRIAL_CANDIDATES = 8u;
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct DecimationInfo {
-    texel_count : u32,
-    weight_count : u32,
-    weight_x : u32,
-    weight_y : u32,
-
-    max_quant_level : u32,
-    max_angular_steps : u32,
-    max_quant_steps: u32,
-    _padding: u32,
-
-    texel_weight_count : array<u32, BLOCK_MAX_TEXELS>,
-    texel_weights_offset : array<u32, BLOCK_MAX_TEXELS>,
-
-    weight_texel_count : array<u32, BLOCK_MAX_WEIGHTS>,
-    weight_texels_offset : array<u32, BLOCK_MAX_WEIGHTS>,
-};
-
-struct TexelToWeightMap {
-	weight_index : u32,
-	contribution : f32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct InputBlock {
-    pixels: array<vec4<f32>, BLOCK_MAX_TEXELS>,
-    texel_partitions: array<u32, BLOCK_MAX_TEXELS>,
-    partition_pixel_counts: array<u32, 4>,
-
-    partitioning_idx: u32,
-    grayscale: u32,
-    constant_alpha: u32,
-    padding: u32,
-};
-
-struct BlockMode {
-	mode_index : u32,
-    decimation_mode : u32,
-    quant_mode : u32,
-    weight_bits : u32,
-    is_dual_plane : u32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-    _padding3 : u32,
-};
-
-struct IdealEndpointsAndWeightsPartition {
-    avg: vec4<f32>,
-    dir: vec4<f32>,
-    endpoint0: vec4<f32>,
-    endpoint1: vec4<f32>,
-};
-
-struct FinalCandidate {
-    block_mode_index: u32,
-    block_mode_trial_index: u32,
-    total_error: f32,
-    quant_level: u32, // The original quant level
-    quant_level_mod: u32,
-
-    _padding1: u32,
-
-	color_formats_matched: u32,
-    final_quant_mode: u32, // The quant mode after checking the mod version
-
-    formats: vec4<u32>,
-    quantized_weights: array<u32, BLOCK_MAX_WEIGHTS>,
-    candidate_partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-
-	final_formats: vec4<u32>,
-	//8 integers per partition
-    packed_color_values: array<u32, 32>,
-};
-
-
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
 @group(0) @binding(1) var<storage, read> decimation_infos: array<DecimationInfo>;
@@ -117,12 +19,13 @@ struct FinalCandidate {
 
 @group(0) @binding(5) var<storage, read_write> final_candidates: array<FinalCandidate>;
 @group(0) @binding(6) var<storage, read_write> candidate_rgbs_vectors: array<vec4<f32>>;
-
+@group(0) @binding(7) var<storage, read> partitioned_blocks: array<PartitionedBlock>;
+@group(0) @binding(8) var<storage, read> partitionInfos: array<PartitonInfo>;
 
 
 // Undecimated weights of block
 var<workgroup> dec_weights: array<f32, BLOCK_MAX_WEIGHTS>;
-var<workgroup> undec_weights: array<f32, BLOCK_MAX_TEXELS>;
+var<workgroup> undec_weights: array<f32, TEXEL_CAPACITY>;
 
 //precomputed values
 var<workgroup> averages: array<vec4<f32>, 4>;
@@ -218,8 +121,9 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
     workgroupBarrier();
 
 
-    let partition_count = uniforms.partition_count;
-    let input_block = input_blocks[block_idx];
+    let partition_count = PARTITION_COUNT;
+    let partitioned = partitioned_block(block_idx, PARTITION_COUNT);
+    let input_block = input_blocks[partitioned.source_block];
 
     // Initialize accumulators
     if(local_idx < partition_count) {
@@ -241,7 +145,7 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
         //precompute averages and scale directions
         averages[local_idx] = candidate.candidate_partitions[local_idx].avg;
 
-        let partition_size = f32(input_block.partition_pixel_counts[local_idx]);
+        let partition_size = f32(partitionInfos[partitioned.partition_table_idx].partition_texel_count[local_idx]);
         let rgba_sum = averages[local_idx] * partition_size * uniforms.channel_weights;
         let rgba_weight_sum = max(uniforms.channel_weights * partition_size, vec4<f32>(1e-17));
         scale_dirs[local_idx] = normalize(rgba_sum.xyz / rgba_weight_sum.xyz);
@@ -253,8 +157,8 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
     // Acumulate multiple properties per-partition
     for (var i = local_idx; i < di.texel_count; i += WORKGROUP_SIZE) {
 
-        let p = input_block.texel_partitions[i];
-        let rgba = input_block.pixels[i];
+        let p = partitionInfos[partitioned.partition_table_idx].partition_of_texel[i];
+        let rgba = decode_texel(input_block.pixels[i]);
         let weight = undec_weights[i];
 
         atomicMin_f32(&wmin1[p], weight);
@@ -345,7 +249,7 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
         if(wmin1_val >= wmax1_val * 0.999f) {
             // If all weights are equal set endpoints to average
 
-            let partition_size = f32(input_block.partition_pixel_counts[p]);
+            let partition_size = f32(partitionInfos[partitioned.partition_table_idx].partition_texel_count[p]);
             let rgba_weight_sum = max(uniforms.channel_weights * partition_size, vec4<f32>(1e-17));
             let avg_color = (color_x + color_y) / rgba_weight_sum;
 
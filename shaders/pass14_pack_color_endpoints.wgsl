@@ -1,7 +1,9 @@
-const BLOCK_MAX_PARTITIONS: u32 = 4u;
+#partition_variants 1 2 3 4
+#include "common/uniforms.wgsl"
+#include "common/endpoints.wgsl"
+#include "common/candidates.wgsl"
+
 const ERROR_CALC_DEFAULT: f32 = 1e37;
-const BLOCK_MAX_TEXELS: u32 = 144u;
-const BLOCK_MAX_WEIGHTS: u32 = 64u;
 
 const TUNE_MAX_TRIAL_CANDIDATES = 8u;
 
@@ -321,58 +323,6 @@ const COLOR_UNQUANT_TO_QUANT_TABLE = array<i32, 8704>(
 
 //------------------------------------------------------------------------------------------------
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct IdealEndpointsAndWeightsPartition {
-    avg: vec4<f32>,
-    dir: vec4<f32>,
-    endpoint0: vec4<f32>,
-    endpoint1: vec4<f32>,
-};
-
-
-struct FinalCandidate {
-    block_mode_index: u32,
-    block_mode_trial_index: u32,
-    total_error: f32,
-    quant_level: u32, // The original quant level
-    quant_level_mod: u32,
-
-    _padding1: u32,
-
-	color_formats_matched: u32,
-    final_quant_mode: u32, // The quant mode after checking the mod version
-
-    formats: vec4<u32>,
-    quantized_weights: array<u32, BLOCK_MAX_WEIGHTS>,
-    candidate_partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-
-	final_formats: vec4<u32>, //Formats can change after quantization
-    packed_color_values: array<u32, 32>, //8 integers per partition
-};
 
 struct PackedPartitionResult {
     values: array<u32, 8>,
@@ -1229,7 +1179,7 @@ fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
     let candidate_idx = block_idx * uniforms.tune_candidate_limit + global_id.y;
 
     let candidate = final_candidates[candidate_idx];
-    let partition_count = uniforms.partition_count;
+    let partition_count = PARTITION_COUNT;
 
     // 1. First Pass Pack (Using normal quant_level)
     var all_same = (candidate.quant_level != candidate.quant_level_mod);
@@ -1,6 +1,8 @@
-const BLOCK_MAX_PARTITIONS: u32 = 4u;
-const BLOCK_MAX_TEXELS: u32 = 144u;
-const BLOCK_MAX_WEIGHTS: u32 = 64u;
+#partition_variants 1 2 3 4
+#include "common/uniforms.wgsl"
+#include "common/endpoints.wgsl"
+#include "common/candidates.wgsl"
+
 
 const TUNE_MAX_TRIAL_CANDIDATES = 8u;
 
@@ -24,63 +26,6 @@ const FMT_HDR_RGBA = 15u;
 
 
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct IdealEndpointsAndWeightsPartition {
-    avg: vec4<f32>,
-    dir: vec4<f32>,
-    endpoint0: vec4<f32>,
-    endpoint1: vec4<f32>,
-};
-
-
-struct FinalCandidate {
-    block_mode_index: u32,
-    block_mode_trial_index: u32,
-    total_error: f32,
-    quant_level: u32, // The original quant level
-    quant_level_mod: u32,
-
-    _padding1: u32,
-
-	color_formats_matched: u32,
-    final_quant_mode: u32, // The quant mode after checking the mod version
-
-    formats: vec4<u32>,
-    quantized_weights: array<u32, BLOCK_MAX_WEIGHTS>,
-    candidate_partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-
-	final_formats: vec4<u32>, //Formats can change after quantization
-    packed_color_values: array<u32, 32>, //8 integers per partition
-};
-
-struct UnpackedEndpoints {
-    endpoint0: array<vec4<i32>, 4>,
-    endpoint1: array<vec4<i32>, 4>,
-}
 
 //--------------------------------------------------------------------------------------------------------
 
@@ -309,7 +254,7 @@ fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
 
     let block_idx = global_id.x;
     let candidate_idx = block_idx * uniforms.tune_candidate_limit + global_id.y;
-    let partition_count = uniforms.partition_count;
+    let partition_count = PARTITION_COUNT;
 
     let foramts = final_candidates[candidate_idx].final_formats;
     let packed_color_values = final_candidates[candidate_idx].packed_color_values;
@@ -1,7 +1,11 @@
+#partition_variants 1 2 3 4
+#include "common/uniforms.wgsl"
+#include "common/partitioned_blocks.wgsl"
+#include "common/decimation.wgsl"
+#include "common/endpoints.wgsl"
+#include "common/candidates.wgsl"
+
 const WORKGROUP_SIZE: u32 = 64u;
-const BLOCK_MAX_TEXELS: u32 = 144u;
-const BLOCK_MAX_WEIGHTS: u32 = 64u;
-const BLOCK_MAX_PARTITIONS: u32 = 4u;
 
 const TUNE_MAX_TRIAL_CANDIDATES = 8u;
 
@@ -73,121 +77,6 @@ const ALL_PREV_NEXT_VALUES = array<u32, 780>(
     0x403c,0,0x403e
 );
 
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct BlockMode {
-	mode_index : u32,
-    decimation_mode : u32,
-    quant_mode : u32,
-    weight_bits : u32,
-    is_dual_plane : u32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-    _padding3 : u32,
-};
-
-struct DecimationInfo {
-    texel_count : u32,
-    weight_count : u32,
-    weight_x : u32,
-    weight_y : u32,
-
-    max_quant_level : u32,
-    max_angular_steps : u32,
-    max_quant_steps: u32,
-    _padding: u32,
-
-    texel_weight_count : array<u32, BLOCK_MAX_TEXELS>,
-    texel_weights_offset : array<u32, BLOCK_MAX_TEXELS>,
-
-    weight_texel_count : array<u32, BLOCK_MAX_WEIGHTS>,
-    weight_texels_offset : array<u32, BLOCK_MAX_WEIGHTS>,
-};
-
-struct TexelToWeightMap {
-	weight_index : u32,
-	contribution : f32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct WeightToTexelMap {
-    texel_index : u32,
-	contribution : f32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct InputBlock {
-    pixels: array<vec4<f32>, BLOCK_MAX_TEXELS>,
-    texel_partitions: array<u32, BLOCK_MAX_TEXELS>,
-    partition_pixel_counts: array<u32, 4>,
-
-    partitioning_idx: u32,
-    grayscale: u32,
-    constant_alpha: u32,
-    padding: u32,
-};
-
-struct IdealEndpointsAndWeightsPartition {
-    avg: vec4<f32>,
-    dir: vec4<f32>,
-    endpoint0: vec4<f32>,
-    endpoint1: vec4<f32>,
-};
-
-struct UnpackedEndpoints {
-    endpoint0: array<vec4<i32>, 4>,
-    endpoint1: array<vec4<i32>, 4>,
-}
-
-struct FinalCandidate {
-    block_mode_index: u32,
-    block_mode_trial_index: u32,
-    total_error: f32,
-    quant_level: u32, // The original quant level
-    quant_level_mod: u32,
-
-    _padding1: u32,
-
-	color_formats_matched: u32,
-    final_quant_mode: u32, // The quant mode after checking the mod version
-
-    formats: vec4<u32>,
-    quantized_weights: array<u32, BLOCK_MAX_WEIGHTS>,
-    candidate_partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-
-	final_formats: vec4<u32>, //Formats can change after quantization
-    packed_color_values: array<u32, 32>, //8 integers per partition
-};
-
-
 
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
 @group(0) @binding(1) var<storage, read> block_modes: array<BlockMode>;
@@ -198,7 +87,8 @@ struct FinalCandidate {
 @group(0) @binding(6) var<storage, read> unpacked_endpoints: array<UnpackedEndpoints>;
 
 @group(0) @binding(7) var<storage, read_write> final_candidates: array<FinalCandidate>;
-
+@group(0) @binding(8) var<storage, read> partitioned_blocks: array<PartitionedBlock>;
+@group(0) @binding(9) var<storage, read> partitionInfos: array<PartitonInfo>;
 
 
 var<workgroup> uq_weightsf: array<f32, BLOCK_MAX_WEIGHTS>; 
@@ -207,7 +97,6 @@ var<workgroup> part_offsets: array<vec4<f32>, 4>;
 var<workgroup> part_bases: array<vec4<f32>, 4>;
 
 
-
 @compute @workgroup_size(WORKGROUP_SIZE)
 fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_index) local_idx: u32) {
 
@@ -216,8 +105,9 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
 
     let bm = block_modes[final_candidates[candidate_idx].block_mode_index];
     let di = decimation_infos[bm.decimation_mode];
-    let input_block = input_blocks[block_idx];
-    let partition_count = uniforms.partition_count;
+    let partitioned = partitioned_block(block_idx, PARTITION_COUNT);
+    let input_block = input_blocks[partitioned.source_block];
+    let partition_count = PARTITION_COUNT;
 
 
     //Unpack endpoints and pre-calculate offset vectors for all partitions.
@@ -260,12 +150,12 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
             let weight_down_diff = f32(uqw_down - uqw);
             let weight_up_diff = f32(uqw_up - uqw);
 
-            let p = input_block.texel_partitions[texel_idx];
+            let p = partitionInfos[partitioned.partition_table_idx].partition_of_texel[texel_idx];
             let color_offset = part_offsets[p];
             let color_base = part_bases[p];
             
             let color = color_base + color_offset * weight_base;
-            let orig_color = input_block.pixels[texel_idx];
+            let orig_color = decode_texel(input_block.pixels[texel_idx]);
             let error_weight = uniforms.channel_weights;
 
             let color_diff = color - orig_color;
@@ -332,12 +222,12 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
                 let weight_down_diff = uqw_diff_down * tw_base;
                 let weight_up_diff = uqw_diff_up * tw_base;
 
-                let p = input_block.texel_partitions[texel_idx];
+                let p = partitionInfos[partitioned.partition_table_idx].partition_of_texel[texel_idx];
                 let color_offset = part_offsets[p];
                 let color_base = part_bases[p];
 
                 let color = color_base + color_offset * weight_base;
-                let orig_color = input_block.pixels[texel_idx];
+                let orig_color = decode_texel(input_block.pixels[texel_idx]);
 
                 let color_diff = color - orig_color;
                 let color_diff_down = color_diff + color_offset * weight_down_diff;
@@ -1,119 +1,15 @@
+#partition_variants 1 2 3 4
+#include "common/uniforms.wgsl"
+#include "common/partitioned_blocks.wgsl"
+#include "common/decimation.wgsl"
+#include "common/endpoints.wgsl"
+#include "common/candidates.wgsl"
+#include "common/texel_capacity.wgsl"
+
 const WORKGROUP_SIZE: u32 = 64u;
-const BLOCK_MAX_TEXELS: u32 = 144u;
-const BLOCK_MAX_WEIGHTS: u32 = 64u;
-const BLOCK_MAX_PARTITIONS: u32 = 4u;
 const ERROR_CALC_DEFAULT: f32 = 1e37;
 
 
-
-struct UniformVariables {
-    xdim : u32,
-    ydim : u32,
-
-    texel_count : u32,
-
-    decimation_mode_count : u32,
-    block_mode_count : u32,
-
-    valid_decimation_mode_count: u32,
-	valid_block_mode_count: u32,
-
-    quant_limit : u32,
-    partition_count : u32,
-    tune_candidate_limit : u32,
-
-    _padding1: u32,
-    _padding2: u32,
-
-    channel_weights : vec4<f32>,
-
-    partitioning_count_selected : vec4<u32>,
-    partitioning_count_all : vec4<u32>,
-};
-
-struct BlockMode {
-	mode_index : u32,
-    decimation_mode : u32,
-    quant_mode : u32,
-    weight_bits : u32,
-    is_dual_plane : u32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-    _padding3 : u32,
-};
-
-struct DecimationInfo {
-    texel_count : u32,
-    weight_count : u32,
-    weight_x : u32,
-    weight_y : u32,
-
-    max_quant_level : u32,
-    max_angular_steps : u32,
-    max_quant_steps: u32,
-    _padding: u32,
-
-    texel_weight_count : array<u32, BLOCK_MAX_TEXELS>,
-    texel_weights_offset : array<u32, BLOCK_MAX_TEXELS>,
-
-    weight_texel_count : array<u32, BLOCK_MAX_WEIGHTS>,
-    weight_texels_offset : array<u32, BLOCK_MAX_WEIGHTS>,
-};
-
-struct TexelToWeightMap {
-	weight_index : u32,
-	contribution : f32,
-
-    _padding1 : u32,
-    _padding2 : u32,
-};
-
-struct InputBlock {
-    pixels: array<vec4<f32>, BLOCK_MAX_TEXELS>,
-    texel_partitions: array<u32, BLOCK_MAX_TEXELS>,
-    partition_pixel_counts: array<u32, 4>,
-
-    partitioning_idx: u32,
-    grayscale: u32,
-    constant_alpha: u32,
-    padding: u32,
-};
-
-struct IdealEndpointsAndWeightsPartition {
-    avg: vec4<f32>,
-    dir: vec4<f32>,
-    endpoint0: vec4<f32>,
-    endpoint1: vec4<f32>,
-};
-
-struct FinalCandidate {
-    block_mode_index: u32,
-    block_mode_trial_index: u32,
-    total_error: f32,
-    quant_level: u32, // The original quant level
-    quant_level_mod: u32,
-
-    _padding1: u32,
-
-	color_formats_matched: u32,
-    final_quant_mode: u32, // The quant mode after checking the mod version
-
-    formats: vec4<u32>,
-    quantized_weights: array<u32, BLOCK_MAX_WEIGHTS>,
-    candidate_partitions: array<IdealEndpointsAndWeightsPartition, 4>,
-
-	final_formats: vec4<u32>, //Formats can change after quantization
-    packed_color_values: array<u32, 32>, //8 integers per partition
-};
-
-struct UnpackedEndpoints {
-    endpoint0: array<vec4<i32>, 4>,
-    endpoint1: array<vec4<i32>, 4>,
-}
-
-
-
 @group(0) @binding(0) var<uniform> uniforms: UniformVariables;
 @group(0) @binding(1) var<storage, read> block_modes: array<BlockMode>;
 @group(0) @binding(2) var<storage, read> decimation_infos: array<DecimationInfo>;
@@ -123,11 +19,12 @@ struct UnpackedEndpoints {
 
 @group(0) @binding(6) var<storage, read_write> final_candidates: array<FinalCandidate>;
 @group(0) @binding(7) var<storage, read_write> top_candidates: array<FinalCandidate>;
-
+@group(0) @binding(8) var<storage, read> partitioned_blocks: array<PartitionedBlock>;
+@group(0) @binding(9) var<storage, read> partitionInfos: array<PartitonInfo>;
 
 
 var<workgroup> dec_weights: array<f32, BLOCK_MAX_WEIGHTS>;
-var<workgroup> undec_weights: array<f32, BLOCK_MAX_TEXELS>;
+var<workgroup> undec_weights: array<f32, TEXEL_CAPACITY>;
 var<workgroup> shared_total_error: atomic<u32>;
 
 
@@ -145,7 +42,6 @@ fn atomicAdd_f32(atomic_target: ptr<workgroup, atomic<u32>>, value_to_add: f32)
 }
 
 
-
 @compute @workgroup_size(WORKGROUP_SIZE)
 fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_index) local_idx: u32) {
 
@@ -154,9 +50,10 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
 
     let bm = block_modes[final_candidates[candidate_idx].block_mode_index];
     let di = decimation_infos[bm.decimation_mode];
-    let partition_count = uniforms.partition_count;
+    let partition_count = PARTITION_COUNT;
 
-    let input_block = input_blocks[block_idx];
+    let partitioned = partitioned_block(block_idx, PARTITION_COUNT);
+    let input_block = input_blocks[partitioned.source_block];
 
     let quantized_weights = final_candidates[candidate_idx].quantized_weights;
 
@@ -192,7 +89,7 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
 
     //sum error for all texels
     for (var i = local_idx; i < di.texel_count; i += WORKGROUP_SIZE) {
-        let p = input_block.texel_partitions[i];
+        let p = partitionInfos[partitioned.partition_table_idx].partition_of_texel[i];
         if (p < partition_count) {
 
             let endpoint0 = unpacked_endpoints[candidate_idx].endpoint0[p];
@@ -206,7 +103,7 @@ fn main(@builtin(workgroup_id) group_id: vec3<u32>, @builtin(local_invocation_in
             var color = (endpoint0 * weight0) + (endpoint1 * weight1) + vec4<i32>(32);
             color = color >> vec4<u32>(6);
 
-            var diff = input_block.pixels[i] - vec4<f32>(color);
+            var diff = decode_texel(input_block.pixels[i]) - vec4<f32>(color);
             diff = min(abs(diff), vec4<f32>(1e15f));
             
             let error = dot(diff * diff, uniforms.channel_weights);
@@ -0,0 +1,246 @@
+#include "common/uniforms.wgsl"
+#include "common/decimation.wgsl"
+#include "common/candidates.wgsl"
+
+const WEIGHTS_PLANE2_OFFSET: u32 = 32u;
+const PARTITION_INDEX_BITS: u32 = 10u;
+
+const QUANT_6: u32 = 4u;
+
+const WORKGROUP_SIZE: u32 = 64u;
+
+//Tables of physical_compression.cpp, widened to u32
+struct ISETables {
+    quant_levels: array<u32, 21>,
+    btq_counts: array<u32, 21>, //bits | trits << 8 | quints << 16
+    ise_sizes: array<u32, 21>, //scale | divisor << 8
+    integer_of_trits: array<u32, 243>, //indexed [i4][i3][i2][i1][i0]
+    integer_of_quints: array<u32, 125>, //indexed [i2][i1][i0]
+    weight_scramble_maps: array<u32, 384>, //indexed [quant_mode][value], 32 values per quant mode
+    color_scrambled_pquant: array<u32, 4352>, //indexed [quant_mode - QUANT_6][value], 256 values per quant mode
+};
+
+
+@group(0) @binding(0) var<uniform> uniforms: UniformVariables;
+@group(0) @binding(1) var<storage, read> symbolic_blocks: array<SymbolicBlock>;
+@group(0) @binding(2) var<storage, read> block_modes: array<BlockMode>;
+@group(0) @binding(3) var<storage, read> block_mode_index: array<u32>;
+@group(0) @binding(4) var<storage, read> decimation_infos: array<DecimationInfo>;
+@group(0) @binding(5) var<storage, read> ise_tables: ISETables;
+
+@group(0) @binding(6) var<storage, read_write> physical_blocks: array<vec4<u32>>;
+
+
+//Writes up to 24 bits at an arbitrary bit offset of a 128 bit block
+fn write_bits(bits: ptr<function, array<u32, 4>>, value: u32, bitcount: u32, bitoffset: u32) {
+    let mask = (1u << bitcount) - 1u;
+    let v = value & mask;
+
+    let word = bitoffset / 32u;
+    let shift = bitoffset % 32u;
+
+    (*bits)[word] = ((*bits)[word] & ~(mask << shift)) | (v << shift);
+
+    //the value spans two words, bits past the end of the block are dropped
+    if (shift + bitcount > 32u && word < 3u) {
+        let high_shift = 32u - shift;
+        (*bits)[word + 1u] = ((*bits)[word + 1u] & ~(mask >> high_shift)) | (v >> high_shift);
+    }
+}
+
+fn get_ise_sequence_bitcount(character_count: u32, quant_level: u32) -> u32 {
+    if (quant_level >= 21u) {
+        return 1024u;
+    }
+
+    let entry = ise_tables.ise_sizes[quant_level];
+    let scale = entry & 0xFFu;
+    let divisor = ((entry >> 8u) << 1u) + 1u;
+    return (scale * character_count + divisor - 1u) / divisor;
+}
+
+fn encode_ise(quant_level: u32, character_count: u32, input_data: ptr<function, array<u32, BLOCK_MAX_WEIGHTS>>, output_data: ptr<function, array<u32, 4>>, start_offset: u32) {
+
+    let btq = ise_tables.btq_counts[quant_level];
+    let bits = btq & 0xFFu;
+    let trits = (btq >> 8u) & 0xFFu;
+    let quints = (btq >> 16u) & 0xFFu;
+    let mask = (1u << bits) - 1u;
+
+    var bit_offset = start_offset;
+
+    // Write out trits and bits, 5 values share 8 trit bits
+    if (trits != 0u) {
+        var tbits = array<u32, 5>(2u, 2u, 1u, 2u, 1u);
+        var tshift = array<u32, 5>(0u, 2u, 4u, 5u, 7u);
+
+        for (var i = 0u; i < character_count; i += 5u) {
+            var t = array<u32, 5>(0u, 0u, 0u, 0u, 0u);
+            for (var j = 0u; j < 5u; j += 1u) {
+                if (i + j < character_count) {
+                    t[j] = (*input_data)[i + j] >> bits;
+                }
+            }
+
+            let T = ise_tables.integer_of_trits[(((t[4] * 3u + t[3]) * 3u + t[2]) * 3u + t[1]) * 3u + t[0]];
+
+            for (var j = 0u; j < 5u && i + j < character_count; j += 1u) {
+                let pack = ((*input_data)[i + j] & mask) | (((T >> tshift[j]) & ((1u << tbits[j]) - 1u)) << bits);
+                write_bits(output_data, pack, bits + tbits[j], bit_offset);
+                bit_offset += bits + tbits[j];
+            }
+        }
+    }
+    // Write out quints and bits, 3 values share 7 quint bits
+    else if (quints != 0u) {
+        var tbits = array<u32, 3>(3u, 2u, 2u);
+        var tshift = array<u32, 3>(0u, 3u, 5u);
+
+        for (var i = 0u; i < character_count; i += 3u) {
+            var q = array<u32, 3>(0u, 0u, 0u);
+            for (var j = 0u; j < 3u; j += 1u) {
+                if (i + j < character_count) {
+                    q[j] = (*input_data)[i + j] >> bits;
+                }
+            }
+
+            let T = ise_tables.integer_of_quints[(q[2] * 5u + q[1]) * 5u + q[0]];
+
+            for (var j = 0u; j < 3u && i + j < character_count; j += 1u) {
+                let pack = ((*input_data)[i + j] & mask) | (((T >> tshift[j]) & ((1u << tbits[j]) - 1u)) << bits);
+                write_bits(output_data, pack, bits + tbits[j], bit_offset);
+                bit_offset += bits + tbits[j];
+            }
+        }
+    }
+    // Write out just bits
+    else {
+        for (var i = 0u; i < character_count; i += 1u) {
+            write_bits(output_data, (*input_data)[i], bits, bit_offset);
+            bit_offset += bits;
+        }
+    }
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn main(@builtin(global_invocation_id) global_id: vec3<u32>) {
+
+    let block_idx = global_id.x;
+    if (block_idx >= uniforms.batch_block_count) {
+        return;
+    }
+
+    let scb = symbolic_blocks[block_idx];
+    let partition_count = scb.partition_count;
+
+    let bm = block_modes[block_mode_index[scb.block_mode_index]];
+    let weight_count = decimation_infos[bm.decimation_mode].weight_count;
+    let weight_quant_method = bm.quant_mode;
+    let weight_quant_levels = f32(ise_tables.quant_levels[weight_quant_method]);
+    let is_dual_plane = (bm.is_dual_plane & 1u) != 0u;
+
+    var real_weight_count = weight_count;
+    if (is_dual_plane) {
+        real_weight_count = 2u * weight_count;
+    }
+
+    let bits_for_weights = get_ise_sequence_bitcount(real_weight_count, weight_quant_method);
+
+    //compress weights
+    //encoded as an ordinary integer sequence and then bit-reversed
+    var weights: array<u32, BLOCK_MAX_WEIGHTS>;
+    if (is_dual_plane) {
+        for (var i = 0u; i < weight_count; i += 1u) {
+            let qw0 = u32(f32(scb.quantized_weights[i]) * (1.0 / 64.0) * (weight_quant_levels - 1.0) + 0.5);
+            let qw1 = u32(f32(scb.quantized_weights[i + WEIGHTS_PLANE2_OFFSET]) * (1.0 / 64.0) * (weight_quant_levels - 1.0) + 0.5);
+            weights[2u * i] = ise_tables.weight_scramble_maps[weight_quant_method * 32u + qw0];
+            weights[2u * i + 1u] = ise_tables.weight_scramble_maps[weight_quant_method * 32u + qw1];
+        }
+    }
+    else {
+        for (var i = 0u; i < weight_count; i += 1u) {
+            let qw = u32(f32(scb.quantized_weights[i]) * (1.0 / 64.0) * (weight_quant_levels - 1.0) + 0.5);
+            weights[i] = ise_tables.weight_scramble_maps[weight_quant_method * 32u + qw];
+        }
+    }
+
+    var weightbuf = array<u32, 4>(0u, 0u, 0u, 0u);
+    encode_ise(weight_quant_method, real_weight_count, &weights, &weightbuf, 0u);
+
+    //reversing the whole 128 bits reverses the byte order and the bits of every byte
+    var pcb: array<u32, 4>;
+    for (var i = 0u; i < 4u; i += 1u) {
+        pcb[i] = reverseBits(weightbuf[3u - i]);
+    }
+
+    write_bits(&pcb, scb.block_mode_index, 11u, 0u);
+    write_bits(&pcb, partition_count - 1u, 2u, 11u);
+
+    if (partition_count > 1u) {
+        write_bits(&pcb, scb.partition_index, 6u, 13u);
+        write_bits(&pcb, scb.partition_index >> 6u, PARTITION_INDEX_BITS - 6u, 19u);
+
+        if (scb.partition_formats_matched != 0u) {
+            write_bits(&pcb, scb.partition_formats[0] << 2u, 6u, 13u + PARTITION_INDEX_BITS);
+        }
+        else {
+            // Check endpoint types for each partition to determine the lowest class present
+            var low_class = 4u;
+            for (var i = 0u; i < partition_count; i += 1u) {
+                low_class = min(scb.partition_formats[i] >> 2u, low_class);
+            }
+
+            if (low_class == 3u) {
+                low_class = 2u;
+            }
+
+            var encoded_type = low_class + 1u;
+            var bitpos = 2u;
+
+            for (var i = 0u; i < partition_count; i += 1u) {
+                let classbit_of_format = (scb.partition_formats[i] >> 2u) - low_class;
+                encoded_type |= classbit_of_format << bitpos;
+                bitpos += 1u;
+            }
+
+            for (var i = 0u; i < partition_count; i += 1u) {
+                let lowbits_of_format = scb.partition_formats[i] & 3u;
+                encoded_type |= lowbits_of_format << bitpos;
+                bitpos += 2u;
+            }
+
+            let encoded_type_lowpart = encoded_type & 0x3Fu;
+            let encoded_type_highpart = encoded_type >> 6u;
+            let encoded_type_highpart_size = (3u * partition_count) - 4u;
+            let encoded_type_highpart_pos = 128u - bits_for_weights - encoded_type_highpart_size;
+            write_bits(&pcb, encoded_type_lowpart, 6u, 13u + PARTITION_INDEX_BITS);
+            write_bits(&pcb, encoded_type_highpart, encoded_type_highpart_size, encoded_type_highpart_pos);
+        }
+    }
+    else {
+        write_bits(&pcb, scb.partition_formats[0], 4u, 13u);
+    }
+
+    // Encode the color components
+    var values_to_encode: array<u32, BLOCK_MAX_WEIGHTS>;
+    var valuecount_to_encode = 0u;
+
+    let pack_table_offset = (scb.quant_mode - QUANT_6) * 256u;
+    for (var i = 0u; i < partition_count; i += 1u) {
+        let vals = 2u * (scb.partition_formats[i] >> 2u) + 2u;
+
+        for (var j = 0u; j < vals; j += 1u) {
+            values_to_encode[j + valuecount_to_encode] = ise_tables.color_scrambled_pquant[pack_table_offset + scb.packed_color_values[i * 8u + j]];
+        }
+        valuecount_to_encode += vals;
+    }
+
+    var color_offset = 17u;
+    if (partition_count > 1u) {
+        color_offset = 19u + PARTITION_INDEX_BITS;
+    }
+
+    encode_ise(scb.quant_mode, valuecount_to_encode, &values_to_encode, &pcb, color_offset);
+
+    physical_blocks[block_idx] = vec4<u32>(pcb[0], pcb[1], pcb[2], pcb[3]);
+}
@@ -0,0 +1,720 @@
+#include "astc_decoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//quantization ranges of the ISE alphabets, from 2 to 256 levels (the order of the block mode quant field)
+static const unsigned int QUANT_RANGE_COUNT = 21;
+static const unsigned int QUANT_BITS[QUANT_RANGE_COUNT] = { 1, 0, 2, 0, 1, 3, 1, 2, 4, 2, 3, 5, 3, 4, 6, 4, 5, 7, 5, 6, 8 };
+static const unsigned int QUANT_TRITS[QUANT_RANGE_COUNT] = { 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0 };
+static const unsigned int QUANT_QUINTS[QUANT_RANGE_COUNT] = { 0, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0 };
+
+//color endpoints use the ranges from 6 levels up
+static const unsigned int COLOR_QUANT_MIN_RANGE = 4;
+
+static const uint8_t ERROR_COLOR[4] = { 255, 0, 255, 255 };
+
+/**
+ * @brief Reads bits of a block, bits past the end of the field (limit) read as 0.
+ */
+struct BitReader {
+	const uint8_t* data;
+	unsigned int position;
+	unsigned int limit;
+
+	unsigned int read(unsigned int count) {
+		unsigned int value = 0;
+		for (unsigned int i = 0; i < count; i++, position++) {
+			if (position < limit) {
+				value |= ((data[position >> 3] >> (position & 7)) & 1u) << i;
+			}
+		}
+		return value;
+	}
+};
+
+static unsigned int read_bits(const uint8_t* data, unsigned int offset, unsigned int count) {
+	BitReader reader = { data, offset, 128 };
+	return reader.read(count);
+}
+
+static unsigned int ise_bitcount(unsigned int range, unsigned int count) {
+	return QUANT_BITS[range] * count + (QUANT_TRITS[range] ? (8 * count + 4) / 5 : 0) + (QUANT_QUINTS[range] ? (7 * count + 2) / 3 : 0);
+}
+
+static void decode_trits(unsigned int T, unsigned int trits[5]) {
+	unsigned int C;
+	if (((T >> 2) & 7) == 7) {
+		C = (((T >> 5) & 7) << 2) | (T & 3);
+		trits[4] = 2;
+		trits[3] = 2;
+	}
+	else {
+		C = T & 0x1F;
+		if (((T >> 5) & 3) == 3) {
+			trits[4] = 2;
+			trits[3] = (T >> 7) & 1;
+		}
+		else {
+			trits[4] = (T >> 7) & 1;
+			trits[3] = (T >> 5) & 3;
+		}
+	}
+
+	if ((C & 3) == 3) {
+		trits[2] = 2;
+		trits[1] = (C >> 4) & 1;
+		trits[0] = (((C >> 3) & 1) << 1) | (((C >> 2) & 1) & ~((C >> 3) & 1));
+	}
+	else if (((C >> 2) & 3) == 3) {
+		trits[2] = 2;
+		trits[1] = 2;
+		trits[0] = C & 3;
+	}
+	else {
+		trits[2] = (C >> 4) & 1;
+		trits[1] = (C >> 2) & 3;
+		trits[0] = (((C >> 1) & 1) << 1) | ((C & 1) & ~((C >> 1) & 1));
+	}
+}
+
+static void decode_quints(unsigned int Q, unsigned int quints[3]) {
+	if (((Q >> 1) & 3) == 3 && ((Q >> 5) & 3) == 0) {
+		unsigned int q0 = Q & 1;
+		quints[2] = (q0 << 2) | ((((Q >> 4) & 1) & ~q0 & 1) << 1) | (((Q >> 3) & 1) & ~q0 & 1);
+		quints[1] = 4;
+		quints[0] = 4;
+		return;
+	}
+
+	unsigned int C;
+	if (((Q >> 1) & 3) == 3) {
+		quints[2] = 4;
+		C = (((Q >> 3) & 3) << 3) | ((~(Q >> 5) & 3) << 1) | (Q & 1);
+	}
+	else {
+		quints[2] = (Q >> 5) & 3;
+		C = Q & 0x1F;
+	}
+
+	if ((C & 7) == 5) {
+		quints[1] = 4;
+		quints[0] = (C >> 3) & 3;
+	}
+	else {
+		quints[1] = (C >> 3) & 3;
+		quints[0] = C & 7;
+	}
+}
+
+//integer sequence decoding of count values of a range, starting at a bit of data
+static void decode_ise(unsigned int range, unsigned int count, const uint8_t* data, unsigned int offset, unsigned int* values) {
+	unsigned int bits = QUANT_BITS[range];
+	BitReader reader = { data, offset, offset + ise_bitcount(range, count) };
+
+	if (QUANT_TRITS[range]) {
+		//blocks of 5 values, the 8 bits of the packed trits are spread between the low bits
+		static const unsigned int TRIT_BITS[5] = { 2, 2, 1, 2, 1 };
+		for (unsigned int i = 0; i < count; i += 5) {
+			unsigned int low[5];
+			unsigned int T = 0;
+			unsigned int shift = 0;
+			for (unsigned int j = 0; j < 5; j++) {
+				low[j] = reader.read(bits);
+				T |= reader.read(TRIT_BITS[j]) << shift;
+				shift += TRIT_BITS[j];
+			}
+
+			unsigned int trits[5];
+			decode_trits(T, trits);
+			for (unsigned int j = 0; j < 5 && i + j < count; j++) {
+				values[i + j] = (trits[j] << bits) | low[j];
+			}
+		}
+	}
+	else if (QUANT_QUINTS[range]) {
+		//blocks of 3 values with 7 bits of packed quints
+		static const unsigned int QUINT_BITS[3] = { 3, 2, 2 };
+		for (unsigned int i = 0; i < count; i += 3) {
+			unsigned int low[3];
+			unsigned int Q = 0;
+			unsigned int shift = 0;
+			for (unsigned int j = 0; j < 3; j++) {
+				low[j] = reader.read(bits);
+				Q |= reader.read(QUINT_BITS[j]) << shift;
+				shift += QUINT_BITS[j];
+			}
+
+			unsigned int quints[3];
+			decode_quints(Q, quints);
+			for (unsigned int j = 0; j < 3 && i + j < count; j++) {
+				values[i + j] = (quints[j] << bits) | low[j];
+			}
+		}
+	}
+	else {
+		for (unsigned int i = 0; i < count; i++) {
+			values[i] = reader.read(bits);
+		}
+	}
+}
+
+//repeats the bits of value until they fill to bits (the top bits of value end up at the bottom)
+static unsigned int replicate_bits(unsigned int value, unsigned int bits, unsigned int to) {
+	unsigned int result = 0;
+	int shift = static_cast<int>(to) - static_cast<int>(bits);
+	while (shift > -static_cast<int>(bits)) {
+		result |= shift >= 0 ? value << shift : value >> -shift;
+		shift -= bits;
+	}
+	return result & ((1u << to) - 1);
+}
+
+//weights unquantized to 0..64
+static unsigned int unquantize_weight(unsigned int range, unsigned int value) {
+	unsigned int bits = QUANT_BITS[range];
+
+	if (!QUANT_TRITS[range] && !QUANT_QUINTS[range]) {
+		unsigned int result = replicate_bits(value, bits, 6);
+		return result > 32 ? result + 1 : result;
+	}
+
+	if (bits == 0) {
+		return QUANT_TRITS[range] ? value * 32 : value * 16;
+	}
+
+	unsigned int low = value & ((1u << bits) - 1);
+	unsigned int D = value >> bits;
+	unsigned int A = (low & 1) ? 0x7F : 0;
+	unsigned int b = (low >> 1) & 1;
+	unsigned int c = (low >> 2) & 1;
+	unsigned int B = 0;
+	unsigned int C = 0;
+
+	if (QUANT_TRITS[range]) {
+		switch (bits) {
+		case 1: C = 50; break;
+		case 2: C = 23; B = b * 0x45; break;
+		case 3: C = 11; B = c * 0x42 + b * 0x21; break;
+		}
+	}
+	else {
+		switch (bits) {
+		case 1: C = 28; break;
+		case 2: C = 13; B = b * 0x43; break;
+		}
+	}
+
+	unsigned int T = (D * C + B) ^ A;
+	T = (A & 0x20) | (T >> 2);
+	return T > 32 ? T + 1 : T;
+}
+
+//color endpoint values unquantized to 0..255
+static unsigned int unquantize_color(unsigned int range, unsigned int value) {
+	unsigned int bits = QUANT_BITS[range];
+
+	if (!QUANT_TRITS[range] && !QUANT_QUINTS[range]) {
+		return replicate_bits(value, bits, 8);
+	}
+
+	unsigned int low = value & ((1u << bits) - 1);
+	unsigned int D = value >> bits;
+	unsigned int A = (low & 1) ? 0x1FF : 0;
+	unsigned int b = (low >> 1) & 1;
+	unsigned int c = (low >> 2) & 1;
+	unsigned int d = (low >> 3) & 1;
+	unsigned int e = (low >> 4) & 1;
+	unsigned int f = (low >> 5) & 1;
+	unsigned int B = 0;
+	unsigned int C = 0;
+
+	if (QUANT_TRITS[range]) {
+		switch (bits) {
+		case 1: C = 204; break;
+		case 2: C = 93; B = b * 0x116; break;
+		case 3: C = 44; B = c * 0x10A + b * 0x85; break;
+		case 4: C = 22; B = d * 0x104 + c * 0x82 + b * 0x41; break;
+		case 5: C = 11; B = e * 0x102 + d * 0x81 + c * 0x40 + b * 0x20; break;
+		case 6: C = 5; B = f * 0x101 + e * 0x80 + d * 0x40 + c * 0x20 + b * 0x10; break;
+		}
+	}
+	else {
+		switch (bits) {
+		case 1: C = 113; break;
+		case 2: C = 54; B = b * 0x10C; break;
+		case 3: C = 26; B = c * 0x105 + b * 0x82; break;
+		case 4: C = 13; B = d * 0x102 + c * 0x81 + b * 0x40; break;
+		case 5: C = 6; B = e * 0x101 + d * 0x80 + c * 0x40 + b * 0x20; break;
+		}
+	}
+
+	unsigned int T = (D * C + B) ^ A;
+	return (A & 0x80) | (T >> 2);
+}
+
+static bool decode_block_mode(
+	unsigned int mode,
+	unsigned int& x_weights,
+	unsigned int& y_weights,
+	bool& dual_plane,
+	unsigned int& weight_range
+) {
+	unsigned int R = (mode >> 4) & 1;
+	unsigned int H = (mode >> 9) & 1;
+	unsigned int D = (mode >> 10) & 1;
+	unsigned int A = (mode >> 5) & 3;
+
+	if ((mode & 3) != 0) {
+		R |= (mode & 3) << 1;
+		unsigned int B = (mode >> 7) & 3;
+		switch ((mode >> 2) & 3) {
+		case 0: x_weights = B + 4; y_weights = A + 2; break;
+		case 1: x_weights = B + 8; y_weights = A + 2; break;
+		case 2: x_weights = A + 2; y_weights = B + 8; break;
+		default:
+			B &= 1;
+			if (mode & 0x100) {
+				x_weights = B + 2;
+				y_weights = A + 2;
+			}
+			else {
+				x_weights = A + 2;
+				y_weights = B + 6;
+			}
+			break;
+		}
+	}
+	else {
+		R |= ((mode >> 2) & 3) << 1;
+		if (((mode >> 2) & 3) == 0) {
+			return false;
+		}
+
+		unsigned int B = (mode >> 9) & 3;
+		switch ((mode >> 7) & 3) {
+		case 0: x_weights = 12; y_weights = A + 2; break;
+		case 1: x_weights = A + 2; y_weights = 12; break;
+		case 2: x_weights = A + 6; y_weights = B + 6; D = 0; H = 0; break;
+		default:
+			switch (A) {
+			case 0: x_weights = 6; y_weights = 10; break;
+			case 1: x_weights = 10; y_weights = 6; break;
+			default: return false;
+			}
+			break;
+		}
+	}
+
+	dual_plane = D != 0;
+	weight_range = (R - 2) + 6 * H;
+
+	unsigned int weight_count = x_weights * y_weights * (dual_plane ? 2 : 1);
+	unsigned int weight_bits = ise_bitcount(weight_range, weight_count);
+	return weight_count <= 64 && weight_bits >= 24 && weight_bits <= 96;
+}
+
+static uint32_t hash52(uint32_t inp) {
+	inp ^= inp >> 15;
+	inp *= 0xEEDE0891;
+	inp ^= inp >> 5;
+	inp += inp << 16;
+	inp ^= inp >> 7;
+	inp ^= inp >> 3;
+	inp ^= inp << 6;
+	inp ^= inp >> 17;
+	return inp;
+}
+
+static unsigned int select_partition(int seed, int x, int y, int partition_count, bool small_block) {
+	if (small_block) {
+		x <<= 1;
+		y <<= 1;
+	}
+
+	seed += (partition_count - 1) * 1024;
+	uint32_t rnum = hash52(seed);
+
+	unsigned int seeds[8];
+	for (unsigned int i = 0; i < 8; i++) {
+		seeds[i] = (rnum >> (4 * i)) & 0xF;
+		seeds[i] *= seeds[i];
+	}
+
+	int sh1, sh2;
+	if (seed & 1) {
+		sh1 = (seed & 2) ? 4 : 5;
+		sh2 = partition_count == 3 ? 6 : 5;
+	}
+	else {
+		sh1 = partition_count == 3 ? 6 : 5;
+		sh2 = (seed & 2) ? 4 : 5;
+	}
+
+	for (unsigned int i = 0; i < 8; i++) {
+		seeds[i] >>= (i & 1) ? sh2 : sh1;
+	}
+
+	//the z seeds drop out for 2D blocks
+	int a = (seeds[0] * x + seeds[1] * y + (rnum >> 14)) & 0x3F;
+	int b = (seeds[2] * x + seeds[3] * y + (rnum >> 10)) & 0x3F;
+	int c = (seeds[4] * x + seeds[5] * y + (rnum >> 6)) & 0x3F;
+	int d = (seeds[6] * x + seeds[7] * y + (rnum >> 2)) & 0x3F;
+
+	if (partition_count <= 3) d = 0;
+	if (partition_count <= 2) c = 0;
+	if (partition_count <= 1) b = 0;
+
+	if (a >= b && a >= c && a >= d) return 0;
+	if (b >= c && b >= d) return 1;
+	if (c >= d) return 2;
+	return 3;
+}
+
+static void bit_transfer_signed(int& a, int& b) {
+	b >>= 1;
+	b |= a & 0x80;
+	a >>= 1;
+	a &= 0x3F;
+	if (a & 0x20) {
+		a -= 0x40;
+	}
+}
+
+static void blue_contract(int color[4]) {
+	color[0] = (color[0] + color[2]) >> 1;
+	color[1] = (color[1] + color[2]) >> 1;
+}
+
+//LDR endpoints of a color endpoint mode, false for the HDR modes
+static bool decode_endpoints(unsigned int cem, const unsigned int* values, int e0[4], int e1[4]) {
+	int v[8];
+	for (unsigned int i = 0; i < ((cem >> 2) + 1) * 2; i++) {
+		v[i] = static_cast<int>(values[i]);
+	}
+
+	switch (cem) {
+	case 0: //luminance
+		e0[0] = e0[1] = e0[2] = v[0]; e0[3] = 255;
+		e1[0] = e1[1] = e1[2] = v[1]; e1[3] = 255;
+		break;
+	case 1: { //luminance, base and offset
+		int l0 = (v[0] >> 2) | (v[1] & 0xC0);
+		int l1 = std::min(l0 + (v[1] & 0x3F), 255);
+		e0[0] = e0[1] = e0[2] = l0; e0[3] = 255;
+		e1[0] = e1[1] = e1[2] = l1; e1[3] = 255;
+		break;
+	}
+	case 4: //luminance and alpha
+		e0[0] = e0[1] = e0[2] = v[0]; e0[3] = v[2];
+		e1[0] = e1[1] = e1[2] = v[1]; e1[3] = v[3];
+		break;
+	case 5: //luminance and alpha, base and offset
+		bit_transfer_signed(v[1], v[0]);
+		bit_transfer_signed(v[3], v[2]);
+		e0[0] = e0[1] = e0[2] = v[0]; e0[3] = v[2];
+		e1[0] = e1[1] = e1[2] = v[0] + v[1]; e1[3] = v[2] + v[3];
+		break;
+	case 6: //rgb, base and scale
+		e0[0] = (v[0] * v[3]) >> 8; e0[1] = (v[1] * v[3]) >> 8; e0[2] = (v[2] * v[3]) >> 8; e0[3] = 255;
+		e1[0] = v[0]; e1[1] = v[1]; e1[2] = v[2]; e1[3] = 255;
+		break;
+	case 8: //rgb
+	case 12: { //rgba
+		int a0 = cem == 12 ? v[6] : 255;
+		int a1 = cem == 12 ? v[7] : 255;
+		if (v[1] + v[3] + v[5] >= v[0] + v[2] + v[4]) {
+			e0[0] = v[0]; e0[1] = v[2]; e0[2] = v[4]; e0[3] = a0;
+			e1[0] = v[1]; e1[1] = v[3]; e1[2] = v[5]; e1[3] = a1;
+		}
+		else {
+			e0[0] = v[1]; e0[1] = v[3]; e0[2] = v[5]; e0[3] = a1;
+			e1[0] = v[0]; e1[1] = v[2]; e1[2] = v[4]; e1[3] = a0;
+			blue_contract(e0);
+			blue_contract(e1);
+		}
+		break;
+	}
+	case 9: //rgb, base and offset
+	case 13: { //rgba, base and offset
+		bit_transfer_signed(v[1], v[0]);
+		bit_transfer_signed(v[3], v[2]);
+		bit_transfer_signed(v[5], v[4]);
+		int a0 = 255;
+		int a1 = 255;
+		if (cem == 13) {
+			bit_transfer_signed(v[7], v[6]);
+			a0 = v[6];
+			a1 = v[6] + v[7];
+		}
+
+		if (v[1] + v[3] + v[5] >= 0) {
+			e0[0] = v[0]; e0[1] = v[2]; e0[2] = v[4]; e0[3] = a0;
+			e1[0] = v[0] + v[1]; e1[1] = v[2] + v[3]; e1[2] = v[4] + v[5]; e1[3] = a1;
+		}
+		else {
+			e0[0] = v[0] + v[1]; e0[1] = v[2] + v[3]; e0[2] = v[4] + v[5]; e0[3] = a1;
+			e1[0] = v[0]; e1[1] = v[2]; e1[2] = v[4]; e1[3] = a0;
+			blue_contract(e0);
+			blue_contract(e1);
+		}
+		break;
+	}
+	case 10: //rgb, base and scale, and two alphas
+		e0[0] = (v[0] * v[3]) >> 8; e0[1] = (v[1] * v[3]) >> 8; e0[2] = (v[2] * v[3]) >> 8; e0[3] = v[4];
+		e1[0] = v[0]; e1[1] = v[1]; e1[2] = v[2]; e1[3] = v[5];
+		break;
+	default: //HDR modes
+		return false;
+	}
+
+	for (unsigned int c = 0; c < 4; c++) {
+		e0[c] = std::clamp(e0[c], 0, 255);
+		e1[c] = std::clamp(e1[c], 0, 255);
+	}
+	return true;
+}
+
+//UNORM16 to 8 bits, rounded
+static uint8_t unorm16_to_unorm8(unsigned int value) {
+	return static_cast<uint8_t>((value * 255 + 32767) / 65535);
+}
+
+static void fill_error_color(unsigned int texel_count, uint8_t* texels) {
+	for (unsigned int i = 0; i < texel_count; i++) {
+		memcpy(texels + i * 4, ERROR_COLOR, 4);
+	}
+}
+
+bool decode_astc_block(const uint8_t block[16], unsigned int block_x, unsigned int block_y, uint8_t* texels) {
+	unsigned int texel_count = block_x * block_y;
+	unsigned int mode = read_bits(block, 0, 11);
+
+	//void extent: a constant color block
+	if ((mode & 0x1FF) == 0x1FC) {
+		if (mode & 0x200) {
+			fill_error_color(texel_count, texels); //HDR
+			return false;
+		}
+
+		uint8_t color[4];
+		for (unsigned int c = 0; c < 4; c++) {
+			color[c] = unorm16_to_unorm8(read_bits(block, 64 + 16 * c, 16));
+		}
+		for (unsigned int i = 0; i < texel_count; i++) {
+			memcpy(texels + i * 4, color, 4);
+		}
+		return true;
+	}
+
+	unsigned int x_weights, y_weights, weight_range;
+	bool dual_plane;
+	if (!decode_block_mode(mode, x_weights, y_weights, dual_plane, weight_range) || x_weights > block_x || y_weights > block_y) {
+		fill_error_color(texel_count, texels);
+		return false;
+	}
+
+	unsigned int partition_count = read_bits(block, 11, 2) + 1;
+	if (dual_plane && partition_count == 4) {
+		fill_error_color(texel_count, texels);
+		return false;
+	}
+
+	unsigned int weight_count = x_weights * y_weights * (dual_plane ? 2 : 1);
+	unsigned int weight_bits = ise_bitcount(weight_range, weight_count);
+
+	//color endpoint modes, for several partitions partly stored below the weights
+	unsigned int cems[4] = {};
+	unsigned int partition_seed = 0;
+	unsigned int color_start;
+	unsigned int extra_cem_bits = 0;
+
+	if (partition_count == 1) {
+		cems[0] = read_bits(block, 13, 4);
+		color_start = 17;
+	}
+	else {
+		partition_seed = read_bits(block, 13, 10);
+		unsigned int encoded = read_bits(block, 23, 6);
+		color_start = 29;
+
+		if ((encoded & 3) == 0) {
+			for (unsigned int p = 0; p < partition_count; p++) {
+				cems[p] = encoded >> 2;
+			}
+		}
+		else {
+			extra_cem_bits = 3 * partition_count - 4;
+			encoded |= read_bits(block, 128 - weight_bits - extra_cem_bits, extra_cem_bits) << 6;
+
+			unsigned int base_class = (encoded & 3) - 1;
+			for (unsigned int p = 0; p < partition_count; p++) {
+				unsigned int class_offset = (encoded >> (2 + p)) & 1;
+				unsigned int low = (encoded >> (2 + partition_count + 2 * p)) & 3;
+				cems[p] = ((base_class + class_offset) << 2) | low;
+			}
+		}
+	}
+
+	unsigned int below_weights = 128 - weight_bits - extra_cem_bits;
+	unsigned int plane2_component = 0;
+	if (dual_plane) {
+		below_weights -= 2;
+		plane2_component = read_bits(block, below_weights, 2);
+	}
+
+	unsigned int color_value_count = 0;
+	for (unsigned int p = 0; p < partition_count; p++) {
+		color_value_count += ((cems[p] >> 2) + 1) * 2;
+	}
+
+	if (color_value_count > 18 || below_weights <= color_start) {
+		fill_error_color(texel_count, texels);
+		return false;
+	}
+
+	//the color values use the largest range that fits into the remaining bits
+	unsigned int color_bits = below_weights - color_start;
+	int color_range = -1;
+	for (int range = QUANT_RANGE_COUNT - 1; range >= static_cast<int>(COLOR_QUANT_MIN_RANGE); range--) {
+		if (ise_bitcount(range, color_value_count) <= color_bits) {
+			color_range = range;
+			break;
+		}
+	}
+	if (color_range < 0) {
+		fill_error_color(texel_count, texels);
+		return false;
+	}
+
+	unsigned int color_values[18];
+	decode_ise(color_range, color_value_count, block, color_start, color_values);
+	for (unsigned int i = 0; i < color_value_count; i++) {
+		color_values[i] = unquantize_color(color_range, color_values[i]);
+	}
+
+	int endpoints[4][2][4];
+	unsigned int value_index = 0;
+	for (unsigned int p = 0; p < partition_count; p++) {
+		if (!decode_endpoints(cems[p], color_values + value_index, endpoints[p][0], endpoints[p][1])) {
+			fill_error_color(texel_count, texels);
+			return false;
+		}
+		value_index += ((cems[p] >> 2) + 1) * 2;
+	}
+
+	//the weights are stored from the top of the block down, so they are read from the bit reversed block
+	uint8_t reversed[16];
+	for (unsigned int i = 0; i < 16; i++) {
+		uint8_t value = block[15 - i];
+		uint8_t result = 0;
+		for (unsigned int bit = 0; bit < 8; bit++) {
+			result |= ((value >> bit) & 1) << (7 - bit);
+		}
+		reversed[i] = result;
+	}
+
+	unsigned int weights[64];
+	decode_ise(weight_range, weight_count, reversed, 0, weights);
+	for (unsigned int i = 0; i < weight_count; i++) {
+		weights[i] = unquantize_weight(weight_range, weights[i]);
+	}
+
+	//bilinear infill of the weight grid to the texels
+	unsigned int planes = dual_plane ? 2 : 1;
+	unsigned int ds = (1024 + block_x / 2) / (block_x - 1);
+	unsigned int dt = (1024 + block_y / 2) / (block_y - 1);
+	bool small_block = texel_count < 32;
+
+	for (unsigned int t = 0; t < block_y; t++) {
+		for (unsigned int s = 0; s < block_x; s++) {
+			unsigned int gs = (ds * s * (x_weights - 1) + 32) >> 6;
+			unsigned int gt = (dt * t * (y_weights - 1) + 32) >> 6;
+			unsigned int js = gs >> 4;
+			unsigned int fs = gs & 0xF;
+			unsigned int jt = gt >> 4;
+			unsigned int ft = gt & 0xF;
+
+			unsigned int w11 = (fs * ft + 8) >> 4;
+			unsigned int w10 = ft - w11;
+			unsigned int w01 = fs - w11;
+			unsigned int w00 = 16 - fs - ft + w11;
+
+			unsigned int v0 = js + jt * x_weights;
+			unsigned int texel_weights[2];
+			for (unsigned int plane = 0; plane < planes; plane++) {
+				//grid points past the edge have a zero factor
+				auto weight = [&](unsigned int index) {
+					return index < x_weights * y_weights ? weights[index * planes + plane] : 0u;
+				};
+				texel_weights[plane] = (weight(v0) * w00 + weight(v0 + 1) * w01 + weight(v0 + x_weights) * w10 + weight(v0 + x_weights + 1) * w11 + 8) >> 4;
+			}
+
+			unsigned int partition = partition_count > 1 ? select_partition(partition_seed, s, t, partition_count, small_block) : 0;
+			const int* e0 = endpoints[partition][0];
+			const int* e1 = endpoints[partition][1];
+
+			uint8_t* texel = texels + (t * block_x + s) * 4;
+			for (unsigned int c = 0; c < 4; c++) {
+				unsigned int w = dual_plane && c == plane2_component ? texel_weights[1] : texel_weights[0];
+				unsigned int c0 = static_cast<unsigned int>(e0[c]) * 257;
+				unsigned int c1 = static_cast<unsigned int>(e1[c]) * 257;
+				texel[c] = unorm16_to_unorm8((c0 * (64 - w) + c1 * w + 32) >> 6);
+			}
+		}
+	}
+
+	return true;
+}
+
+uint64_t decode_astc_image(
+	const uint8_t* blocks,
+	unsigned int block_x,
+	unsigned int block_y,
+	unsigned int width,
+	unsigned int height,
+	uint8_t* pixels
+) {
+	unsigned int blocks_x = (width + block_x - 1) / block_x;
+	unsigned int blocks_y = (height + block_y - 1) / block_y;
+
+	uint64_t error_blocks = 0;
+	std::vector<uint8_t> texels(block_x * block_y * 4);
+
+	for (unsigned int by = 0; by < blocks_y; by++) {
+		for (unsigned int bx = 0; bx < blocks_x; bx++) {
+			const uint8_t* block = blocks + ((uint64_t)by * blocks_x + bx) * 16;
+			if (!decode_astc_block(block, block_x, block_y, texels.data())) {
+				error_blocks++;
+			}
+
+			//texels of partial blocks past the image edge are dropped
+			for (unsigned int y = 0; y < block_y && by * block_y + y < height; y++) {
+				unsigned int columns = std::min(block_x, width - bx * block_x);
+				memcpy(pixels + ((uint64_t)(by * block_y + y) * width + bx * block_x) * 4, texels.data() + y * block_x * 4, columns * 4);
+			}
+		}
+	}
+
+	return error_blocks;
+}
+
+double image_psnr(const uint8_t* reference, const uint8_t* decoded, size_t pixelCount, bool include_alpha) {
+	unsigned int channels = include_alpha ? 4 : 3;
+	double squared_error = 0.0;
+
+	for (size_t i = 0; i < pixelCount; i++) {
+		for (unsigned int c = 0; c < channels; c++) {
+			double difference = static_cast<double>(reference[i * 4 + c]) - static_cast<double>(decoded[i * 4 + c]);
+			squared_error += difference * difference;
+		}
+	}
+
+	if (squared_error == 0.0 || pixelCount == 0) {
+		return 99.0;
+	}
+
+	double mse = squared_error / (static_cast<double>(pixelCount) * channels);
+	return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
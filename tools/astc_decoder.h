@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Reference decoder of 2D LDR ASTC blocks for the tools (quality measurements of the encoder output).
+ *
+ * Written from the format specification and independent of the encoder, so it does not share its mistakes.
+ * HDR endpoint modes, reserved block modes and malformed blocks decode to the error color (magenta).
+ */
+
+//decodes one 16 byte block into block_x * block_y RGBA8 texels
+//returns false (and fills the error color) for blocks a LDR decoder has to reject
+bool decode_astc_block(const uint8_t block[16], unsigned int block_x, unsigned int block_y, uint8_t* texels);
+
+//decodes the row-major blocks of an image into tightly packed RGBA8 pixels, returns the number of error blocks
+uint64_t decode_astc_image(
+	const uint8_t* blocks,
+	unsigned int block_x,
+	unsigned int block_y,
+	unsigned int width,
+	unsigned int height,
+	uint8_t* pixels
+);
+
+/**
+ * @brief PSNR of two RGBA8 images in dB over the RGB channels, and over alpha as well with include_alpha.
+ *
+ * Identical images return 99 dB instead of infinity.
+ */
+double image_psnr(const uint8_t* reference, const uint8_t* decoded, size_t pixelCount, bool include_alpha);
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "astcgpu.h"
+#include "astc_decoder.h"
+#include "synthetic_images.h"
+#include "trace.h"
+
+struct BenchOptions {
+	std::vector<std::pair<uint32_t, uint32_t>> sizes = { { 256, 256 }, { 1000, 1000 }, { 2048, 1024 } };
+	std::vector<std::pair<uint32_t, uint32_t>> blockSizes; //all 2D block sizes when empty
+	std::vector<std::string> images = synthetic_image_kinds();
+	unsigned int repeats = 3;
+	std::string jsonPath;
+};
+
+struct BenchResult {
+	std::string image;
+	uint32_t width;
+	uint32_t height;
+	uint32_t blockX;
+	uint32_t blockY;
+	double bestSeconds;    //fastest of the repeats
+	double meanSeconds;
+	double setupSeconds;   //first encode of the image size and block size
+	double readRowsSeconds; //stage times are the means over the repeats
+	double submitSeconds;
+	double waitSeconds;
+	double writeSeconds;
+	double psnr;
+	uint64_t errorBlocks;
+
+	double megapixelsPerSecond() const {
+		return (double)width * height / bestSeconds * 1e-6;
+	}
+};
+
+static void printUsage() {
+	std::cout << "Usage: webgpu_astc_bench [--quick] [--sizes WxH,...] [--blocks XxY,...] [--images name,...] [--repeats n] [--json <file>]" << std::endl;
+	std::cout << "  images: ";
+	for (const std::string& kind : synthetic_image_kinds()) {
+		std::cout << kind << " ";
+	}
+	std::cout << std::endl;
+}
+
+static std::vector<std::string> splitList(const std::string& list) {
+	std::vector<std::string> items;
+	size_t start = 0;
+	while (start <= list.size()) {
+		size_t end = list.find(',', start);
+		if (end == std::string::npos) {
+			end = list.size();
+		}
+		if (end > start) {
+			items.push_back(list.substr(start, end - start));
+		}
+		start = end + 1;
+	}
+	return items;
+}
+
+static std::pair<uint32_t, uint32_t> parseDimensions(const std::string& text) {
+	unsigned int x = 0;
+	unsigned int y = 0;
+	char separator = 0;
+	if (sscanf(text.c_str(), "%u%c%u", &x, &separator, &y) != 3 || separator != 'x' || x == 0 || y == 0) {
+		throw std::runtime_error("Invalid dimensions " + text + ", expected e.g. 256x256");
+	}
+	return { x, y };
+}
+
+static BenchOptions parseOptions(int argc, char** argv) {
+	BenchOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--quick") {
+			options.sizes = { { 256, 256 } };
+			options.blockSizes = { { 4, 4 }, { 6, 6 }, { 8, 8 }, { 12, 12 } };
+			options.repeats = 1;
+		}
+		else if (argument == "--sizes" && hasValue) {
+			options.sizes.clear();
+			for (const std::string& item : splitList(argv[++i])) {
+				options.sizes.push_back(parseDimensions(item));
+			}
+		}
+		else if (argument == "--blocks" && hasValue) {
+			options.blockSizes.clear();
+			for (const std::string& item : splitList(argv[++i])) {
+				std::pair<uint32_t, uint32_t> blockSize = parseDimensions(item);
+				if (!astcgpu_is_valid_block_size(blockSize.first, blockSize.second)) {
+					throw std::runtime_error("Unsupported block size " + item);
+				}
+				options.blockSizes.push_back(blockSize);
+			}
+		}
+		else if (argument == "--images" && hasValue) {
+			options.images = splitList(argv[++i]);
+		}
+		else if (argument == "--repeats" && hasValue) {
+			options.repeats = std::max(1, atoi(argv[++i]));
+		}
+		else if (argument == "--json" && hasValue) {
+			options.jsonPath = argv[++i];
+		}
+		else {
+			throw std::runtime_error("Unknown option " + argument);
+		}
+	}
+
+	if (options.blockSizes.empty()) {
+		for (uint32_t y = 3; y <= 12; y++) {
+			for (uint32_t x = 3; x <= 12; x++) {
+				if (astcgpu_is_valid_block_size(x, y)) {
+					options.blockSizes.push_back({ x, y });
+				}
+			}
+		}
+	}
+
+	return options;
+}
+
+static void checkStatus(astcgpu_context* context, astcgpu_status status, const char* what) {
+	if (status != ASTCGPU_SUCCESS) {
+		throw std::runtime_error(std::string(what) + " failed: " + astcgpu_status_string(status) + " " + astcgpu_get_last_error(context));
+	}
+}
+
+static BenchResult runBenchmark(astcgpu_context* context, const SyntheticImage& image, uint32_t blockX, uint32_t blockY, unsigned int repeats) {
+
+	BenchResult result = {};
+	result.image = image.name;
+	result.width = image.width;
+	result.height = image.height;
+	result.blockX = blockX;
+	result.blockY = blockY;
+
+	std::vector<uint8_t> blocks(astcgpu_compressed_size(image.width, image.height, blockX, blockY));
+
+	//the first encode of a size creates the buffers and bind groups (and the session of a new block size), it is
+	//reported as setup and not timed
+	astcgpu_statistics before = {};
+	astcgpu_statistics after = {};
+	astcgpu_reset_statistics(context);
+	checkStatus(context, astcgpu_encode(context, image.pixels.data(), image.width, image.height, 0, blockX, blockY, blocks.data(), blocks.size()), "Encode");
+	astcgpu_get_statistics(context, &before);
+	result.setupSeconds = before.setup_seconds;
+
+	double totalSeconds = 0.0;
+	result.bestSeconds = 1e30;
+	for (unsigned int i = 0; i < repeats; i++) {
+		auto start = std::chrono::steady_clock::now();
+		checkStatus(context, astcgpu_encode(context, image.pixels.data(), image.width, image.height, 0, blockX, blockY, blocks.data(), blocks.size()), "Encode");
+		std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+		result.bestSeconds = std::min(result.bestSeconds, seconds.count());
+		totalSeconds += seconds.count();
+	}
+	astcgpu_get_statistics(context, &after);
+
+	result.meanSeconds = totalSeconds / repeats;
+	result.readRowsSeconds = (after.read_rows_seconds - before.read_rows_seconds) / repeats;
+	result.submitSeconds = (after.submit_seconds - before.submit_seconds) / repeats;
+	result.waitSeconds = (after.wait_seconds - before.wait_seconds) / repeats;
+	result.writeSeconds = (after.write_seconds - before.write_seconds) / repeats;
+
+	std::vector<uint8_t> decoded((size_t)image.width * image.height * 4);
+	result.errorBlocks = decode_astc_image(blocks.data(), blockX, blockY, image.width, image.height, decoded.data());
+	result.psnr = image_psnr(image.pixels.data(), decoded.data(), (size_t)image.width * image.height, image.hasAlpha);
+
+	return result;
+}
+
+static void writeJson(const std::string& path, const BenchOptions& options, const std::vector<BenchResult>& results) {
+
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Could not open " + path);
+	}
+
+	const char* fallback = std::getenv("ASTC_FALLBACK_ADAPTER");
+	file << "{\n  \"repeats\": " << options.repeats << ",\n";
+	file << "  \"fallback_adapter\": " << (fallback != nullptr && fallback[0] != '\0' && strcmp(fallback, "0") != 0 ? "true" : "false") << ",\n";
+	file << "  \"results\": [";
+
+	char line[512];
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult& r = results[i];
+		snprintf(line, sizeof(line),
+			"%s\n    {\"image\": \"%s\", \"width\": %u, \"height\": %u, \"block\": \"%ux%u\", \"mpix_per_s\": %.4f, \"best_ms\": %.4f, "
+			"\"mean_ms\": %.4f, \"setup_ms\": %.4f, \"read_rows_ms\": %.4f, \"submit_ms\": %.4f, \"wait_ms\": %.4f, \"write_ms\": %.4f, "
+			"\"psnr_db\": %.4f, \"error_blocks\": %llu}",
+			i == 0 ? "" : ",", r.image.c_str(), r.width, r.height, r.blockX, r.blockY, r.megapixelsPerSecond(), r.bestSeconds * 1e3,
+			r.meanSeconds * 1e3, r.setupSeconds * 1e3, r.readRowsSeconds * 1e3, r.submitSeconds * 1e3, r.waitSeconds * 1e3, r.writeSeconds * 1e3,
+			r.psnr, (unsigned long long)r.errorBlocks);
+		file << line;
+	}
+	file << "\n  ]\n}\n";
+
+	if (!file) {
+		throw std::runtime_error("Could not write " + path);
+	}
+	std::cout << "Results written to " << path << std::endl;
+}
+
+//End to end throughput benchmark: encodes the synthetic corpus with every block size through the C API and reports
+//the throughput, the host time of the encode stages and the quality of the decoded blocks
+int main(int argc, char** argv) {
+
+	BenchOptions options;
+	try {
+		options = parseOptions(argc, argv);
+	}
+	catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		printUsage();
+		return 1;
+	}
+
+	//the per image messages of the encoder would drown the results
+	if (std::getenv("ASTC_LOG_LEVEL") == nullptr) {
+		setLogLevel(LogLevel::Warning);
+	}
+
+	astcgpu_context* context = nullptr;
+	astcgpu_status status = astcgpu_context_create(nullptr, &context);
+	if (status != ASTCGPU_SUCCESS) {
+		std::cout << "Could not create the encoder: " << astcgpu_status_string(status) << " (" << astcgpu_get_last_error(nullptr) << ")" << std::endl;
+		return 1;
+	}
+
+	std::vector<BenchResult> results;
+	bool failed = false;
+
+	char line[256];
+	snprintf(line, sizeof(line), "%-10s %-10s %-6s %9s %9s %9s %9s %9s %9s %9s %8s", "image", "size", "block", "Mpix/s", "best ms",
+		"setup ms", "rows ms", "submit ms", "wait ms", "write ms", "PSNR");
+	std::cout << line << std::endl;
+
+	try {
+		for (const std::pair<uint32_t, uint32_t>& size : options.sizes) {
+			std::vector<SyntheticImage> images;
+			for (const std::string& kind : options.images) {
+				images.push_back(generate_synthetic_image(kind, size.first, size.second));
+			}
+
+			for (const std::pair<uint32_t, uint32_t>& blockSize : options.blockSizes) {
+				for (const SyntheticImage& image : images) {
+					BenchResult r = runBenchmark(context, image, blockSize.first, blockSize.second, options.repeats);
+
+					std::string sizeText = std::to_string(r.width) + "x" + std::to_string(r.height);
+					std::string blockText = std::to_string(r.blockX) + "x" + std::to_string(r.blockY);
+					snprintf(line, sizeof(line), "%-10s %-10s %-6s %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %8.2f", r.image.c_str(), sizeText.c_str(),
+						blockText.c_str(), r.megapixelsPerSecond(), r.bestSeconds * 1e3, r.setupSeconds * 1e3, r.readRowsSeconds * 1e3,
+						r.submitSeconds * 1e3, r.waitSeconds * 1e3, r.writeSeconds * 1e3, r.psnr);
+					std::cout << line << std::endl;
+
+					if (r.errorBlocks > 0) {
+						std::cout << "  " << r.errorBlocks << " blocks did not decode" << std::endl;
+						failed = true;
+					}
+					results.push_back(r);
+				}
+			}
+		}
+
+		//throughput of each block size over the whole corpus
+		std::cout << "--- Throughput per block size ---" << std::endl;
+		for (const std::pair<uint32_t, uint32_t>& blockSize : options.blockSizes) {
+			double pixels = 0.0;
+			double seconds = 0.0;
+			for (const BenchResult& r : results) {
+				if (r.blockX == blockSize.first && r.blockY == blockSize.second) {
+					pixels += (double)r.width * r.height;
+					seconds += r.bestSeconds;
+				}
+			}
+			snprintf(line, sizeof(line), "%2ux%-2u %9.2f Mpix/s", blockSize.first, blockSize.second, seconds > 0.0 ? pixels / seconds * 1e-6 : 0.0);
+			std::cout << line << std::endl;
+		}
+
+		if (!options.jsonPath.empty()) {
+			writeJson(options.jsonPath, options, results);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		failed = true;
+	}
+
+	astcgpu_context_destroy(context);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,32 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "metadata_cache.h"
+
+//Build time generator of the block size metadata: writes the compressed metadata images of all 2D block sizes
+//into one bundle, which the build embeds into the encoder (ASTC_PREBUILT_METADATA)
+int main(int argc, char** argv) {
+
+	if (argc != 2) {
+		std::cout << "Usage: astc_metadata_generator <output_file>" << std::endl;
+		return 1;
+	}
+
+	std::vector<uint8_t> bundle = build_metadata_bundle();
+
+	std::ofstream file(argv[1], std::ios::binary | std::ios::trunc);
+	if (!file) {
+		std::cout << "Could not open " << argv[1] << std::endl;
+		return 1;
+	}
+
+	file.write(reinterpret_cast<const char*>(bundle.data()), bundle.size());
+	if (!file) {
+		std::cout << "Could not write " << argv[1] << std::endl;
+		return 1;
+	}
+
+	std::cout << "Wrote " << bundle.size() << " bytes of block size metadata to " << argv[1] << std::endl;
+	return 0;
+}
@@ -0,0 +1,489 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MICROBENCH_HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MICROBENCH_HAS_TSC 1
+#else
+#define MICROBENCH_HAS_TSC 0
+#endif
+
+#include "astc.h"
+#include "synthetic_images.h"
+
+struct MicrobenchOptions {
+	std::vector<std::pair<uint32_t, uint32_t>> blockSizes = { { 4, 4 }, { 6, 6 }, { 8, 8 }, { 12, 12 } };
+	std::string filter;
+	double minSeconds = 0.2; //per case, split over the samples
+	std::string jsonPath;
+};
+
+struct MicrobenchResult {
+	std::string name;
+	std::string blockSize; //empty for cases that do not depend on it
+	std::string unit;
+	double nanoseconds;    //per unit, best sample
+	double cycles;         //per unit, time stamp counter cycles of the same sample (0 without one)
+};
+
+static const unsigned int SAMPLES = 5;
+
+//results are folded into this so the compiler can not drop the measured calls
+static volatile uint64_t sink;
+
+static uint64_t readCycleCounter() {
+#if MICROBENCH_HAS_TSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @brief Runs a case until a sample takes its share of the minimum time, the best of the samples is reported.
+ *
+ * run(iterations) has to do iterations calls, each call is unitsPerCall units (blocks, sequences or calls).
+ */
+template <typename Run>
+static MicrobenchResult measure(const MicrobenchOptions& options, const std::string& name, const std::string& blockSize,
+	const std::string& unit, uint64_t unitsPerCall, Run&& run) {
+
+	using clock = std::chrono::steady_clock;
+
+	//warm up and find an iteration count that takes long enough to time
+	uint64_t iterations = 1;
+	double sampleSeconds = options.minSeconds / SAMPLES;
+	while (true) {
+		auto start = clock::now();
+		run(iterations);
+		double seconds = std::chrono::duration<double>(clock::now() - start).count();
+		if (seconds >= sampleSeconds || iterations >= (1ull << 40)) {
+			break;
+		}
+		iterations = seconds > 0.0 ? std::max<uint64_t>(iterations * 2, (uint64_t)(iterations * sampleSeconds * 1.2 / seconds)) : iterations * 16;
+	}
+
+	MicrobenchResult result = { name, blockSize, unit, 1e30, 0.0 };
+	for (unsigned int sample = 0; sample < SAMPLES; sample++) {
+		auto start = clock::now();
+		uint64_t startCycles = readCycleCounter();
+		run(iterations);
+		uint64_t cycles = readCycleCounter() - startCycles;
+		double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+		double units = (double)iterations * unitsPerCall;
+		if (seconds * 1e9 / units < result.nanoseconds) {
+			result.nanoseconds = seconds * 1e9 / units;
+			result.cycles = cycles / units;
+		}
+	}
+
+	return result;
+}
+
+static std::string blockSizeName(uint32_t blockX, uint32_t blockY) {
+	return std::to_string(blockX) + "x" + std::to_string(blockY);
+}
+
+//block descriptor with the metadata and partition tables, as the encoder builds it (huge, so on the heap)
+static std::unique_ptr<block_descriptor> buildBlockDescriptor(uint32_t blockX, uint32_t blockY) {
+	std::unique_ptr<block_descriptor> descriptor = std::make_unique<block_descriptor>();
+	construct_metadata_structures(blockX, blockY, *descriptor);
+	init_partition_tables(*descriptor, false, 4);
+	return descriptor;
+}
+
+//blocks of the synthetic images with detail (noise, text edges, alpha cut-outs), the same for every run
+static std::vector<InputBlock> sampleBlocks(uint32_t blockX, uint32_t blockY, unsigned int count) {
+	const char* kinds[] = { "noise", "text", "alpha" };
+
+	std::vector<InputBlock> blocks;
+	blocks.reserve(count);
+	for (unsigned int k = 0; blocks.size() < count; k = (k + 1) % 3) {
+		SyntheticImage image = generate_synthetic_image(kinds[k], 96, 96);
+		std::vector<InputBlock> imageBlocks = SplitImageIntoBlocks(image.pixels.data(), image.width, image.height, blockX, blockY);
+		for (size_t i = 0; i < imageBlocks.size() && blocks.size() < count; i += 3) {
+			blocks.push_back(imageBlocks[i]);
+		}
+	}
+	return blocks;
+}
+
+//random symbolic blocks with valid single plane block modes and LDR endpoint formats that fit the remaining bits
+static std::vector<SymbolicBlock> randomSymbolicBlocks(const block_descriptor& descriptor, unsigned int count, uint64_t seed) {
+	std::vector<SymbolicBlock> blocks;
+	blocks.reserve(count);
+
+	uint64_t state = seed;
+	auto random = [&state](uint32_t range) {
+		state = state * 6364136223846793005ull + 1442695040888963407ull;
+		return static_cast<uint32_t>((state >> 33) % range);
+	};
+
+	while (blocks.size() < count) {
+		unsigned int mode = random(WEIGHTS_MAX_BLOCK_MODES);
+		if (descriptor.block_mode_index[mode] == BLOCK_BAD_BLOCK_MODE) {
+			continue;
+		}
+		const block_mode& bm = descriptor.block_modes[descriptor.block_mode_index[mode]];
+		if (bm.is_dual_plane) {
+			continue;
+		}
+
+		unsigned int partitionCount = 1 + random(BLOCK_MAX_PARTITIONS);
+		if (descriptor.partitioning_count_selected[partitionCount - 1] == 0) {
+			continue;
+		}
+
+		//formats 0 (luminance), 4 (luminance alpha), 8 (RGB), 12 (RGBA), all partitions share one
+		unsigned int format = random(4) * 4;
+		unsigned int colorValues = partitionCount * (2 * (format >> 2) + 2);
+		int availableBits = 128 - static_cast<int>(bm.weight_bits) - (partitionCount == 1 ? 17 : 19 + PARTITION_INDEX_BITS);
+
+		int quant = QUANT_256;
+		while (quant >= QUANT_6 && static_cast<int>(get_ise_sequence_bitcount(colorValues, static_cast<quant_method>(quant))) > availableBits) {
+			quant--;
+		}
+		if (quant < QUANT_6) {
+			continue;
+		}
+
+		SymbolicBlock block = {};
+		block.block_mode_index = mode;
+		block.partition_count = partitionCount;
+		block.partition_index = partitionCount > 1 ? random(1u << PARTITION_INDEX_BITS) : 0;
+		block.partition_formats_matched = 1;
+		block.quant_mode = static_cast<uint32_t>(quant);
+		for (unsigned int p = 0; p < partitionCount; p++) {
+			block.partition_formats[p] = format;
+		}
+		for (unsigned int i = 0; i < colorValues; i++) {
+			block.packed_color_values[i] = random(256);
+		}
+		unsigned int weightCount = descriptor.decimation_info_metadata[bm.decimation_mode].weight_count;
+		for (unsigned int i = 0; i < weightCount; i++) {
+			block.quantized_weights[i] = random(65);
+		}
+		blocks.push_back(block);
+	}
+
+	return blocks;
+}
+
+static void runBlockSizeCases(const MicrobenchOptions& options, uint32_t blockX, uint32_t blockY, std::vector<MicrobenchResult>& results) {
+
+	std::string size = blockSizeName(blockX, blockY);
+	auto wanted = [&](const std::string& name) {
+		return options.filter.empty() || name.find(options.filter) != std::string::npos;
+	};
+
+	if (wanted("SplitImageIntoBlocks")) {
+		SyntheticImage image = generate_synthetic_image("noise", 256, 256);
+		uint32_t blockCount = ((256 + blockX - 1) / blockX) * ((256 + blockY - 1) / blockY);
+		std::vector<InputBlock> blocks(blockCount);
+		results.push_back(measure(options, "SplitImageIntoBlocks", size, "block", blockCount, [&](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				SplitImageIntoBlocks(image.pixels.data(), image.width, image.height, blockX, blockY, 0, blockCount, blocks.data());
+				sink = sink + blocks[i % blockCount].grayscale;
+			}
+		}));
+	}
+
+	if (wanted("construct_metadata_structures")) {
+		std::unique_ptr<block_descriptor> descriptor = std::make_unique<block_descriptor>();
+		results.push_back(measure(options, "construct_metadata_structures", size, "call", 1, [&](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				//the packed decimation data is appended to, it keeps its capacity between the calls
+				descriptor->decimation_info_packed.texel_to_weight_map_data.clear();
+				descriptor->decimation_info_packed.weight_to_texel_map_data.clear();
+				construct_metadata_structures(blockX, blockY, *descriptor);
+				sink = sink + descriptor->uniform_variables.texel_count;
+			}
+		}));
+	}
+
+	std::unique_ptr<block_descriptor> descriptor = buildBlockDescriptor(blockX, blockY);
+
+	if (wanted("init_partition_tables")) {
+		results.push_back(measure(options, "init_partition_tables", size, "call", 1, [&](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				init_partition_tables(*descriptor, false, 4);
+				sink = sink + descriptor->partitioning_count_selected[1];
+			}
+		}));
+	}
+
+	const unsigned int BLOCK_SAMPLE_COUNT = 256;
+	std::vector<InputBlock> blocks = sampleBlocks(blockX, blockY, BLOCK_SAMPLE_COUNT);
+	const uniform_variables& uniforms = descriptor->uniform_variables;
+
+	for (unsigned int partitionCount = 2; partitionCount <= BLOCK_MAX_PARTITIONS; partitionCount++) {
+		std::string suffix = " p" + std::to_string(partitionCount);
+
+		if (descriptor->partitioning_count_selected[partitionCount - 1] == 0) {
+			continue;
+		}
+
+		//centers and assignments of the first round, the inputs of assign and update
+		std::vector<std::vector<std::array<float, 4>>> centers(blocks.size());
+		std::vector<std::array<uint8_t, BLOCK_MAX_TEXELS>> assignments(blocks.size());
+		for (size_t b = 0; b < blocks.size(); b++) {
+			kmeans_init(blocks[b], uniforms.texel_count, partitionCount, uniforms.channel_weights, centers[b]);
+			kmeans_assign(blocks[b], uniforms.texel_count, partitionCount, uniforms.channel_weights, centers[b], assignments[b].data());
+		}
+
+		if (wanted("kmeans_init" + suffix)) {
+			std::vector<std::array<float, 4>> initCenters;
+			results.push_back(measure(options, "kmeans_init" + suffix, size, "block", BLOCK_SAMPLE_COUNT, [&](uint64_t iterations) {
+				for (uint64_t i = 0; i < iterations; i++) {
+					for (const InputBlock& block : blocks) {
+						kmeans_init(block, uniforms.texel_count, partitionCount, uniforms.channel_weights, initCenters);
+						sink = sink + static_cast<uint64_t>(initCenters[1][0]);
+					}
+				}
+			}));
+		}
+
+		if (wanted("kmeans_assign" + suffix)) {
+			uint8_t texelPartitions[BLOCK_MAX_TEXELS];
+			results.push_back(measure(options, "kmeans_assign" + suffix, size, "block", BLOCK_SAMPLE_COUNT, [&](uint64_t iterations) {
+				for (uint64_t i = 0; i < iterations; i++) {
+					for (size_t b = 0; b < blocks.size(); b++) {
+						kmeans_assign(blocks[b], uniforms.texel_count, partitionCount, uniforms.channel_weights, centers[b], texelPartitions);
+						sink = sink + texelPartitions[0];
+					}
+				}
+			}));
+		}
+
+		if (wanted("kmeans_update" + suffix)) {
+			//the centers move on every call, the assignments stay those of the first round
+			results.push_back(measure(options, "kmeans_update" + suffix, size, "block", BLOCK_SAMPLE_COUNT, [&](uint64_t iterations) {
+				for (uint64_t i = 0; i < iterations; i++) {
+					for (size_t b = 0; b < blocks.size(); b++) {
+						kmeans_update(blocks[b], uniforms.texel_count, partitionCount, centers[b], assignments[b].data());
+						sink = sink + static_cast<uint64_t>(centers[b][0][0]);
+					}
+				}
+			}));
+		}
+
+		if (wanted("find_best_partition_candidates" + suffix)) {
+			results.push_back(measure(options, "find_best_partition_candidates" + suffix, size, "block", BLOCK_SAMPLE_COUNT, [&](uint64_t iterations) {
+				unsigned int candidates[TUNE_MAX_PARTITIONING_CANDIDATES];
+				for (uint64_t i = 0; i < iterations; i++) {
+					for (const InputBlock& block : blocks) {
+						find_best_partition_candidates(*descriptor, block, partitionCount, TUNE_MAX_PARTITIONING_CANDIDATE_LIMIT, candidates,
+							TUNE_MAX_PARTITIONING_CANDIDATES);
+						sink = sink + candidates[0];
+					}
+				}
+			}));
+		}
+	}
+
+	if (wanted("symbolic_to_physical")) {
+		const unsigned int SYMBOLIC_BLOCK_COUNT = 1024;
+		std::vector<SymbolicBlock> symbolicBlocks = randomSymbolicBlocks(*descriptor, SYMBOLIC_BLOCK_COUNT, 0x53594D42ull + blockX * 16 + blockY);
+		results.push_back(measure(options, "symbolic_to_physical", size, "block", SYMBOLIC_BLOCK_COUNT, [&](uint64_t iterations) {
+			uint8_t physical[16];
+			for (uint64_t i = 0; i < iterations; i++) {
+				for (const SymbolicBlock& block : symbolicBlocks) {
+					symbolic_to_physical(*descriptor, block, physical);
+					sink = sink + physical[0];
+				}
+			}
+		}));
+	}
+}
+
+//cases that do not depend on the block size: the integer sequence encoding of every quant level
+static void runSequenceCases(const MicrobenchOptions& options, std::vector<MicrobenchResult>& results) {
+
+	auto wanted = [&](const std::string& name) {
+		return options.filter.empty() || name.find(options.filter) != std::string::npos;
+	};
+
+	//sequences of 32 values, as long as the color values of 4 RGBA partitions
+	const unsigned int CHARACTERS = 32;
+	const unsigned int SEQUENCES = 64;
+
+	for (unsigned int quant = QUANT_2; quant <= QUANT_256; quant++) {
+		unsigned int levels = get_quant_level(static_cast<quant_method>(quant));
+		std::string name = "encode_ise q" + std::to_string(levels);
+		if (!wanted(name)) {
+			continue;
+		}
+
+		std::vector<uint8_t> values(CHARACTERS * SEQUENCES);
+		uint32_t state = 0x49534531u + quant;
+		for (uint8_t& value : values) {
+			state = state * 1664525u + 1013904223u;
+			value = static_cast<uint8_t>((state >> 16) % levels);
+		}
+
+		//large enough for 32 characters of 8 bits
+		uint8_t output[40];
+		results.push_back(measure(options, name, "", "sequence", SEQUENCES, [&](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				for (unsigned int s = 0; s < SEQUENCES; s++) {
+					std::fill(std::begin(output), std::end(output), 0);
+					encode_ise(static_cast<quant_method>(quant), CHARACTERS, values.data() + s * CHARACTERS, output, 0);
+					sink = sink + output[0];
+				}
+			}
+		}));
+	}
+
+	if (wanted("get_ise_sequence_bitcount")) {
+		//all quant levels with 1 to 64 characters
+		results.push_back(measure(options, "get_ise_sequence_bitcount", "", "call", QUANT_LEVELS * 64, [&](uint64_t iterations) {
+			for (uint64_t i = 0; i < iterations; i++) {
+				unsigned int total = 0;
+				for (unsigned int quant = QUANT_2; quant <= QUANT_256; quant++) {
+					for (unsigned int count = 1; count <= 64; count++) {
+						total += get_ise_sequence_bitcount(count, static_cast<quant_method>(quant));
+					}
+				}
+				sink = sink + total;
+			}
+		}));
+	}
+}
+
+static void printUsage() {
+	std::cout << "Usage: astc_microbench [--blocks XxY,...] [--filter <name>] [--min-time <ms>] [--json <file>]" << std::endl;
+}
+
+static std::vector<std::pair<uint32_t, uint32_t>> parseBlockSizes(const std::string& list) {
+	std::vector<std::pair<uint32_t, uint32_t>> sizes;
+	size_t start = 0;
+	while (start < list.size()) {
+		size_t end = std::min(list.find(',', start), list.size());
+		unsigned int x = 0;
+		unsigned int y = 0;
+		bool valid = false;
+		if (sscanf(list.substr(start, end - start).c_str(), "%ux%u", &x, &y) == 2) {
+			for (unsigned int i = 0; i < ASTC_BLOCK_SIZE_COUNT_2D; i++) {
+				valid |= ASTC_BLOCK_SIZES_2D[i][0] == x && ASTC_BLOCK_SIZES_2D[i][1] == y;
+			}
+		}
+		if (!valid) {
+			throw std::runtime_error("Invalid block size " + list.substr(start, end - start));
+		}
+		sizes.push_back({ x, y });
+		start = end + 1;
+	}
+	return sizes;
+}
+
+static void writeJson(const std::string& path, const std::vector<MicrobenchResult>& results) {
+
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Could not open " + path);
+	}
+
+	file << "{\n  \"cycle_counter\": " << (MICROBENCH_HAS_TSC ? "true" : "false") << ",\n  \"results\": [";
+	char line[256];
+	for (size_t i = 0; i < results.size(); i++) {
+		const MicrobenchResult& r = results[i];
+		snprintf(line, sizeof(line), "%s\n    {\"name\": \"%s\", \"block\": \"%s\", \"unit\": \"%s\", \"ns\": %.3f, \"cycles\": %.1f}",
+			i == 0 ? "" : ",", r.name.c_str(), r.blockSize.c_str(), r.unit.c_str(), r.nanoseconds, r.cycles);
+		file << line;
+	}
+	file << "\n  ]\n}\n";
+
+	if (!file) {
+		throw std::runtime_error("Could not write " + path);
+	}
+	std::cout << "Results written to " << path << std::endl;
+}
+
+//Microbenchmarks of the host side code of the encoder (no GPU needed): ns and time stamp counter cycles per
+//block, sequence or call, on fixed seed inputs so the runs are comparable
+int main(int argc, char** argv) {
+
+	MicrobenchOptions options;
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string argument = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (argument == "--blocks" && hasValue) {
+				options.blockSizes = parseBlockSizes(argv[++i]);
+			}
+			else if (argument == "--filter" && hasValue) {
+				options.filter = argv[++i];
+			}
+			else if (argument == "--min-time" && hasValue) {
+				options.minSeconds = std::max(1, atoi(argv[++i])) * 1e-3;
+			}
+			else if (argument == "--json" && hasValue) {
+				options.jsonPath = argv[++i];
+			}
+			else {
+				throw std::runtime_error("Unknown option " + argument);
+			}
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		printUsage();
+		return 1;
+	}
+
+	std::vector<MicrobenchResult> results;
+	char line[160];
+	snprintf(line, sizeof(line), "%-40s %-6s %12s %12s  %s", "case", "block", "ns", "cycles", "per");
+	std::cout << line << std::endl;
+
+	auto printNew = [&](size_t first) {
+		for (size_t i = first; i < results.size(); i++) {
+			const MicrobenchResult& r = results[i];
+			char cycles[32];
+			if (MICROBENCH_HAS_TSC) {
+				snprintf(cycles, sizeof(cycles), "%.1f", r.cycles);
+			}
+			else {
+				snprintf(cycles, sizeof(cycles), "-");
+			}
+			snprintf(line, sizeof(line), "%-40s %-6s %12.2f %12s  %s", r.name.c_str(), r.blockSize.empty() ? "-" : r.blockSize.c_str(), r.nanoseconds,
+				cycles, r.unit.c_str());
+			std::cout << line << std::endl;
+		}
+	};
+
+	try {
+		runSequenceCases(options, results);
+		printNew(0);
+
+		for (const std::pair<uint32_t, uint32_t>& blockSize : options.blockSizes) {
+			size_t first = results.size();
+			runBlockSizeCases(options, blockSize.first, blockSize.second, results);
+			printNew(first);
+		}
+
+		if (!options.jsonPath.empty()) {
+			writeJson(options.jsonPath, results);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
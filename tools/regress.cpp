@@ -0,0 +1,442 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "astcgpu.h"
+#include "astc_decoder.h"
+#include "synthetic_images.h"
+#include "trace.h"
+
+/*
+ * Golden file, one entry per line:
+ *   budget <bx>x<by> <dB>                                    allowed PSNR loss of lossy changes for a block size
+ *   time_budget <factor>                                     allowed slowdown of the total encode time (optional)
+ *   output <image> <w>x<h> <bx>x<by> <fnv1a64> <psnr> <ms>   golden output of an image
+ */
+struct GoldenOutput {
+	std::string hash;
+	double psnr = 0.0;
+	double milliseconds = 0.0;
+};
+
+struct Golden {
+	std::map<std::string, double> budgets; //by block size
+	std::map<std::string, GoldenOutput> outputs; //by image, size and block size
+	double timeBudget = 0.0; //0 for no time check
+};
+
+struct RegressOptions {
+	std::string goldenPath;
+	bool update = false;
+	bool exact = false;      //outputs have to be bit identical (changes meant to be neutral)
+	bool hardware = false;   //the default adapter instead of the fallback one
+	std::vector<std::pair<uint32_t, uint32_t>> sizes = { { 256, 256 }, { 203, 157 } };
+	std::vector<std::pair<uint32_t, uint32_t>> blockSizes = { { 4, 4 }, { 5, 5 }, { 6, 6 }, { 8, 8 }, { 10, 10 }, { 12, 12 } };
+	std::vector<std::string> references;
+	unsigned int repeats = 3;
+};
+
+struct RegressImage {
+	std::string name;
+	uint32_t width;
+	uint32_t height;
+	bool hasAlpha;
+	std::vector<uint8_t> pixels;
+};
+
+static const double DEFAULT_BUDGET = 0.05;
+
+//ctest reports the run as skipped: no adapter to encode on
+static const int EXIT_SKIPPED = 77;
+
+static std::string dimensionsName(uint32_t x, uint32_t y) {
+	return std::to_string(x) + "x" + std::to_string(y);
+}
+
+static std::pair<uint32_t, uint32_t> parseDimensions(const std::string& text) {
+	unsigned int x = 0;
+	unsigned int y = 0;
+	char separator = 0;
+	if (sscanf(text.c_str(), "%u%c%u", &x, &separator, &y) != 3 || separator != 'x' || x == 0 || y == 0) {
+		throw std::runtime_error("Invalid dimensions " + text + ", expected e.g. 256x256");
+	}
+	return { x, y };
+}
+
+static std::vector<std::pair<uint32_t, uint32_t>> parseDimensionList(const std::string& list) {
+	std::vector<std::pair<uint32_t, uint32_t>> items;
+	std::stringstream stream(list);
+	std::string item;
+	while (std::getline(stream, item, ',')) {
+		if (!item.empty()) {
+			items.push_back(parseDimensions(item));
+		}
+	}
+	return items;
+}
+
+//FNV-1a, enough to tell outputs apart and stable across platforms
+static std::string hashBlocks(const std::vector<uint8_t>& blocks) {
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (uint8_t byte : blocks) {
+		hash = (hash ^ byte) * 0x100000001B3ull;
+	}
+	char text[17];
+	snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+	return text;
+}
+
+static Golden readGolden(const std::string& path, bool mustExist) {
+	Golden golden;
+
+	std::ifstream file(path);
+	if (!file) {
+		if (mustExist) {
+			throw std::runtime_error("Could not open the golden file " + path + ", create it with --update");
+		}
+		return golden;
+	}
+
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		std::stringstream stream(line);
+		std::string kind;
+		if (!(stream >> kind) || kind[0] == '#') {
+			continue;
+		}
+
+		if (kind == "budget") {
+			std::string block;
+			double budget;
+			if (stream >> block >> budget) {
+				golden.budgets[block] = budget;
+				continue;
+			}
+		}
+		else if (kind == "time_budget") {
+			if (stream >> golden.timeBudget) {
+				continue;
+			}
+		}
+		else if (kind == "output") {
+			std::string image, size, block;
+			GoldenOutput output;
+			if (stream >> image >> size >> block >> output.hash >> output.psnr >> output.milliseconds) {
+				golden.outputs[image + " " + size + " " + block] = output;
+				continue;
+			}
+		}
+
+		throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": invalid golden entry");
+	}
+
+	return golden;
+}
+
+static void writeGolden(const std::string& path, const Golden& golden) {
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Could not open " + path);
+	}
+
+	file << "# Golden outputs of webgpu_astc_regress (regenerate with --update)\n";
+	file << "# budget <block> <allowed PSNR loss in dB>\n";
+	for (const auto& [block, budget] : golden.budgets) {
+		file << "budget " << block << " " << budget << "\n";
+	}
+
+	if (golden.timeBudget > 0.0) {
+		file << "# time_budget <allowed slowdown of the total encode time>\n";
+		file << "time_budget " << golden.timeBudget << "\n";
+	}
+
+	file << "# output <image> <size> <block> <fnv1a64 of the blocks> <PSNR> <best encode ms>\n";
+	char line[256];
+	for (const auto& [key, output] : golden.outputs) {
+		snprintf(line, sizeof(line), "output %s %s %.4f %.3f\n", key.c_str(), output.hash.c_str(), output.psnr, output.milliseconds);
+		file << line;
+	}
+
+	if (!file) {
+		throw std::runtime_error("Could not write " + path);
+	}
+	std::cout << "Golden outputs written to " << path << std::endl;
+}
+
+static std::vector<RegressImage> loadCorpus(const RegressOptions& options) {
+	std::vector<RegressImage> images;
+
+	for (const std::pair<uint32_t, uint32_t>& size : options.sizes) {
+		for (const std::string& kind : synthetic_image_kinds()) {
+			SyntheticImage synthetic = generate_synthetic_image(kind, size.first, size.second);
+			images.push_back({ synthetic.name, synthetic.width, synthetic.height, synthetic.hasAlpha, std::move(synthetic.pixels) });
+		}
+	}
+
+	for (const std::string& path : options.references) {
+		int width, height, channels;
+		uint8_t* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+		if (!pixels) {
+			throw std::runtime_error("Failed to load image: " + path);
+		}
+
+		//the file name without directories and extension, spaces would break the golden file
+		std::string name = path.substr(path.find_last_of("/\\") + 1);
+		name = name.substr(0, name.find_last_of('.'));
+		std::replace(name.begin(), name.end(), ' ', '_');
+
+		RegressImage image = { name, (uint32_t)width, (uint32_t)height, channels == 2 || channels == 4 };
+		image.pixels.assign(pixels, pixels + (size_t)width * height * 4);
+		stbi_image_free(pixels);
+		images.push_back(std::move(image));
+	}
+
+	return images;
+}
+
+//the software adapter encodes the same way on every machine, hardware outputs can differ between GPUs and drivers
+static void selectFallbackAdapter() {
+#if defined(_WIN32)
+	_putenv_s("ASTC_FALLBACK_ADAPTER", "1");
+#else
+	setenv("ASTC_FALLBACK_ADAPTER", "1", 1);
+#endif
+}
+
+static void printUsage() {
+	std::cout << "Usage: webgpu_astc_regress <golden_file> [--update] [--exact] [--hardware] [--sizes WxH,...] [--blocks XxY,...]" << std::endl;
+	std::cout << "                           [--reference <image>]... [--repeats n]" << std::endl;
+	std::cout << "Exits with " << EXIT_SKIPPED << " when there is no adapter, a golden file without outputs fails unless --update is given." << std::endl;
+}
+
+static RegressOptions parseOptions(int argc, char** argv) {
+	RegressOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--update") {
+			options.update = true;
+		}
+		else if (argument == "--exact") {
+			options.exact = true;
+		}
+		else if (argument == "--hardware") {
+			options.hardware = true;
+		}
+		else if (argument == "--sizes" && hasValue) {
+			options.sizes = parseDimensionList(argv[++i]);
+		}
+		else if (argument == "--blocks" && hasValue) {
+			options.blockSizes = parseDimensionList(argv[++i]);
+			for (const std::pair<uint32_t, uint32_t>& blockSize : options.blockSizes) {
+				if (!astcgpu_is_valid_block_size(blockSize.first, blockSize.second)) {
+					throw std::runtime_error("Unsupported block size " + dimensionsName(blockSize.first, blockSize.second));
+				}
+			}
+		}
+		else if (argument == "--reference" && hasValue) {
+			options.references.push_back(argv[++i]);
+		}
+		else if (argument == "--repeats" && hasValue) {
+			options.repeats = std::max(1, atoi(argv[++i]));
+		}
+		else if (argument[0] != '-' && options.goldenPath.empty()) {
+			options.goldenPath = argument;
+		}
+		else {
+			throw std::runtime_error("Unknown option " + argument);
+		}
+	}
+
+	if (options.goldenPath.empty()) {
+		throw std::runtime_error("No golden file");
+	}
+
+	return options;
+}
+
+//Golden output and quality regression check: encodes the synthetic corpus (and reference images) with the full
+//encoder and compares the outputs with the golden file, bit exact or within the PSNR budget of the block size
+int main(int argc, char** argv) {
+
+	RegressOptions options;
+	try {
+		options = parseOptions(argc, argv);
+	}
+	catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		printUsage();
+		return 1;
+	}
+
+	if (std::getenv("ASTC_LOG_LEVEL") == nullptr) {
+		setLogLevel(LogLevel::Warning);
+	}
+
+	if (!options.hardware) {
+		selectFallbackAdapter();
+	}
+
+	Golden golden;
+	std::vector<RegressImage> images;
+	try {
+		golden = readGolden(options.goldenPath, !options.update);
+		images = loadCorpus(options);
+	}
+	catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+
+	if (golden.outputs.empty() && !options.update) {
+		std::cout << "No golden outputs in " << options.goldenPath << ", record them with --update on the fallback adapter" << std::endl;
+		return 1;
+	}
+
+	astcgpu_context* context = nullptr;
+	astcgpu_status status = astcgpu_context_create(nullptr, &context);
+	if (status != ASTCGPU_SUCCESS) {
+		std::cout << "Could not create the encoder: " << astcgpu_status_string(status) << " (" << astcgpu_get_last_error(nullptr) << ")" << std::endl;
+		//a machine without the adapter can't run the check, every other failure is one of the encoder
+		return status == ASTCGPU_ERROR_NO_ADAPTER ? EXIT_SKIPPED : 1;
+	}
+
+	unsigned int failures = 0;
+	unsigned int changed = 0;
+	double goldenMilliseconds = 0.0;
+	double currentMilliseconds = 0.0;
+
+	char line[256];
+	snprintf(line, sizeof(line), "%-12s %-9s %-6s %-6s %9s %9s %8s %8s %10s %10s %8s  %s", "image", "size", "block", "exact", "golden dB", "dB",
+		"delta", "floor", "golden ms", "ms", "speedup", "result");
+	std::cout << line << std::endl;
+
+	for (const std::pair<uint32_t, uint32_t>& blockSize : options.blockSizes) {
+		std::string block = dimensionsName(blockSize.first, blockSize.second);
+		if (!golden.budgets.count(block)) {
+			golden.budgets[block] = DEFAULT_BUDGET;
+		}
+		double budget = golden.budgets[block];
+
+		for (const RegressImage& image : images) {
+			std::string size = dimensionsName(image.width, image.height);
+			std::string key = image.name + " " + size + " " + block;
+
+			std::vector<uint8_t> blocks(astcgpu_compressed_size(image.width, image.height, blockSize.first, blockSize.second));
+
+			//untimed first encode (setup of the size), then the best of the repeats
+			double bestSeconds = 1e30;
+			for (unsigned int i = 0; i <= options.repeats && status == ASTCGPU_SUCCESS; i++) {
+				auto start = std::chrono::steady_clock::now();
+				status = astcgpu_encode(context, image.pixels.data(), image.width, image.height, 0, blockSize.first, blockSize.second, blocks.data(), blocks.size());
+				std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+				if (i > 0) {
+					bestSeconds = std::min(bestSeconds, seconds.count());
+				}
+			}
+			if (status != ASTCGPU_SUCCESS) {
+				std::cout << key << ": encode failed: " << astcgpu_status_string(status) << " " << astcgpu_get_last_error(context) << std::endl;
+				astcgpu_context_destroy(context);
+				return 1;
+			}
+
+			std::vector<uint8_t> decoded((size_t)image.width * image.height * 4);
+			uint64_t errorBlocks = decode_astc_image(blocks.data(), blockSize.first, blockSize.second, image.width, image.height, decoded.data());
+
+			GoldenOutput current;
+			current.hash = hashBlocks(blocks);
+			current.psnr = image_psnr(image.pixels.data(), decoded.data(), (size_t)image.width * image.height, image.hasAlpha);
+			current.milliseconds = bestSeconds * 1e3;
+
+			auto found = golden.outputs.find(key);
+			const char* result;
+			if (errorBlocks > 0) {
+				result = "FAIL (blocks that do not decode)";
+				failures++;
+			}
+			else if (found == golden.outputs.end()) {
+				result = options.update ? "new" : "FAIL (no golden output)";
+				failures += options.update ? 0 : 1;
+			}
+			else if (found->second.hash == current.hash) {
+				result = "ok";
+			}
+			else if (options.exact) {
+				result = "FAIL (output changed)";
+				failures++;
+			}
+			else if (current.psnr < found->second.psnr - budget) {
+				result = "FAIL (below the PSNR floor)";
+				failures++;
+			}
+			else {
+				result = "ok (changed, within budget)";
+			}
+
+			bool hasGolden = found != golden.outputs.end();
+			bool exact = hasGolden && found->second.hash == current.hash;
+			changed += hasGolden && !exact ? 1 : 0;
+
+			if (hasGolden) {
+				const GoldenOutput& reference = found->second;
+				snprintf(line, sizeof(line), "%-12s %-9s %-6s %-6s %9.2f %9.2f %+8.3f %8.2f %10.2f %10.2f %7.2fx  %s", image.name.c_str(), size.c_str(),
+					block.c_str(), exact ? "yes" : "no", reference.psnr, current.psnr, current.psnr - reference.psnr, reference.psnr - budget,
+					reference.milliseconds, current.milliseconds, reference.milliseconds / current.milliseconds, result);
+				goldenMilliseconds += reference.milliseconds;
+				currentMilliseconds += current.milliseconds;
+			}
+			else {
+				snprintf(line, sizeof(line), "%-12s %-9s %-6s %-6s %9s %9.2f %8s %8s %10s %10.2f %8s  %s", image.name.c_str(), size.c_str(),
+					block.c_str(), "-", "-", current.psnr, "-", "-", "-", current.milliseconds, "-", result);
+			}
+			std::cout << line << std::endl;
+
+			if (options.update) {
+				golden.outputs[key] = current;
+			}
+		}
+	}
+
+	astcgpu_context_destroy(context);
+
+	if (currentMilliseconds > 0.0) {
+		snprintf(line, sizeof(line), "Total encode time %.2f ms, golden %.2f ms (%.2fx)", currentMilliseconds, goldenMilliseconds,
+			goldenMilliseconds / currentMilliseconds);
+		std::cout << line << std::endl;
+
+		if (golden.timeBudget > 0.0 && !options.update && currentMilliseconds > goldenMilliseconds * golden.timeBudget) {
+			snprintf(line, sizeof(line), "FAIL: slower than %.2fx the golden encode time", golden.timeBudget);
+			std::cout << line << std::endl;
+			failures++;
+		}
+	}
+	std::cout << changed << " outputs changed, " << failures << " failures" << std::endl;
+
+	if (options.update) {
+		try {
+			writeGolden(options.goldenPath, golden);
+		}
+		catch (const std::exception& e) {
+			std::cout << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	return failures > 0 ? 1 : 0;
+}
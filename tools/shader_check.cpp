@@ -0,0 +1,127 @@
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "webgpu_utils.h"
+#include "trace.h"
+
+//ctest reports the run as skipped: no adapter to compile the shaders on
+static const int EXIT_SKIPPED = 77;
+
+//errors of the device, reported by the uncaptured error callback
+struct ShaderCheckErrors {
+	unsigned int count = 0;
+	std::string lastMessage;
+};
+
+static void printUsage() {
+	std::cout << "Usage: webgpu_astc_shader_check [--hardware] <composed_shader.wgsl>..." << std::endl;
+	std::cout << "Exits with " << EXIT_SKIPPED << " when there is no adapter." << std::endl;
+}
+
+//Compile check of the composed shaders: creates the shader module and a compute pipeline of every file on a
+//device, the fallback (software) adapter unless --hardware is given, and fails on any device error
+int main(int argc, char** argv) {
+
+	bool hardware = false;
+	std::vector<std::string> shaderPaths;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument == "--hardware") {
+			hardware = true;
+		}
+		else if (argument[0] != '-') {
+			shaderPaths.push_back(argument);
+		}
+		else {
+			std::cout << "Unknown option " << argument << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (shaderPaths.empty()) {
+		std::cout << "No shaders" << std::endl;
+		printUsage();
+		return 1;
+	}
+
+	if (std::getenv("ASTC_LOG_LEVEL") == nullptr) {
+		setLogLevel(LogLevel::Warning);
+	}
+
+	wgpu::InstanceDescriptor instanceDesc = {};
+	wgpu::Instance instance = wgpu::CreateInstance(&instanceDesc);
+	if (!instance) {
+		std::cout << "Could not initialize WebGPU" << std::endl;
+		return EXIT_SKIPPED;
+	}
+
+	wgpu::RequestAdapterOptions adapterOpts = {};
+	adapterOpts.powerPreference = wgpu::PowerPreference::HighPerformance;
+	adapterOpts.forceFallbackAdapter = !hardware;
+	wgpu::Adapter adapter = requestAdapterSync(instance, &adapterOpts);
+	if (!adapter) {
+		std::cout << "Could not get adapter" << std::endl;
+		return EXIT_SKIPPED;
+	}
+
+	//the limits of the encoder device, pipelines are validated against them
+	wgpu::RequiredLimits requiredLimits = getRequiredLimits(adapter);
+
+	wgpu::DeviceDescriptor deviceDesc = {};
+	deviceDesc.label = "ASTC shader check device";
+	deviceDesc.requiredFeatureCount = 0;
+	deviceDesc.requiredLimits = &requiredLimits;
+
+	wgpu::Device device = requestDeviceSync(adapter, &deviceDesc);
+	if (!device) {
+		std::cout << "Could not get device" << std::endl;
+		return 1;
+	}
+
+	ShaderCheckErrors errors;
+	auto onDeviceError = [](WGPUErrorType /* type */, char const* message, void* pUserData) {
+		ShaderCheckErrors* errors = static_cast<ShaderCheckErrors*>(pUserData);
+		errors->count++;
+		errors->lastMessage = message ? message : "";
+		};
+	device.SetUncapturedErrorCallback(onDeviceError, &errors);
+
+	unsigned int failures = 0;
+	for (const std::string& path : shaderPaths) {
+		std::string name = std::filesystem::path(path).filename().string();
+		if (!std::filesystem::exists(path)) {
+			std::cout << name << ": FAIL (missing, compose the shaders first)" << std::endl;
+			failures++;
+			continue;
+		}
+
+		unsigned int errorsBefore = errors.count;
+
+		//auto layout and the default values of the overrides, the module is compiled with the pipeline
+		wgpu::ShaderModule module = prepareShaderModule(device, path, name.c_str());
+
+		wgpu::ComputePipelineDescriptor pipelineDesc = {};
+		pipelineDesc.label = name.c_str();
+		pipelineDesc.compute.module = module;
+		pipelineDesc.compute.entryPoint = "main";
+		pipelineDesc.layout = nullptr;
+		wgpu::ComputePipeline pipeline = device.CreateComputePipeline(&pipelineDesc);
+
+		device.Tick();
+
+		if (errors.count != errorsBefore || !module || !pipeline) {
+			std::cout << name << ": FAIL" << std::endl << errors.lastMessage << std::endl;
+			failures++;
+		}
+		else {
+			std::cout << name << ": ok" << std::endl;
+		}
+	}
+
+	std::cout << shaderPaths.size() - failures << " of " << shaderPaths.size() << " shaders compile" << std::endl;
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,221 @@
+#include "synthetic_images.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @brief Small fixed seed generator (splitmix64), std distributions differ between standard libraries.
+ */
+class Random {
+public:
+	explicit Random(uint64_t seed) : state(seed) {}
+
+	uint64_t next() {
+		uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	//uniform in [0, range)
+	uint32_t below(uint32_t range) {
+		return static_cast<uint32_t>(next() % range);
+	}
+
+private:
+	uint64_t state;
+};
+
+static uint8_t clamp_unorm8(float value) {
+	return static_cast<uint8_t>(std::clamp(value, 0.0f, 255.0f) + 0.5f);
+}
+
+static void set_pixel(SyntheticImage& image, uint32_t x, uint32_t y, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+	uint8_t* pixel = &image.pixels[((size_t)y * image.width + x) * 4];
+	pixel[0] = r;
+	pixel[1] = g;
+	pixel[2] = b;
+	pixel[3] = a;
+}
+
+//smooth gradients in all channels, with a slow wave so they are not planar
+static void generate_gradient(SyntheticImage& image) {
+	for (uint32_t y = 0; y < image.height; y++) {
+		for (uint32_t x = 0; x < image.width; x++) {
+			float u = static_cast<float>(x) / image.width;
+			float v = static_cast<float>(y) / image.height;
+			float wave = 0.5f + 0.5f * sinf((u + v) * 6.2831853f);
+			set_pixel(image, x, y, clamp_unorm8(u * 255.0f), clamp_unorm8(v * 255.0f), clamp_unorm8(wave * 255.0f), 255);
+		}
+	}
+}
+
+//value noise of two octaves plus a little white noise, the hardest case for the endpoint search
+static void generate_noise(SyntheticImage& image) {
+	Random random(0x4E4F495345ull);
+
+	const uint32_t lattice = 17;
+	std::vector<float> coarse(lattice * lattice * 3);
+	for (float& value : coarse) {
+		value = static_cast<float>(random.below(256));
+	}
+
+	for (uint32_t y = 0; y < image.height; y++) {
+		for (uint32_t x = 0; x < image.width; x++) {
+			float fx = static_cast<float>(x) * (lattice - 1) / image.width;
+			float fy = static_cast<float>(y) * (lattice - 1) / image.height;
+			uint32_t x0 = static_cast<uint32_t>(fx);
+			uint32_t y0 = static_cast<uint32_t>(fy);
+			float tx = fx - x0;
+			float ty = fy - y0;
+
+			uint8_t channels[3];
+			for (uint32_t c = 0; c < 3; c++) {
+				float v00 = coarse[(y0 * lattice + x0) * 3 + c];
+				float v10 = coarse[(y0 * lattice + x0 + 1) * 3 + c];
+				float v01 = coarse[((y0 + 1) * lattice + x0) * 3 + c];
+				float v11 = coarse[((y0 + 1) * lattice + x0 + 1) * 3 + c];
+				float smooth = (v00 * (1 - tx) + v10 * tx) * (1 - ty) + (v01 * (1 - tx) + v11 * tx) * ty;
+				float grain = static_cast<float>(random.below(97)) - 48.0f;
+				channels[c] = clamp_unorm8(smooth + grain);
+			}
+			set_pixel(image, x, y, channels[0], channels[1], channels[2], 255);
+		}
+	}
+}
+
+//dark glyph-like strokes on a light background, sharp edges that need partitioning
+static void generate_text(SyntheticImage& image) {
+	Random random(0x54455854ull);
+
+	std::fill(image.pixels.begin(), image.pixels.end(), 255);
+	for (size_t i = 2; i < image.pixels.size(); i += 4) {
+		image.pixels[i] = 235; //slightly warm paper
+	}
+
+	const uint32_t lineHeight = 14;
+	const uint32_t glyphWidth = 8;
+	for (uint32_t line = 0; line + lineHeight <= image.height; line += lineHeight + 4) {
+		uint8_t ink = static_cast<uint8_t>(random.below(60));
+		for (uint32_t glyph = 2; glyph + glyphWidth <= image.width; glyph += glyphWidth + 1) {
+			//a space now and then, otherwise a few vertical and horizontal strokes
+			if (random.below(7) == 0) {
+				continue;
+			}
+			uint32_t strokes = random.below(16) | 1;
+			for (uint32_t y = 0; y < lineHeight - 2; y++) {
+				for (uint32_t x = 0; x < glyphWidth - 2; x++) {
+					bool left = (strokes & 1) && x < 2;
+					bool right = (strokes & 2) && x >= glyphWidth - 4;
+					bool top = (strokes & 4) && y < 2;
+					bool middle = (strokes & 8) && y >= (lineHeight - 2) / 2 - 1 && y <= (lineHeight - 2) / 2;
+					if (left || right || top || middle) {
+						set_pixel(image, glyph + x, line + 1 + y, ink, ink, static_cast<uint8_t>(ink + 20), 255);
+					}
+				}
+			}
+		}
+	}
+}
+
+//large areas of one color with a few hard borders, most blocks are solid
+static void generate_flat(SyntheticImage& image) {
+	Random random(0x464C4154ull);
+
+	const uint32_t regions = 12;
+	uint8_t colors[regions][3];
+	for (uint32_t i = 0; i < regions; i++) {
+		for (uint32_t c = 0; c < 3; c++) {
+			colors[i][c] = static_cast<uint8_t>(random.below(256));
+		}
+	}
+
+	for (uint32_t y = 0; y < image.height; y++) {
+		for (uint32_t x = 0; x < image.width; x++) {
+			uint32_t column = x * 4 / image.width;
+			uint32_t row = y * 3 / image.height;
+			const uint8_t* color = colors[row * 4 + column];
+			set_pixel(image, x, y, color[0], color[1], color[2], 255);
+		}
+	}
+}
+
+//colored disks with soft and hard alpha edges on a transparent background
+static void generate_alpha(SyntheticImage& image) {
+	Random random(0x414C504841ull);
+
+	std::fill(image.pixels.begin(), image.pixels.end(), 0);
+
+	uint32_t shortSide = std::min(image.width, image.height);
+	for (uint32_t disk = 0; disk < 24; disk++) {
+		float cx = static_cast<float>(random.below(image.width));
+		float cy = static_cast<float>(random.below(image.height));
+		float radius = static_cast<float>(shortSide) * (0.03f + 0.12f * random.below(100) / 100.0f);
+		float softness = random.below(2) ? radius * 0.3f : 1.0f;
+		uint8_t r = static_cast<uint8_t>(random.below(256));
+		uint8_t g = static_cast<uint8_t>(random.below(256));
+		uint8_t b = static_cast<uint8_t>(random.below(256));
+
+		uint32_t x0 = static_cast<uint32_t>(std::max(0.0f, cx - radius));
+		uint32_t x1 = static_cast<uint32_t>(std::min<float>(static_cast<float>(image.width), cx + radius + 1));
+		uint32_t y0 = static_cast<uint32_t>(std::max(0.0f, cy - radius));
+		uint32_t y1 = static_cast<uint32_t>(std::min<float>(static_cast<float>(image.height), cy + radius + 1));
+
+		for (uint32_t y = y0; y < y1; y++) {
+			for (uint32_t x = x0; x < x1; x++) {
+				float distance = sqrtf((x - cx) * (x - cx) + (y - cy) * (y - cy));
+				float coverage = std::clamp((radius - distance) / softness, 0.0f, 1.0f);
+				uint8_t alpha = clamp_unorm8(coverage * 255.0f);
+				uint8_t* pixel = &image.pixels[((size_t)y * image.width + x) * 4];
+				if (alpha > pixel[3]) {
+					set_pixel(image, x, y, r, g, b, alpha);
+				}
+			}
+		}
+	}
+}
+
+//luminance only (R = G = B): a photo-like mix of gradient and noise
+static void generate_grayscale(SyntheticImage& image) {
+	Random random(0x47524159ull);
+
+	for (uint32_t y = 0; y < image.height; y++) {
+		for (uint32_t x = 0; x < image.width; x++) {
+			float u = static_cast<float>(x) / image.width;
+			float v = static_cast<float>(y) / image.height;
+			float value = 128.0f + 90.0f * sinf(u * 9.0f) * cosf(v * 7.0f) + static_cast<float>(random.below(25)) - 12.0f;
+			uint8_t gray = clamp_unorm8(value);
+			set_pixel(image, x, y, gray, gray, gray, 255);
+		}
+	}
+}
+
+const std::vector<std::string>& synthetic_image_kinds() {
+	static const std::vector<std::string> kinds = { "gradient", "noise", "text", "flat", "alpha", "grayscale" };
+	return kinds;
+}
+
+SyntheticImage generate_synthetic_image(const std::string& kind, uint32_t width, uint32_t height) {
+
+	if (width == 0 || height == 0) {
+		throw std::runtime_error("Synthetic images need a size of at least 1x1");
+	}
+
+	SyntheticImage image;
+	image.name = kind;
+	image.width = width;
+	image.height = height;
+	image.pixels.resize((size_t)width * height * 4);
+
+	if (kind == "gradient") generate_gradient(image);
+	else if (kind == "noise") generate_noise(image);
+	else if (kind == "text") generate_text(image);
+	else if (kind == "flat") generate_flat(image);
+	else if (kind == "alpha") generate_alpha(image);
+	else if (kind == "grayscale") generate_grayscale(image);
+	else throw std::runtime_error("Unknown synthetic image " + kind);
+
+	image.hasAlpha = kind == "alpha";
+	return image;
+}
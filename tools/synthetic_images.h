@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Deterministic synthetic test images of the tools, generated in process from fixed seeds so every run (and every
+ * machine) encodes exactly the same pixels.
+ */
+
+struct SyntheticImage {
+	std::string name;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	bool hasAlpha = false; //alpha is not constant, quality is measured over all 4 channels
+	std::vector<uint8_t> pixels; //tightly packed RGBA8
+};
+
+//names of the generated image kinds: gradient, noise, text, flat, alpha, grayscale
+const std::vector<std::string>& synthetic_image_kinds();
+
+//throws std::runtime_error for an unknown kind
+SyntheticImage generate_synthetic_image(const std::string& kind, uint32_t width, uint32_t height);